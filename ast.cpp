@@ -1,11 +1,211 @@
 #include "ast.hpp"
+#include "string_pool.hpp"
+#include "errors.hpp"
 
-cminusminus::ProgramNode::ProgramNode(std::list<DeclNode *> * globalsIn)
-: ASTNode(new Position(0,0,0,0)), myGlobals(globalsIn){
-	if (!globalsIn->empty()){
-		myPos->expand(
-			myGlobals->front()->pos(),
-			myGlobals->back()->pos()
+static const cminusminus::Position noPos(0,0,0,0);
+
+cminusminus::ProgramNode::ProgramNode(
+	std::vector<DeclNode *> globalsIn,
+	std::vector<ImportNode *> importsIn)
+: ASTNode(&noPos), myGlobals(std::move(globalsIn)),
+  myImports(std::move(importsIn)){
+	if (!myGlobals.empty()){
+		myPos.expand(
+			myGlobals.front()->pos(),
+			myGlobals.back()->pos()
 		);
 	}
 }
+
+void cminusminus::ProgramNode::collectRecords(
+	std::list<const RecordType *> * records){
+	for (auto decl : myGlobals){
+		const RecordType * record = decl->declaredRecord();
+		if (record != nullptr){ records->push_back(record); }
+	}
+}
+
+namespace cminusminus{
+
+//Marks each string literal it is offered, leaving the tree
+// as it is
+class MarkLiterals : public ExpRewriter{
+public:
+	MarkLiterals(LiveInterned * live) : myLive(live){ }
+	ExpNode * rewrite(ExpNode * exp) override {
+		StrLitNode * lit = exp->asStrLit();
+		if (lit != nullptr){ myLive->markLiteral(lit->getStrID()); }
+		return exp;
+	}
+private:
+	LiveInterned * myLive;
+};
+
+void ProgramNode::markLive(LiveInterned * live){
+	for (auto import : myImports){
+		live->markLiteral(import->getPathID());
+	}
+	MarkLiterals marker(live);
+	for (auto decl : myGlobals){
+		decl->rewriteExps(&marker);
+		//The initializer of a constant is a literal, which
+		// rewriting expressions doesn't reach
+		ConstDeclNode * constant = decl->asConst();
+		if (constant != nullptr){ marker.rewrite(constant->getInit()); }
+	}
+}
+
+template <typename T>
+static void deleteAll(const std::vector<T *>& nodes){
+	for (auto node : nodes){
+		delete node;
+	}
+}
+
+std::string ImportNode::getPath() const{
+	return StringPool::contents(myPathID);
+}
+
+ProgramNode::~ProgramNode(){
+	deleteAll(myGlobals);
+	deleteAll(myImports);
+}
+
+DeclNode::~DeclNode(){
+	delete mySymbol;
+}
+
+VarDeclNode * VarDeclNode::temp(const Position * p,
+	const DataType * type, const std::string& name){
+	TypeNode * typeNode;
+	if (type->isBool()){
+		typeNode = new BoolTypeNode(p);
+	} else if (type->isShort()){
+		typeNode = new ShortTypeNode(p);
+	} else if (type->isInt()){
+		typeNode = new IntTypeNode(p);
+	} else {
+		std::string msg = "No temporary of type " + type->getString();
+		throw new InternalError(msg.c_str());
+	}
+	IDNode * id = new IDNode(p, name);
+	VarDeclNode * decl = new VarDeclNode(p, typeNode, id);
+	decl->mySymbol = new VarSymbol(name, type);
+	id->attachSymbol(decl->mySymbol);
+	return decl;
+}
+
+VarDeclNode::~VarDeclNode(){
+	delete myType;
+	delete myID;
+}
+
+ConstDeclNode::~ConstDeclNode(){
+	delete myInit;
+}
+
+FnDeclNode::~FnDeclNode(){
+	delete myRetType;
+	delete myID;
+	deleteAll(myFormals);
+	deleteAll(myBody);
+	delete myFnType;
+}
+
+RecordDeclNode::~RecordDeclNode(){
+	delete myID;
+	deleteAll(myFields);
+	delete myType;
+}
+
+AssignStmtNode::~AssignStmtNode(){
+	delete myExp;
+}
+
+ReadStmtNode::~ReadStmtNode(){
+	delete myDst;
+}
+
+WriteStmtNode::~WriteStmtNode(){
+	delete mySrc;
+}
+
+PostDecStmtNode::~PostDecStmtNode(){
+	delete myLVal;
+}
+
+PostIncStmtNode::~PostIncStmtNode(){
+	delete myLVal;
+}
+
+IfStmtNode::~IfStmtNode(){
+	delete myCond;
+	deleteAll(myBody);
+}
+
+IfElseStmtNode::~IfElseStmtNode(){
+	delete myCond;
+	deleteAll(myBodyTrue);
+	deleteAll(myBodyFalse);
+}
+
+WhileStmtNode::~WhileStmtNode(){
+	delete myCond;
+	deleteAll(myBody);
+}
+
+ReturnStmtNode::~ReturnStmtNode(){
+	delete myExp;
+}
+
+CallExpNode::~CallExpNode(){
+	delete myID;
+	deleteAll(myArgs);
+}
+
+BinaryExpNode::~BinaryExpNode(){
+	delete myExp1;
+	delete myExp2;
+}
+
+//A RefNode's ID is its operand, and is deleted as such
+UnaryExpNode::~UnaryExpNode(){
+	delete myExp;
+}
+
+DerefNode::~DerefNode(){
+	delete myID;
+}
+
+FieldAccessNode::~FieldAccessNode(){
+	delete myBase;
+	delete myField;
+}
+
+IndexNode::~IndexNode(){
+	delete myBase;
+	delete myIndex;
+}
+
+PtrTypeNode::~PtrTypeNode(){
+	delete myBaseType;
+}
+
+RecordTypeNode::~RecordTypeNode(){
+	delete myID;
+}
+
+ArrayTypeNode::~ArrayTypeNode(){
+	delete myElemType;
+}
+
+AssignExpNode::~AssignExpNode(){
+	delete myDst;
+	delete mySrc;
+}
+
+CallStmtNode::~CallStmtNode(){
+	delete myCallExp;
+}
+
+}
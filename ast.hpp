@@ -1,10 +1,12 @@
 #ifndef CMINUSMINUS_AST_HPP
 #define CMINUSMINUS_AST_HPP
 
+#include <cstdint>
 #include <ostream>
 #include <sstream>
 #include <string.h>
 #include <list>
+#include <vector>
 #include "tokens.hpp"
 #include "symbol_table.hpp"
 #include "types.hpp"
@@ -12,11 +14,30 @@
 namespace cminusminus {
 
 class TypeAnalysis;
+class Effects;
+class BoundsCheckElim;
+class Range;
+class ConstFold;
+class CopyProp;
+class CondElim;
+class ScalarPromotion;
+class LoopRotation;
+class ScalarEvolution;
+class DeadArgElim;
+class Compiler;
+class ExpCode;
+class StmtCode;
+class LoopCode;
+class ExpRewriter;
+class ConsKey;
+class NodeStats;
+class Interpreter;
 
 class SymbolTable;
 class SemSymbol;
 
 class DeclNode;
+class FnDeclNode;
 class VarDeclNode;
 class StmtNode;
 class AssignExpNode;
@@ -25,52 +46,187 @@ class TypeNode;
 class ExpNode;
 class LValNode;
 class IDNode;
+class RecordDeclNode;
+class IndexNode;
+class CallExpNode;
+class ReturnStmtNode;
+class ConstDeclNode;
+class StrLitNode;
 
+//Each node owns its children, and deleting it deletes 
+// them. Declarations also own the symbols they create. Once
+// expressions have been shared by hash-consing, the tree is
+// a DAG and is no longer deleted.
 class ASTNode{
 public:
-	ASTNode(Position * pos) : myPos(pos){ }
+	ASTNode(const Position * pos) : myPos(*pos){ }
+	virtual ~ASTNode(){ }
 	virtual void unparse(std::ostream&, int) = 0;
-	Position * pos() { return myPos; };
+	Position * pos() { return &myPos; };
 	std::string posStr(){ return pos()->span(); }
 	virtual bool nameAnalysis(SymbolTable *) = 0;
 	//Note that there is no ASTNode::typeAnalysis. To allow
 	// for different type signatures, type analysis is 
 	// implemented as needed in various subclasses
+	//The checks that type a node once its children have 
+	// been typed. These let names and types be resolved
+	// in a single traversal (see TypeAnalysis::buildFused)
+	virtual void typeRule(TypeAnalysis *){ }
+	//Count the nodes of the subtree, at a depth in the AST
+	virtual void measure(NodeStats * stats, size_t depth);
 protected:
-	Position * myPos = nullptr;
+	Position myPos;
+};
+
+//Brings the global declarations of another file (a module)
+// into scope. Imports may appear anywhere among the global
+// declarations, and the names they import are visible
+// throughout the importing file.
+class ImportNode : public ASTNode{
+public:
+	ImportNode(const Position * p, size_t pathIDIn)
+	: ASTNode(p), myPathID(pathIDIn){ }
+	void unparse(std::ostream&, int) override;
+	bool nameAnalysis(SymbolTable *) override;
+	//The path of the module, as written
+	std::string getPath() const;
+	size_t getPathID() const { return myPathID; }
+private:
+	//The id of the path in the StringPool
+	size_t myPathID;
+};
+
+//The global declarations and imports of a program, as they
+// are collected by the parser
+struct Globals{
+	std::vector<DeclNode *> decls;
+	std::vector<ImportNode *> imports;
 };
 
 class ProgramNode : public ASTNode{
 public:
-	ProgramNode(std::list<DeclNode *> * globalsIn);
+	ProgramNode(std::vector<DeclNode *> globalsIn,
+		std::vector<ImportNode *> importsIn);
+	~ProgramNode();
 	void unparse(std::ostream&, int) override;
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *);
+	void typeRule(TypeAnalysis *) override;
+	void collectRecords(std::list<const RecordType *> * records);
+	void boundsChecks(BoundsCheckElim * bce);
+	void rewriteExps(ExpRewriter * rw);
+	void foldConsts(ConstFold * fold);
+	void propagateCopies(CopyProp * prop);
+	void simplifyConds(CondElim * elim);
+	void promoteGlobals(ScalarPromotion * sp);
+	void rotateLoops(LoopRotation * rot);
+	void closeLoops(ScalarEvolution * scev);
+	void elimDeadArgs(DeadArgElim * dae);
+	//Mark the string literals and import paths of the
+	// program as used
+	void markLive(LiveInterned * live);
+	const std::vector<DeclNode *>& getGlobals() const {
+		return myGlobals;
+	}
+	const std::vector<ImportNode *>& getImports() const {
+		return myImports;
+	}
 private:
-	std::list<DeclNode *> * myGlobals;
+	std::vector<DeclNode *> myGlobals;
+	std::vector<ImportNode *> myImports;
+};
+
+//Rewrites expression trees bottom-up: each expression has
+// its subexpressions rewritten first and is then offered to
+// the rewriter, which returns the node that takes its place
+// (which may be the expression itself)
+class ExpRewriter{
+public:
+	virtual ~ExpRewriter(){ }
+	virtual ExpNode * rewrite(ExpNode * exp) = 0;
+	//Offered each variable used as a location, which the
+	// rewriter may retarget to another variable
+	virtual void rewriteLoc(IDNode * loc){ }
 };
 
 class ExpNode : public ASTNode{
 protected:
-	ExpNode(Position * p) : ASTNode(p){ }
+	ExpNode(const Position * p) : ASTNode(p){ }
 public:
 	virtual void unparseNested(std::ostream& out);
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *);
+	virtual void collectEffects(Effects * effects){ }
+	virtual IDNode * asID(){ return nullptr; }
+	virtual CallExpNode * asCall(){ return nullptr; }
+	virtual LValNode * asLVal(){ return nullptr; }
+	virtual StrLitNode * asStrLit(){ return nullptr; }
+	//Run the expression, giving its value. A record or
+	// array has no value, only a location
+	virtual int64_t eval(Interpreter * interp);
+	//Compile the expression for the second tier of a run
+	virtual ExpCode * compile(Compiler * comp);
+	//Compute the range of integer values the expression
+	// may take, given the facts known to the analysis. 
+	// Returns false if nothing is known.
+	virtual bool valueRange(BoundsCheckElim * bce, Range * range){ 
+		return false; 
+	}
+	//Narrow the facts known to the analysis, given that
+	// the expression evaluated to truth
+	virtual void refine(BoundsCheckElim * bce, bool truth){ }
+	//Rewrite the subexpressions, and then the expression
+	// itself, returning the node that takes its place
+	virtual ExpNode * rewriteExps(ExpRewriter * rw){ 
+		return rw->rewrite(this); 
+	}
+	//A fresh copy of a literal, or nullptr if the 
+	// expression is not a literal
+	virtual ExpNode * copyLiteral(const Position * pos) const { 
+		return nullptr; 
+	}
+	//A fresh copy of the expression, or nullptr if it does
+	// more than read variables and compute with them
+	virtual ExpNode * duplicate() const { return copyLiteral(&myPos); }
+	//Describe the expression for hash-consing, if it is pure
+	// enough that all structurally identical copies of it may
+	// be shared. Returns false otherwise.
+	virtual bool consKey(ConsKey * key) const { return false; }
+	//Let go of the subexpressions, which will outlive the
+	// node when it is deleted
+	virtual void disownChildren(){ }
 };
 
 class LValNode : public ExpNode{
 public:
-	LValNode(Position * p) : ExpNode(p){}
+	LValNode(const Position * p) : ExpNode(p){}
 	void unparse(std::ostream& out, int indent) override = 0;
 	void unparseNested(std::ostream& out) override;
 	void attachSymbol(SemSymbol * symbolIn) { } 
 	bool nameAnalysis(SymbolTable * symTab) override { return false; }
+	//The type of the location, as far as it is known
+	// from the symbols attached during name analysis.
+	// This is what allows fields to be resolved before
+	// type analysis has run.
+	virtual const DataType * resolvedType() const { return nullptr; }
+	//The variable this location is part of, or nullptr if 
+	// the location is reached through a pointer
+	virtual SemSymbol * rootSymbol() const { return nullptr; }
+	//Collect the effects of finding the location (but not
+	// of reading or writing the value stored there)
+	virtual void collectLocEffects(Effects * effects){ }
+	//Rewrite the expressions used to find the location 
+	// (the location itself is never replaced)
+	virtual void rewriteLocExps(ExpRewriter * rw){ }
+	LValNode * asLVal() override { return this; }
+	int64_t eval(Interpreter * interp) override;
+	//The address of the location, as the program runs
+	virtual size_t locate(Interpreter * interp) = 0;
 };
 
 class IDNode : public LValNode{
 public:
-	IDNode(Position * p, std::string nameIn)
+	IDNode(const Position * p, std::string nameIn)
 	: LValNode(p), name(nameIn), mySymbol(nullptr){}
 	std::string getName(){ return name; }
 	void unparse(std::ostream& out, int indent) override;
@@ -78,6 +234,23 @@ public:
 	SemSymbol * getSymbol() const { return mySymbol; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const DataType * resolvedType() const override;
+	IDNode * asID() override { return this; }
+	SemSymbol * rootSymbol() const override { return mySymbol; }
+	//Make the node name another variable
+	void rename(SemSymbol * sym){
+		name = sym->getName();
+		mySymbol = sym;
+	}
+	void collectEffects(Effects * effects) override;
+	void rewriteLocExps(ExpRewriter * rw) override;
+	bool valueRange(BoundsCheckElim * bce, Range * range) override;
+	ExpNode * duplicate() const override;
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
+	size_t locate(Interpreter * interp) override;
 private:
 	std::string name;
 	SemSymbol * mySymbol;
@@ -85,59 +258,164 @@ private:
 
 class TypeNode : public ASTNode{
 public:
-	TypeNode(Position * p) : ASTNode(p){ }
+	TypeNode(const Position * p) : ASTNode(p){ }
 	void unparse(std::ostream&, int) override = 0;
 	virtual const DataType * getType() = 0;
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *);
+	//Output any part of the type that follows the
+	// declared name
+	virtual void unparseSuffix(std::ostream& out){ }
 };
 
 class StmtNode : public ASTNode{
 public:
-	StmtNode(Position * p) : ASTNode(p){ }
+	StmtNode(const Position * p) : ASTNode(p){ }
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *);
+	virtual void collectEffects(Effects * effects){ }
+	virtual void boundsChecks(BoundsCheckElim * bce);
+	virtual void rewriteExps(ExpRewriter * rw){ }
+	//Replace the uses of copies, and note the copies the
+	// statement makes
+	virtual void propagateCopies(CopyProp * prop);
+	//Remove dead copies from any nested bodies, returning
+	// true if the statement itself is dead
+	virtual bool dropDeadCopies(CopyProp * prop){ return false; }
+	//Remove the tests whose outcome the facts known decide,
+	// returning true if the statement is to be replaced by
+	// the statements in replacement
+	virtual bool simplifyConds(CondElim * elim,
+		std::vector<StmtNode *> * replacement);
+	//The condition of a branch, and the statements that
+	// run for each outcome of it (nullptr if none can)
+	virtual ExpNode * branchCond(){ return nullptr; }
+	virtual std::vector<StmtNode *> * arm(bool truth){ return nullptr; }
+	//Keep globals in locals over the loops in the statement,
+	// adding the statements needed before and after it
+	virtual void promoteGlobals(ScalarPromotion * sp,
+		std::vector<StmtNode *> * before, std::vector<StmtNode *> * after){ }
+	//Store promoted globals back before any nested return
+	virtual void storeBeforeReturns(ScalarPromotion * sp){ }
+	virtual bool isReturn() const { return false; }
+	//Rotate the loops in the statement, returning the
+	// statement that takes its place
+	virtual StmtNode * rotateLoops(LoopRotation * rot){ return this; }
+	//Replace the loops in the statement that only count by
+	// the values they leave, returning the statement that
+	// takes its place
+	virtual StmtNode * closeLoops(ScalarEvolution * scev){ return this; }
+	//Note how the statement changes a variable on each
+	// iteration of the loop it is in, returning false if it
+	// does anything else
+	virtual bool addRecurrence(ScalarEvolution * scev){ return false; }
+	//The assignment the statement makes, if it is an
+	// assignment statement
+	virtual AssignExpNode * assignment(){ return nullptr; }
+	//Note the calls whose values the statement discards, or
+	// drop the values returned by functions made void, in
+	// any nested bodies
+	virtual void elimDeadArgs(DeadArgElim * dae){ }
+	virtual ReturnStmtNode * asReturn(){ return nullptr; }
+	virtual DeclNode * asDecl(){ return nullptr; }
+	//Run the statement, returning true if it returned
+	// from the function
+	virtual bool exec(Interpreter * interp);
+	virtual StmtCode * compile(Compiler * comp);
 };
 
 class DeclNode : public StmtNode{
 public:
-	DeclNode(Position * p) : StmtNode(p){ }
+	DeclNode(const Position * p) : StmtNode(p){ }
+	~DeclNode();
 	void unparse(std::ostream& out, int indent) override =0;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual const RecordType * declaredRecord() const { return nullptr; }
+	//The name being declared
+	virtual IDNode * ID() const = 0;
+	virtual FnDeclNode * asFn(){ return nullptr; }
+	virtual ConstDeclNode * asConst(){ return nullptr; }
+	DeclNode * asDecl() override { return this; }
+	//The symbol introduced by the declaration, once
+	// name analysis has created it
+	SemSymbol * getSymbol() const { return mySymbol; }
+protected:
+	//Delete the symbol from any earlier name analysis of
+	// the declaration
+	void dropSymbol(){ 
+		delete mySymbol; 
+		mySymbol = nullptr;
+	}
+	SemSymbol * mySymbol = nullptr;
 };
 
 class VarDeclNode : public DeclNode{
 public:
-	VarDeclNode(Position * p, TypeNode * typeIn, IDNode * IDIn)
+	VarDeclNode(const Position * p, TypeNode * typeIn, IDNode * IDIn)
 	: DeclNode(p), myType(typeIn), myID(IDIn){ }
+	//A new local of a basic type, for passes to hold
+	// values in
+	static VarDeclNode * temp(const Position * p, const DataType * type,
+		const std::string& name);
+	~VarDeclNode();
 	void unparse(std::ostream& out, int indent) override;
-	IDNode * ID(){ return myID; }
+	IDNode * ID() const override { return myID; }
 	TypeNode * getTypeNode(){ return myType; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	void propagateCopies(CopyProp * prop) override;
+	bool dropDeadCopies(CopyProp * prop) override;
+	bool simplifyConds(CondElim * elim,
+		std::vector<StmtNode *> * replacement) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	TypeNode * myType;
 	IDNode * myID;
 };
 
+//A global whose value is fixed by a literal. Uses are
+// replaced by the literal, so no storage is needed.
+class ConstDeclNode : public VarDeclNode{
+public:
+	ConstDeclNode(const Position * p, TypeNode * type, IDNode * id,
+	  ExpNode * initIn)
+	: VarDeclNode(p, type, id), myInit(initIn){ }
+	~ConstDeclNode();
+	void unparse(std::ostream& out, int indent) override;
+	bool nameAnalysis(SymbolTable * symTab) override;
+	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	ConstDeclNode * asConst() override { return this; }
+	ExpNode * getInit() const { return myInit; }
+private:
+	ExpNode * myInit;
+};
+
 class FormalDeclNode : public VarDeclNode{
 public:
-	FormalDeclNode(Position * p, TypeNode * type, IDNode * id) 
+	FormalDeclNode(const Position * p, TypeNode * type, IDNode * id) 
 	: VarDeclNode(p, type, id){ }
 	void unparse(std::ostream& out, int indent) override;
 };
 
 class FnDeclNode : public DeclNode{
 public:
-	FnDeclNode(Position * p, 
+	FnDeclNode(const Position * p, 
 	  TypeNode * retTypeIn, IDNode * idIn,
-	  std::list<FormalDeclNode *> * formalsIn,
-	  std::list<StmtNode *> * bodyIn)
+	  std::vector<FormalDeclNode *> formalsIn,
+	  std::vector<StmtNode *> bodyIn)
 	: DeclNode(p), myRetType(retTypeIn), myID(idIn),
-	  myFormals(formalsIn), myBody(bodyIn){ 
+	  myFormals(std::move(formalsIn)), myBody(std::move(bodyIn)),
+	  myFnType(nullptr){ 
 	}
-	IDNode * ID() const { return myID; }
-	std::list<FormalDeclNode *> * getFormals() const{
+	~FnDeclNode();
+	IDNode * ID() const override { return myID; }
+	FnDeclNode * asFn() override { return this; }
+	const std::vector<FormalDeclNode *>& getFormals() const{
 		return myFormals;
 	}
 	virtual TypeNode * getRetTypeNode() {
@@ -146,141 +424,337 @@ public:
 	void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void boundsChecks(BoundsCheckElim * bce) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	void propagateCopies(CopyProp * prop) override;
+	bool simplifyConds(CondElim * elim,
+		std::vector<StmtNode *> * replacement) override;
+	void promoteGlobals(ScalarPromotion * sp,
+		std::vector<StmtNode *> * before,
+		std::vector<StmtNode *> * after) override;
+	StmtNode * rotateLoops(LoopRotation * rot) override;
+	StmtNode * closeLoops(ScalarEvolution * scev) override;
+	void elimDeadArgs(DeadArgElim * dae) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	//Run the body, in a frame the caller has set up
+	void invoke(Interpreter * interp);
+	StmtCode * compileBody(Compiler * comp);
+	//Remove the formals marked dead, or the return type,
+	// changing the function's type to match
+	void dropFormals(const std::vector<bool>& dead);
+	void dropResult();
 private:
 	TypeNode * myRetType;
 	IDNode * myID;
-	std::list<FormalDeclNode *> * myFormals;
-	std::list<StmtNode *> * myBody;
+	std::vector<FormalDeclNode *> myFormals;
+	std::vector<StmtNode *> myBody;
+	//The function's type, as found by name analysis
+	FnType * myFnType;
+};
+
+class RecordDeclNode : public DeclNode{
+public:
+	RecordDeclNode(const Position * p, IDNode * idIn,
+	  std::vector<VarDeclNode *> fieldsIn)
+	: DeclNode(p), myID(idIn), myFields(std::move(fieldsIn)), 
+	  myType(nullptr){ }
+	~RecordDeclNode();
+	IDNode * ID() const override { return myID; }
+	void unparse(std::ostream& out, int indent) override;
+	bool nameAnalysis(SymbolTable * symTab) override;
+	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const RecordType * declaredRecord() const override { return myType; }
+	void measure(NodeStats * stats, size_t depth) override;
+private:
+	IDNode * myID;
+	std::vector<VarDeclNode *> myFields;
+	RecordType * myType;
 };
 
 class AssignStmtNode : public StmtNode{
 public:
-	AssignStmtNode(Position * p, AssignExpNode * expIn)
+	AssignStmtNode(const Position * p, AssignExpNode * expIn)
 	: StmtNode(p), myExp(expIn){ }
+	~AssignStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void boundsChecks(BoundsCheckElim * bce) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	void propagateCopies(CopyProp * prop) override;
+	bool dropDeadCopies(CopyProp * prop) override;
+	bool simplifyConds(CondElim * elim,
+		std::vector<StmtNode *> * replacement) override;
+	bool addRecurrence(ScalarEvolution * scev) override;
+	AssignExpNode * assignment() override { return myExp; }
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	AssignExpNode * myExp;
 };
 
 class ReadStmtNode : public StmtNode{
 public:
-	ReadStmtNode(Position * p, LValNode * dstIn)
+	ReadStmtNode(const Position * p, LValNode * dstIn)
 	: StmtNode(p), myDst(dstIn){ }
+	~ReadStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	LValNode * myDst;
 };
 
 class WriteStmtNode : public StmtNode{
 public:
-	WriteStmtNode(Position * p, ExpNode * srcIn)
+	WriteStmtNode(const Position * p, ExpNode * srcIn)
 	: StmtNode(p), mySrc(srcIn){ }
+	~WriteStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	ExpNode * mySrc;
 };
 
 class PostDecStmtNode : public StmtNode{
 public:
-	PostDecStmtNode(Position * p, LValNode * lvalIn)
+	PostDecStmtNode(const Position * p, LValNode * lvalIn)
 	: StmtNode(p), myLVal(lvalIn){ }
+	~PostDecStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void boundsChecks(BoundsCheckElim * bce) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	bool addRecurrence(ScalarEvolution * scev) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	LValNode * myLVal;
 };
 
 class PostIncStmtNode : public StmtNode{
 public:
-	PostIncStmtNode(Position * p, LValNode * lvalIn)
+	PostIncStmtNode(const Position * p, LValNode * lvalIn)
 	: StmtNode(p), myLVal(lvalIn){ }
+	~PostIncStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void boundsChecks(BoundsCheckElim * bce) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	bool addRecurrence(ScalarEvolution * scev) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	LValNode * myLVal;
 };
 
 class IfStmtNode : public StmtNode{
 public:
-	IfStmtNode(Position * p, ExpNode * condIn,
-	  std::list<StmtNode *> * bodyIn)
-	: StmtNode(p), myCond(condIn), myBody(bodyIn){ }
+	IfStmtNode(const Position * p, ExpNode * condIn,
+	  std::vector<StmtNode *> bodyIn)
+	: StmtNode(p), myCond(condIn), myBody(std::move(bodyIn)){ }
+	~IfStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void boundsChecks(BoundsCheckElim * bce) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	void propagateCopies(CopyProp * prop) override;
+	bool dropDeadCopies(CopyProp * prop) override;
+	bool simplifyConds(CondElim * elim,
+		std::vector<StmtNode *> * replacement) override;
+	void promoteGlobals(ScalarPromotion * sp,
+		std::vector<StmtNode *> * before,
+		std::vector<StmtNode *> * after) override;
+	void storeBeforeReturns(ScalarPromotion * sp) override;
+	StmtNode * rotateLoops(LoopRotation * rot) override;
+	StmtNode * closeLoops(ScalarEvolution * scev) override;
+	void elimDeadArgs(DeadArgElim * dae) override;
+	ExpNode * branchCond() override;
+	std::vector<StmtNode *> * arm(bool truth) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBody;
+	std::vector<StmtNode *> myBody;
 };
 
 class IfElseStmtNode : public StmtNode{
 public:
-	IfElseStmtNode(Position * p, ExpNode * condIn, 
-	  std::list<StmtNode *> * bodyTrueIn,
-	  std::list<StmtNode *> * bodyFalseIn)
+	IfElseStmtNode(const Position * p, ExpNode * condIn, 
+	  std::vector<StmtNode *> bodyTrueIn,
+	  std::vector<StmtNode *> bodyFalseIn)
 	: StmtNode(p), myCond(condIn),
-	  myBodyTrue(bodyTrueIn), myBodyFalse(bodyFalseIn) { }
+	  myBodyTrue(std::move(bodyTrueIn)), 
+	  myBodyFalse(std::move(bodyFalseIn)) { }
+	~IfElseStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void boundsChecks(BoundsCheckElim * bce) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	void propagateCopies(CopyProp * prop) override;
+	bool dropDeadCopies(CopyProp * prop) override;
+	bool simplifyConds(CondElim * elim,
+		std::vector<StmtNode *> * replacement) override;
+	void promoteGlobals(ScalarPromotion * sp,
+		std::vector<StmtNode *> * before,
+		std::vector<StmtNode *> * after) override;
+	void storeBeforeReturns(ScalarPromotion * sp) override;
+	StmtNode * rotateLoops(LoopRotation * rot) override;
+	StmtNode * closeLoops(ScalarEvolution * scev) override;
+	void elimDeadArgs(DeadArgElim * dae) override;
+	ExpNode * branchCond() override;
+	std::vector<StmtNode *> * arm(bool truth) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBodyTrue;
-	std::list<StmtNode *> * myBodyFalse;
+	std::vector<StmtNode *> myBodyTrue;
+	std::vector<StmtNode *> myBodyFalse;
 };
 
 class WhileStmtNode : public StmtNode{
 public:
-	WhileStmtNode(Position * p, ExpNode * condIn, 
-	  std::list<StmtNode *> * bodyIn)
-	: StmtNode(p), myCond(condIn), myBody(bodyIn){ }
+	WhileStmtNode(const Position * p, ExpNode * condIn, 
+	  std::vector<StmtNode *> bodyIn)
+	: StmtNode(p), myCond(condIn), myBody(std::move(bodyIn)),
+	  myRotated(false){ }
+	~WhileStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void boundsChecks(BoundsCheckElim * bce) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	void propagateCopies(CopyProp * prop) override;
+	bool dropDeadCopies(CopyProp * prop) override;
+	bool simplifyConds(CondElim * elim,
+		std::vector<StmtNode *> * replacement) override;
+	void promoteGlobals(ScalarPromotion * sp,
+		std::vector<StmtNode *> * before,
+		std::vector<StmtNode *> * after) override;
+	void storeBeforeReturns(ScalarPromotion * sp) override;
+	StmtNode * rotateLoops(LoopRotation * rot) override;
+	StmtNode * closeLoops(ScalarEvolution * scev) override;
+	void elimDeadArgs(DeadArgElim * dae) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
+	LoopCode * compileLoop(Compiler * comp);
+	//Whether the loop is only reached once its condition
+	// has been tested, so that it is tested at the bottom
+	bool isRotated() const { return myRotated; }
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBody;
+	std::vector<StmtNode *> myBody;
+	bool myRotated;
 };
 
 class ReturnStmtNode : public StmtNode{
 public:
-	ReturnStmtNode(Position * p, ExpNode * exp)
+	ReturnStmtNode(const Position * p, ExpNode * exp)
 	: StmtNode(p), myExp(exp){ }
+	~ReturnStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	bool isReturn() const override { return true; }
+	ReturnStmtNode * asReturn() override { return this; }
+	ExpNode * getExp() const { return myExp; }
+	void dropExp(){ myExp = nullptr; }
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	ExpNode * myExp;
 };
 
 class CallExpNode : public ExpNode{
 public:
-	CallExpNode(Position * p, IDNode * id,
-	  std::list<ExpNode *> * argsIn)
-	: ExpNode(p), myID(id), myArgs(argsIn){ }
+	CallExpNode(const Position * p, IDNode * id,
+	  std::vector<ExpNode *> argsIn)
+	: ExpNode(p), myID(id), myArgs(std::move(argsIn)){ }
+	~CallExpNode();
+	CallExpNode * asCall() override { return this; }
+	SemSymbol * callee() const;
+	const std::vector<ExpNode *>& getArgs() const { return myArgs; }
+	void setArgs(std::vector<ExpNode *> args){ myArgs = std::move(args); }
 	void unparse(std::ostream& out, int indent) override;
 	void unparseNested(std::ostream& out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	ExpNode * rewriteExps(ExpRewriter * rw) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 private:
 	IDNode * myID;
-	std::list<ExpNode *> * myArgs;
+	std::vector<ExpNode *> myArgs;
 };
 
 class BinaryExpNode : public ExpNode{
 public:
-	BinaryExpNode(Position * p, ExpNode * lhs, ExpNode * rhs)
+	BinaryExpNode(const Position * p, ExpNode * lhs, ExpNode * rhs)
 	: ExpNode(p), myExp1(lhs), myExp2(rhs) { }
+	~BinaryExpNode();
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	ExpNode * rewriteExps(ExpRewriter * rw) override;
+	ExpNode * duplicate() const override;
+	bool consKey(ConsKey * key) const override;
+	void disownChildren() override {
+		myExp1 = nullptr;
+		myExp2 = nullptr;
+	}
+	//The operator, as it is written in the source
+	virtual const char * opString() const = 0;
+	//A new node for the same operator on other operands
+	virtual BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const = 0;
+	ExpCode * compile(Compiler * comp) override;
+	void measure(NodeStats * stats, size_t depth) override;
 protected:
 	ExpNode * myExp1;
 	ExpNode * myExp2;
@@ -288,208 +762,421 @@ protected:
 
 class PlusNode : public BinaryExpNode{
 public:
-	PlusNode(Position * p, ExpNode * e1, ExpNode * e2)
+	PlusNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	bool valueRange(BoundsCheckElim * bce, Range * range) override;
+	const char * opString() const override { return "+"; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new PlusNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class MinusNode : public BinaryExpNode{
 public:
-	MinusNode(Position * p, ExpNode * e1, ExpNode * e2)
+	MinusNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	bool valueRange(BoundsCheckElim * bce, Range * range) override;
+	const char * opString() const override { return "-"; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new MinusNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class TimesNode : public BinaryExpNode{
 public:
-	TimesNode(Position * p, ExpNode * e1In, ExpNode * e2In)
+	TimesNode(const Position * p, ExpNode * e1In, ExpNode * e2In)
 	: BinaryExpNode(p, e1In, e2In){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const char * opString() const override { return "*"; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new TimesNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class DivideNode : public BinaryExpNode{
 public:
-	DivideNode(Position * p, ExpNode * e1, ExpNode * e2)
+	DivideNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const char * opString() const override { return "/"; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new DivideNode(&myPos, lhs, rhs);
+	}
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
 };
 
 class AndNode : public BinaryExpNode{
 public:
-	AndNode(Position * p, ExpNode * e1, ExpNode * e2)
+	AndNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void refine(BoundsCheckElim * bce, bool truth) override;
+	const char * opString() const override { return "and"; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new AndNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class OrNode : public BinaryExpNode{
 public:
-	OrNode(Position * p, ExpNode * e1, ExpNode * e2)
+	OrNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void refine(BoundsCheckElim * bce, bool truth) override;
+	const char * opString() const override { return "or"; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new OrNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class EqualsNode : public BinaryExpNode{
 public:
-	EqualsNode(Position * p, ExpNode * e1, ExpNode * e2)
+	EqualsNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const char * opString() const override { return "=="; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new EqualsNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class NotEqualsNode : public BinaryExpNode{
 public:
-	NotEqualsNode(Position * p, ExpNode * e1, ExpNode * e2)
+	NotEqualsNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const char * opString() const override { return "!="; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new NotEqualsNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class LessNode : public BinaryExpNode{
 public:
-	LessNode(Position * p, ExpNode * e1, ExpNode * e2)
+	LessNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void refine(BoundsCheckElim * bce, bool truth) override;
+	const char * opString() const override { return "<"; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new LessNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class LessEqNode : public BinaryExpNode{
 public:
-	LessEqNode(Position * pos, ExpNode * e1, ExpNode * e2)
+	LessEqNode(const Position * pos, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(pos, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void refine(BoundsCheckElim * bce, bool truth) override;
+	const char * opString() const override { return "<="; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new LessEqNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class GreaterNode : public BinaryExpNode{
 public:
-	GreaterNode(Position * p, ExpNode * e1, ExpNode * e2)
+	GreaterNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void refine(BoundsCheckElim * bce, bool truth) override;
+	const char * opString() const override { return ">"; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new GreaterNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class GreaterEqNode : public BinaryExpNode{
 public:
-	GreaterEqNode(Position * p, ExpNode * e1, ExpNode * e2)
+	GreaterEqNode(const Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
-	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void refine(BoundsCheckElim * bce, bool truth) override;
+	const char * opString() const override { return ">="; }
+	BinaryExpNode * withOperands(ExpNode * lhs,
+		ExpNode * rhs) const override{
+		return new GreaterEqNode(&myPos, lhs, rhs);
+	}
+	int64_t eval(Interpreter * interp) override;
 };
 
 class UnaryExpNode : public ExpNode {
 public:
-	UnaryExpNode(Position * p, ExpNode * expIn) 
+	UnaryExpNode(const Position * p, ExpNode * expIn) 
 	: ExpNode(p){
 		this->myExp = expIn;
 	}
+	~UnaryExpNode();
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	ExpNode * rewriteExps(ExpRewriter * rw) override;
+	void disownChildren() override { myExp = nullptr; }
+	void measure(NodeStats * stats, size_t depth) override;
 protected:
 	ExpNode * myExp;
 };
 
 class RefNode : public UnaryExpNode{
 public:
-	RefNode(Position * p, IDNode * IDIn) 
+	RefNode(const Position * p, IDNode * IDIn) 
 	: UnaryExpNode(p, IDIn), myID(IDIn){
 	}
 	virtual void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	ExpNode * rewriteExps(ExpRewriter * rw) override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 protected:
 	IDNode * myID;
 };
 
 class DerefNode : public LValNode{
 public:
-	DerefNode(Position * p, IDNode * IDIn) 
+	DerefNode(const Position * p, IDNode * IDIn) 
 	: LValNode(p), myID(IDIn){
 	}
+	~DerefNode();
 	virtual void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const DataType * resolvedType() const override;
+	void collectEffects(Effects * effects) override;
+	SemSymbol * rootSymbol() const override { return nullptr; }
+	void collectLocEffects(Effects * effects) override;
+	ExpNode * duplicate() const override;
+	void measure(NodeStats * stats, size_t depth) override;
+	size_t locate(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 protected:
 	IDNode * myID;
 };
 
+class FieldAccessNode : public LValNode{
+public:
+	FieldAccessNode(const Position * p, LValNode * baseIn, IDNode * fieldIn)
+	: LValNode(p), myBase(baseIn), myField(fieldIn){ }
+	~FieldAccessNode();
+	void unparse(std::ostream& out, int indent) override;
+	bool nameAnalysis(SymbolTable * symTab) override;
+	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const DataType * resolvedType() const override;
+	void collectEffects(Effects * effects) override;
+	SemSymbol * rootSymbol() const override { 
+		return myBase->rootSymbol(); 
+	}
+	void collectLocEffects(Effects * effects) override;
+	ExpNode * rewriteExps(ExpRewriter * rw) override;
+	void rewriteLocExps(ExpRewriter * rw) override;
+	ExpNode * duplicate() const override;
+	void measure(NodeStats * stats, size_t depth) override;
+	size_t locate(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
+private:
+	LValNode * myBase;
+	IDNode * myField;
+};
+
+class IndexNode : public LValNode{
+public:
+	IndexNode(const Position * p, LValNode * baseIn, ExpNode * indexIn)
+	: LValNode(p), myBase(baseIn), myIndex(indexIn), myChecked(true){ }
+	~IndexNode();
+	void unparse(std::ostream& out, int indent) override;
+	bool nameAnalysis(SymbolTable * symTab) override;
+	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	const DataType * resolvedType() const override;
+	SemSymbol * rootSymbol() const override { 
+		return myBase->rootSymbol(); 
+	}
+	void collectEffects(Effects * effects) override;
+	void collectLocEffects(Effects * effects) override;
+	//Indexing is bounds-checked unless the check has 
+	// been proven redundant
+	bool isChecked() const { return myChecked; }
+	void checkBounds(BoundsCheckElim * bce);
+	ExpNode * rewriteExps(ExpRewriter * rw) override;
+	void rewriteLocExps(ExpRewriter * rw) override;
+	ExpNode * duplicate() const override;
+	void measure(NodeStats * stats, size_t depth) override;
+	size_t locate(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
+private:
+	LValNode * myBase;
+	ExpNode * myIndex;
+	bool myChecked;
+};
+
 class NegNode : public UnaryExpNode{
 public:
-	NegNode(Position * p, ExpNode * exp)
+	NegNode(const Position * p, ExpNode * exp)
 	: UnaryExpNode(p, exp){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	ExpNode * duplicate() const override;
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 };
 
 class NotNode : public UnaryExpNode{
 public:
-	NotNode(Position * p, ExpNode * exp)
+	NotNode(const Position * p, ExpNode * exp)
 	: UnaryExpNode(p, exp){ }
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void refine(BoundsCheckElim * bce, bool truth) override;
+	ExpNode * duplicate() const override;
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 };
 
 class VoidTypeNode : public TypeNode{
 public:
-	VoidTypeNode(Position * p) : TypeNode(p){}
+	VoidTypeNode(const Position * p) : TypeNode(p){}
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
 };
 
 class PtrTypeNode : public TypeNode{
 public:
-	PtrTypeNode(Position * p, TypeNode * baseTypeIn)
+	PtrTypeNode(const Position * p, TypeNode * baseTypeIn)
 	:TypeNode(p), myBaseType(baseTypeIn) { }
+	~PtrTypeNode();
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
+	bool nameAnalysis(SymbolTable * symTab) override;
 private:
 	TypeNode * myBaseType;
 };
 
+//A use of a record's name as a type. Unlike the other 
+// TypeNodes, the type is not known until name analysis 
+// has found the record's declaration
+class RecordTypeNode : public TypeNode{
+public:
+	RecordTypeNode(const Position * p, IDNode * idIn)
+	: TypeNode(p), myID(idIn), myType(nullptr){ }
+	~RecordTypeNode();
+	void unparse(std::ostream& out, int indent) override;
+	virtual const DataType * getType() override;
+	bool nameAnalysis(SymbolTable * symTab) override;
+private:
+	IDNode * myID;
+	const DataType * myType;
+};
+
+//The type of an array variable. The length is written
+// after the variable's name, so the declaration unparses
+// the suffix itself
+class ArrayTypeNode : public TypeNode{
+public:
+	ArrayTypeNode(const Position * p, TypeNode * elemTypeIn, int lengthIn)
+	: TypeNode(p), myElemType(elemTypeIn), myLength(lengthIn){ }
+	~ArrayTypeNode();
+	void unparse(std::ostream& out, int indent) override;
+	void unparseSuffix(std::ostream& out) override;
+	virtual const DataType * getType() override;
+	bool nameAnalysis(SymbolTable * symTab) override;
+private:
+	TypeNode * myElemType;
+	int myLength;
+};
+
 
 class IntTypeNode : public TypeNode{
 public:
-	IntTypeNode(Position * p): TypeNode(p){}
+	IntTypeNode(const Position * p): TypeNode(p){}
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
 };
 
 class ShortTypeNode : public TypeNode{
 public:
-	ShortTypeNode(Position * p): TypeNode(p){}
+	ShortTypeNode(const Position * p): TypeNode(p){}
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
 };
 
 class BoolTypeNode : public TypeNode{
 public:
-	BoolTypeNode(Position * p): TypeNode(p) { }
+	BoolTypeNode(const Position * p): TypeNode(p) { }
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
 };
 
 class StringTypeNode : public TypeNode{
 public:
-	StringTypeNode(Position * p): TypeNode(p) { }
+	StringTypeNode(const Position * p): TypeNode(p) { }
 	void unparse(std::ostream& out, int indent) override;
 	virtual const DataType * getType() override;
 };
 
 class AssignExpNode : public ExpNode{
 public:
-	AssignExpNode(Position * p, LValNode * dstIn, ExpNode * srcIn)
+	AssignExpNode(const Position * p, LValNode * dstIn, ExpNode * srcIn)
 	: ExpNode(p), myDst(dstIn), mySrc(srcIn){ }
+	~AssignExpNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	LValNode * getDst() const { return myDst; }
+	ExpNode * getSrc() const { return mySrc; }
+	ExpNode * rewriteExps(ExpRewriter * rw) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 private:
 	LValNode * myDst;
 	ExpNode * mySrc;
@@ -497,7 +1184,7 @@ private:
 
 class ShortLitNode : public ExpNode{
 public:
-	ShortLitNode(Position * p, const int numIn)
+	ShortLitNode(const Position * p, const int numIn)
 	: ExpNode(p), myNum(numIn){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
@@ -505,13 +1192,19 @@ public:
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	bool valueRange(BoundsCheckElim * bce, Range * range) override;
+	ExpNode * copyLiteral(const Position * pos) const override;
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 private:
 	const int myNum;
 };
 
 class IntLitNode : public ExpNode{
 public:
-	IntLitNode(Position * p, const int numIn)
+	IntLitNode(const Position * p, const int numIn)
 	: ExpNode(p), myNum(numIn){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
@@ -519,53 +1212,85 @@ public:
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	bool valueRange(BoundsCheckElim * bce, Range * range) override;
+	ExpNode * copyLiteral(const Position * pos) const override;
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 private:
 	const int myNum;
 };
 
 class StrLitNode : public ExpNode{
 public:
-	StrLitNode(Position * p, const std::string strIn)
-	: ExpNode(p), myStr(strIn){ }
+	StrLitNode(const Position * p, size_t strIDIn)
+	: ExpNode(p), myStrID(strIDIn){ }
+	//The id of the literal in the StringPool
+	size_t getStrID() const { return myStrID; }
+	StrLitNode * asStrLit() override { return this; }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	ExpNode * copyLiteral(const Position * pos) const override;
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 private:
-	 const std::string myStr;
+	const size_t myStrID;
 };
 
 class TrueNode : public ExpNode{
 public:
-	TrueNode(Position * p): ExpNode(p){ }
+	TrueNode(const Position * p): ExpNode(p){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	ExpNode * copyLiteral(const Position * pos) const override;
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 };
 
 class FalseNode : public ExpNode{
 public:
-	FalseNode(Position * p): ExpNode(p){ }
+	FalseNode(const Position * p): ExpNode(p){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	ExpNode * copyLiteral(const Position * pos) const override;
+	bool consKey(ConsKey * key) const override;
+	int64_t eval(Interpreter * interp) override;
+	ExpCode * compile(Compiler * comp) override;
 };
 
 class CallStmtNode : public StmtNode{
 public:
-	CallStmtNode(Position * p, CallExpNode * expIn)
+	CallStmtNode(const Position * p, CallExpNode * expIn)
 	: StmtNode(p), myCallExp(expIn){ }
+	~CallStmtNode();
 	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
+	void typeRule(TypeAnalysis *) override;
+	void collectEffects(Effects * effects) override;
+	void rewriteExps(ExpRewriter * rw) override;
+	void elimDeadArgs(DeadArgElim * dae) override;
+	void measure(NodeStats * stats, size_t depth) override;
+	bool exec(Interpreter * interp) override;
+	StmtCode * compile(Compiler * comp) override;
 private:
 	CallExpNode * myCallExp;
 };
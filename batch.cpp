@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "batch.hpp"
+#include "time_report.hpp"
+
+namespace cminusminus{
+
+bool Batch::run(TypeAnalysis * types, const std::vector<std::string>& inputs,
+	std::ostream& out, RunStats * stats, bool tiered){
+	Batch batch(types, inputs, tiered);
+	Stopwatch watch;
+	size_t cores = std::max(1u, std::thread::hardware_concurrency());
+	size_t count = std::min(cores, inputs.size());
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < count; i++){
+		workers.emplace_back(&Batch::work, &batch);
+	}
+	batch.drain(out);
+	for (auto& worker : workers){ worker.join(); }
+	if (batch.myError != nullptr){ std::rethrow_exception(batch.myError); }
+	batch.myStats.seconds = watch.lap();
+	if (stats != nullptr){ *stats = batch.myStats; }
+	return batch.myFailed == 0;
+}
+
+void Batch::work(){
+	while (true){
+		size_t index;
+		{
+			std::lock_guard<std::mutex> guard(myLock);
+			if (myNext == myInputs.size() || myError != nullptr){ return; }
+			index = myNext++;
+		}
+		try {
+			runOne(index);
+		} catch (...){
+			std::lock_guard<std::mutex> guard(myLock);
+			if (myError == nullptr){ myError = std::current_exception(); }
+			myFinished.notify_all();
+			return;
+		}
+	}
+}
+
+void Batch::runOne(size_t index){
+	const std::string& path = myInputs[index];
+	std::ostringstream output;
+	RunStats stats;
+	bool ran = false;
+	std::ifstream in(path);
+	if (in.good()){
+		ran = Interpreter::run(myTypes, in, output, &stats, myTiered, output);
+	} else {
+		output << "Bad input file " << path << "\n";
+	}
+	std::lock_guard<std::mutex> guard(myLock);
+	myOutputs[index] = output.str();
+	myDone[index] = true;
+	myStats.add(stats);
+	if (!ran){ myFailed++; }
+	myFinished.notify_all();
+}
+
+void Batch::drain(std::ostream& out){
+	for (size_t i = 0; i < myInputs.size(); i++){
+		std::string output;
+		{
+			std::unique_lock<std::mutex> lock(myLock);
+			myFinished.wait(lock, [&]{ return myDone[i] || myError != nullptr; });
+			if (!myDone[i]){ return; }
+			output.swap(myOutputs[i]);
+		}
+		out << "==> " << myInputs[i] << " <==\n" << output;
+		//Keep the next header on a line of its own
+		if (!output.empty() && output.back() != '\n'){ out << "\n"; }
+	}
+	out.flush();
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef CMINUSMINUS_BATCH
+#define CMINUSMINUS_BATCH
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "interpreter.hpp"
+
+namespace cminusminus{
+
+class TypeAnalysis;
+
+//Runs a program that has been checked and optimized once
+// over each of many inputs, as --run does over stdin. Every
+// run has memory of its own, so each starts from fresh
+// globals, and the runs share nothing but the AST, which
+// they only read. As many runs go at once as there are
+// cores. The output of each run, along with what it failed
+// with, is kept apart and written under a header naming its
+// input, in the order the inputs were given, as soon as it
+// and every run before it have finished.
+class Batch{
+public:
+	//Returns false if any run failed
+	static bool run(TypeAnalysis * types,
+		const std::vector<std::string>& inputs, std::ostream& out,
+		RunStats * stats, bool tiered);
+private:
+	Batch(TypeAnalysis * types, const std::vector<std::string>& inputs,
+		bool tiered)
+	: myTypes(types), myInputs(inputs), myTiered(tiered),
+	  myOutputs(inputs.size()), myDone(inputs.size(), false),
+	  myNext(0), myFailed(0){ }
+	//Take inputs and run them until there are none left
+	void work();
+	void runOne(size_t index);
+	//Write each output once it is done, in order
+	void drain(std::ostream& out);
+	TypeAnalysis * myTypes;
+	const std::vector<std::string>& myInputs;
+	bool myTiered;
+	std::vector<std::string> myOutputs;
+	std::vector<bool> myDone;
+	size_t myNext;
+	size_t myFailed;
+	RunStats myStats;
+	//What stopped the batch, other than a run failing
+	std::exception_ptr myError;
+	std::mutex myLock;
+	std::condition_variable myFinished;
+};
+
+}
+
+#endif
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Time name and type analysis of a generated program (see 
+# gen_parse.sh), as two passes and as a single fused pass.
+# Usage: check.sh <cmmc> [functions] [runs]
+CMMC=${1:-./cmmc}
+N=${2:-20000}
+RUNS=${3:-5}
+DIR=$(dirname "$0")
+PROG=$(mktemp --suffix=.cmm)
+trap 'rm -f "$PROG"' EXIT
+
+bash "$DIR/gen_parse.sh" "$N" > "$PROG"
+echo "Checking $(wc -l < "$PROG") lines, $RUNS runs"
+TIMEFORMAT="%R"
+for mode in "" "--fused"; do
+	printf "%-10s" "-c $mode"
+	for ((r = 0; r < RUNS; r++)); do
+		{ time "$CMMC" "$PROG" -c $mode > /dev/null 2>&1; } 2>&1
+	done | sort -n | awk '{ t[NR] = $1 } 
+		END { printf "min %.3fs  median %.3fs\n", t[1], t[int((NR + 1) / 2)] }'
+done
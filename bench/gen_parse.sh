@@ -0,0 +1,44 @@
+#!/bin/bash
+# Generate a large, syntactically valid C-- program for timing
+# the front end. The single argument is the number of functions.
+N=${1:-1000}
+cat <<'HDR'
+record point {
+	int x;
+	int y;
+}
+const int LIMIT = 64;
+int table[64];
+HDR
+for ((i = 0; i < N; i++)); do
+cat <<FN
+int work$i(int a, short b, ptr int p){
+	int i;
+	int sum;
+	bool done;
+	point pt;
+	i = 0;
+	sum = 0;
+	done = false;
+	while (i < LIMIT and done == false){
+		table[i] = (a + i) * 3 - sum / 2;
+		sum = sum + table[i];
+		if (sum > 1000 or @p == a){
+			done = true;
+		} else {
+			pt.x = pt.y + i;
+			i++;
+		}
+	}
+	write "work$i done";
+	return sum + pt.x;
+}
+FN
+done
+cat <<'MAIN'
+int main(){
+	int x;
+	x = work0(1, 2S, &x);
+	return x;
+}
+MAIN
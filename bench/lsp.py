@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# Time how long cmmc --lsp takes to publish diagnostics after
+# an edit to a large generated program (see gen_parse.sh).
+# Usage: lsp.py <cmmc> [functions] [edits]
+import json
+import os
+import subprocess
+import sys
+import time
+
+CMMC = sys.argv[1] if len(sys.argv) > 1 else "./cmmc"
+N = int(sys.argv[2]) if len(sys.argv) > 2 else 4800
+EDITS = int(sys.argv[3]) if len(sys.argv) > 3 else 20
+DIR = os.path.dirname(os.path.abspath(__file__))
+URI = "file:///bench.cmm"
+
+text = subprocess.run(["bash", os.path.join(DIR, "gen_parse.sh"), str(N)],
+	capture_output=True, text=True, check=True).stdout
+lines = text.split("\n")
+
+server = subprocess.Popen([CMMC, "--lsp"], stdin=subprocess.PIPE,
+	stdout=subprocess.PIPE)
+
+def send(msg):
+	body = json.dumps(msg).encode()
+	server.stdin.write(b"Content-Length: %d\r\n\r\n" % len(body) + body)
+	server.stdin.flush()
+
+def receive():
+	length = 0
+	while True:
+		line = server.stdout.readline()
+		if line in (b"\r\n", b""):
+			break
+		if line.lower().startswith(b"content-length:"):
+			length = int(line.split(b":")[1])
+	return json.loads(server.stdout.read(length))
+
+def diagnostics():
+	while True:
+		msg = receive()
+		if msg.get("method") == "textDocument/publishDiagnostics":
+			return msg["params"]["diagnostics"]
+
+version = 1
+def change(line, start, end, new):
+	global version
+	version += 1
+	send({"jsonrpc": "2.0", "method": "textDocument/didChange",
+		"params": {"textDocument": {"uri": URI, "version": version},
+		"contentChanges": [{"range": {
+			"start": {"line": line, "character": start},
+			"end": {"line": line, "character": end}}, "text": new}]}})
+
+send({"jsonrpc": "2.0", "id": 1, "method": "initialize",
+	"params": {"capabilities": {}}})
+receive()
+send({"jsonrpc": "2.0", "method": "initialized", "params": {}})
+start = time.perf_counter()
+send({"jsonrpc": "2.0", "method": "textDocument/didOpen",
+	"params": {"textDocument": {"uri": URI, "languageId": "cmm",
+	"version": version, "text": text}}})
+# The generated program type checks, so there should be no
+# diagnostics to begin with
+baseline = len(diagnostics())
+print("Opened %d lines in %.1fms, %d diagnostics" % (len(lines),
+	(time.perf_counter() - start) * 1000, baseline))
+
+# Edit the body of a function in the middle of the file, 
+# which affects only that function, then the name of the
+# function main calls, which affects main too
+middle = lines.index("int work%d(int a, short b, ptr int p){" % (N // 2))
+body = middle + 6
+column = lines[body].index("0")
+called = lines.index("int work0(int a, short b, ptr int p){")
+
+def timed(edit, undo, expect):
+	times = []
+	for _ in range(EDITS):
+		for action, want in ((edit, expect), (undo, baseline)):
+			start = time.perf_counter()
+			action()
+			found = len(diagnostics())
+			times.append((time.perf_counter() - start) * 1000)
+			if found != want:
+				sys.exit("expected %d diagnostics, got %d" % (want, found))
+	times.sort()
+	return "median %.2fms  max %.2fms" % (times[len(times) // 2], times[-1])
+
+print("body edit       ", timed(
+	lambda: change(body, column, column + 1, "true"),
+	lambda: change(body, column, column + 4, "0"), baseline + 1))
+# Only the undeclared name is reported, as by cmmc -c
+print("signature edit  ", timed(
+	lambda: change(called, 4, 9, "renamed"),
+	lambda: change(called, 4, 11, "work0"), 1))
+
+# Each edit writes a literal the server hasn't seen before.
+# Only what the document still contains is kept interned,
+# so the server shouldn't grow with the number of edits
+def rss():
+	with open("/proc/%d/status" % server.pid) as status:
+		for line in status:
+			if line.startswith("VmRSS:"):
+				return int(line.split()[1])
+
+def fresh(rounds, first):
+	for i in range(first, first + rounds):
+		lit = '"' + ("%06d" % i) * 1000 + '"'
+		change(body, column, column + 1, lit)
+		diagnostics()
+		change(body, column, column + len(lit), "0")
+		diagnostics()
+
+fresh(50, 0)
+before = rss()
+fresh(500, 50)
+grown = rss() - before
+print("fresh literals   grew %dKB over 500 edits" % grown)
+if grown > 1024:
+	sys.exit("interned literals are not released")
+
+# Messages missing their params or id are ignored, and the
+# server goes on answering
+send({"jsonrpc": "2.0", "method": "textDocument/didChange"})
+send({"jsonrpc": "2.0", "method": "textDocument/diagnostic",
+	"params": {"textDocument": {"uri": URI}}})
+change(body, column, column + 1, "true")
+if len(diagnostics()) != baseline + 1:
+	sys.exit("malformed messages broke the server")
+change(body, column, column + 4, "0")
+diagnostics()
+
+send({"jsonrpc": "2.0", "id": 2, "method": "shutdown"})
+receive()
+send({"jsonrpc": "2.0", "method": "exit"})
+sys.exit(server.wait())
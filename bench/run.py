@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+# Run the programs in bench/programs under every execution
+# mode of cmmc, checking the output of each against its
+# .out file (with input from its .in file, if it has one).
+# A program with a .err file is expected to fail as it runs,
+# with the diagnostic in that file, and one with a .opt file
+# is expected to be optimized (by the default passes, as -o
+# outputs it) into what that file holds.
+# Reports the time each mode took, and the steps (statements
+# and expressions) it ran per second, as counted by --stats.
+# Usage: run.py <cmmc> [runs] [program ...]
+import os
+import subprocess
+import sys
+import time
+
+CMMC = sys.argv[1] if len(sys.argv) > 1 else "./cmmc"
+RUNS = int(sys.argv[2]) if len(sys.argv) > 2 else 3
+DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "programs")
+PROGRAMS = sys.argv[3:] or sorted(name[:-4] for name in os.listdir(DIR)
+	if name.endswith(".cmm"))
+
+# The rewrites the superoptimizer found for these programs,
+# with cmmc --superopt-search
+RULES = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+	"superopt.rules")
+
+# How many times run-batch runs a program over its input
+BATCH = 4
+
+# Each mode is the flags that run a program a particular way
+MODES = [
+	("run", ["--run"]),
+	("run-unopt", ["--run", "--passes="]),
+	("run-tiered", ["--run", "--tiered"]),
+	("run-super", ["--run", "--passes=fold,dead-args,copy-prop,cond-elim,scev,"
+		"superopt",
+		"--superopt-rules=" + RULES]),
+	("run-batch", ["--run-batch"]),
+	("run-bounds", ["--run", "--passes=fold,dead-args,copy-prop,cond-elim,"
+		"scev,bounds"]),
+	("run-promote", ["--run", "--passes=fold,dead-args,copy-prop,cond-elim,"
+		"scev,promote"]),
+	("run-rotate", ["--run", "--passes=fold,dead-args,rotate,copy-prop,"
+		"cond-elim,scev"]),
+	("tier-rotate", ["--run", "--tiered", "--passes=fold,dead-args,rotate,"
+		"copy-prop,cond-elim,scev"]),
+	("run-shared", ["--run", "--hash-cons"]),
+]
+
+def batchInput(path):
+	return path + ".in" if os.path.exists(path + ".in") else os.devnull
+
+# What a run outputs, with the header run-batch puts above
+# each input's output
+def expectedOutput(program, flags, expected, error):
+	if "--run-batch" not in flags:
+		return expected
+	header = "==> %s <==\n" % batchInput(os.path.join(DIR, program))
+	return (header + expected + error) * BATCH
+
+# Whether a run did what the program's .out and .err files say
+def matches(program, flags, done, expected, error):
+	if done.stdout != expectedOutput(program, flags, expected, error):
+		return False
+	if "--run-batch" in flags:
+		return done.returncode == (1 if error else 0)
+	fatal = "".join(line + "\n" for line in done.stderr.splitlines()
+		if line.startswith("FATAL"))
+	return done.returncode == (1 if error else 0) and fatal == error
+
+def run(program, flags):
+	path = os.path.join(DIR, program)
+	stdin = subprocess.DEVNULL
+	if os.path.exists(path + ".in"):
+		stdin = open(path + ".in")
+	if "--run-batch" in flags:
+		flags = flags + [batchInput(path)] * BATCH
+	start = time.perf_counter()
+	done = subprocess.run([CMMC, path + ".cmm"] + flags + ["--stats"],
+		stdin=stdin, capture_output=True, text=True)
+	wall = time.perf_counter() - start
+	stats = {}
+	for line in done.stderr.splitlines():
+		key, _, value = line.rpartition(" ")
+		stats[key] = value
+	return done, wall, stats
+
+failed = False
+print("%-10s %-11s %9s %9s %12s %10s" % ("program", "mode", "wall ms",
+	"run ms", "steps", "Msteps/s"))
+for program in PROGRAMS:
+	with open(os.path.join(DIR, program + ".out")) as f:
+		expected = f.read()
+	error = ""
+	if os.path.exists(os.path.join(DIR, program + ".err")):
+		with open(os.path.join(DIR, program + ".err")) as f:
+			error = f.read()
+	optPath = os.path.join(DIR, program + ".opt")
+	if os.path.exists(optPath):
+		with open(optPath) as f:
+			optimized = f.read()
+		done = subprocess.run([CMMC, os.path.join(DIR, program + ".cmm"),
+			"-o", "--"], capture_output=True, text=True)
+		if done.returncode != 0 or done.stdout != optimized:
+			print("%-10s %-11s FAILED (exit %d)" % (program, "-o",
+				done.returncode))
+			sys.stderr.write(done.stderr)
+			failed = True
+	for mode, flags in MODES:
+		results = []
+		for _ in range(RUNS):
+			done, wall, stats = run(program, flags)
+			if not matches(program, flags, done, expected, error):
+				print("%-10s %-11s FAILED (exit %d)" % (program, mode,
+					done.returncode))
+				sys.stderr.write(done.stderr)
+				failed = True
+				break
+			results.append((float(stats["seconds"]), wall, int(stats["steps"])))
+		if len(results) < RUNS:
+			continue
+		results.sort()
+		seconds, wall, steps = results[len(results) // 2]
+		print("%-10s %-11s %9.1f %9.1f %12d %10.2f" % (program, mode,
+			wall * 1000, seconds * 1000, steps, steps / seconds / 1e6))
+sys.exit(1 if failed else 0)
@@ -0,0 +1,488 @@
+#include <climits>
+#include <algorithm>
+#include "bounds_check.hpp"
+
+namespace cminusminus{
+
+BoundsCheckElim * BoundsCheckElim::build(TypeAnalysis * typeAnalysis,
+	Remarks * remarks){
+	//Ranges are only sound for a well-typed program, so 
+	// the analysis requires type analysis to be done
+	BoundsCheckElim * bce = new BoundsCheckElim(typeAnalysis);
+	typeAnalysis->ast->boundsChecks(bce);
+	if (remarks != nullptr){ bce->remark(remarks); }
+	return bce;
+}
+
+void BoundsCheckElim::remark(Remarks * remarks){
+	for (auto check : myChecks){
+		if (check->isChecked()){
+			remarks->missed("bounds", check->pos(), 
+				"Bounds check kept, " + myWhy[check]);
+		} else {
+			remarks->applied("bounds", check->pos(), 
+				"Bounds check eliminated, " + myWhy[check]);
+		}
+	}
+}
+
+size_t BoundsCheckElim::eliminated() const{
+	size_t count = 0;
+	for (auto check : myChecks){
+		if (!check->isChecked()){ count++; }
+	}
+	return count;
+}
+
+void BoundsCheckElim::report(std::ostream& out){
+	for (auto check : myChecks){
+		out << check->pos()->span() << ": bounds check " 
+		  << (check->isChecked() ? "kept" : "eliminated") << "\n";
+	}
+	out << eliminated() << " of " << total() 
+	  << " bounds checks eliminated\n";
+}
+
+bool BoundsCheckElim::trackable(SemSymbol * sym){
+	//Variables whose address is taken could change under
+	// any write through a pointer, so they aren't tracked
+	return sym != nullptr && !myAliases.addrTaken(sym);
+}
+
+bool BoundsCheckElim::lookup(SemSymbol * sym, Range * range){
+	auto found = myFacts.find(sym);
+	if (found == myFacts.end()){ return false; }
+	*range = found->second;
+	return true;
+}
+
+void BoundsCheckElim::set(SemSymbol * sym, Range range){
+	if (!trackable(sym)){ return; }
+	if (!range.hasLo && !range.hasHi){ 
+		forget(sym);
+		return;
+	}
+	myFacts[sym] = range;
+}
+
+void BoundsCheckElim::forget(SemSymbol * sym){
+	myFacts.erase(sym);
+}
+
+void BoundsCheckElim::kill(const Effects * effects){
+	for (auto sym : *effects->getModified()){
+		forget(sym);
+	}
+	if (!Aliases::hidden(effects)){ return; }
+	for (auto it = myFacts.begin(); it != myFacts.end(); ){
+		if (myAliases.aliased(it->first)){
+			it = myFacts.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void BoundsCheckElim::join(const Facts& other){
+	Facts joined;
+	for (auto fact : myFacts){
+		auto found = other.find(fact.first);
+		if (found == other.end()){ continue; }
+		Range a = fact.second;
+		Range b = found->second;
+		Range r;
+		r.hasLo = a.hasLo && b.hasLo;
+		r.lo = std::min(a.lo, b.lo);
+		r.hasHi = a.hasHi && b.hasHi;
+		r.hi = std::max(a.hi, b.hi);
+		if (r.hasLo || r.hasHi){ joined[fact.first] = r; }
+	}
+	myFacts = joined;
+}
+
+void BoundsCheckElim::compare(ExpNode * lhs, ExpNode * rhs, bool strict){
+	Range lhsRange;
+	Range rhsRange;
+	bool lhsKnown = lhs->valueRange(this, &lhsRange);
+	bool rhsKnown = rhs->valueRange(this, &rhsRange);
+	long gap = strict ? 1 : 0;
+
+	IDNode * lhsID = lhs->asID();
+	if (lhsID != nullptr && rhsKnown && rhsRange.hasHi){
+		SemSymbol * sym = lhsID->getSymbol();
+		Range r;
+		lookup(sym, &r);
+		long bound = rhsRange.hi - gap;
+		r.hi = r.hasHi ? std::min(r.hi, bound) : bound;
+		r.hasHi = true;
+		set(sym, r);
+	}
+	IDNode * rhsID = rhs->asID();
+	if (rhsID != nullptr && lhsKnown && lhsRange.hasLo){
+		SemSymbol * sym = rhsID->getSymbol();
+		Range r;
+		lookup(sym, &r);
+		long bound = lhsRange.lo + gap;
+		r.lo = r.hasLo ? std::max(r.lo, bound) : bound;
+		r.hasLo = true;
+		set(sym, r);
+	}
+}
+
+bool BoundsCheckElim::fits(const ASTNode * node, const Range& range){
+	return fits(myTypes->nodeType(node), range);
+}
+
+bool BoundsCheckElim::fits(const DataType * type, const Range& range){
+	long min = INT_MIN;
+	long max = INT_MAX;
+	if (type->isShort()){
+		min = SHRT_MIN;
+		max = SHRT_MAX;
+	}
+	if (range.hasLo && (range.lo < min || range.lo > max)){ 
+		return false; 
+	}
+	if (range.hasHi && (range.hi < min || range.hi > max)){ 
+		return false; 
+	}
+	return true;
+}
+
+void BoundsCheckElim::enterFn(const Effects * fnEffects){
+	myFacts.clear();
+	myAliases.enterFn(fnEffects);
+}
+
+void BoundsCheckElim::checkIndexes(const Effects * effects){
+	Facts before = myFacts;
+	kill(effects);
+	for (auto index : *effects->getIndexes()){
+		index->checkBounds(this);
+	}
+	myFacts = before;
+}
+
+void BoundsCheckElim::decide(IndexNode * node, bool safe,
+	const std::string& why){
+	if (mySafe.find(node) == mySafe.end()){
+		myChecks.push_back(node);
+	}
+	mySafe[node] = safe;
+	myWhy[node] = why;
+}
+
+bool BoundsCheckElim::pure(const Effects * effects){
+	return effects->getModified()->empty() 
+	  && !effects->hasCalls() && !effects->hasPtrWrites();
+}
+
+void IndexNode::checkBounds(BoundsCheckElim * bce){
+	const DataType * baseType = myBase->resolvedType();
+	const ArrayType * arrType = nullptr;
+	if (baseType != nullptr){ arrType = baseType->asArray(); }
+
+	Range range;
+	bool known = arrType != nullptr && myIndex->valueRange(bce, &range);
+	long last = known ? static_cast<long>(arrType->getLength()) - 1 : 0;
+	bool safe = known && range.hasLo && range.lo >= 0
+	  && range.hasHi && range.hi <= last;
+	std::string why;
+	if (!known){
+		why = "nothing is known about the index";
+	} else if (safe){
+		why = "the index is from " + std::to_string(range.lo) + " to "
+		  + std::to_string(range.hi);
+	} else if (!range.hasLo || range.lo < 0){
+		why = "the index may be negative";
+	} else {
+		why = "the index may be past the last element "
+		  + std::to_string(last);
+	}
+	//A check proven redundant along one path may still be 
+	// needed on another (e.g. when a loop is re-analyzed),
+	// so the latest decision is the one that stands
+	myChecked = !safe;
+	bce->decide(this, safe, why);
+}
+
+void ProgramNode::boundsChecks(BoundsCheckElim * bce){
+	for (auto decl : myGlobals){
+		SemSymbol * sym = decl->getSymbol();
+		if (sym != nullptr && sym->getKind() == VAR){
+			bce->addGlobal(sym);
+		}
+	}
+	for (auto decl : myGlobals){
+		decl->boundsChecks(bce);
+	}
+}
+
+void StmtNode::boundsChecks(BoundsCheckElim * bce){
+	//Most statements only check their own indexes and then
+	// forget whatever they may have changed
+	Effects effects;
+	collectEffects(&effects);
+	bce->checkIndexes(&effects);
+	bce->kill(&effects);
+}
+
+void FnDeclNode::boundsChecks(BoundsCheckElim * bce){
+	Effects fnEffects;
+	collectEffects(&fnEffects);
+	bce->enterFn(&fnEffects);
+	for (auto stmt : myBody){
+		stmt->boundsChecks(bce);
+	}
+}
+
+void AssignStmtNode::boundsChecks(BoundsCheckElim * bce){
+	//The store itself comes after every index has been
+	// evaluated, so only what is changed on the way to it
+	// matters to the checks
+	Effects valueEffects;
+	myExp->getDst()->collectLocEffects(&valueEffects);
+	myExp->getSrc()->collectEffects(&valueEffects);
+	bce->checkIndexes(&valueEffects);
+	Effects effects;
+	collectEffects(&effects);
+
+	//The value is computed before anything is stored
+	IDNode * dstID = myExp->getDst()->asID();
+	Range range;
+	bool known = dstID != nullptr 
+	  && myExp->getSrc()->valueRange(bce, &range);
+	bce->kill(&effects);
+	if (known){ bce->set(dstID->getSymbol(), range); }
+}
+
+//Shift the range of the variable being stepped, if the 
+// result can't wrap around
+static void step(BoundsCheckElim * bce, LValNode * lval, 
+	Effects * effects, long delta){
+	bce->checkIndexes(effects);
+	IDNode * id = lval->asID();
+	Range range;
+	bool known = id != nullptr && bce->lookup(id->getSymbol(), &range);
+	bce->kill(effects);
+	if (!known){ return; }
+
+	range.lo += delta;
+	range.hi += delta;
+	if (bce->fits(id->getSymbol()->getDataType(), range)){
+		bce->set(id->getSymbol(), range);
+	}
+}
+
+void PostIncStmtNode::boundsChecks(BoundsCheckElim * bce){
+	Effects effects;
+	collectEffects(&effects);
+	step(bce, myLVal, &effects, 1);
+}
+
+void PostDecStmtNode::boundsChecks(BoundsCheckElim * bce){
+	Effects effects;
+	collectEffects(&effects);
+	step(bce, myLVal, &effects, -1);
+}
+
+//Evaluate a branch condition, leaving the facts as they are
+// when the condition has just been found to be truth
+static void branch(BoundsCheckElim * bce, ExpNode * cond, bool truth){
+	Effects condEffects;
+	cond->collectEffects(&condEffects);
+	bce->checkIndexes(&condEffects);
+	bce->kill(&condEffects);
+	if (BoundsCheckElim::pure(&condEffects)){
+		cond->refine(bce, truth);
+	}
+}
+
+void IfStmtNode::boundsChecks(BoundsCheckElim * bce){
+	BoundsCheckElim::Facts before = bce->save();
+	branch(bce, myCond, true);
+	for (auto stmt : myBody){
+		stmt->boundsChecks(bce);
+	}
+	BoundsCheckElim::Facts thenFacts = bce->save();
+
+	bce->restore(before);
+	branch(bce, myCond, false);
+	bce->join(thenFacts);
+}
+
+void IfElseStmtNode::boundsChecks(BoundsCheckElim * bce){
+	BoundsCheckElim::Facts before = bce->save();
+	branch(bce, myCond, true);
+	for (auto stmt : myBodyTrue){
+		stmt->boundsChecks(bce);
+	}
+	BoundsCheckElim::Facts thenFacts = bce->save();
+
+	bce->restore(before);
+	branch(bce, myCond, false);
+	for (auto stmt : myBodyFalse){
+		stmt->boundsChecks(bce);
+	}
+	bce->join(thenFacts);
+}
+
+void WhileStmtNode::boundsChecks(BoundsCheckElim * bce){
+	Effects loopEffects;
+	collectEffects(&loopEffects);
+	BoundsCheckElim::Facts entry = bce->save();
+
+	//Variables that the loop only ever counts upwards keep
+	// their entry lower bound at the loop head (and those
+	// that only count down keep their upper bound). That
+	// only holds if they can't wrap around, which is 
+	// verified after the body has been analyzed.
+	std::list<SemSymbol *> upward;
+	std::list<SemSymbol *> downward;
+	for (auto sym : *loopEffects.getModified()){
+		Range range;
+		if (!bce->lookup(sym, &range)){ continue; }
+		if (loopEffects.defCount(sym) > 0){ continue; }
+		size_t incs = loopEffects.incCount(sym);
+		size_t decs = loopEffects.decCount(sym);
+		if (incs > 0 && decs == 0 && range.hasLo){ 
+			upward.push_back(sym); 
+		}
+		if (decs > 0 && incs == 0 && range.hasHi){ 
+			downward.push_back(sym); 
+		}
+	}
+
+	while (true){
+		bce->restore(entry);
+		bce->kill(&loopEffects);
+		for (auto sym : upward){
+			bce->set(sym, Range::atLeast(entry[sym].lo));
+		}
+		for (auto sym : downward){
+			bce->set(sym, Range::atMost(entry[sym].hi));
+		}
+		BoundsCheckElim::Facts head = bce->save();
+
+		branch(bce, myCond, true);
+		for (auto stmt : myBody){
+			stmt->boundsChecks(bce);
+		}
+
+		//Each induction variable must still be bounded at 
+		// the end of the body, or it may have wrapped around
+		// and the head facts don't hold after all
+		bool sound = true;
+		for (auto it = upward.begin(); it != upward.end(); ){
+			Range range;
+			if (bce->lookup(*it, &range) && range.hasHi){ 
+				++it; 
+			} else {
+				it = upward.erase(it);
+				sound = false;
+			}
+		}
+		for (auto it = downward.begin(); it != downward.end(); ){
+			Range range;
+			if (bce->lookup(*it, &range) && range.hasLo){ 
+				++it; 
+			} else {
+				it = downward.erase(it);
+				sound = false;
+			}
+		}
+		if (sound){ 
+			bce->restore(head);
+			break;
+		}
+	}
+
+	//The loop is left when the condition is false
+	branch(bce, myCond, false);
+}
+
+bool IntLitNode::valueRange(BoundsCheckElim * bce, Range * range){
+	*range = Range(myNum, myNum);
+	return true;
+}
+
+bool ShortLitNode::valueRange(BoundsCheckElim * bce, Range * range){
+	*range = Range(myNum, myNum);
+	return true;
+}
+
+bool IDNode::valueRange(BoundsCheckElim * bce, Range * range){
+	return bce->lookup(mySymbol, range);
+}
+
+bool PlusNode::valueRange(BoundsCheckElim * bce, Range * range){
+	Range r1;
+	Range r2;
+	if (!myExp1->valueRange(bce, &r1)){ return false; }
+	if (!myExp2->valueRange(bce, &r2)){ return false; }
+	Range r;
+	r.hasLo = r1.hasLo && r2.hasLo;
+	r.lo = r1.lo + r2.lo;
+	r.hasHi = r1.hasHi && r2.hasHi;
+	r.hi = r1.hi + r2.hi;
+	//If the sum might overflow, nothing is known at all
+	if (!bce->fits(this, r)){ return false; }
+	*range = r;
+	return r.hasLo || r.hasHi;
+}
+
+bool MinusNode::valueRange(BoundsCheckElim * bce, Range * range){
+	Range r1;
+	Range r2;
+	if (!myExp1->valueRange(bce, &r1)){ return false; }
+	if (!myExp2->valueRange(bce, &r2)){ return false; }
+	Range r;
+	r.hasLo = r1.hasLo && r2.hasHi;
+	r.lo = r1.lo - r2.hi;
+	r.hasHi = r1.hasHi && r2.hasLo;
+	r.hi = r1.hi - r2.lo;
+	if (!bce->fits(this, r)){ return false; }
+	*range = r;
+	return r.hasLo || r.hasHi;
+}
+
+void LessNode::refine(BoundsCheckElim * bce, bool truth){
+	if (truth){ bce->compare(myExp1, myExp2, true); }
+	else { bce->compare(myExp2, myExp1, false); }
+}
+
+void LessEqNode::refine(BoundsCheckElim * bce, bool truth){
+	if (truth){ bce->compare(myExp1, myExp2, false); }
+	else { bce->compare(myExp2, myExp1, true); }
+}
+
+void GreaterNode::refine(BoundsCheckElim * bce, bool truth){
+	if (truth){ bce->compare(myExp2, myExp1, true); }
+	else { bce->compare(myExp1, myExp2, false); }
+}
+
+void GreaterEqNode::refine(BoundsCheckElim * bce, bool truth){
+	if (truth){ bce->compare(myExp2, myExp1, false); }
+	else { bce->compare(myExp1, myExp2, true); }
+}
+
+void AndNode::refine(BoundsCheckElim * bce, bool truth){
+	//Only a true conjunction says anything about both sides
+	if (truth){
+		myExp1->refine(bce, true);
+		myExp2->refine(bce, true);
+	}
+}
+
+void OrNode::refine(BoundsCheckElim * bce, bool truth){
+	if (!truth){
+		myExp1->refine(bce, false);
+		myExp2->refine(bce, false);
+	}
+}
+
+void NotNode::refine(BoundsCheckElim * bce, bool truth){
+	myExp->refine(bce, !truth);
+}
+
+}
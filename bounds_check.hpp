@@ -0,0 +1,103 @@
+#ifndef CMINUSMINUS_BOUNDS_CHECK
+#define CMINUSMINUS_BOUNDS_CHECK
+
+#include <list>
+#include <ostream>
+#include <set>
+#include <string>
+#include "ast.hpp"
+#include "effects.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+//A range of integer values. Either end may be missing, in 
+// which case the range is unbounded in that direction.
+class Range{
+public:
+	Range() : lo(0), hi(0), hasLo(false), hasHi(false){ }
+	Range(long loIn, long hiIn) 
+	: lo(loIn), hi(hiIn), hasLo(true), hasHi(true){ }
+	static Range atLeast(long loIn){
+		Range r; r.lo = loIn; r.hasLo = true; return r;
+	}
+	static Range atMost(long hiIn){
+		Range r; r.hi = hiIn; r.hasHi = true; return r;
+	}
+	long lo;
+	long hi;
+	bool hasLo;
+	bool hasHi;
+};
+
+// Every array index is bounds-checked by default. This pass 
+// removes the checks that a forward range analysis proves can
+// never fail. The analysis tracks an integer range for each 
+// (non-address-taken) variable through each function. Loop
+// induction variables that are only ever incremented keep
+// their lower bound at the loop head, and the loop condition
+// (e.g. i < N) supplies the upper bound inside the body, so 
+// the usual "while (i < N){ a[i] ... i++; }" loops need no
+// checks.
+class BoundsCheckElim{
+public:
+	using Facts = HashMap<SemSymbol *, Range>;
+
+	static BoundsCheckElim * build(TypeAnalysis * typeAnalysis,
+		Remarks * remarks = nullptr);
+	void report(std::ostream& out);
+	size_t eliminated() const;
+	size_t total() const { return myChecks.size(); }
+
+	//Facts about the current point of the analysis
+	bool lookup(SemSymbol * sym, Range * range);
+	void set(SemSymbol * sym, Range range);
+	void forget(SemSymbol * sym);
+	//Drop all facts that the given effects may invalidate
+	void kill(const Effects * effects);
+	Facts save(){ return myFacts; }
+	void restore(const Facts& facts){ myFacts = facts; }
+	//Keep only what holds on both this path and the other
+	void join(const Facts& other);
+
+	//Narrow the facts given that lhs < rhs (or lhs <= rhs
+	// if the comparison isn't strict)
+	void compare(ExpNode * lhs, ExpNode * rhs, bool strict);
+	//Whether the range fits in the type of the node, so 
+	// that computing it could not have overflowed
+	bool fits(const ASTNode * node, const Range& range);
+	bool fits(const DataType * type, const Range& range);
+
+	void addGlobal(SemSymbol * sym){ myAliases.addGlobal(sym); }
+	void enterFn(const Effects * fnEffects);
+	//Decide the checks of the indexes among the effects of
+	// (part of) a statement. An index may be evaluated after
+	// anything else the effects change, such as a variable
+	// assigned earlier in the same expression, so nothing
+	// they may change is relied on
+	void checkIndexes(const Effects * effects);
+	//Decide whether a check is needed, and why
+	void decide(IndexNode * node, bool safe, const std::string& why);
+	//Whether a condition is free of side effects, so that
+	// its outcome can be used to narrow the facts
+	static bool pure(const Effects * effects);
+private:
+	//Note each check kept or eliminated
+	void remark(Remarks * remarks);
+	BoundsCheckElim(TypeAnalysis * typeAnalysis)
+	: myTypes(typeAnalysis){ }
+	bool trackable(SemSymbol * sym);
+	TypeAnalysis * myTypes;
+	Facts myFacts;
+	Aliases myAliases;
+	//Each check in the order first seen, along with 
+	// whether it was eliminated
+	std::list<IndexNode *> myChecks;
+	HashMap<IndexNode *, bool> mySafe;
+	HashMap<IndexNode *, std::string> myWhy;
+};
+
+}
+
+#endif
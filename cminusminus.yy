@@ -10,6 +10,7 @@
 
 %code requires{
 	#include <list>
+	#include <vector>
 	#include "tokens.hpp"
 	#include "ast.hpp"
 	namespace cminusminus {
@@ -48,98 +49,83 @@
   #define yylex scanner.yylex
 }
 
-%union {
-   bool                                  transBool;
-   cminusminus::Token*                         transToken;
-   cminusminus::Token*                         lexeme;
-   cminusminus::IDToken*                       transIDToken;
-   cminusminus::IntLitToken*                   transIntToken;
-   cminusminus::IntLitToken*                   transShortToken;
-   cminusminus::StrToken*                      transStrToken;
-   cminusminus::ProgramNode*                   transProgram;
-   cminusminus::DeclNode *                     transDecl;
-   std::list<cminusminus::DeclNode *> *        transDeclList;
-   cminusminus::VarDeclNode *                  transVarDecl;
-   std::list<cminusminus::VarDeclNode *> *     transVarDeclList;
-   cminusminus::FormalDeclNode *               transFormal;
-   std::list<cminusminus::FormalDeclNode *> *  transFormalList;
-   cminusminus::TypeNode *                     transType;
-   cminusminus::LValNode *                     transLVal;
-   cminusminus::IDNode *                       transID;
-   cminusminus::FnDeclNode *                   transFn;
-   std::list<cminusminus::VarDeclNode *> *     transVarDecls;
-   std::list<cminusminus::StmtNode *> *        transStmts;
-   cminusminus::StmtNode *                     transStmt;
-   cminusminus::ExpNode *                      transExp;
-   cminusminus::AssignExpNode *                transAssignExp;
-   cminusminus::CallExpNode *                  transCallExp;
-   std::list<cminusminus::ExpNode *> *         transActuals;
-}
+%define api.value.type variant
 
 %define parse.assert
 
 %token                   END	   0 "end file"
-%token	<transToken>     AMP
-%token	<transToken>     AND
-%token	<transToken>     ASSIGN
-%token	<transToken>     AT
-%token	<transToken>     BOOL
-%token	<transToken>     COMMA
-%token	<transToken>     DEC
-%token	<transToken>     DIVIDE
-%token	<transToken>     ELSE
-%token	<transToken>     EQUALS
-%token	<transToken>     FALSE
-%token	<transToken>     GREATER
-%token	<transToken>     GREATEREQ
-%token	<transIDToken>   ID
-%token	<transToken>     IF
-%token	<transToken>     INC
-%token	<transToken>     INT
-%token	<transIntToken>  INTLITERAL
-%token	<transToken>     LCURLY
-%token	<transToken>     LESS
-%token	<transToken>     LESSEQ
-%token	<transToken>     LPAREN
-%token	<transToken>     MINUS
-%token	<transToken>     NOT
-%token	<transToken>     NOTEQUALS
-%token	<transToken>     OR
-%token	<transToken>     PLUS
-%token	<transToken>     PTR
-%token	<transToken>     READ
-%token	<transToken>     RETURN
-%token	<transToken>     RCURLY
-%token	<transToken>     RPAREN
-%token	<transToken>     SEMICOL
-%token	<transToken>     SHORT
-%token	<transShortToken> SHORTLITERAL
-%token	<transToken>     STRING
-%token	<transStrToken>  STRLITERAL
-%token	<transToken>     TIMES
-%token	<transToken>     TRUE
-%token	<transToken>     VOID
-%token	<transToken>     WHILE
-%token	<transToken>     WRITE
-
-%type <transProgram> program
-%type <transDeclList> globals
-%type <transDecl> decl
-%type <transVarDecl> varDecl
-%type <transFn> fnDecl
-%type <transLVal> lval
-%type <transExp> term
-%type <transExp> exp
-%type <transActuals> actualsList
-%type <transCallExp> callExp
-%type <transAssignExp> assignExp
-%type <transID> id
-%type <transStmt> stmt
-%type <transStmts> stmtList
-%type <transType> type
-%type <transFormal> formalDecl
-%type <transFormalList> formals
-%type <transType> primType
+%token	<Token>  AMP
+%token	<Token>  AND
+%token	<Token>  ASSIGN
+%token	<Token>  AT
+%token	<Token>  BOOL
+%token	<Token>  COMMA
+%token	<Token>  CONST
+%token	<Token>  DEC
+%token	<Token>  DIVIDE
+%token	<Token>  DOT
+%token	<Token>  ELSE
+%token	<Token>  EQUALS
+%token	<Token>  FALSE
+%token	<Token>  GREATER
+%token	<Token>  GREATEREQ
+%token	<Token>  ID
+%token	<Token>  IF
+%token	<Token>  IMPORT
+%token	<Token>  INC
+%token	<Token>  INT
+%token	<Token>  INTLITERAL
+%token	<Token>  LBRACKET
+%token	<Token>  LCURLY
+%token	<Token>  LESS
+%token	<Token>  LESSEQ
+%token	<Token>  LPAREN
+%token	<Token>  MINUS
+%token	<Token>  NOT
+%token	<Token>  NOTEQUALS
+%token	<Token>  OR
+%token	<Token>  PLUS
+%token	<Token>  PTR
+%token	<Token>  READ
+%token	<Token>  RECORD
+%token	<Token>  RETURN
+%token	<Token>  RBRACKET
+%token	<Token>  RCURLY
+%token	<Token>  RPAREN
+%token	<Token>  SEMICOL
+%token	<Token>  SHORT
+%token	<Token>  SHORTLITERAL
+%token	<Token>  STRING
+%token	<Token>  STRLITERAL
+%token	<Token>  TIMES
+%token	<Token>  TRUE
+%token	<Token>  VOID
+%token	<Token>  WHILE
+%token	<Token>  WRITE
+
+%type <ProgramNode *> program
+%type <Globals> globals
+%type <DeclNode *> decl
+%type <ImportNode *> import
+%type <VarDeclNode *> varDecl
+%type <VarDeclNode *> constDecl
+%type <std::vector<VarDeclNode *>> fields
+%type <RecordDeclNode *> recordDecl
+%type <FnDeclNode *> fnDecl
+%type <LValNode *> lval
+%type <ExpNode *> term
+%type <ExpNode *> literal
+%type <ExpNode *> exp
+%type <std::vector<ExpNode *>> actualsList
+%type <CallExpNode *> callExp
+%type <AssignExpNode *> assignExp
+%type <IDNode *> id
+%type <StmtNode *> stmt
+%type <std::vector<StmtNode *>> stmtList
+%type <TypeNode *> type
+%type <FormalDeclNode *> formalDecl
+%type <std::vector<FormalDeclNode *>> formals
+%type <TypeNode *> primType
 
 /* NOTE: Make sure to add precedence and associativity 
  * declarations
@@ -156,30 +142,56 @@
 
 program 	: globals
 		  {
-		  $$ = new ProgramNode($1);
+		  $$ = new ProgramNode(std::move($1.decls),
+		    std::move($1.imports));
 		  *root = $$;
 		  }
 
 globals 	: globals decl 
 	  	  { 
-	  	  $$ = $1; 
-	  	  DeclNode * declNode = $2;
-		  $$->push_back(declNode);
+	  	  $$ = std::move($1); 
+		  $$.decls.push_back($2);
 	  	  }
+		| globals import
+		  {
+		  $$ = std::move($1);
+		  $$.imports.push_back($2);
+		  }
 		| /* epsilon */
 		  {
-		  $$ = new std::list<DeclNode * >();
+		  }
+
+import		: IMPORT STRLITERAL SEMICOL
+		  {
+		  Position p($1.pos(), $3.pos());
+		  $$ = new ImportNode(&p, $2.strID());
 		  }
 
 decl 		: varDecl
 		  { $$ = $1; }
 		| fnDecl 
 		  { $$ = $1; }
+		| recordDecl
+		  { $$ = $1; }
+		| constDecl
+		  { $$ = $1; }
 
 varDecl 	: type id SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new VarDeclNode(p, $1, $2);
+		  Position p($1->pos(), $2->pos());
+		  $$ = new VarDeclNode(&p, $1, $2);
+		  }
+		| type id LBRACKET INTLITERAL RBRACKET SEMICOL
+		  {
+		  Position p($1->pos(), $5.pos());
+		  TypeNode * arrType = new ArrayTypeNode(&p, $1, $4.num());
+		  $$ = new VarDeclNode(&p, arrType, $2);
+		  }
+
+constDecl	: CONST type id ASSIGN literal SEMICOL
+		  {
+		  Position p($1.pos(), $6.pos());
+		  $$ = new ConstDeclNode(&p, $2, $3, $5);
 		  }
 
 type		: primType
@@ -188,251 +200,256 @@ type		: primType
 		  }
 		| PTR primType
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new PtrTypeNode(p, $2);
+		  Position p($1.pos(), $2->pos());
+		  $$ = new PtrTypeNode(&p, $2);
 		  }
 primType 	: INT
 	  	  { 
-		  $$ = new IntTypeNode($1->pos());
+		  $$ = new IntTypeNode($1.pos());
 		  }
 		| BOOL
 		  {
-		  $$ = new BoolTypeNode($1->pos());
+		  $$ = new BoolTypeNode($1.pos());
 		  }
 		| STRING
 		  {
-		  $$ = new StringTypeNode($1->pos());
+		  $$ = new StringTypeNode($1.pos());
 		  }
 		| SHORT
 		  {
-		  $$ = new ShortTypeNode($1->pos());
+		  $$ = new ShortTypeNode($1.pos());
 		  }
 		| VOID
 		  {
-		  $$ = new VoidTypeNode($1->pos());
+		  $$ = new VoidTypeNode($1.pos());
+		  }
+		| id
+		  {
+		  $$ = new RecordTypeNode($1->pos(), $1);
+		  }
+
+recordDecl	: RECORD id LCURLY fields RCURLY
+		  {
+		  Position p($1.pos(), $5.pos());
+		  $$ = new RecordDeclNode(&p, $2, std::move($4));
+		  }
+
+fields		: varDecl
+		  {
+		  $$.push_back($1);
+		  }
+		| fields varDecl
+		  {
+		  $$ = std::move($1);
+		  $$.push_back($2);
 		  }
 
 fnDecl 		: type id LPAREN RPAREN LCURLY stmtList RCURLY
 		  {
-		  Position * pos = new Position($1->pos(), $7->pos());
-		  std::list<FormalDeclNode *> * f = new std::list<FormalDeclNode *>();
-		  $$ = new FnDeclNode(pos, $1, $2, f, $6);
+		  Position p($1->pos(), $7.pos());
+		  $$ = new FnDeclNode(&p, $1, $2, 
+		    std::vector<FormalDeclNode *>(), std::move($6));
 		  }
 		| type id LPAREN formals RPAREN LCURLY stmtList RCURLY
 		  {
-		  Position * pos = new Position($1->pos(), $8->pos());
-		  $$ = new FnDeclNode(pos, $1, $2, $4, $7);
+		  Position p($1->pos(), $8.pos());
+		  $$ = new FnDeclNode(&p, $1, $2, 
+		    std::move($4), std::move($7));
 		  }
 
 formals 	: formalDecl
 		  {
-		  $$ = new std::list<FormalDeclNode *>();
-		  $$->push_back($1);
+		  $$.push_back($1);
 		  }
 		| formals COMMA formalDecl
 		  {
-		  $$ = $1;
-		  $$->push_back($3);
+		  $$ = std::move($1);
+		  $$.push_back($3);
 		  }
 
 formalDecl 	: type id
 		  {
-		  Position * pos = new Position($1->pos(), $2->pos());
-		  $$ = new FormalDeclNode(pos, $1, $2);
+		  Position p($1->pos(), $2->pos());
+		  $$ = new FormalDeclNode(&p, $1, $2);
 		  }
 
 stmtList 	: /* epsilon */
 	   	  {
-		  $$ = new std::list<StmtNode *>();
 	   	  }
 		| stmtList stmt
 	  	  {
-		  $$ = $1;
-		  $$->push_back($2);
+		  $$ = std::move($1);
+		  $$.push_back($2);
 	  	  }
 
 stmt		: varDecl
 		  {
-		  Position * p = $1->pos();
-		  $$ = new VarDeclNode(p, $1->getTypeNode(), $1->ID());
+		  $$ = $1;
 		  }
 		| assignExp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new AssignStmtNode(p, $1); 
+		  Position p($1->pos(), $2.pos());
+		  $$ = new AssignStmtNode(&p, $1); 
 		  }
 		| lval DEC SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PostDecStmtNode(p, $1);
+		  Position p($1->pos(), $3.pos());
+		  $$ = new PostDecStmtNode(&p, $1);
 		  }
 		| lval INC SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PostIncStmtNode(p, $1);
+		  Position p($1->pos(), $3.pos());
+		  $$ = new PostIncStmtNode(&p, $1);
 		  }
 		| READ lval SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new ReadStmtNode(p, $2);
+		  Position p($1.pos(), $3.pos());
+		  $$ = new ReadStmtNode(&p, $2);
 		  }
 		| WRITE exp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new WriteStmtNode(p, $2);
+		  Position p($1.pos(), $3.pos());
+		  $$ = new WriteStmtNode(&p, $2);
 		  }
 		| WHILE LPAREN exp RPAREN LCURLY stmtList RCURLY
 		  {
-		  Position * p = new Position($1->pos(), $7->pos());
-		  $$ = new WhileStmtNode(p, $3, $6);
+		  Position p($1.pos(), $7.pos());
+		  $$ = new WhileStmtNode(&p, $3, std::move($6));
 		  }
 		| IF LPAREN exp RPAREN LCURLY stmtList RCURLY
 		  {
-		  Position * p = new Position($1->pos(), $7->pos());
-		  $$ = new IfStmtNode(p, $3, $6);
+		  Position p($1.pos(), $7.pos());
+		  $$ = new IfStmtNode(&p, $3, std::move($6));
 		  }
 		| IF LPAREN exp RPAREN LCURLY stmtList RCURLY ELSE LCURLY stmtList RCURLY
 		  {
-		  Position * p = new Position($1->pos(), $11->pos());
-		  $$ = new IfElseStmtNode(p, $3, $6, $10);
+		  Position p($1.pos(), $11.pos());
+		  $$ = new IfElseStmtNode(&p, $3, std::move($6), std::move($10));
 		  }
 		| RETURN exp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new ReturnStmtNode(p, $2);
+		  Position p($1.pos(), $3.pos());
+		  $$ = new ReturnStmtNode(&p, $2);
 		  }
 		| RETURN SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new ReturnStmtNode(p, nullptr);
+		  Position p($1.pos(), $2.pos());
+		  $$ = new ReturnStmtNode(&p, nullptr);
 		  }
 		| callExp SEMICOL
 		  { 
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new CallStmtNode(p, $1); 
+		  Position p($1->pos(), $2.pos());
+		  $$ = new CallStmtNode(&p, $1); 
 		  }
 
 exp		: assignExp 
 		  { $$ = $1; } 
 		| exp MINUS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new MinusNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new MinusNode(&p, $1, $3);
 		  }
 		| exp PLUS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PlusNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new PlusNode(&p, $1, $3);
 		  }
 		| exp TIMES exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new TimesNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new TimesNode(&p, $1, $3);
 		  }
 		| exp DIVIDE exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new DivideNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new DivideNode(&p, $1, $3);
 		  }
 		| exp AND exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new AndNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new AndNode(&p, $1, $3);
 		  }
 		| exp OR exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new OrNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new OrNode(&p, $1, $3);
 		  }
 		| exp EQUALS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new EqualsNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new EqualsNode(&p, $1, $3);
 		  }
 		| exp NOTEQUALS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new NotEqualsNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new NotEqualsNode(&p, $1, $3);
 		  }
 		| exp GREATER exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new GreaterNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new GreaterNode(&p, $1, $3);
 		  }
 		| exp GREATEREQ exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new GreaterEqNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new GreaterEqNode(&p, $1, $3);
 		  }
 		| exp LESS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new LessNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new LessNode(&p, $1, $3);
 		  }
 		| exp LESSEQ exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new LessEqNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new LessEqNode(&p, $1, $3);
 		  }
 		| NOT exp
 	  	  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new NotNode(p, $2);
+		  Position p($1.pos(), $2->pos());
+		  $$ = new NotNode(&p, $2);
 		  }
 		| MINUS term
 	  	  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new NegNode(p, $2);
+		  Position p($1.pos(), $2->pos());
+		  $$ = new NegNode(&p, $2);
 		  }
 		| term
 	  	  { $$ = $1; }
 
 assignExp	: lval ASSIGN exp
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new AssignExpNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new AssignExpNode(&p, $1, $3);
 		  }
 
 callExp		: id LPAREN RPAREN
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  std::list<ExpNode *> * noargs =
-		    new std::list<ExpNode *>();
-		  $$ = new CallExpNode(p, $1, noargs);
+		  Position p($1->pos(), $3.pos());
+		  $$ = new CallExpNode(&p, $1, std::vector<ExpNode *>());
 		  }
 		| id LPAREN actualsList RPAREN
 		  {
-		  Position * p = new Position($1->pos(), $4->pos());
-		  $$ = new CallExpNode(p, $1, $3);
+		  Position p($1->pos(), $4.pos());
+		  $$ = new CallExpNode(&p, $1, std::move($3));
 		  }
 
 actualsList	: exp
 		  {
-		  std::list<ExpNode *> * list =
-		    new std::list<ExpNode *>();
-		  list->push_back($1);
-		  $$ = list;
+		  $$.push_back($1);
 		  }
 		| actualsList COMMA exp
 		  {
-		  $$ = $1;
-		  $$->push_back($3);
+		  $$ = std::move($1);
+		  $$.push_back($3);
 		  }
 
 term 		: lval
 		  { $$ = $1; }
-		| INTLITERAL 
-		  { $$ = new IntLitNode($1->pos(), $1->num()); }
-		| SHORTLITERAL 
-		  { $$ = new ShortLitNode($1->pos(), $1->num()); }
-		| STRLITERAL 
-		  { $$ = new StrLitNode($1->pos(), $1->str()); }
+		| literal
+		  { $$ = $1; }
 		| AMP id
-		  { $$ = new RefNode($1->pos(), $2); }
-		| TRUE
-		  { $$ = new TrueNode($1->pos()); }
-		| FALSE
-		  { $$ = new FalseNode($1->pos()); }
+		  { $$ = new RefNode($1.pos(), $2); }
 		| LPAREN exp RPAREN
 		  { $$ = $2; }
 		| callExp
@@ -440,20 +457,40 @@ term 		: lval
 		  $$ = $1;
 		  }
 
+literal		: INTLITERAL 
+		  { $$ = new IntLitNode($1.pos(), $1.num()); }
+		| SHORTLITERAL 
+		  { $$ = new ShortLitNode($1.pos(), $1.num()); }
+		| STRLITERAL 
+		  { $$ = new StrLitNode($1.pos(), $1.strID()); }
+		| TRUE
+		  { $$ = new TrueNode($1.pos()); }
+		| FALSE
+		  { $$ = new FalseNode($1.pos()); }
+
 lval		: id
 		  {
 		  $$ = $1;
 		  }
 		| AT id
 		  {
-		  Position * pos = new Position($1->pos(), $2->pos());
-		  $$ = new DerefNode(pos, $2);
+		  Position pos($1.pos(), $2->pos());
+		  $$ = new DerefNode(&pos, $2);
+		  }
+		| lval DOT id
+		  {
+		  Position pos($1->pos(), $3->pos());
+		  $$ = new FieldAccessNode(&pos, $1, $3);
+		  }
+		| lval LBRACKET exp RBRACKET
+		  {
+		  Position pos($1->pos(), $4.pos());
+		  $$ = new IndexNode(&pos, $1, $3);
 		  }
 
 id		: ID
 		  {
-		  Position * pos = $1->pos();
-		  $$ = new IDNode(pos, $1->value()); 
+		  $$ = new IDNode($1.pos(), $1.value()); 
 		  }
 	
 %%
@@ -0,0 +1,796 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include "compilation.hpp"
+#include "errors.hpp"
+#include "symbol_table.hpp"
+#include "time_report.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+class Item;
+class NodeQuery;
+class ResolvedQuery;
+class SignatureQuery;
+class TypedQuery;
+
+//The keys of the declarations of a file are spaced this
+// far apart to begin with, leaving room to insert new ones
+static const uint64_t KEY_SPACING = uint64_t(1) << 32;
+
+//Whatever the compiler writes to std::cerr while running,
+// which is where Report::fatal writes diagnostics
+class CaptureErrors{
+public:
+	CaptureErrors() : myOld(std::cerr.rdbuf(myText.rdbuf())){ }
+	~CaptureErrors(){ std::cerr.rdbuf(myOld); }
+	std::string text() const { return myText.str(); }
+private:
+	std::stringstream myText;
+	std::streambuf * myOld;
+};
+
+//Run an analysis of a declaration or import. Whatever the
+// compiler throws is kept as the failure of the analysis,
+// and is reported as cmmc would, but at the node
+template <typename Analysis>
+static bool analyzeAt(ASTNode * node, std::exception_ptr& failure,
+	Analysis analysis){
+	failure = nullptr;
+	std::string msg;
+	try {
+		return analysis();
+	} catch (ToDoError * e){
+		msg = std::string("ToDoError: ") + e->msg();
+		failure = std::current_exception();
+	} catch (InternalError * e){
+		msg = "Something in the compiler is broken: " + e->msg();
+		failure = std::current_exception();
+	} catch (UserError * e){
+		msg = "The user made a mistake: " + e->msg();
+		failure = std::current_exception();
+	}
+	std::cerr << "FATAL " << node->pos()->span() << ": " << msg << "\n";
+	return false;
+}
+
+class SourceInput : public Input{ };
+
+//The global declarations of a file, in order
+class AstQuery : public Query{
+public:
+	AstQuery(SourceFile * file) : myFile(file){ }
+	const std::vector<Item *>& items() const { return myItems; }
+	const std::vector<Item *> * declared(const std::string& name) const {
+		auto found = myDeclared.find(name);
+		if (found == myDeclared.end()){ return nullptr; }
+		return &found->second;
+	}
+	void retireItems(Database * db);
+protected:
+	bool compute(Database * db) override;
+private:
+	//Give the declarations found between two that were kept
+	// the items replaced between them, or new ones
+	void fill(Database * db, const std::vector<Item *>& replaced,
+		const std::vector<std::pair<DeclNode *, Chunk *>>& found,
+		uint64_t low, uint64_t high);
+	Item * item(uint64_t key, DeclNode * decl, Chunk * chunk);
+	SourceFile * myFile;
+	std::vector<Item *> myItems;
+	std::unordered_map<std::string, std::vector<Item *>> myDeclared;
+	bool myRenumber;
+};
+
+//The declarations of a global name in a file, in order.
+// Only the first of them that is added to the global scope
+// is visible to later declarations.
+class DeclarersQuery : public Query{
+public:
+	DeclarersQuery(SourceFile * file, const std::string& name)
+	: myFile(file), myName(name){ }
+	const std::vector<Item *>& items() const { return myItems; }
+protected:
+	bool compute(Database * db) override;
+private:
+	SourceFile * myFile;
+	std::string myName;
+	std::vector<Item *> myItems;
+};
+
+//The names imported by a file, which are visible to all of
+// its declarations
+class ImportsQuery : public Query{
+public:
+	ImportsQuery(SourceFile * file) : myFile(file), myOk(true){ }
+	bool ok() const { return myOk; }
+	SemSymbol * symbol(const std::string& name) const {
+		auto found = myNames.find(name);
+		if (found == myNames.end()){ return nullptr; }
+		return found->second;
+	}
+	//The errors of the imports, with the chunk of each
+	const std::vector<std::pair<Chunk *, Diagnostic>>& errors() const {
+		return myErrs;
+	}
+	//A failure of the compiler is always the last error
+	std::exception_ptr failure() const { return myFailure; }
+protected:
+	bool compute(Database * db) override;
+private:
+	SourceFile * myFile;
+	bool myOk;
+	std::unordered_map<std::string, SemSymbol *> myNames;
+	std::vector<std::pair<Chunk *, Diagnostic>> myErrs;
+	std::exception_ptr myFailure;
+	//Which load of each module was imported, in order
+	std::vector<size_t> myLoads;
+};
+
+//What cmmc -c reports for a file
+class DiagnosticsQuery : public Query{
+public:
+	DiagnosticsQuery(SourceFile * file) : myFile(file),
+	  myParses(false), myPasses(false), myFailureAt(0){ }
+	const std::vector<Diagnostic>& diagnostics() const { return myDiags; }
+	bool parses() const { return myParses; }
+	bool passes() const { return myPasses; }
+	std::exception_ptr failure(size_t * at) const {
+		*at = myFailureAt;
+		return myFailure;
+	}
+protected:
+	bool compute(Database * db) override;
+private:
+	void add(const std::vector<Diagnostic>& diags, Chunk * chunk,
+		std::exception_ptr failure);
+	SourceFile * myFile;
+	std::vector<Diagnostic> myDiags;
+	bool myParses;
+	bool myPasses;
+	//The first failure of the compiler itself, which stops
+	// cmmc, and the index of its diagnostic
+	std::exception_ptr myFailure;
+	size_t myFailureAt;
+};
+
+class SourceFile{
+public:
+	SourceFile(Compilation * compilationIn, const std::string& pathIn,
+	  const std::string& text)
+	: compilation(compilationIn), path(pathIn), doc(new Document(text)),
+	  source(new SourceInput()), ast(new AstQuery(this)),
+	  imports(new ImportsQuery(this)),
+	  diagnostics(new DiagnosticsQuery(this)){ }
+	DeclarersQuery * declarers(const std::string& name){
+		DeclarersQuery *& query = myDeclarers[name];
+		if (query == nullptr){ query = new DeclarersQuery(this, name); }
+		return query;
+	}
+	void retire(Database * db){
+		ast->retireItems(db);
+		for (auto& declarers : myDeclarers){
+			db->retire(declarers.second);
+		}
+		db->retire(diagnostics);
+		db->retire(imports);
+		db->retire(ast);
+		db->retire(source);
+	}
+	~SourceFile(){ delete doc; }
+	Compilation * compilation;
+	//Where the file is, which its imports are relative to
+	std::string path;
+	Document * doc;
+	SourceInput * source;
+	AstQuery * ast;
+	ImportsQuery * imports;
+	DiagnosticsQuery * diagnostics;
+private:
+	std::unordered_map<std::string, DeclarersQuery *> myDeclarers;
+};
+
+//A global declaration of a file. Declarations are told
+// apart by keys, which are in the order of the declarations
+// and stay the same while lines elsewhere are edited. An
+// edited declaration that keeps its place and name keeps
+// its item, and so its queries.
+class Item{
+public:
+	Item(SourceFile * fileIn, uint64_t keyIn, DeclNode * declIn,
+	  Chunk * chunkIn);
+	void retire(Database * db);
+	SourceFile * file;
+	uint64_t key;
+	std::string name;
+	DeclNode * decl;
+	//The chunk of the declaration, to tell where it is now
+	Chunk * chunk;
+	NodeQuery * node;
+	ResolvedQuery * resolved;
+	SignatureQuery * signature;
+	TypedQuery * typed;
+};
+
+//The AST of a declaration, which changes when the lines of
+// the declaration are parsed again
+class NodeQuery : public Query{
+public:
+	NodeQuery(Item * item) : myItem(item), myDecl(nullptr){ }
+protected:
+	bool compute(Database * db) override {
+		db->fetch(myItem->file->ast);
+		bool changed = myItem->decl != myDecl;
+		myDecl = myItem->decl;
+		return changed;
+	}
+private:
+	Item * myItem;
+	DeclNode * myDecl;
+};
+
+//Name analysis of a declaration, in a global scope holding
+// just the names it uses that are declared before it
+class ResolvedQuery : public Query{
+public:
+	ResolvedQuery(Item * item) : myItem(item), myOk(false),
+	  mySymbol(nullptr), mySeconds(0){ }
+	bool ok() const { return myOk; }
+	//The time the last analysis took
+	double seconds() const { return mySeconds; }
+	const std::vector<Diagnostic>& errors() const { return myErrs; }
+	std::exception_ptr failure() const { return myFailure; }
+	//What the declaration added to the global scope, if
+	// anything. It belongs to the declaration
+	SemSymbol * symbol() const { return mySymbol; }
+protected:
+	bool compute(Database * db) override;
+private:
+	Item * myItem;
+	bool myOk;
+	std::vector<Diagnostic> myErrs;
+	std::exception_ptr myFailure;
+	SemSymbol * mySymbol;
+	double mySeconds;
+};
+
+//What other declarations can see of a global: its type and
+// the value of a constant. Each analysis of a record makes
+// a new type for it, so a record's signature changes
+// whenever it is analyzed.
+class SignatureQuery : public Query{
+public:
+	SignatureQuery(Item * item) : myItem(item), mySymbol(nullptr),
+	  myKind(VAR){ }
+	SemSymbol * symbol() const { return mySymbol; }
+protected:
+	bool compute(Database * db) override;
+private:
+	Item * myItem;
+	SemSymbol * mySymbol;
+	SymbolKind myKind;
+	std::string myType;
+	std::string myConstant;
+};
+
+//Type analysis of a declaration whose names all resolved
+class TypedQuery : public Query{
+public:
+	TypedQuery(Item * item) : myItem(item), myPassed(false),
+	  mySeconds(0){ }
+	bool passed() const { return myPassed; }
+	double seconds() const { return mySeconds; }
+	const std::vector<Diagnostic>& errors() const { return myErrs; }
+	std::exception_ptr failure() const { return myFailure; }
+protected:
+	bool compute(Database * db) override;
+private:
+	Item * myItem;
+	bool myPassed;
+	std::vector<Diagnostic> myErrs;
+	std::exception_ptr myFailure;
+	double mySeconds;
+};
+
+Item::Item(SourceFile * fileIn, uint64_t keyIn, DeclNode * declIn,
+  Chunk * chunkIn)
+: file(fileIn), key(keyIn), name(declIn->ID()->getName()),
+  decl(declIn), chunk(chunkIn), node(new NodeQuery(this)),
+  resolved(new ResolvedQuery(this)), signature(new SignatureQuery(this)),
+  typed(new TypedQuery(this)){ }
+
+void Item::retire(Database * db){
+	db->retire(typed);
+	db->retire(signature);
+	db->retire(resolved);
+	db->retire(node);
+}
+
+Item * AstQuery::item(uint64_t key, DeclNode * decl, Chunk * chunk){
+	return new Item(myFile, key, decl, chunk);
+}
+
+void AstQuery::retireItems(Database * db){
+	for (auto item : myItems){
+		item->retire(db);
+		delete item;
+	}
+	myItems.clear();
+	myDeclared.clear();
+}
+
+bool AstQuery::compute(Database * db){
+	db->fetch(myFile->source);
+	std::vector<Item *> old;
+	old.swap(myItems);
+	myDeclared.clear();
+	myRenumber = false;
+
+	//Declarations whose chunks were not parsed again keep
+	// their items, and with them their keys. Those found
+	// between two of them take the place of what was there
+	std::unordered_map<DeclNode *, size_t> kept;
+	for (size_t i = 0; i < old.size(); i++){
+		kept[old[i]->decl] = i;
+	}
+	std::vector<std::pair<DeclNode *, Chunk *>> found;
+	size_t oldAt = 0;
+	uint64_t low = 0;
+	for (auto chunk : myFile->doc->chunks()){
+		for (auto decl : chunk->decls){
+			auto keep = kept.find(decl);
+			if (keep == kept.end()){
+				found.push_back(std::make_pair(decl, chunk));
+				continue;
+			}
+			Item * item = old[keep->second];
+			fill(db, std::vector<Item *>(old.begin() + long(oldAt),
+				old.begin() + long(keep->second)), found, low, item->key);
+			found.clear();
+			item->chunk = chunk;
+			myItems.push_back(item);
+			oldAt = keep->second + 1;
+			low = item->key;
+		}
+	}
+	fill(db, std::vector<Item *>(old.begin() + long(oldAt), old.end()),
+		found, low, 0);
+
+	if (myRenumber){
+		//There was no room for new keys in some place, so
+		// every declaration starts over
+		std::vector<std::pair<DeclNode *, Chunk *>> all;
+		for (auto item : myItems){
+			all.push_back(std::make_pair(item->decl, item->chunk));
+		}
+		retireItems(db);
+		for (size_t i = 0; i < all.size(); i++){
+			myItems.push_back(item((i + 1) * KEY_SPACING,
+				all[i].first, all[i].second));
+		}
+	}
+	for (auto item : myItems){
+		myDeclared[item->name].push_back(item);
+	}
+
+	//Nothing refers to the old ASTs any more
+	for (auto chunk : myFile->doc->takeReplaced()){
+		delete chunk;
+	}
+	return true;
+}
+
+void AstQuery::fill(Database * db, const std::vector<Item *>& replaced,
+	const std::vector<std::pair<DeclNode *, Chunk *>>& found,
+	uint64_t low, uint64_t high){
+	if (replaced.size() == found.size()){
+		for (size_t i = 0; i < found.size(); i++){
+			Item * old = replaced[i];
+			if (old->name == found[i].first->ID()->getName()){
+				old->decl = found[i].first;
+				old->chunk = found[i].second;
+				myItems.push_back(old);
+				continue;
+			}
+			myItems.push_back(item(old->key, found[i].first,
+				found[i].second));
+			old->retire(db);
+			delete old;
+		}
+		return;
+	}
+	for (auto old : replaced){
+		old->retire(db);
+		delete old;
+	}
+	uint64_t step = KEY_SPACING;
+	if (high != 0){
+		step = (high - low) / (found.size() + 1);
+		if (step == 0){ myRenumber = true; }
+	}
+	for (size_t i = 0; i < found.size(); i++){
+		myItems.push_back(item(low + step * (i + 1), found[i].first,
+			found[i].second));
+	}
+}
+
+bool DeclarersQuery::compute(Database * db){
+	db->fetch(myFile->ast);
+	const std::vector<Item *> * declared = myFile->ast->declared(myName);
+	std::vector<Item *> items;
+	if (declared != nullptr){ items = *declared; }
+	bool changed = items != myItems;
+	myItems.swap(items);
+	return changed;
+}
+
+bool ImportsQuery::compute(Database * db){
+	db->fetch(myFile->ast);
+	Compilation * compilation = myFile->compilation;
+	Modules * modules = &compilation->myModules;
+	SymbolTable * symTab = new SymbolTable();
+	symTab->importFrom(modules, myFile->path);
+	ScopeTable * globals = symTab->enterScope();
+	bool ok = true;
+	std::vector<std::pair<Chunk *, Diagnostic>> errs;
+	std::exception_ptr failure;
+	std::vector<Module *> imported;
+	for (auto chunk : myFile->doc->chunks()){
+		if (chunk->root == nullptr || failure){ continue; }
+		for (auto import : chunk->root->getImports()){
+			std::string path = Modules::resolve(myFile->path,
+				import->getPath());
+			db->fetch(compilation->moduleInput(path));
+			std::string text;
+			{
+				CaptureErrors capture;
+				ok = analyzeAt(import, failure, [&](){
+					return import->nameAnalysis(symTab);
+				}) && ok;
+				text = capture.text();
+			}
+			std::vector<Diagnostic> diags;
+			Diagnostic::readFatals(text, diags);
+			for (auto& diag : diags){
+				errs.push_back(std::make_pair(chunk, diag));
+			}
+			//As with cmmc, nothing is analyzed after a
+			// failure of the compiler
+			if (failure){ break; }
+			imported.push_back(modules->load(path));
+		}
+	}
+
+	std::vector<size_t> loads;
+	myNames.clear();
+	for (auto module : imported){
+		loads.push_back(module->serial());
+		for (auto sym : module->exports()){
+			myNames[sym->getName()] = globals->lookup(sym->getName());
+		}
+	}
+	delete symTab;
+	bool changed = loads != myLoads || errs != myErrs || ok != myOk
+		|| failure != myFailure;
+	myLoads.swap(loads);
+	myErrs.swap(errs);
+	myOk = ok;
+	myFailure = failure;
+	return changed;
+}
+
+bool ResolvedQuery::compute(Database * db){
+	db->fetch(myItem->node);
+	db->fetch(myItem->file->imports);
+	DeclNode * decl = myItem->decl;
+	SymbolTable * symTab = new SymbolTable();
+	ScopeTable * globals = symTab->enterScope();
+	for (auto& name : myItem->chunk->names){
+		//Imported names hide any declaration of the file,
+		// which is reported as declaring them again
+		SemSymbol * imported = myItem->file->imports->symbol(name);
+		if (imported != nullptr){
+			globals->insert(imported);
+			continue;
+		}
+		DeclarersQuery * declarers = myItem->file->declarers(name);
+		db->fetch(declarers);
+		for (auto other : declarers->items()){
+			if (other->key >= myItem->key){ break; }
+			db->fetch(other->signature);
+			if (other->signature->symbol() != nullptr){
+				globals->insert(other->signature->symbol());
+				break;
+			}
+		}
+	}
+
+	bool fresh = globals->lookup(myItem->name) == nullptr;
+	std::string errs;
+	{
+		CaptureErrors capture;
+		Stopwatch watch;
+		myOk = analyzeAt(decl, myFailure, [&](){
+			return decl->nameAnalysis(symTab);
+		});
+		mySeconds = watch.lap();
+		errs = capture.text();
+	}
+	while (symTab->getCurrentScope() != globals){
+		symTab->leaveScope();
+	}
+	mySymbol = fresh ? globals->lookup(myItem->name) : nullptr;
+	delete symTab;
+	myErrs.clear();
+	Diagnostic::readFatals(errs, myErrs);
+	return true;
+}
+
+//Write a type so that two types have the same key only if
+// they are the same type. A record is told apart from any
+// record that was in its place in memory before
+static void typeKey(std::ostream& out, const DataType * type){
+	if (type == nullptr){
+		out << "?";
+	} else if (type->asPtr() != nullptr){
+		out << "ptr ";
+		typeKey(out, type->asPtr()->getBase());
+	} else if (type->asArray() != nullptr){
+		out << type->asArray()->getLength() << "[] ";
+		typeKey(out, type->asArray()->getElem());
+	} else if (type->asRecord() != nullptr){
+		out << type->getString() << "#" << type->asRecord()->serial();
+	} else if (type->asFn() != nullptr){
+		for (auto formal : *type->asFn()->getFormalTypes()){
+			typeKey(out, formal);
+			out << ",";
+		}
+		out << "->";
+		typeKey(out, type->asFn()->getReturnType());
+	} else {
+		out << type->getString();
+	}
+}
+
+bool SignatureQuery::compute(Database * db){
+	db->fetch(myItem->resolved);
+	SemSymbol * sym = myItem->resolved->symbol();
+	SymbolKind kind = VAR;
+	std::stringstream type;
+	std::string constant;
+	if (sym != nullptr){
+		kind = sym->getKind();
+		typeKey(type, sym->getDataType());
+		if (sym->getConstant() != nullptr){
+			std::stringstream value;
+			sym->getConstant()->unparse(value, 0);
+			constant = value.str();
+		}
+	}
+	bool changed = (sym == nullptr) != (mySymbol == nullptr)
+		|| kind != myKind || type.str() != myType
+		|| constant != myConstant;
+	mySymbol = sym;
+	myKind = kind;
+	myType = type.str();
+	myConstant.swap(constant);
+	return changed;
+}
+
+bool TypedQuery::compute(Database * db){
+	db->fetch(myItem->node);
+	db->fetch(myItem->resolved);
+	myErrs.clear();
+	myPassed = false;
+	myFailure = nullptr;
+	mySeconds = 0;
+	//Type analysis of unresolved names is never reported,
+	// and would not be safe
+	if (!myItem->resolved->ok()){ return true; }
+
+	DeclNode * decl = myItem->decl;
+	std::string errs;
+	{
+		CaptureErrors capture;
+		Stopwatch watch;
+		myPassed = analyzeAt(decl, myFailure, [&](){
+			TypeAnalysis * ta = TypeAnalysis::build(decl);
+			bool passed = ta->passed();
+			delete ta;
+			return passed;
+		});
+		mySeconds = watch.lap();
+		errs = capture.text();
+	}
+	Diagnostic::readFatals(errs, myErrs);
+	return true;
+}
+
+void DiagnosticsQuery::add(const std::vector<Diagnostic>& diags,
+	Chunk * chunk, std::exception_ptr failure){
+	for (auto& diag : diags){
+		myDiags.push_back(chunk->moved(diag));
+	}
+	if (failure && !myFailure){
+		//The failure is the last diagnostic of the analysis
+		myFailure = failure;
+		myFailureAt = myDiags.size() - 1;
+	}
+}
+
+bool DiagnosticsQuery::compute(Database * db){
+	db->fetch(myFile->ast);
+	Document * doc = myFile->doc;
+	std::vector<Diagnostic> old;
+	old.swap(myDiags);
+	bool oldParses = myParses;
+	bool oldPasses = myPasses;
+	myDiags = doc->lexErrors();
+	myFailure = nullptr;
+	myParses = doc->parses();
+	myPasses = false;
+	//As with cmmc, syntax errors stop the compiler before
+	// name analysis, and name errors stop it before type
+	// analysis
+	if (!myParses){
+		for (auto& diag : doc->parseErrors()){
+			myDiags.push_back(diag);
+		}
+	} else {
+		ImportsQuery * imports = myFile->imports;
+		db->fetch(imports);
+		bool named = imports->ok();
+		for (auto& err : imports->errors()){
+			myDiags.push_back(err.first->moved(err.second));
+		}
+		if (imports->failure()){
+			myFailure = imports->failure();
+			myFailureAt = myDiags.size() - 1;
+		}
+		for (auto item : myFile->ast->items()){
+			db->fetch(item->resolved);
+			named = named && item->resolved->ok();
+			add(item->resolved->errors(), item->chunk,
+				item->resolved->failure());
+		}
+		myPasses = named;
+		for (size_t i = 0; named && i < myFile->ast->items().size(); i++){
+			Item * item = myFile->ast->items()[i];
+			db->fetch(item->typed);
+			myPasses = myPasses && item->typed->passed();
+			add(item->typed->errors(), item->chunk,
+				item->typed->failure());
+		}
+	}
+	return old != myDiags || oldParses != myParses
+		|| oldPasses != myPasses;
+}
+
+Compilation::~Compilation(){
+	while (!myFiles.empty()){
+		removeSource(myFiles.begin()->first);
+	}
+	for (auto& input : myModuleInputs){
+		myDB.retire(input.second);
+	}
+}
+
+std::string Compilation::pathOf(const std::string& file){
+	const std::string scheme = "file://";
+	if (file.compare(0, scheme.length(), scheme) == 0){
+		return file.substr(scheme.length());
+	}
+	return file;
+}
+
+Input * Compilation::moduleInput(const std::string& path){
+	Input *& input = myModuleInputs[path];
+	if (input == nullptr){ input = new Input(); }
+	return input;
+}
+
+void Compilation::saved(const std::string& file){
+	for (auto& path : myModules.forget(Modules::resolve("", pathOf(file)))){
+		auto input = myModuleInputs.find(path);
+		if (input != myModuleInputs.end()){ myDB.set(input->second); }
+	}
+}
+
+void Compilation::setSource(const std::string& file,
+	const std::string& text){
+	SourceFile *& src = myFiles[file];
+	if (src == nullptr){
+		src = new SourceFile(this, pathOf(file), text);
+	} else {
+		src->doc->reload(text);
+	}
+	myDB.set(src->source);
+}
+
+void Compilation::editSource(const std::string& file, size_t startLine,
+	size_t startCol, size_t endLine, size_t endCol,
+	const std::string& text){
+	SourceFile * src = source(file);
+	src->doc->edit(startLine, startCol, endLine, endCol, text);
+	myDB.set(src->source);
+}
+
+void Compilation::removeSource(const std::string& file){
+	SourceFile * src = source(file);
+	myFiles.erase(file);
+	src->retire(&myDB);
+	delete src;
+}
+
+void Compilation::releaseUnused(){
+	if (Token::internedBytes() <= 2 * myInternedBytes){ return; }
+	LiveInterned live;
+	for (auto& file : myFiles){
+		file.second->doc->markLive(&live);
+	}
+	myModules.markLive(&live);
+	Token::release(live);
+	myInternedBytes = Token::internedBytes();
+}
+
+SourceFile * Compilation::source(const std::string& file){
+	auto found = myFiles.find(file);
+	if (found == myFiles.end()){
+		throw new InternalError("No such source file");
+	}
+	return found->second;
+}
+
+bool Compilation::parses(const std::string& file){
+	SourceFile * src = source(file);
+	myDB.fetch(src->diagnostics);
+	return src->diagnostics->parses();
+}
+
+bool Compilation::passes(const std::string& file){
+	SourceFile * src = source(file);
+	myDB.fetch(src->diagnostics);
+	return src->diagnostics->passes();
+}
+
+const std::vector<Diagnostic>& Compilation::diagnostics(
+	const std::string& file){
+	SourceFile * src = source(file);
+	myDB.fetch(src->diagnostics);
+	return src->diagnostics->diagnostics();
+}
+
+void Compilation::timeFns(const std::string& file, TimeReport * report){
+	SourceFile * src = source(file);
+	myDB.fetch(src->diagnostics);
+	for (auto item : src->ast->items()){
+		FnDeclNode * fn = item->decl->asFn();
+		if (fn == nullptr){ continue; }
+		//What the chunk took is shared by its declarations
+		Chunk * chunk = item->chunk;
+		double share = 1.0 / chunk->decls.size();
+		TimeReport::Fn times;
+		times.name = item->name;
+		times.line = fn->pos()->line() + chunk->first - chunk->parsedAt;
+		times.seconds[TimeReport::LEX] = chunk->lexSeconds * share;
+		times.seconds[TimeReport::PARSE] = chunk->parseSeconds * share;
+		times.seconds[TimeReport::NAMES] = item->resolved->seconds();
+		times.seconds[TimeReport::TYPES] = item->typed->seconds();
+		NodeStats stats;
+		fn->measure(&stats, 0);
+		times.nodes = stats.nodes;
+		times.depth = stats.maxDepth;
+		report->add(times);
+	}
+}
+
+std::exception_ptr Compilation::failure(const std::string& file,
+	size_t * at){
+	SourceFile * src = source(file);
+	myDB.fetch(src->diagnostics);
+	return src->diagnostics->failure(at);
+}
+
+}
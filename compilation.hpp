@@ -0,0 +1,88 @@
+#ifndef CMINUSMINUS_COMPILATION
+#define CMINUSMINUS_COMPILATION
+
+#include <exception>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "document.hpp"
+#include "modules.hpp"
+#include "query.hpp"
+
+namespace cminusminus{
+
+class ImportsQuery;
+class SourceFile;
+class TimeReport;
+
+//The compiler as queries over a set of source files, each
+// computed only when something asks for it and kept for as
+// long as what it was computed from is unchanged. The
+// queries are
+//  ast(file): the global declarations of a file, of which
+//   only those on edited lines are lexed and parsed again
+//  imports(file): the names imported by a file, which only
+//   change when the interface of a module they are from
+//   does
+//  signature(decl): what other declarations can see of a
+//   global, which only changes when its type does
+//  resolved(decl), typed(decl): name and type analysis of
+//   a global declaration, which are done again once the
+//   declaration or a signature it uses changes
+//  diagnostics(file): what cmmc -c reports for the file
+class Compilation{
+public:
+	Compilation() : myInternedBytes(0){ }
+	~Compilation();
+	//Set the text of a file. The new text is compared with
+	// the old, so only the lines that differ are lexed again
+	void setSource(const std::string& file, const std::string& text);
+	//Replace the text between two (0-based) positions
+	void editSource(const std::string& file, size_t startLine,
+		size_t startCol, size_t endLine, size_t endCol,
+		const std::string& text);
+	void removeSource(const std::string& file);
+	//Note that a file was written, and so may have changed
+	// as a module. Modules are read from disk, and only
+	// read again once saved
+	void saved(const std::string& file);
+	bool hasSource(const std::string& file) const {
+		return myFiles.count(file) > 0;
+	}
+	//Whether the file parses, and whether it also passes
+	// name and type analysis
+	bool parses(const std::string& file);
+	bool passes(const std::string& file);
+	const std::vector<Diagnostic>& diagnostics(const std::string& file);
+	//The first error of the compiler itself while analyzing
+	// the file, if any, and the index of its diagnostic. cmmc
+	// stops there
+	std::exception_ptr failure(const std::string& file, size_t * at);
+	//Add the time each function of the file took to lex,
+	// parse and analyze, as last done
+	void timeFns(const std::string& file, TimeReport * report);
+	//Release the interned text of IDs and the literals that
+	// no file or module uses any longer. Since ids are shared
+	// by the whole process, nothing else may hold them. This
+	// is only done once as much has been interned again as
+	// was kept the last time, so it takes no longer than
+	// interning did
+	void releaseUnused();
+private:
+	friend class ImportsQuery;
+	SourceFile * source(const std::string& file);
+	//The path of a file, which may be given as a file URI
+	static std::string pathOf(const std::string& file);
+	//Set when the module at a path changes
+	Input * moduleInput(const std::string& path);
+	Database myDB;
+	Modules myModules;
+	std::unordered_map<std::string, SourceFile *> myFiles;
+	std::unordered_map<std::string, Input *> myModuleInputs;
+	//The size of what was kept interned by the last release
+	size_t myInternedBytes;
+};
+
+}
+
+#endif
@@ -0,0 +1,464 @@
+#include <cstdint>
+#include <string>
+#include "cond_elim.hpp"
+#include "hash_cons.hpp"
+
+namespace cminusminus{
+
+CondElim * CondElim::build(ProgramNode * ast, Remarks * remarks){
+	CondElim * elim = new CondElim(remarks);
+	ast->simplifyConds(elim);
+	return elim;
+}
+
+bool CondElim::same(const ExpNode * a, const ExpNode * b){
+	if (a == b){ return true; }
+	ConsKey keyA;
+	ConsKey keyB;
+	if (!a->consKey(&keyA) || !b->consKey(&keyB)){ return false; }
+	if (keyA.op != keyB.op || keyA.sym != keyB.sym
+	  || keyA.num != keyB.num){
+		return false;
+	}
+	if ((keyA.lhs == nullptr) != (keyB.lhs == nullptr)){ return false; }
+	if ((keyA.rhs == nullptr) != (keyB.rhs == nullptr)){ return false; }
+	if (keyA.lhs != nullptr && !same(keyA.lhs, keyB.lhs)){ return false; }
+	if (keyA.rhs != nullptr && !same(keyA.rhs, keyB.rhs)){ return false; }
+	return true;
+}
+
+bool CondElim::pure(const ExpNode * exp){
+	ConsKey key;
+	if (!exp->consKey(&key)){ return false; }
+	if (key.lhs != nullptr && !pure(key.lhs)){ return false; }
+	if (key.rhs != nullptr && !pure(key.rhs)){ return false; }
+	return true;
+}
+
+void CondElim::usesOf(const ExpNode * exp,
+	std::set<const SemSymbol *> * uses){
+	ConsKey key;
+	if (!exp->consKey(&key)){ return; }
+	if (key.sym != nullptr){ uses->insert(key.sym); }
+	if (key.lhs != nullptr){ usesOf(key.lhs, uses); }
+	if (key.rhs != nullptr){ usesOf(key.rhs, uses); }
+}
+
+void CondElim::enterFn(const Effects * fnEffects){
+	myFacts = Facts();
+	myArmsOf = nullptr;
+	myAliases.enterFn(fnEffects);
+}
+
+void CondElim::simplify(std::vector<StmtNode *>& body){
+	size_t i = 0;
+	while (i < body.size()){
+		Facts before = save();
+		std::vector<StmtNode *> replacement;
+		if (body[i]->simplifyConds(this, &replacement)){
+			//The statements that replace a branch are
+			// simplified in turn
+			body.erase(body.begin() + static_cast<long>(i));
+			body.insert(body.begin() + static_cast<long>(i),
+				replacement.begin(), replacement.end());
+			continue;
+		}
+		if (thread(body, i)){
+			//The arms of the branch have grown, so it is
+			// simplified again
+			restore(before);
+			continue;
+		}
+		i++;
+	}
+}
+
+bool CondElim::thread(std::vector<StmtNode *>& body, size_t i){
+	if (myArmsOf != body[i] || i + 1 >= body.size()){ return false; }
+	myArmsOf = nullptr;
+	StmtNode * first = body[i];
+	StmtNode * next = body[i + 1];
+	const ExpNode * cond = next->branchCond();
+	if (cond == nullptr){ return false; }
+
+	Facts after = save();
+	bool onTrue = false;
+	bool onFalse = false;
+	restore(myArms[0]);
+	bool knownOnTrue = decide(cond, &onTrue);
+	restore(myArms[1]);
+	bool knownOnFalse = decide(cond, &onFalse);
+	restore(after);
+	if (!knownOnTrue || !knownOnFalse){ return false; }
+
+	auto at = body.begin() + static_cast<long>(i + 1);
+	if (onTrue == onFalse){
+		//Either way the same arm runs, which takes the place
+		// of the branch (and is simplified next)
+		std::vector<StmtNode *> * taken = next->arm(onTrue);
+		if (declares(taken)){ return false; }
+		at = body.erase(at);
+		if (taken != nullptr){
+			body.insert(at, taken->begin(), taken->end());
+			taken->clear();
+		}
+		decided(next, onTrue);
+		return false;
+	}
+
+	std::vector<StmtNode *> * intoTrue = first->arm(true);
+	std::vector<StmtNode *> * intoFalse = first->arm(false);
+	if (intoFalse == nullptr){ return false; }
+	std::vector<StmtNode *> * fromTrue = next->arm(onTrue);
+	std::vector<StmtNode *> * fromFalse = next->arm(onFalse);
+	if (declares(fromTrue) || declares(fromFalse)){ return false; }
+	if (fromTrue != nullptr){
+		intoTrue->insert(intoTrue->end(), fromTrue->begin(), fromTrue->end());
+		fromTrue->clear();
+	}
+	if (fromFalse != nullptr){
+		intoFalse->insert(intoFalse->end(), fromFalse->begin(),
+			fromFalse->end());
+		fromFalse->clear();
+	}
+	body.erase(at);
+	myThreaded++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("cond-elim", next->pos(), "Threaded the"
+			" branch into the arms of the one before it, at the end"
+			" of each of which its outcome is known");
+	}
+	return true;
+}
+
+bool CondElim::declares(const std::vector<StmtNode *> * arm){
+	if (arm == nullptr){ return false; }
+	for (auto stmt : *arm){
+		if (stmt->asDecl() != nullptr){ return true; }
+	}
+	return false;
+}
+
+bool CondElim::decide(const ExpNode * cond, bool * truth){
+	long result = 0;
+	if (!value(cond, &result)){ return false; }
+	*truth = result != 0;
+	return true;
+}
+
+//Keep a value within the range of an int, as the program
+// computing it would
+static long wrap(long value){
+	return static_cast<int32_t>(static_cast<uint32_t>(value));
+}
+
+bool CondElim::value(const ExpNode * exp, long * result){
+	for (auto& cond : myFacts.conds){
+		if (same(cond.exp, exp)){
+			*result = cond.truth ? 1 : 0;
+			return true;
+		}
+	}
+	ConsKey key;
+	if (!exp->consKey(&key)){ return false; }
+	const std::string& op = key.op;
+	if (op == "id"){
+		auto found = myFacts.values.find(key.sym);
+		if (found == myFacts.values.end()){ return false; }
+		*result = found->second;
+		return true;
+	}
+	if (op == "int" || op == "short"){
+		*result = key.num;
+		return true;
+	}
+	if (op == "true" || op == "false"){
+		*result = op == "true" ? 1 : 0;
+		return true;
+	}
+
+	long lhs = 0;
+	long rhs = 0;
+	if (key.lhs == nullptr || !value(key.lhs, &lhs)){ return false; }
+	if (op == "!"){
+		*result = lhs == 0 ? 1 : 0;
+		return true;
+	}
+	if (op == "neg"){
+		*result = wrap(-lhs);
+		return true;
+	}
+	//The right operand of and and or is only evaluated if
+	// the left one doesn't decide the outcome
+	if (op == "and" && lhs == 0){
+		*result = 0;
+		return true;
+	}
+	if (op == "or" && lhs != 0){
+		*result = 1;
+		return true;
+	}
+	if (key.rhs == nullptr || !value(key.rhs, &rhs)){ return false; }
+	if (op == "and" || op == "or"){ *result = rhs != 0 ? 1 : 0; }
+	else if (op == "+"){ *result = wrap(lhs + rhs); }
+	else if (op == "-"){ *result = wrap(lhs - rhs); }
+	else if (op == "*"){ *result = wrap(lhs * rhs); }
+	else if (op == "/"){
+		//Leave failing divisions to happen as the program runs
+		if (rhs == 0 || rhs == -1){ return false; }
+		*result = wrap(lhs / rhs);
+	}
+	else if (op == "=="){ *result = lhs == rhs; }
+	else if (op == "!="){ *result = lhs != rhs; }
+	else if (op == "<"){ *result = lhs < rhs; }
+	else if (op == "<="){ *result = lhs <= rhs; }
+	else if (op == ">"){ *result = lhs > rhs; }
+	else if (op == ">="){ *result = lhs >= rhs; }
+	else { return false; }
+	return true;
+}
+
+void CondElim::learn(const ExpNode * cond, bool truth){
+	ConsKey key;
+	if (!cond->consKey(&key)){ return; }
+	if (key.op == "!"){
+		learn(key.lhs, !truth);
+		return;
+	}
+	if ((key.op == "and" && truth) || (key.op == "or" && !truth)){
+		learn(key.lhs, truth);
+		learn(key.rhs, truth);
+	}
+	if (!pure(cond)){ return; }
+
+	Cond fact;
+	fact.exp = cond;
+	fact.truth = truth;
+	usesOf(cond, &fact.uses);
+	myFacts.conds.push_back(fact);
+
+	//A variable tested on its own is a bool, and one
+	// compared equal to a constant has its value
+	if (key.op == "id"){
+		assigned(key.sym, truth ? 1 : 0);
+	}
+	bool equal = (key.op == "==" && truth) || (key.op == "!=" && !truth);
+	if (!equal){ return; }
+	ConsKey lhsKey;
+	ConsKey rhsKey;
+	long num = 0;
+	key.lhs->consKey(&lhsKey);
+	key.rhs->consKey(&rhsKey);
+	if (lhsKey.op == "id" && value(key.rhs, &num)){
+		assigned(lhsKey.sym, num);
+	} else if (rhsKey.op == "id" && value(key.lhs, &num)){
+		assigned(rhsKey.sym, num);
+	}
+}
+
+void CondElim::assigned(const SemSymbol * sym, long value){
+	myFacts.values[sym] = value;
+}
+
+void CondElim::kill(const Effects * effects){
+	bool hidden = Aliases::hidden(effects);
+	std::set<const SemSymbol *> modified(effects->getModified()->begin(),
+		effects->getModified()->end());
+	auto dead = [&](const SemSymbol * sym){
+		return (hidden && myAliases.aliased(sym)) || modified.count(sym) > 0;
+	};
+	auto& conds = myFacts.conds;
+	for (auto it = conds.begin(); it != conds.end(); ){
+		bool killed = false;
+		for (auto sym : it->uses){
+			if (dead(sym)){ killed = true; }
+		}
+		it = killed ? conds.erase(it) : it + 1;
+	}
+	auto& values = myFacts.values;
+	for (auto it = values.begin(); it != values.end(); ){
+		if (dead(it->first)){
+			it = values.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void CondElim::join(const Facts& other){
+	auto& conds = myFacts.conds;
+	for (auto it = conds.begin(); it != conds.end(); ){
+		bool both = false;
+		for (auto& cond : other.conds){
+			if (cond.truth == it->truth && same(cond.exp, it->exp)){
+				both = true;
+			}
+		}
+		it = both ? it + 1 : conds.erase(it);
+	}
+	auto& values = myFacts.values;
+	for (auto it = values.begin(); it != values.end(); ){
+		auto found = other.values.find(it->first);
+		if (found == other.values.end() || found->second != it->second){
+			it = values.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void CondElim::decided(StmtNode * branch, bool truth){
+	myRemoved++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("cond-elim", branch->pos(), "Removed a test"
+			" whose outcome is always " + std::string(truth ? "true" : "false")
+			+ " here");
+	}
+}
+
+void ProgramNode::simplifyConds(CondElim * elim){
+	for (auto decl : myGlobals){
+		SemSymbol * sym = decl->getSymbol();
+		if (sym != nullptr && sym->getKind() == VAR){
+			elim->addGlobal(sym);
+		}
+	}
+	for (auto decl : myGlobals){
+		std::vector<StmtNode *> replacement;
+		decl->simplifyConds(elim, &replacement);
+	}
+}
+
+bool StmtNode::simplifyConds(CondElim * elim,
+	std::vector<StmtNode *> * replacement){
+	Effects effects;
+	collectEffects(&effects);
+	elim->kill(&effects);
+	return false;
+}
+
+bool VarDeclNode::simplifyConds(CondElim * elim,
+	std::vector<StmtNode *> * replacement){
+	//Each time a declaration is reached, the variable
+	// starts out afresh
+	Effects effects;
+	effects.def(myID);
+	elim->kill(&effects);
+	return false;
+}
+
+bool FnDeclNode::simplifyConds(CondElim * elim,
+	std::vector<StmtNode *> * replacement){
+	Effects fnEffects;
+	collectEffects(&fnEffects);
+	elim->enterFn(&fnEffects);
+	elim->simplify(myBody);
+	return false;
+}
+
+bool AssignStmtNode::simplifyConds(CondElim * elim,
+	std::vector<StmtNode *> * replacement){
+	long value = 0;
+	bool known = elim->value(myExp->getSrc(), &value);
+	Effects effects;
+	collectEffects(&effects);
+	elim->kill(&effects);
+	IDNode * dst = myExp->getDst()->asID();
+	if (known && dst != nullptr){
+		elim->assigned(dst->getSymbol(), value);
+	}
+	return false;
+}
+
+//Evaluate a branch condition, leaving the facts as they
+// are just before the branch is taken
+static void branch(CondElim * elim, ExpNode * cond){
+	Effects condEffects;
+	cond->collectEffects(&condEffects);
+	elim->kill(&condEffects);
+}
+
+bool IfStmtNode::simplifyConds(CondElim * elim,
+	std::vector<StmtNode *> * replacement){
+	bool truth = false;
+	if (elim->decide(myCond, &truth)
+	  && !(truth && CondElim::declares(&myBody))){
+		if (truth){ replacement->swap(myBody); }
+		elim->decided(this, truth);
+		return true;
+	}
+	branch(elim, myCond);
+	CondElim::Facts before = elim->save();
+	elim->learn(myCond, true);
+	elim->simplify(myBody);
+	CondElim::Facts onTrue = elim->save();
+
+	elim->restore(before);
+	elim->learn(myCond, false);
+	CondElim::Facts onFalse = elim->save();
+	elim->join(onTrue);
+	elim->arms(this, onTrue, onFalse);
+	return false;
+}
+
+bool IfElseStmtNode::simplifyConds(CondElim * elim,
+	std::vector<StmtNode *> * replacement){
+	bool truth = false;
+	if (elim->decide(myCond, &truth)
+	  && !CondElim::declares(truth ? &myBodyTrue : &myBodyFalse)){
+		replacement->swap(truth ? myBodyTrue : myBodyFalse);
+		elim->decided(this, truth);
+		return true;
+	}
+	branch(elim, myCond);
+	CondElim::Facts before = elim->save();
+	elim->learn(myCond, true);
+	elim->simplify(myBodyTrue);
+	CondElim::Facts onTrue = elim->save();
+
+	elim->restore(before);
+	elim->learn(myCond, false);
+	elim->simplify(myBodyFalse);
+	CondElim::Facts onFalse = elim->save();
+	elim->join(onTrue);
+	elim->arms(this, onTrue, onFalse);
+	return false;
+}
+
+bool WhileStmtNode::simplifyConds(CondElim * elim,
+	std::vector<StmtNode *> * replacement){
+	//A loop whose condition is false on entry never runs
+	bool truth = false;
+	if (elim->decide(myCond, &truth) && !truth){
+		elim->decided(this, truth);
+		return true;
+	}
+	Effects loopEffects;
+	collectEffects(&loopEffects);
+	elim->kill(&loopEffects);
+	CondElim::Facts head = elim->save();
+	elim->learn(myCond, true);
+	elim->simplify(myBody);
+
+	elim->restore(head);
+	elim->learn(myCond, false);
+	return false;
+}
+
+ExpNode * IfStmtNode::branchCond(){
+	return myCond;
+}
+
+std::vector<StmtNode *> * IfStmtNode::arm(bool truth){
+	return truth ? &myBody : nullptr;
+}
+
+ExpNode * IfElseStmtNode::branchCond(){
+	return myCond;
+}
+
+std::vector<StmtNode *> * IfElseStmtNode::arm(bool truth){
+	return truth ? &myBodyTrue : &myBodyFalse;
+}
+
+}
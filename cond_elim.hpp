@@ -0,0 +1,107 @@
+#ifndef CMINUSMINUS_COND_ELIM
+#define CMINUSMINUS_COND_ELIM
+
+#include <set>
+#include <vector>
+#include "ast.hpp"
+#include "effects.hpp"
+#include "remarks.hpp"
+
+namespace cminusminus{
+
+// Removes the tests of branches whose outcome is already
+// known. Along each path through a function, the analysis
+// keeps the conditions known to be true or false (having
+// been tested on the way) and the variables known to equal
+// a constant (from tests like x == 3, or from assignments).
+// An if whose condition is known is replaced by the arm that
+// runs, and a loop known not to run is removed. A branch that
+// directly follows another, and whose outcome is known at the
+// end of each arm of the first, is threaded: each of its arms
+// moves to the end of the arm of the first branch that leads
+// to it, so that its test is never made.
+class CondElim{
+public:
+	//A condition that was tested, and the variables its
+	// outcome depends on
+	struct Cond{
+		const ExpNode * exp;
+		bool truth;
+		std::set<const SemSymbol *> uses;
+	};
+	struct Facts{
+		std::vector<Cond> conds;
+		HashMap<const SemSymbol *, long> values;
+	};
+
+	static CondElim * build(ProgramNode * ast,
+		Remarks * remarks = nullptr);
+	size_t removed() const { return myRemoved; }
+	size_t threaded() const { return myThreaded; }
+
+	void addGlobal(SemSymbol * sym){ myAliases.addGlobal(sym); }
+	void enterFn(const Effects * fnEffects);
+	//Simplify the statements of a body in order, as the
+	// facts flow through them
+	void simplify(std::vector<StmtNode *>& body);
+	//Whether the value of a condition is known, and if so
+	// what it is
+	bool decide(const ExpNode * cond, bool * truth);
+	//Whether the value of an expression is known to be a
+	// constant, and if so what it is
+	bool value(const ExpNode * exp, long * result);
+	//Add the facts that follow from a condition having the
+	// given outcome
+	void learn(const ExpNode * cond, bool truth);
+	//Note that a variable now holds a constant
+	void assigned(const SemSymbol * sym, long value);
+	//Drop all facts that the given effects may invalidate
+	void kill(const Effects * effects);
+	Facts save(){ return myFacts; }
+	void restore(const Facts& facts){ myFacts = facts; }
+	//Keep only the facts that hold on both paths
+	void join(const Facts& other);
+	//Note the facts at the end of each arm of the branch
+	// just simplified, which let the branch after it be
+	// threaded (an if has no false arm, so its end is
+	// where the condition was false)
+	void arms(StmtNode * branch, const Facts& onTrue,
+		const Facts& onFalse){
+		myArms[0] = onTrue;
+		myArms[1] = onFalse;
+		myArmsOf = branch;
+	}
+	//Note that a branch had a known outcome, and was
+	// replaced by its arm that runs
+	void decided(StmtNode * branch, bool truth);
+	//Whether an arm declares locals, which are scoped to it
+	// and so keep it from being moved into another body
+	static bool declares(const std::vector<StmtNode *> * arm);
+private:
+	CondElim(Remarks * remarks)
+	: myRemarks(remarks), myArmsOf(nullptr), myRemoved(0),
+	  myThreaded(0){ }
+	//Whether two pure expressions are the same
+	static bool same(const ExpNode * a, const ExpNode * b);
+	//Whether an expression only reads variables and
+	// computes with what it reads
+	static bool pure(const ExpNode * exp);
+	//The variables an expression reads
+	static void usesOf(const ExpNode * exp,
+		std::set<const SemSymbol *> * uses);
+	//Thread the branch at body[i + 1] into the arms of the
+	// one at body[i], if its outcome is known in each.
+	// Returns true if the arms of body[i] have grown
+	bool thread(std::vector<StmtNode *>& body, size_t i);
+	Remarks * myRemarks;
+	Facts myFacts;
+	Facts myArms[2];
+	StmtNode * myArmsOf;
+	Aliases myAliases;
+	size_t myRemoved;
+	size_t myThreaded;
+};
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include <sstream>
+#include "const_fold.hpp"
+
+namespace cminusminus{
+
+ConstFold * ConstFold::build(TypeAnalysis * typeAnalysis,
+	Remarks * remarks){
+	ConstFold * fold = new ConstFold(typeAnalysis, remarks);
+	typeAnalysis->ast->foldConsts(fold);
+	return fold;
+}
+
+ExpNode * ConstFold::rewrite(ExpNode * exp){
+	IDNode * use = exp->asID();
+	if (use == nullptr || use->getSymbol() == nullptr){ return exp; }
+	ExpNode * value = use->getSymbol()->getConstant();
+	if (value == nullptr){ return exp; }
+
+	ExpNode * lit = value->copyLiteral(use->pos());
+	myTypes->nodeType(lit, myTypes->nodeType(use));
+	myFolded++;
+	if (myRemarks != nullptr){
+		std::stringstream text;
+		lit->unparse(text, 0);
+		myRemarks->applied("fold", use->pos(), "Replaced "
+			+ use->getName() + " by its value " + text.str());
+	}
+	return lit;
+}
+
+void ConstFold::removeDecl(DeclNode * decl){
+	myRemoved++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("fold", decl->pos(), "Removed constant "
+			+ decl->ID()->getName() + ", whose uses are all folded");
+	}
+}
+
+void ProgramNode::foldConsts(ConstFold * fold){
+	for (auto it = myGlobals.begin(); it != myGlobals.end(); ){
+		SemSymbol * sym = (*it)->getSymbol();
+		if (sym != nullptr && sym->getConstant() != nullptr){
+			fold->removeDecl(*it);
+			it = myGlobals.erase(it);
+		} else {
+			(*it)->rewriteExps(fold);
+			++it;
+		}
+	}
+}
+
+ExpNode * ShortLitNode::copyLiteral(const Position * pos) const{
+	return new ShortLitNode(pos, myNum);
+}
+
+ExpNode * IntLitNode::copyLiteral(const Position * pos) const{
+	return new IntLitNode(pos, myNum);
+}
+
+ExpNode * StrLitNode::copyLiteral(const Position * pos) const{
+	return new StrLitNode(pos, myStrID);
+}
+
+ExpNode * TrueNode::copyLiteral(const Position * pos) const{
+	return new TrueNode(pos);
+}
+
+ExpNode * FalseNode::copyLiteral(const Position * pos) const{
+	return new FalseNode(pos);
+}
+
+}
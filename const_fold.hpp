@@ -0,0 +1,37 @@
+#ifndef CMINUSMINUS_CONST_FOLD
+#define CMINUSMINUS_CONST_FOLD
+
+#include "ast.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+// Replaces every use of a constant global by an immediate
+// copy of its literal value. Since type analysis rejects any
+// write to a constant (or taking its address), no use can
+// observe anything but the initializer, and once all uses 
+// have been replaced the declarations themselves (and their
+// storage) are dropped from the program.
+class ConstFold : public ExpRewriter{
+public:
+	static ConstFold * build(TypeAnalysis * typeAnalysis,
+		Remarks * remarks = nullptr);
+	//Replace a use of a constant by its literal value
+	ExpNode * rewrite(ExpNode * exp) override;
+	size_t folded() const { return myFolded; }
+	size_t removed() const { return myRemoved; }
+	void removeDecl(DeclNode * decl);
+private:
+	ConstFold(TypeAnalysis * typeAnalysis, Remarks * remarks) 
+	: myTypes(typeAnalysis), myRemarks(remarks), myFolded(0),
+	  myRemoved(0){ }
+	TypeAnalysis * myTypes;
+	Remarks * myRemarks;
+	size_t myFolded;
+	size_t myRemoved;
+};
+
+}
+
+#endif
@@ -0,0 +1,276 @@
+#include "copy_prop.hpp"
+
+namespace cminusminus{
+
+CopyProp * CopyProp::build(TypeAnalysis * typeAnalysis,
+	Remarks * remarks){
+	CopyProp * prop = new CopyProp(typeAnalysis, remarks);
+	typeAnalysis->ast->propagateCopies(prop);
+	return prop;
+}
+
+ExpNode * CopyProp::rewrite(ExpNode * exp){
+	IDNode * use = exp->asID();
+	if (use == nullptr){ return exp; }
+	auto found = myCopies.find(use->getSymbol());
+	if (found == myCopies.end()){ return exp; }
+
+	SemSymbol * src = found->second;
+	IDNode * replacement = new IDNode(use->pos(), src->getName());
+	replacement->attachSymbol(src);
+	myTypes->nodeType(replacement, myTypes->nodeType(use));
+	myReplaced++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("copy-prop", use->pos(), "Replaced "
+			+ use->getName() + " by " + src->getName()
+			+ ", which it holds a copy of");
+	}
+	return replacement;
+}
+
+bool CopyProp::isLocal(SemSymbol * sym) const{
+	return sym != nullptr && sym->getKind() == VAR
+	  && !myAliases.isGlobal(sym);
+}
+
+bool CopyProp::isScalar(SemSymbol * sym) const{
+	const DataType * type = sym->getDataType();
+	return type != nullptr && type->asError() == nullptr
+	  && !type->isRecord() && !type->isArray();
+}
+
+void CopyProp::enterFn(const Effects * fnEffects){
+	myCopies.clear();
+	myAliases.enterFn(fnEffects);
+}
+
+void CopyProp::copied(SemSymbol * dst, SemSymbol * src){
+	if (!isLocal(dst) || myAliases.aliased(dst) || !isScalar(dst)){ return; }
+	if (src == nullptr || src == dst || src->getKind() != VAR){ return; }
+	if (!isScalar(src)){ return; }
+	myCopies[dst] = src;
+}
+
+void CopyProp::kill(const Effects * effects){
+	bool hidden = Aliases::hidden(effects);
+	for (auto it = myCopies.begin(); it != myCopies.end(); ){
+		if (effects->modifies(it->first) || effects->modifies(it->second)
+		  || (hidden && myAliases.aliased(it->second))){
+			it = myCopies.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void CopyProp::join(const Copies& other){
+	for (auto it = myCopies.begin(); it != myCopies.end(); ){
+		auto found = other.find(it->first);
+		if (found == other.end() || found->second != it->second){
+			it = myCopies.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void CopyProp::finishFn(std::vector<StmtNode *>& body){
+	Effects after;
+	for (auto stmt : body){
+		stmt->collectEffects(&after);
+	}
+	myUnread.clear();
+	for (auto sym : *after.getModified()){
+		if (isLocal(sym) && !myAliases.aliased(sym) && !after.uses(sym)){
+			myUnread.insert(sym);
+		}
+	}
+	prune(body);
+	myUnread.clear();
+
+	Effects left;
+	for (auto stmt : body){
+		stmt->collectEffects(&left);
+	}
+	myLeft = &left;
+	prune(body);
+	myLeft = nullptr;
+}
+
+void CopyProp::prune(std::vector<StmtNode *>& body){
+	for (auto it = body.begin(); it != body.end(); ){
+		if ((*it)->dropDeadCopies(this)){
+			it = body.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+bool CopyProp::deadCopy(AssignExpNode * exp){
+	IDNode * dst = exp->getDst()->asID();
+	if (dst == nullptr || myUnread.count(dst->getSymbol()) == 0){
+		return false;
+	}
+	//Only copies of variables and literals are dropped,
+	// since computing anything else may fail as the
+	// program runs
+	ExpNode * src = exp->getSrc();
+	ExpNode * lit = src->copyLiteral(src->pos());
+	bool copy = src->asID() != nullptr || lit != nullptr;
+	delete lit;
+	if (!copy){ return false; }
+
+	myEliminated++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("copy-prop", exp->pos(), "Removed copy into "
+			+ dst->getName() + ", whose value is never read");
+	}
+	return true;
+}
+
+bool CopyProp::deadLocal(VarDeclNode * decl){
+	SemSymbol * sym = decl->getSymbol();
+	if (myLeft == nullptr || sym == nullptr){ return false; }
+	if (myLeft->uses(sym) || myLeft->modifies(sym)
+	  || myLeft->addrTaken(sym)){
+		return false;
+	}
+	myRemoved++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("copy-prop", decl->pos(), "Removed local "
+			+ sym->getName() + ", which is no longer used");
+	}
+	return true;
+}
+
+void ProgramNode::propagateCopies(CopyProp * prop){
+	for (auto decl : myGlobals){
+		SemSymbol * sym = decl->getSymbol();
+		if (sym != nullptr && sym->getKind() == VAR){
+			prop->addGlobal(sym);
+		}
+	}
+	for (auto decl : myGlobals){
+		decl->propagateCopies(prop);
+	}
+}
+
+void StmtNode::propagateCopies(CopyProp * prop){
+	//Anything the statement changes may change before its
+	// own uses are evaluated, so copies of it are dropped
+	// before the uses are replaced
+	Effects effects;
+	collectEffects(&effects);
+	prop->kill(&effects);
+	rewriteExps(prop);
+}
+
+void VarDeclNode::propagateCopies(CopyProp * prop){
+	//Each time a declaration is reached, the variable
+	// starts out as zero again
+	Effects effects;
+	effects.def(myID);
+	prop->kill(&effects);
+}
+
+void FnDeclNode::propagateCopies(CopyProp * prop){
+	Effects fnEffects;
+	collectEffects(&fnEffects);
+	prop->enterFn(&fnEffects);
+	for (auto stmt : myBody){
+		stmt->propagateCopies(prop);
+	}
+	prop->finishFn(myBody);
+}
+
+void AssignStmtNode::propagateCopies(CopyProp * prop){
+	//The value is stored only once it has been computed,
+	// so the store itself can't change what the uses see
+	Effects valueEffects;
+	myExp->getDst()->collectLocEffects(&valueEffects);
+	myExp->getSrc()->collectEffects(&valueEffects);
+	prop->kill(&valueEffects);
+	myExp->rewriteExps(prop);
+
+	Effects effects;
+	collectEffects(&effects);
+	prop->kill(&effects);
+	IDNode * dst = myExp->getDst()->asID();
+	IDNode * src = myExp->getSrc()->asID();
+	if (dst != nullptr && src != nullptr){
+		prop->copied(dst->getSymbol(), src->getSymbol());
+	}
+}
+
+//Replace the uses of copies in a branch or loop condition
+static ExpNode * propagateCond(CopyProp * prop, ExpNode * cond){
+	Effects condEffects;
+	cond->collectEffects(&condEffects);
+	prop->kill(&condEffects);
+	return cond->rewriteExps(prop);
+}
+
+void IfStmtNode::propagateCopies(CopyProp * prop){
+	myCond = propagateCond(prop, myCond);
+	CopyProp::Copies before = prop->save();
+	for (auto stmt : myBody){
+		stmt->propagateCopies(prop);
+	}
+	prop->join(before);
+}
+
+void IfElseStmtNode::propagateCopies(CopyProp * prop){
+	myCond = propagateCond(prop, myCond);
+	CopyProp::Copies before = prop->save();
+	for (auto stmt : myBodyTrue){
+		stmt->propagateCopies(prop);
+	}
+	CopyProp::Copies thenCopies = prop->save();
+
+	prop->restore(before);
+	for (auto stmt : myBodyFalse){
+		stmt->propagateCopies(prop);
+	}
+	prop->join(thenCopies);
+}
+
+void WhileStmtNode::propagateCopies(CopyProp * prop){
+	//Only copies that no iteration can change hold at the
+	// loop head, and so after the loop
+	Effects loopEffects;
+	collectEffects(&loopEffects);
+	prop->kill(&loopEffects);
+	myCond = myCond->rewriteExps(prop);
+	CopyProp::Copies head = prop->save();
+	for (auto stmt : myBody){
+		stmt->propagateCopies(prop);
+	}
+	prop->restore(head);
+}
+
+bool VarDeclNode::dropDeadCopies(CopyProp * prop){
+	return prop->deadLocal(this);
+}
+
+bool AssignStmtNode::dropDeadCopies(CopyProp * prop){
+	return prop->deadCopy(myExp);
+}
+
+bool IfStmtNode::dropDeadCopies(CopyProp * prop){
+	prop->prune(myBody);
+	return false;
+}
+
+bool IfElseStmtNode::dropDeadCopies(CopyProp * prop){
+	prop->prune(myBodyTrue);
+	prop->prune(myBodyFalse);
+	return false;
+}
+
+bool WhileStmtNode::dropDeadCopies(CopyProp * prop){
+	prop->prune(myBody);
+	return false;
+}
+
+}
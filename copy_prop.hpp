@@ -0,0 +1,83 @@
+#ifndef CMINUSMINUS_COPY_PROP
+#define CMINUSMINUS_COPY_PROP
+
+#include <set>
+#include <vector>
+#include "ast.hpp"
+#include "effects.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+// Replaces each use of a local that holds a copy of another
+// variable (after "t = a;") by a use of that variable, for as
+// long as neither of them is assigned again. Chains of
+// temporaries (t1 = a; t2 = t1; t3 = t2 + 1;) collapse onto
+// their source. Only scalar locals whose address is never
+// taken hold copies; a copy of a global or of a variable
+// whose address is taken is forgotten at any call or write
+// through a pointer, which may change the source. Once uses
+// are replaced, copies into locals that are never read are
+// removed, along with the locals left with nothing to do.
+class CopyProp : public ExpRewriter{
+public:
+	//The copies known to hold at a point of a function,
+	// each a local and the variable it holds a copy of
+	using Copies = HashMap<SemSymbol *, SemSymbol *>;
+
+	static CopyProp * build(TypeAnalysis * typeAnalysis,
+		Remarks * remarks = nullptr);
+	//Replace a use of a copy by its source
+	ExpNode * rewrite(ExpNode * exp) override;
+	size_t replaced() const { return myReplaced; }
+	size_t eliminated() const { return myEliminated; }
+	size_t removed() const { return myRemoved; }
+
+	void addGlobal(SemSymbol * sym){ myAliases.addGlobal(sym); }
+	void enterFn(const Effects * fnEffects);
+	//Note that a local now holds a copy of a variable
+	void copied(SemSymbol * dst, SemSymbol * src);
+	//Drop all copies that the given effects may invalidate
+	void kill(const Effects * effects);
+	Copies save(){ return myCopies; }
+	void restore(const Copies& copies){ myCopies = copies; }
+	//Keep only the copies that hold on both paths
+	void join(const Copies& other);
+
+	//Remove the copies into locals that are never read,
+	// and then the locals left unused, from a function body
+	// whose uses of copies have been replaced
+	void finishFn(std::vector<StmtNode *>& body);
+	//Remove the dead statements of a body, as judged by
+	// the statements themselves
+	void prune(std::vector<StmtNode *>& body);
+	//Whether an assignment is a dead copy, and if so note
+	// that it is removed
+	bool deadCopy(AssignExpNode * exp);
+	//Whether a local declaration is no longer needed, and
+	// if so note that it is removed
+	bool deadLocal(VarDeclNode * decl);
+private:
+	CopyProp(TypeAnalysis * typeAnalysis, Remarks * remarks)
+	: myTypes(typeAnalysis), myRemarks(remarks), myLeft(nullptr),
+	  myReplaced(0), myEliminated(0), myRemoved(0){ }
+	bool isLocal(SemSymbol * sym) const;
+	bool isScalar(SemSymbol * sym) const;
+	TypeAnalysis * myTypes;
+	Remarks * myRemarks;
+	Copies myCopies;
+	Aliases myAliases;
+	//Locals whose value is never read
+	std::set<SemSymbol *> myUnread;
+	//What is left of the function once dead copies are
+	// removed, while its unused locals are being removed
+	const Effects * myLeft;
+	size_t myReplaced;
+	size_t myEliminated;
+	size_t myRemoved;
+};
+
+}
+
+#endif
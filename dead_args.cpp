@@ -0,0 +1,318 @@
+#include "dead_args.hpp"
+#include "effects.hpp"
+#include "hash_cons.hpp"
+
+namespace cminusminus{
+
+DeadArgElim * DeadArgElim::build(TypeAnalysis * typeAnalysis,
+	Remarks * remarks){
+	DeadArgElim * dae = new DeadArgElim(typeAnalysis, remarks);
+	//Without a main, the functions may be called from the
+	// files that import them
+	bool program = false;
+	for (auto decl : typeAnalysis->ast->getGlobals()){
+		FnDeclNode * fn = decl->asFn();
+		if (fn != nullptr && fn->getSymbol() != nullptr
+		  && fn->getSymbol()->getName() == "main"){
+			program = true;
+		}
+	}
+	while (program && dae->round()){ }
+	return dae;
+}
+
+bool DeadArgElim::droppable(const ExpNode * exp){
+	ConsKey key;
+	if (!exp->consKey(&key)){ return false; }
+	if (key.op == "/"){
+		//Dividing by anything but a literal other than zero
+		// may fail
+		ConsKey divisor;
+		if (!key.rhs->consKey(&divisor) || divisor.op != "int"
+		  || divisor.num == 0){
+			return false;
+		}
+	}
+	if (key.lhs != nullptr && !droppable(key.lhs)){ return false; }
+	if (key.rhs != nullptr && !droppable(key.rhs)){ return false; }
+	return true;
+}
+
+ExpNode * DeadArgElim::rewrite(ExpNode * exp){
+	CallExpNode * call = exp->asCall();
+	if (call != nullptr){
+		myCalls[call->callee()].push_back(call);
+		return exp;
+	}
+	IDNode * id = exp->asID();
+	if (id != nullptr && id->getSymbol() != nullptr
+	  && id->getSymbol()->getKind() == FN){
+		myNamed.insert(id->getSymbol());
+	}
+	return exp;
+}
+
+void DeadArgElim::discarded(CallExpNode * call){
+	if (!myDropping){ myDiscarded[call->callee()]++; }
+}
+
+void DeadArgElim::elim(std::vector<StmtNode *>& body, bool whole){
+	for (size_t i = 0; i < body.size(); i++){
+		ReturnStmtNode * ret = body[i]->asReturn();
+		if (ret == nullptr){
+			body[i]->elimDeadArgs(this);
+			continue;
+		}
+		ExpNode * value = ret->getExp();
+		if (value == nullptr){ continue; }
+		if (!myDropping){
+			CallExpNode * returned = value->asCall();
+			if (returned != nullptr){
+				myReturned[returned->callee()].push_back(myFn);
+			} else if (!droppable(value)){
+				myKeepsResult.insert(myFn);
+			}
+			continue;
+		}
+		if (myVoided.count(myFn) == 0){ continue; }
+		ret->dropExp();
+		myTypes->nodeType(ret, BasicType::produce(VOID));
+		CallExpNode * call = value->asCall();
+		//A void function can run off the end of its body
+		bool last = whole && i + 1 == body.size();
+		if (last){ delete ret; }
+		if (call == nullptr){
+			delete value;
+			if (last){ body.pop_back(); }
+			continue;
+		}
+		StmtNode * stmt = new CallStmtNode(call->pos(), call);
+		stmt->typeRule(myTypes);
+		if (last){
+			body[i] = stmt;
+		} else {
+			body.insert(body.begin() + static_cast<long>(i), stmt);
+			i++;
+		}
+	}
+}
+
+std::vector<ExpNode *> DeadArgElim::kept(const std::vector<ExpNode *>& args,
+	const std::vector<bool>& dead){
+	std::vector<ExpNode *> result;
+	for (size_t k = 0; k < args.size(); k++){
+		if (!dead[k]){ result.push_back(args[k]); }
+	}
+	return result;
+}
+
+bool DeadArgElim::passedOn(FnDeclNode * fn, size_t k){
+	const std::vector<CallExpNode *>& calls = myCalls[fn->getSymbol()];
+	if (calls.empty()){ return false; }
+	std::vector<bool> dead(fn->getFormals().size(), false);
+	dead[k] = true;
+	std::vector<std::vector<ExpNode *>> args;
+	for (auto call : calls){
+		args.push_back(call->getArgs());
+		call->setArgs(kept(call->getArgs(), dead));
+	}
+	Effects effects;
+	fn->collectEffects(&effects);
+	for (size_t i = 0; i < calls.size(); i++){ calls[i]->setArgs(args[i]); }
+	return !effects.uses(fn->getFormals()[k]->getSymbol());
+}
+
+bool DeadArgElim::dropFormals(FnDeclNode * fn){
+	SemSymbol * sym = fn->getSymbol();
+	const std::vector<CallExpNode *>& calls = myCalls[sym];
+	const std::vector<FormalDeclNode *>& formals = fn->getFormals();
+	Effects effects;
+	fn->collectEffects(&effects);
+
+	std::vector<bool> dead(formals.size(), false);
+	size_t count = 0;
+	for (size_t k = 0; k < formals.size(); k++){
+		SemSymbol * formal = formals[k]->getSymbol();
+		if (effects.modifies(formal) || effects.addrTaken(formal)){
+			continue;
+		}
+		if (effects.uses(formal) && !passedOn(fn, k)){ continue; }
+		CallExpNode * kept = nullptr;
+		for (auto call : calls){
+			if (!droppable(call->getArgs()[k])){
+				kept = call;
+				break;
+			}
+		}
+		if (kept != nullptr){
+			if (myRemarks != nullptr && myMissed.insert(formal).second){
+				myRemarks->missed("dead-args", kept->pos(), "Kept formal "
+					+ formal->getName() + " of " + sym->getName()
+					+ ", which it never uses, since this call's argument for it"
+					+ " may have effects");
+			}
+			continue;
+		}
+		dead[k] = true;
+		count++;
+		if (myRemarks != nullptr){
+			myRemarks->applied("dead-args", formals[k]->pos(), "Removed formal "
+				+ formal->getName() + " of " + sym->getName()
+				+ ", which it never uses, and its argument at "
+				+ std::to_string(calls.size())
+				+ (calls.size() == 1 ? " call" : " calls"));
+		}
+	}
+	if (count == 0){ return false; }
+	for (auto call : calls){
+		std::vector<ExpNode *> args = call->getArgs();
+		call->setArgs(kept(args, dead));
+		for (size_t i = 0; i < args.size(); i++){
+			if (dead[i]){ delete args[i]; }
+		}
+	}
+	fn->dropFormals(dead);
+	myFormals += count;
+	myActuals += count * calls.size();
+	return true;
+}
+
+void DeadArgElim::findUnused(){
+	myUnused.clear();
+	for (auto decl : myTypes->ast->getGlobals()){
+		FnDeclNode * fn = decl->asFn();
+		if (fn == nullptr || fn->getSymbol() == nullptr){ continue; }
+		SemSymbol * sym = fn->getSymbol();
+		const FnType * type = sym->getDataType()->asFn();
+		if (type == nullptr || type->getReturnType()->isVoid()){ continue; }
+		if (sym->getName() == "main" || myNamed.count(sym) > 0){ continue; }
+		if (myDiscarded[sym] + myReturned[sym].size() < myCalls[sym].size()){
+			continue;
+		}
+		if (myKeepsResult.count(sym) > 0){
+			if (myRemarks != nullptr && myMissed.insert(sym).second){
+				myRemarks->missed("dead-args", fn->pos(), "Kept the result of "
+					+ sym->getName() + ", which no call uses, since it returns"
+					+ " a value that may have effects");
+			}
+			continue;
+		}
+		myUnused.insert(sym);
+	}
+	//A call whose value is returned is only unused if the
+	// function returning it is
+	bool changed = true;
+	while (changed){
+		changed = false;
+		for (auto it = myUnused.begin(); it != myUnused.end(); ){
+			bool used = false;
+			for (auto caller : myReturned[*it]){
+				if (myUnused.count(caller) == 0){ used = true; }
+			}
+			if (used){
+				it = myUnused.erase(it);
+				changed = true;
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
+bool DeadArgElim::dropResult(FnDeclNode * fn){
+	SemSymbol * sym = fn->getSymbol();
+	if (myUnused.count(sym) == 0){ return false; }
+	fn->dropResult();
+	myVoided.insert(sym);
+	myResults++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("dead-args", fn->pos(), "Made "
+			+ sym->getName() + " void, since no call uses its result");
+	}
+	return true;
+}
+
+bool DeadArgElim::round(){
+	myCalls.clear();
+	myDiscarded.clear();
+	myNamed.clear();
+	myReturned.clear();
+	myKeepsResult.clear();
+	myVoided.clear();
+	myDropping = false;
+	ProgramNode * ast = myTypes->ast;
+	ast->rewriteExps(this);
+	ast->elimDeadArgs(this);
+	findUnused();
+
+	bool changed = false;
+	for (auto decl : ast->getGlobals()){
+		FnDeclNode * fn = decl->asFn();
+		if (fn == nullptr || fn->getSymbol() == nullptr){ continue; }
+		SemSymbol * sym = fn->getSymbol();
+		if (sym->getName() == "main" || myNamed.count(sym) > 0){ continue; }
+		bool dropped = dropFormals(fn);
+		dropped = dropResult(fn) || dropped;
+		if (!dropped){ continue; }
+		for (auto call : myCalls[sym]){ call->typeRule(myTypes); }
+		changed = true;
+	}
+	if (!myVoided.empty()){
+		myDropping = true;
+		ast->elimDeadArgs(this);
+	}
+	return changed;
+}
+
+void ProgramNode::elimDeadArgs(DeadArgElim * dae){
+	for (auto decl : myGlobals){
+		decl->elimDeadArgs(dae);
+	}
+}
+
+void FnDeclNode::elimDeadArgs(DeadArgElim * dae){
+	dae->enterFn(getSymbol());
+	dae->elim(myBody, true);
+}
+
+void IfStmtNode::elimDeadArgs(DeadArgElim * dae){
+	dae->elim(myBody);
+}
+
+void IfElseStmtNode::elimDeadArgs(DeadArgElim * dae){
+	dae->elim(myBodyTrue);
+	dae->elim(myBodyFalse);
+}
+
+void WhileStmtNode::elimDeadArgs(DeadArgElim * dae){
+	dae->elim(myBody);
+}
+
+void CallStmtNode::elimDeadArgs(DeadArgElim * dae){
+	dae->discarded(myCallExp);
+}
+
+void FnDeclNode::dropFormals(const std::vector<bool>& dead){
+	std::vector<FormalDeclNode *> kept;
+	std::list<const DataType *> * types = new std::list<const DataType *>();
+	for (size_t k = 0; k < myFormals.size(); k++){
+		if (dead[k]){ continue; }
+		kept.push_back(myFormals[k]);
+		types->push_back(myFormals[k]->getSymbol()->getDataType());
+	}
+	myFormals.swap(kept);
+	myFnType->setSignature(types, myFnType->getReturnType());
+}
+
+void FnDeclNode::dropResult(){
+	myRetType = new VoidTypeNode(myRetType->pos());
+	myFnType->setSignature(
+		new std::list<const DataType *>(*myFnType->getFormalTypes()),
+		BasicType::produce(VOID));
+}
+
+SemSymbol * CallExpNode::callee() const{
+	return myID->getSymbol();
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef CMINUSMINUS_DEAD_ARGS
+#define CMINUSMINUS_DEAD_ARGS
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+// Removes what is passed between functions and never used.
+// A formal that the function never reads (other than to pass
+// it on to itself), writes or takes the address of is
+// removed, along with the argument for it at every call, as
+// long as each of those arguments can be dropped: it makes
+// no call and can't fail. A function whose value no call
+// uses, other than by returning it from a function whose
+// value is itself unused, becomes void, each return dropping
+// its value (or making the call it returns a statement of
+// its own). Since dropping an argument can leave another
+// formal unused, this is repeated until nothing changes.
+// Functions named other than in calls, and main, are left
+// as they are, as is a file with no main, whose functions
+// other files may call.
+class DeadArgElim : public ExpRewriter{
+public:
+	static DeadArgElim * build(TypeAnalysis * typeAnalysis,
+		Remarks * remarks = nullptr);
+	//Note each call, and each function named other than in
+	// a call
+	ExpNode * rewrite(ExpNode * exp) override;
+	size_t formals() const { return myFormals; }
+	size_t actuals() const { return myActuals; }
+	size_t results() const { return myResults; }
+
+	void enterFn(SemSymbol * fn){ myFn = fn; }
+	//Look at (or drop) the values returned in a body, which
+	// may be the whole body of the function
+	void elim(std::vector<StmtNode *>& body, bool whole = false);
+	void discarded(CallExpNode * call);
+private:
+	DeadArgElim(TypeAnalysis * typeAnalysis, Remarks * remarks)
+	: myTypes(typeAnalysis), myRemarks(remarks), myFn(nullptr),
+	  myDropping(false), myFormals(0), myActuals(0), myResults(0){ }
+	//Whether an expression can be left unevaluated
+	static bool droppable(const ExpNode * exp);
+	//Remove what is dead once, returning whether anything was
+	bool round();
+	static std::vector<ExpNode *> kept(const std::vector<ExpNode *>& args,
+		const std::vector<bool>& dead);
+	//Whether the k'th formal of a function is only used in
+	// what the function passes to itself as that formal
+	bool passedOn(FnDeclNode * fn, size_t k);
+	//Find the functions whose value no call uses
+	void findUnused();
+	bool dropFormals(FnDeclNode * fn);
+	bool dropResult(FnDeclNode * fn);
+	TypeAnalysis * myTypes;
+	Remarks * myRemarks;
+	SemSymbol * myFn;
+	//Whether returns are being dropped, rather than looked at
+	bool myDropping;
+	std::unordered_map<SemSymbol *, std::vector<CallExpNode *>> myCalls;
+	//The number of calls to each function whose value is
+	// discarded
+	std::unordered_map<SemSymbol *, size_t> myDiscarded;
+	//The functions that return the value of a call to each
+	// function, once for each such return
+	std::unordered_map<SemSymbol *, std::vector<SemSymbol *>> myReturned;
+	std::set<SemSymbol *> myNamed;
+	//The functions that return a value which can't be
+	// dropped, and those made void
+	std::set<SemSymbol *> myKeepsResult;
+	std::set<SemSymbol *> myUnused;
+	std::set<SemSymbol *> myVoided;
+	//What has been remarked as kept, so that each later round
+	// doesn't remark it again
+	std::set<SemSymbol *> myMissed;
+	size_t myFormals;
+	size_t myActuals;
+	size_t myResults;
+};
+
+}
+
+#endif
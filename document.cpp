@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <unordered_set>
+#include "document.hpp"
+#include "scanner.hpp"
+#include "time_report.hpp"
+
+namespace cminusminus{
+
+using Lexeme = cminusminus::Parser::semantic_type;
+
+//A scanner that hands the parser tokens that were lexed
+// earlier, rather than lexing them from a stream
+class TokenReplay : public Scanner{
+public:
+	TokenReplay(std::vector<Token>&& tokens)
+	: Scanner(nullptr), myTokens(std::move(tokens)), myNext(0){ }
+	using Scanner::yylex;
+	int yylex(Parser::semantic_type * const lval) override{
+		if (myNext == myTokens.size()){ return TokenKind::END; }
+		const Token& tok = myTokens[myNext++];
+		lval->emplace<Token>(tok);
+		return tok.kind();
+	}
+	//The token the parser saw last, which is where it is
+	// when reporting a syntax error
+	const Token * last() const {
+		if (myTokens.empty()){ return nullptr; }
+		return &myTokens[myNext == 0 ? 0 : myNext - 1];
+	}
+private:
+	std::vector<Token> myTokens;
+	size_t myNext;
+};
+
+//Read a span as written by Position::span
+static bool readSpan(const char * text, Diagnostic& diag, int * len){
+	return sscanf(text, "[%zu,%zu]-[%zu,%zu]%n", &diag.line,
+		&diag.col, &diag.endLine, &diag.endCol, len) == 4;
+}
+
+//Collect the diagnostics reported by Report::fatal
+void Diagnostic::readFatals(const std::string& text,
+	std::vector<Diagnostic>& out){
+	std::istringstream in(text);
+	std::string line;
+	const std::string prefix = "FATAL ";
+	while (std::getline(in, line)){
+		if (line.compare(0, prefix.length(), prefix) != 0){ continue; }
+		Diagnostic diag;
+		int len = 0;
+		if (!readSpan(line.c_str() + prefix.length(), diag, &len)){
+			continue;
+		}
+		size_t msgAt = prefix.length() + static_cast<size_t>(len);
+		if (line.compare(msgAt, 2, ": ") == 0){ msgAt += 2; }
+		diag.msg = line.substr(msgAt);
+		out.push_back(diag);
+	}
+}
+
+Diagnostic Diagnostic::at(const Position * pos, const std::string& msg){
+	Diagnostic diag;
+	int len = 0;
+	if (!readSpan(pos->span().c_str(), diag, &len)){
+		diag.line = diag.endLine = 1;
+		diag.col = diag.endCol = 1;
+	}
+	diag.msg = msg;
+	return diag;
+}
+
+static std::vector<std::string> splitLines(const std::string& text){
+	std::vector<std::string> lines;
+	size_t start = 0;
+	while (true){
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos){
+			lines.push_back(text.substr(start));
+			return lines;
+		}
+		lines.push_back(text.substr(start, end - start));
+		start = end + 1;
+	}
+}
+
+Document::Document(const std::string& text)
+: myLexErrLines(0){
+	replaceAll(text);
+}
+
+Document::~Document(){
+	for (auto chunk : myChunks){
+		delete chunk;
+	}
+	for (auto chunk : myReplaced){
+		delete chunk;
+	}
+}
+
+void Document::replaceAll(const std::string& text){
+	myLines.clear();
+	myLexErrLines = 0;
+	for (auto& line : splitLines(text)){
+		SourceLine src;
+		src.text = line;
+		myLines.push_back(src);
+	}
+	lex(0, myLines.size());
+	rechunk(0, myLines.size(), 0, myChunks.size());
+}
+
+void Document::edit(size_t startLine, size_t startCol,
+	size_t endLine, size_t endCol, const std::string& text){
+	size_t lastLine = myLines.size() - 1;
+	startLine = std::min(startLine, lastLine);
+	endLine = std::min(std::max(endLine, startLine), lastLine);
+	const std::string& head = myLines[startLine].text;
+	const std::string& tail = myLines[endLine].text;
+	std::string joined = head.substr(0, std::min(startCol, head.length()))
+		+ text + tail.substr(std::min(endCol, tail.length()));
+
+	replaceLines(startLine, endLine - startLine + 1, splitLines(joined));
+}
+
+void Document::reload(const std::string& text){
+	std::vector<std::string> lines = splitLines(text);
+	size_t head = 0;
+	while (head < lines.size() && head < myLines.size()
+	  && lines[head] == myLines[head].text){
+		head++;
+	}
+	size_t tail = 0;
+	while (head + tail < lines.size() && head + tail < myLines.size()
+	  && lines[lines.size() - 1 - tail]
+	  == myLines[myLines.size() - 1 - tail].text){
+		tail++;
+	}
+	if (head + tail == lines.size() && head + tail == myLines.size()){
+		return;
+	}
+	replaceLines(head, myLines.size() - head - tail,
+		std::vector<std::string>(lines.begin() + static_cast<long>(head),
+			lines.end() - static_cast<long>(tail)));
+}
+
+void Document::replaceLines(size_t first, size_t removed,
+	const std::vector<std::string>& lines){
+	std::vector<SourceLine> fresh;
+	for (auto& line : lines){
+		SourceLine src;
+		src.text = line;
+		fresh.push_back(src);
+	}
+	size_t added = fresh.size();
+	for (size_t i = first; i < first + removed; i++){
+		if (!myLines[i].lexErrs.empty()){ myLexErrLines--; }
+	}
+	//Lines are swapped or moved into place rather than
+	// shifted: a short line assigned over a longer one keeps
+	// its buffer, which would hold on to text long edited away
+	if (added == removed){
+		for (size_t i = 0; i < added; i++){
+			std::swap(myLines[first + i], fresh[i]);
+		}
+	} else {
+		std::vector<SourceLine> moved;
+		moved.reserve(myLines.size() - removed + added);
+		auto at = myLines.begin() + static_cast<long>(first);
+		moved.insert(moved.end(), std::make_move_iterator(myLines.begin()),
+			std::make_move_iterator(at));
+		moved.insert(moved.end(), std::make_move_iterator(fresh.begin()),
+			std::make_move_iterator(fresh.end()));
+		moved.insert(moved.end(),
+			std::make_move_iterator(at + static_cast<long>(removed)),
+			std::make_move_iterator(myLines.end()));
+		myLines.swap(moved);
+	}
+	lex(first, added);
+
+	//Chunks start at line 0 and cover every line, so the
+	// edit begins in the last chunk starting at or before it
+	size_t from = 0;
+	while (from + 1 < myChunks.size()
+	  && myChunks[from + 1]->first <= first){
+		from++;
+	}
+	//Chunks wholly after the edit are untouched, but moved
+	size_t keep = from + 1;
+	while (keep < myChunks.size()
+	  && myChunks[keep]->first < first + removed){
+		keep++;
+	}
+	for (size_t i = keep; i < myChunks.size(); i++){
+		myChunks[i]->first = myChunks[i]->first + added - removed;
+	}
+	rechunk(myChunks[from]->first, first + added, from, keep);
+}
+
+void Document::lex(size_t first, size_t count){
+	std::string text;
+	for (size_t i = first; i < first + count; i++){
+		text += myLines[i].text;
+		text += '\n';
+	}
+	Stopwatch watch;
+	std::istringstream in(text);
+	std::stringstream errs;
+	std::streambuf * err = std::cerr.rdbuf(errs.rdbuf());
+	Scanner scanner(&in);
+	Lexeme lexeme;
+	size_t tokens = 0;
+	while (scanner.yylex(&lexeme) != TokenKind::END){
+		Token tok = lexeme.as<Token>();
+		lexeme.destroy<Token>();
+		size_t line = first + tok.pos()->line() - 1;
+		if (line < first + count){
+			myLines[line].tokens.push_back(tok);
+			tokens++;
+		}
+	}
+	std::cerr.rdbuf(err);
+	double perToken = tokens == 0 ? 0 : watch.lap() / tokens;
+	for (size_t i = first; i < first + count; i++){
+		myLines[i].lexSeconds = perToken * myLines[i].tokens.size();
+	}
+
+	std::vector<Diagnostic> diags;
+	Diagnostic::readFatals(errs.str(), diags);
+	for (auto& diag : diags){
+		size_t line = first + diag.line - 1;
+		if (line < first + count){
+			if (myLines[line].lexErrs.empty()){ myLexErrLines++; }
+			myLines[line].lexErrs.push_back(diag);
+		}
+	}
+}
+
+void Document::rechunk(size_t first, size_t dirtyEnd, size_t oldFrom,
+	size_t keepFrom){
+	std::vector<Chunk *> fresh;
+	size_t start = first;
+	size_t depth = 0;
+	int lastKind = 0;
+	bool hasTokens = false;
+	size_t keep = keepFrom;
+	bool synced = false;
+	for (size_t i = first; i < myLines.size() && !synced; i++){
+		for (auto& tok : myLines[i].tokens){
+			if (tok.kind() == TokenKind::LCURLY){ depth++; }
+			if (tok.kind() == TokenKind::RCURLY && depth > 0){
+				depth--;
+			}
+			lastKind = tok.kind();
+			hasTokens = true;
+		}
+		if (depth != 0 || !hasTokens){ continue; }
+		if (lastKind != TokenKind::SEMICOL
+		  && lastKind != TokenKind::RCURLY){
+			continue;
+		}
+		size_t end = i + 1;
+		fresh.push_back(chunk(start, end - start));
+		start = end;
+		hasTokens = false;
+		while (keep < myChunks.size() && myChunks[keep]->first < end){
+			keep++;
+		}
+		synced = end >= dirtyEnd && keep < myChunks.size()
+			&& myChunks[keep]->first == end;
+	}
+	if (!synced){
+		if (start < myLines.size() || fresh.empty()){
+			fresh.push_back(chunk(start, myLines.size() - start));
+		}
+		keep = myChunks.size();
+	}
+
+	//Whoever analyzes the document may still be holding on
+	// to the replaced chunks
+	myReplaced.insert(myReplaced.end(),
+		myChunks.begin() + static_cast<long>(oldFrom),
+		myChunks.begin() + static_cast<long>(keep));
+	myChunks.erase(myChunks.begin() + static_cast<long>(oldFrom),
+		myChunks.begin() + static_cast<long>(keep));
+	myChunks.insert(myChunks.begin() + static_cast<long>(oldFrom),
+		fresh.begin(), fresh.end());
+}
+
+Chunk * Document::chunk(size_t first, size_t count){
+	Chunk * chunk = new Chunk();
+	chunk->first = first;
+	chunk->count = count;
+	parse(chunk);
+	return chunk;
+}
+
+void Document::parse(Chunk * chunk){
+	std::vector<Token> tokens;
+	std::unordered_set<std::string> names;
+	for (size_t i = chunk->first; i < chunk->first + chunk->count; i++){
+		for (auto tok : myLines[i].tokens){
+			tok.moveToLine(i + 1);
+			tokens.push_back(tok);
+			if (tok.kind() == TokenKind::ID){
+				names.insert(tok.value());
+			}
+		}
+	}
+	chunk->names.assign(names.begin(), names.end());
+	chunk->parsedAt = chunk->first;
+	chunk->parsed = true;
+	chunk->lexSeconds = 0;
+	for (size_t i = chunk->first; i < chunk->first + chunk->count; i++){
+		chunk->lexSeconds += myLines[i].lexSeconds;
+	}
+	Stopwatch watch;
+
+	//The parser reports syntax errors on std::cout
+	std::stringstream out;
+	std::stringstream errs;
+	std::streambuf * outBuf = std::cout.rdbuf(out.rdbuf());
+	std::streambuf * errBuf = std::cerr.rdbuf(errs.rdbuf());
+	TokenReplay scanner(std::move(tokens));
+	ProgramNode * root = nullptr;
+	Parser parser(scanner, &root);
+	int errCode = parser.parse();
+	std::cout.rdbuf(outBuf);
+	std::cerr.rdbuf(errBuf);
+	chunk->parseSeconds = watch.lap();
+
+	if (errCode != 0 || root == nullptr){
+		chunk->parsed = false;
+		std::string msg = out.str();
+		while (!msg.empty() && msg.back() == '\n'){ msg.pop_back(); }
+		if (msg.empty()){ msg = "syntax error"; }
+		const Token * at = scanner.last();
+		Position end(chunk->first + chunk->count, 1,
+			chunk->first + chunk->count, 1);
+		chunk->parseErrs.push_back(Diagnostic::at(
+			at == nullptr ? &end : at->pos(), msg));
+		return;
+	}
+	chunk->root = root;
+	chunk->decls = root->getGlobals();
+}
+
+std::vector<Chunk *> Document::takeReplaced(){
+	std::vector<Chunk *> replaced;
+	replaced.swap(myReplaced);
+	return replaced;
+}
+
+void Document::markLive(LiveInterned * live) const{
+	for (auto& line : myLines){
+		for (auto& tok : line.tokens){ tok.markLive(live); }
+	}
+	for (auto chunks : {&myChunks, &myReplaced}){
+		for (auto chunk : *chunks){
+			if (chunk->root != nullptr){ chunk->root->markLive(live); }
+		}
+	}
+}
+
+bool Document::parses() const{
+	for (auto chunk : myChunks){
+		if (!chunk->parsed){ return false; }
+	}
+	return true;
+}
+
+std::vector<Diagnostic> Document::lexErrors() const{
+	std::vector<Diagnostic> out;
+	for (size_t i = 0; myLexErrLines > 0 && i < myLines.size(); i++){
+		for (auto diag : myLines[i].lexErrs){
+			diag.line = i + 1;
+			diag.endLine = i + 1;
+			out.push_back(diag);
+		}
+	}
+	return out;
+}
+
+std::vector<Diagnostic> Document::parseErrors() const{
+	std::vector<Diagnostic> out;
+	for (auto chunk : myChunks){
+		for (auto& diag : chunk->parseErrs){
+			out.push_back(chunk->moved(diag));
+		}
+	}
+	return out;
+}
+
+}
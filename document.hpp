@@ -0,0 +1,123 @@
+#ifndef CMINUSMINUS_DOCUMENT
+#define CMINUSMINUS_DOCUMENT
+
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "tokens.hpp"
+
+namespace cminusminus{
+
+//A diagnostic as reported by the compiler, with 1-based
+// lines and columns
+struct Diagnostic{
+	size_t line;
+	size_t col;
+	size_t endLine;
+	size_t endCol;
+	std::string msg;
+	bool operator==(const Diagnostic& other) const {
+		return line == other.line && col == other.col
+			&& endLine == other.endLine && endCol == other.endCol
+			&& msg == other.msg;
+	}
+	static Diagnostic at(const Position * pos, const std::string& msg);
+	//Collect the diagnostics written by Report::fatal
+	static void readFatals(const std::string& text,
+		std::vector<Diagnostic>& out);
+};
+
+//A line of a document, kept with its tokens. Since no
+// token spans lines, an edited line can be lexed again on
+// its own.
+struct SourceLine{
+	std::string text;
+	std::vector<Token> tokens;
+	//Errors from lexing the line, on whatever line it was
+	// lexed as
+	std::vector<Diagnostic> lexErrs;
+	//The line's share of the time spent lexing it, by its
+	// number of tokens
+	double lexSeconds = 0;
+};
+
+//A run of lines holding one or more whole top-level
+// declarations, which is parsed as a unit. Chunks end where
+// the braces are balanced after a semicolon or closing
+// brace, so an edit only ever needs the chunks it touches
+// to be parsed again.
+struct Chunk{
+	~Chunk(){ delete root; }
+	//A diagnostic of the chunk, moved to where it is now
+	Diagnostic moved(Diagnostic diag) const {
+		diag.line = diag.line + first - parsedAt;
+		diag.endLine = diag.endLine + first - parsedAt;
+		return diag;
+	}
+	//The first line (0-based) and the number of lines
+	size_t first;
+	size_t count;
+	//The line number the chunk was parsed at. Positions in
+	// its AST (and in its diagnostics) are off by however
+	// far the chunk has moved since.
+	size_t parsedAt;
+	bool parsed;
+	//The AST of the chunk, which owns its declarations
+	ProgramNode * root;
+	std::vector<DeclNode *> decls;
+	std::vector<Diagnostic> parseErrs;
+	//Every identifier in the chunk
+	std::vector<std::string> names;
+	//The time spent lexing the lines of the chunk, and then
+	// parsing them
+	double lexSeconds = 0;
+	double parseSeconds = 0;
+};
+
+//The text of a source file, which is kept lexed and parsed
+// across edits
+class Document{
+public:
+	Document(const std::string& text);
+	~Document();
+	void replaceAll(const std::string& text);
+	//Replace the text between two (0-based) positions
+	void edit(size_t startLine, size_t startCol,
+		size_t endLine, size_t endCol, const std::string& text);
+	//Replace the text with a new version, of which only
+	// the lines that differ are lexed and parsed again
+	void reload(const std::string& text);
+	const std::vector<Chunk *>& chunks() const { return myChunks; }
+	//The chunks replaced by edits since the last call, which
+	// are kept until then so that nothing refers to an AST
+	// that is gone. The caller deletes them
+	std::vector<Chunk *> takeReplaced();
+	//Mark the interned text and literals of the document,
+	// and of the chunks it has replaced, as used
+	void markLive(LiveInterned * live) const;
+	bool parses() const;
+	std::vector<Diagnostic> lexErrors() const;
+	std::vector<Diagnostic> parseErrors() const;
+private:
+	//Replace a number of lines from first with new lines
+	void replaceLines(size_t first, size_t removed,
+		const std::vector<std::string>& lines);
+	void lex(size_t first, size_t count);
+	//Split the lines from first into new chunks, in place
+	// of the old chunks from index oldFrom. Once past line
+	// dirtyEnd, the split stops at the first old chunk from
+	// index keepFrom that starts where a new chunk ends
+	void rechunk(size_t first, size_t dirtyEnd, size_t oldFrom,
+		size_t keepFrom);
+	void parse(Chunk * chunk);
+	Chunk * chunk(size_t first, size_t count);
+	std::vector<SourceLine> myLines;
+	std::vector<Chunk *> myChunks;
+	std::vector<Chunk *> myReplaced;
+	//How many lines have lexical errors
+	size_t myLexErrLines;
+};
+
+}
+
+#endif
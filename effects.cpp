@@ -0,0 +1,208 @@
+#include "effects.hpp"
+#include "ast.hpp"
+
+namespace cminusminus{
+
+void Effects::use(SemSymbol * sym){
+	if (sym != nullptr){ myUses.insert(sym); }
+}
+
+void Effects::def(LValNode * loc){
+	SemSymbol * sym = loc->rootSymbol();
+	if (sym == nullptr){ 
+		myPtrWrites = true; 
+		return;
+	}
+	myDefs[sym]++;
+	myModified.insert(sym);
+}
+
+void Effects::inc(LValNode * loc){
+	SemSymbol * sym = loc->rootSymbol();
+	if (sym == nullptr){ 
+		myPtrWrites = true; 
+		return;
+	}
+	myIncs[sym]++;
+	myModified.insert(sym);
+}
+
+void Effects::dec(LValNode * loc){
+	SemSymbol * sym = loc->rootSymbol();
+	if (sym == nullptr){ 
+		myPtrWrites = true; 
+		return;
+	}
+	myDecs[sym]++;
+	myModified.insert(sym);
+}
+
+void Effects::addrOf(SemSymbol * sym){
+	if (sym != nullptr){ myAddrTaken.insert(sym); }
+}
+
+void Effects::call(SemSymbol * callee){
+	myCalls = true;
+	if (callee != nullptr){ myCallees.insert(callee); }
+}
+
+bool Effects::uses(SemSymbol * sym) const{
+	return myUses.find(sym) != myUses.end();
+}
+
+bool Effects::modifies(SemSymbol * sym) const{
+	return myModified.find(sym) != myModified.end();
+}
+
+bool Effects::addrTaken(SemSymbol * sym) const{
+	return myAddrTaken.find(sym) != myAddrTaken.end();
+}
+
+void Aliases::enterFn(const Effects * fnEffects){
+	myAddrTaken.clear();
+	myAddrTaken.insert(fnEffects->getAddrTaken()->begin(),
+		fnEffects->getAddrTaken()->end());
+}
+
+size_t Effects::count(const HashMap<SemSymbol *, size_t>& counts, 
+	SemSymbol * sym){
+	auto found = counts.find(sym);
+	if (found == counts.end()){ return 0; }
+	return found->second;
+}
+
+size_t Effects::defCount(SemSymbol * sym) const{
+	return count(myDefs, sym);
+}
+
+size_t Effects::incCount(SemSymbol * sym) const{
+	return count(myIncs, sym);
+}
+
+size_t Effects::decCount(SemSymbol * sym) const{
+	return count(myDecs, sym);
+}
+
+void FnDeclNode::collectEffects(Effects * effects){
+	for (auto stmt : myBody){
+		stmt->collectEffects(effects);
+	}
+}
+
+void AssignStmtNode::collectEffects(Effects * effects){
+	myExp->collectEffects(effects);
+}
+
+void ReadStmtNode::collectEffects(Effects * effects){
+	myDst->collectLocEffects(effects);
+	effects->def(myDst);
+	effects->io();
+}
+
+void WriteStmtNode::collectEffects(Effects * effects){
+	mySrc->collectEffects(effects);
+	effects->io();
+}
+
+void PostIncStmtNode::collectEffects(Effects * effects){
+	myLVal->collectEffects(effects);
+	effects->inc(myLVal);
+}
+
+void PostDecStmtNode::collectEffects(Effects * effects){
+	myLVal->collectEffects(effects);
+	effects->dec(myLVal);
+}
+
+void IfStmtNode::collectEffects(Effects * effects){
+	myCond->collectEffects(effects);
+	for (auto stmt : myBody){
+		stmt->collectEffects(effects);
+	}
+}
+
+void IfElseStmtNode::collectEffects(Effects * effects){
+	myCond->collectEffects(effects);
+	for (auto stmt : myBodyTrue){
+		stmt->collectEffects(effects);
+	}
+	for (auto stmt : myBodyFalse){
+		stmt->collectEffects(effects);
+	}
+}
+
+void WhileStmtNode::collectEffects(Effects * effects){
+	myCond->collectEffects(effects);
+	for (auto stmt : myBody){
+		stmt->collectEffects(effects);
+	}
+}
+
+void ReturnStmtNode::collectEffects(Effects * effects){
+	if (myExp != nullptr){ myExp->collectEffects(effects); }
+}
+
+void CallStmtNode::collectEffects(Effects * effects){
+	myCallExp->collectEffects(effects);
+}
+
+void CallExpNode::collectEffects(Effects * effects){
+	for (auto arg : myArgs){
+		arg->collectEffects(effects);
+	}
+	effects->call(myID->getSymbol());
+}
+
+void BinaryExpNode::collectEffects(Effects * effects){
+	myExp1->collectEffects(effects);
+	myExp2->collectEffects(effects);
+}
+
+void UnaryExpNode::collectEffects(Effects * effects){
+	myExp->collectEffects(effects);
+}
+
+void RefNode::collectEffects(Effects * effects){
+	effects->addrOf(myID->getSymbol());
+}
+
+void DerefNode::collectEffects(Effects * effects){
+	collectLocEffects(effects);
+	effects->ptrRead();
+}
+
+void DerefNode::collectLocEffects(Effects * effects){
+	myID->collectEffects(effects);
+}
+
+void IDNode::collectEffects(Effects * effects){
+	effects->use(mySymbol);
+}
+
+void FieldAccessNode::collectEffects(Effects * effects){
+	myBase->collectEffects(effects);
+}
+
+void FieldAccessNode::collectLocEffects(Effects * effects){
+	myBase->collectLocEffects(effects);
+}
+
+void IndexNode::collectEffects(Effects * effects){
+	myBase->collectEffects(effects);
+	myIndex->collectEffects(effects);
+	effects->index(this);
+}
+
+void IndexNode::collectLocEffects(Effects * effects){
+	myBase->collectLocEffects(effects);
+	myIndex->collectEffects(effects);
+	effects->index(this);
+}
+
+void AssignExpNode::collectEffects(Effects * effects){
+	myDst->collectLocEffects(effects);
+	mySrc->collectEffects(effects);
+	effects->def(myDst);
+}
+
+}
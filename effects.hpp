@@ -0,0 +1,116 @@
+#ifndef CMINUSMINUS_EFFECTS
+#define CMINUSMINUS_EFFECTS
+
+#include <list>
+#include <set>
+#include "symbol_table.hpp"
+
+namespace cminusminus{
+
+class LValNode;
+class IndexNode;
+
+// A summary of what a piece of the AST may do when it runs:
+// which variables it uses and modifies, whether it calls 
+// functions, goes through pointers, or does I/O. Passes
+// collect the effects of a statement or expression to decide
+// whether moving or removing code is safe. The summary is
+// conservative: modifying any field of a record or element
+// of an array counts as modifying the whole variable.
+class Effects{
+public:
+	Effects()
+	: myCalls(false), myPtrReads(false), myPtrWrites(false), 
+	  myIO(false){ }
+
+	//Record that the subtree...
+	// ...reads the value of a variable
+	void use(SemSymbol * sym);
+	// ...stores to a location (by assignment or read)
+	void def(LValNode * loc);
+	// ...increments or decrements a location
+	void inc(LValNode * loc);
+	void dec(LValNode * loc);
+	// ...takes the address of a variable
+	void addrOf(SemSymbol * sym);
+	// ...calls a function
+	void call(SemSymbol * callee);
+	// ...loads through a pointer
+	void ptrRead(){ myPtrReads = true; }
+	// ...reads input or writes output
+	void io(){ myIO = true; }
+	// ...indexes an array
+	void index(IndexNode * node){ myIndexes.push_back(node); }
+
+	bool uses(SemSymbol * sym) const;
+	bool modifies(SemSymbol * sym) const;
+	bool addrTaken(SemSymbol * sym) const;
+	size_t defCount(SemSymbol * sym) const;
+	size_t incCount(SemSymbol * sym) const;
+	size_t decCount(SemSymbol * sym) const;
+	bool hasCalls() const { return myCalls; }
+	bool hasPtrReads() const { return myPtrReads; }
+	bool hasPtrWrites() const { return myPtrWrites; }
+	bool hasIO() const { return myIO; }
+	const std::set<SemSymbol *> * getUsed() const { return &myUses; }
+	const std::set<SemSymbol *> * getModified() const { 
+		return &myModified; 
+	}
+	const std::set<SemSymbol *> * getAddrTaken() const { 
+		return &myAddrTaken; 
+	}
+	const std::set<SemSymbol *> * getCallees() const { 
+		return &myCallees; 
+	}
+	const std::list<IndexNode *> * getIndexes() const { 
+		return &myIndexes; 
+	}
+private:
+	static size_t count(const HashMap<SemSymbol *, size_t>& counts, 
+		SemSymbol * sym);
+	HashMap<SemSymbol *, size_t> myDefs;
+	HashMap<SemSymbol *, size_t> myIncs;
+	HashMap<SemSymbol *, size_t> myDecs;
+	std::set<SemSymbol *> myUses;
+	std::set<SemSymbol *> myModified;
+	std::set<SemSymbol *> myAddrTaken;
+	std::set<SemSymbol *> myCallees;
+	std::list<IndexNode *> myIndexes;
+	bool myCalls;
+	bool myPtrReads;
+	bool myPtrWrites;
+	bool myIO;
+};
+
+// The variables that may change behind a function's back,
+// in a callee or through a pointer: every global, and every
+// variable whose address the function takes. Passes that
+// carry facts about variables through a function drop the
+// facts about these at each call or write through a pointer.
+class Aliases{
+public:
+	void addGlobal(const SemSymbol * sym){ myGlobals.insert(sym); }
+	//Start on a function, given what the whole of it does
+	void enterFn(const Effects * fnEffects);
+	bool isGlobal(const SemSymbol * sym) const{
+		return myGlobals.find(sym) != myGlobals.end();
+	}
+	bool addrTaken(const SemSymbol * sym) const{
+		return myAddrTaken.find(sym) != myAddrTaken.end();
+	}
+	bool aliased(const SemSymbol * sym) const{
+		return isGlobal(sym) || addrTaken(sym);
+	}
+	//Whether the effects may change any aliased variable
+	// without naming it
+	static bool hidden(const Effects * effects){
+		return effects->hasCalls() || effects->hasPtrWrites();
+	}
+private:
+	std::set<const SemSymbol *> myGlobals;
+	std::set<const SemSymbol *> myAddrTaken;
+};
+
+}
+
+#endif
@@ -19,6 +19,26 @@ static bool multiDecl(Position * pos){
 	Report::fatal(pos, "Multiply declared identifier");
 	return false;
 }
+static bool badFieldBase(Position * pos){
+	Report::fatal(pos, "Field access of non-record type");
+	return false;
+}
+static bool badField(Position * pos){
+	Report::fatal(pos, "Invalid record field name");
+	return false;
+}
+static bool missingModule(Position * pos){
+	Report::fatal(pos, "Imported module not found");
+	return false;
+}
+static bool brokenModule(Position * pos){
+	Report::fatal(pos, "Imported module has errors");
+	return false;
+}
+static bool circularImport(Position * pos){
+	Report::fatal(pos, "Circular import");
+	return false;
+}
 };
 
 } //End namespace cminusminus
@@ -33,6 +33,20 @@ private:
 };
 
 
+/* This class is used to denote a mistake made by a program
+   as it runs, such as dividing by zero, at the place in the
+   program where it was made */
+class RunError{
+public:
+	RunError(const Position * posIn, const char * msgIn)
+	: myPos(*posIn), myMsg(msgIn){}
+	Position * pos(){ return &myPos; }
+	std::string msg(){ return myMsg; }
+private:
+	Position myPos;
+	std::string myMsg;
+};
+
 /* Instances of this class are thrown to denote a situation where you
    (the student) probably need to fill in / change some functionality.
    Note that you may need to fill in / change functionality in 
@@ -51,15 +65,23 @@ private:
 class Report{
 public:
 	static void fatal(
+		std::ostream& out,
 		Position * pos,
 		const char * msg
 	){
-		std::cerr << "FATAL " 
+		out << "FATAL " 
 		<< pos->span()
 		<< ": " 
 		<< msg  << std::endl;
 	}
 
+	static void fatal(
+		Position * pos,
+		const char * msg
+	){
+		fatal(std::cerr, pos, msg);
+	}
+
 	static void fatal(
 		Position * pos,
 		const std::string msg
@@ -0,0 +1,133 @@
+#include <functional>
+#include "hash_cons.hpp"
+
+namespace cminusminus{
+
+size_t ConsKeyHash::operator()(const ConsKey& key) const{
+	size_t h = std::hash<std::string>()(key.op);
+	h = h * 31 + std::hash<const void *>()(key.sym);
+	h = h * 31 + std::hash<const void *>()(key.lhs);
+	h = h * 31 + std::hash<const void *>()(key.rhs);
+	h = h * 31 + std::hash<long>()(key.num);
+	return h;
+}
+
+HashCons * HashCons::build(TypeAnalysis * typeAnalysis,
+	Remarks * remarks){
+	HashCons * hc = new HashCons(typeAnalysis, remarks);
+	typeAnalysis->ast->rewriteExps(hc);
+	return hc;
+}
+
+ExpNode * HashCons::rewrite(ExpNode * exp){
+	ConsKey key;
+	if (!exp->consKey(&key)){ return exp; }
+	//An operator can only be shared if its operands are
+	if (key.lhs != nullptr && !isShared(key.lhs)){ return exp; }
+	if (key.rhs != nullptr && !isShared(key.rhs)){ return exp; }
+	mySeen++;
+
+	auto found = myTable.find(key);
+	if (found == myTable.end()){
+		myTable[key] = exp;
+		myCanon.insert(exp);
+		myUses[exp].push_back(*exp->pos());
+		return exp;
+	}
+
+	ExpNode * canon = found->second;
+	myUses[canon].push_back(*exp->pos());
+	//Sharing leaves is too common to be worth a remark
+	if (myRemarks != nullptr && key.lhs != nullptr){
+		myRemarks->applied("hash-cons", exp->pos(), 
+			"Shared with the same expression at "
+			+ canon->pos()->span());
+	}
+	myTypes->dropNode(exp);
+	//The operands are shared, and stay
+	exp->disownChildren();
+	delete exp;
+	return canon;
+}
+
+const std::vector<Position>& HashCons::usesOf(const ExpNode * exp){
+	return myUses[exp];
+}
+
+void HashCons::report(std::ostream& out){
+	size_t shared = mySeen - myTable.size();
+	out << mySeen << " pure expressions, " 
+	  << myTable.size() << " distinct, "
+	  << shared << " nodes shared\n";
+}
+
+bool BinaryExpNode::consKey(ConsKey * key) const{
+	key->op = opString();
+	key->lhs = myExp1;
+	key->rhs = myExp2;
+	return true;
+}
+
+bool DivideNode::consKey(ConsKey * key) const{
+	//A division that may fail isn't shared, so that a
+	// division by zero is reported where it happened rather
+	// than at the first division like it
+	ConsKey divisor;
+	if (!myExp2->consKey(&divisor) || divisor.num == 0
+	    || (divisor.op != "int" && divisor.op != "short")){
+		return false;
+	}
+	return BinaryExpNode::consKey(key);
+}
+
+bool NegNode::consKey(ConsKey * key) const{
+	key->op = "neg";
+	key->lhs = myExp;
+	return true;
+}
+
+bool NotNode::consKey(ConsKey * key) const{
+	key->op = "!";
+	key->lhs = myExp;
+	return true;
+}
+
+bool IDNode::consKey(ConsKey * key) const{
+	//Only reads of variables are shared
+	if (mySymbol == nullptr || mySymbol->getKind() != VAR){ 
+		return false; 
+	}
+	key->op = "id";
+	key->sym = mySymbol;
+	return true;
+}
+
+bool ShortLitNode::consKey(ConsKey * key) const{
+	key->op = "short";
+	key->num = myNum;
+	return true;
+}
+
+bool IntLitNode::consKey(ConsKey * key) const{
+	key->op = "int";
+	key->num = myNum;
+	return true;
+}
+
+bool StrLitNode::consKey(ConsKey * key) const{
+	key->op = "str";
+	key->num = static_cast<long>(myStrID);
+	return true;
+}
+
+bool TrueNode::consKey(ConsKey * key) const{
+	key->op = "true";
+	return true;
+}
+
+bool FalseNode::consKey(ConsKey * key) const{
+	key->op = "false";
+	return true;
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef CMINUSMINUS_HASH_CONS
+#define CMINUSMINUS_HASH_CONS
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+//The structure of a pure expression node: its operator, 
+// the (already shared) operands, and any literal value (or
+// string pool id) or symbol it refers to
+class ConsKey{
+public:
+	ConsKey() : sym(nullptr), lhs(nullptr), rhs(nullptr), num(0){ }
+	bool operator==(const ConsKey& other) const{
+		return op == other.op && sym == other.sym 
+		  && lhs == other.lhs && rhs == other.rhs
+		  && num == other.num;
+	}
+	std::string op;
+	const SemSymbol * sym;
+	const ExpNode * lhs;
+	const ExpNode * rhs;
+	long num;
+};
+
+class ConsKeyHash{
+public:
+	size_t operator()(const ConsKey& key) const;
+};
+
+// Shares structurally identical pure expressions, so that every
+// literal, every read of the same variable and every operator 
+// applied to the same (shared) operands is a single node. The 
+// tree becomes a DAG; duplicate nodes are deleted and the 
+// positions of their uses are kept in a side table. A
+// division that may fail is never shared, so that a run
+// reports the failing use rather than another. Pointer
+// equality then means structural equality, which is what 
+// CSE-style analyses want. Since shared nodes have several 
+// parents, passes that run afterwards must not modify 
+// expression nodes in place.
+class HashCons : public ExpRewriter{
+public:
+	static HashCons * build(TypeAnalysis * typeAnalysis,
+		Remarks * remarks = nullptr);
+	ExpNode * rewrite(ExpNode * exp) override;
+	//The positions of every use of a shared node
+	const std::vector<Position>& usesOf(const ExpNode * exp);
+	bool isShared(const ExpNode * exp) const{
+		return myCanon.find(exp) != myCanon.end();
+	}
+	void report(std::ostream& out);
+private:
+	HashCons(TypeAnalysis * typeAnalysis, Remarks * remarks) 
+	: myTypes(typeAnalysis), myRemarks(remarks), mySeen(0){ }
+	TypeAnalysis * myTypes;
+	Remarks * myRemarks;
+	std::unordered_map<ConsKey, ExpNode *, ConsKeyHash> myTable;
+	std::unordered_set<const ExpNode *> myCanon;
+	std::unordered_map<const ExpNode *, std::vector<Position>> myUses;
+	size_t mySeen;
+};
+
+}
+
+#endif
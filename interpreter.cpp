@@ -0,0 +1,638 @@
+#include <algorithm>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "interpreter.hpp"
+#include "ast.hpp"
+#include "errors.hpp"
+#include "string_pool.hpp"
+#include "tiers.hpp"
+#include "time_report.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+//The native stack a call may take for each level of the AST
+// of the function it runs, and on top of those, as well as
+// what is kept free at the end of the stack for failing
+static const size_t STACK_PER_LEVEL = 512;
+static const size_t STACK_PER_CALL = 4096;
+static const size_t STACK_SLACK = 256 * 1024;
+//The least native stack a run reserves
+static const size_t STACK_MIN = 64 * 1024 * 1024;
+
+void RunStats::write(std::ostream& out) const{
+	out << "steps " << steps << "\n"
+	  << "calls " << calls << "\n"
+	  << "max depth " << maxDepth << "\n"
+	  << "seconds " << seconds << "\n";
+	for (auto& tierUp : tierUps){ out << "tier up " << tierUp << "\n"; }
+}
+
+void RunStats::add(const RunStats& run){
+	steps += run.steps;
+	calls += run.calls;
+	maxDepth = std::max(maxDepth, run.maxDepth);
+}
+
+bool Interpreter::run(TypeAnalysis * types, std::istream& in,
+	std::ostream& out, RunStats * stats, bool tiered, std::ostream& err){
+	Interpreter interp(types, in, out);
+	if (tiered){ interp.myTiers = new Tiers(&interp.myStats); }
+	Stopwatch watch;
+	bool ok = true;
+	try {
+		interp.startOnStack(types->ast);
+	} catch (RunError * e){
+		out.flush();
+		Report::fatal(err, e->pos(), e->msg().c_str());
+		delete e;
+		ok = false;
+	}
+	interp.myStats.seconds = watch.lap();
+	if (stats != nullptr){ *stats = interp.myStats; }
+	return ok;
+}
+
+Interpreter::~Interpreter(){
+	delete myTiers;
+}
+
+//Half the memory of the machine, which is only committed as
+// calls reach into it, so that how deep calls go is limited
+// by memory rather than by the stack of the thread
+static size_t stackReserve(){
+	long pages = sysconf(_SC_PHYS_PAGES);
+	long pageSize = sysconf(_SC_PAGESIZE);
+	if (pages <= 0 || pageSize <= 0){ return STACK_MIN; }
+	size_t half = static_cast<size_t>(pages) / 2 * static_cast<size_t>(pageSize);
+	return std::max(STACK_MIN, half);
+}
+
+void Interpreter::startOnStack(ProgramNode * ast){
+	myAST = ast;
+	size_t size = stackReserve();
+	void * stack = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+	pthread_attr_t attr;
+	pthread_t thread;
+	bool started = false;
+	if (stack != MAP_FAILED && pthread_attr_init(&attr) == 0){
+		myStackLow = reinterpret_cast<uintptr_t>(stack) + STACK_SLACK;
+		started = pthread_attr_setstack(&attr, stack, size) == 0
+		  && pthread_create(&thread, &attr, &Interpreter::runOnStack, this) == 0;
+		pthread_attr_destroy(&attr);
+	}
+	if (started){
+		pthread_join(thread, nullptr);
+	} else {
+		//This thread's stack ends as far below here as its
+		// limit allows
+		struct rlimit limit;
+		size_t have = 8 * 1024 * 1024;
+		if (getrlimit(RLIMIT_STACK, &limit) == 0
+		  && limit.rlim_cur != RLIM_INFINITY){
+			have = static_cast<size_t>(limit.rlim_cur);
+		}
+		char here;
+		myStackLow = reinterpret_cast<uintptr_t>(&here) - have + 2 * STACK_SLACK;
+		runOnStack(this);
+	}
+	if (stack != MAP_FAILED){ munmap(stack, size); }
+	if (myError != nullptr){ std::rethrow_exception(myError); }
+}
+
+void * Interpreter::runOnStack(void * interp){
+	Interpreter * self = static_cast<Interpreter *>(interp);
+	try {
+		self->start(self->myAST);
+	} catch (...){
+		self->myError = std::current_exception();
+	}
+	return nullptr;
+}
+
+void Interpreter::start(ProgramNode * ast){
+	if (!ast->getImports().empty()){
+		throw new UserError("Only programs without imports can be run");
+	}
+	SemSymbol * main = nullptr;
+	for (auto decl : ast->getGlobals()){
+		SemSymbol * sym = decl->getSymbol();
+		if (sym->getKind() == FN){
+			NodeStats stats;
+			decl->measure(&stats, 0);
+			myFns[sym] = Callee{decl->asFn(),
+				STACK_PER_CALL + stats.maxDepth * STACK_PER_LEVEL};
+			if (sym->getName() == "main"){ main = sym; }
+		} else if (sym->getKind() == VAR && sym->getConstant() == nullptr){
+			mySlots[sym] = Slot{true, myTop};
+			myTop += cells(sym->getDataType());
+		}
+	}
+	reach(myTop);
+	if (main == nullptr){
+		throw new UserError("The program has no main function to run");
+	}
+	if (!myFns[main].decl->getFormals().empty()){
+		throw new UserError("The main function cannot take arguments");
+	}
+	call(main, std::vector<ExpNode *>(), myFns[main].decl->pos());
+	myOut.flush();
+}
+
+void Interpreter::reach(size_t end){
+	if (end <= myMemory.size()){ return; }
+	myMemory.resize(std::max(end, 2 * myMemory.size()), 0);
+}
+
+void Interpreter::copy(size_t dst, size_t src, size_t cells){
+	std::copy(myMemory.begin() + static_cast<ptrdiff_t>(src),
+	  myMemory.begin() + static_cast<ptrdiff_t>(src + cells),
+	  myMemory.begin() + static_cast<ptrdiff_t>(dst));
+}
+
+const Interpreter::Slot * Interpreter::slot(SemSymbol * var) const{
+	auto found = mySlots.find(var);
+	if (found == mySlots.end()){ return nullptr; }
+	return &found->second;
+}
+
+LoopTier * Interpreter::loopTier(WhileStmtNode * loop){
+	if (myTiers == nullptr){ return nullptr; }
+	return myTiers->loop(loop);
+}
+
+size_t Interpreter::address(SemSymbol * var) const{
+	auto found = mySlots.find(var);
+	if (found == mySlots.end()){
+		std::string msg = "No storage for " + var->getName();
+		throw new InternalError(msg.c_str());
+	}
+	const Slot& slot = found->second;
+	return slot.global ? slot.offset : myFrame + slot.offset;
+}
+
+void Interpreter::declare(SemSymbol * var){
+	size_t size = cells(var->getDataType());
+	auto found = mySlots.find(var);
+	size_t offset;
+	if (found == mySlots.end()){
+		offset = *myFrameSize;
+		*myFrameSize += size;
+		mySlots[var] = Slot{false, offset};
+	} else {
+		offset = found->second.offset;
+	}
+	size_t addr = myFrame + offset;
+	if (myTop < addr + size){
+		myTop = addr + size;
+		reach(myTop);
+	}
+	std::fill_n(myMemory.begin() + static_cast<ptrdiff_t>(addr), size, 0);
+}
+
+size_t Interpreter::deref(Cell ptr, const Position * pos) const{
+	if (ptr <= 0 || static_cast<size_t>(ptr) >= myTop){
+		fail(pos, "Dereference of an invalid pointer");
+	}
+	return static_cast<size_t>(ptr);
+}
+
+size_t Interpreter::cells(const DataType * type){
+	const ArrayType * array = type->asArray();
+	const RecordType * record = type->asRecord();
+	if (array == nullptr && record == nullptr){ return 1; }
+	auto found = myCells.find(type);
+	if (found != myCells.end()){ return found->second; }
+	size_t size = 0;
+	if (array != nullptr){
+		size = array->getLength() * cells(array->getElem());
+	} else {
+		for (auto field : *record->getFields()){
+			size += cells(field->getType());
+		}
+	}
+	myCells[type] = size;
+	return size;
+}
+
+size_t Interpreter::fieldOffset(const RecordType * record,
+	SemSymbol * field){
+	auto found = myFieldOffsets.find(field);
+	if (found != myFieldOffsets.end()){ return found->second; }
+	size_t offset = 0;
+	for (auto each : *record->getFields()){
+		myFieldOffsets[each->getSymbol()] = offset;
+		offset += cells(each->getType());
+	}
+	found = myFieldOffsets.find(field);
+	if (found == myFieldOffsets.end()){
+		std::string msg = "No field " + field->getName();
+		throw new InternalError(msg.c_str());
+	}
+	return found->second;
+}
+
+Interpreter::Cell Interpreter::call(SemSymbol * fn,
+	const std::vector<ExpNode *>& args, const Position * pos){
+	FnDeclNode * decl = callee(fn, pos);
+
+	//The actuals are evaluated in the caller's frame, and
+	// may themselves make calls
+	size_t argsAt = myArgs.size();
+	auto formal = decl->getFormals().begin();
+	for (auto arg : args){
+		size_t size = cells((*formal)->getSymbol()->getDataType());
+		if (size == 1){
+			myArgs.push_back(arg->eval(this));
+		} else {
+			size_t src = whole(arg);
+			for (size_t i = 0; i < size; i++){ myArgs.push_back(load(src + i)); }
+		}
+		++formal;
+	}
+	return enter(decl, argsAt);
+}
+
+FnDeclNode * Interpreter::callee(SemSymbol * fn, const Position * pos){
+	auto found = myFns.find(fn);
+	if (found == myFns.end()){ fail(pos, "Call to a function with no body"); }
+	char here;
+	uintptr_t top = reinterpret_cast<uintptr_t>(&here);
+	if (top < myStackLow + found->second.stack){
+		fail(pos, "Calls nested too deeply");
+	}
+	return found->second.decl;
+}
+
+Interpreter::Cell Interpreter::enter(FnDeclNode * decl, size_t argsAt){
+	size_t callerFrame = myFrame;
+	size_t * callerFrameSize = myFrameSize;
+	myFrame = myTop;
+	myFrameSize = &myFrameSizes[decl];
+	myTop = myFrame + *myFrameSize;
+	reach(myTop);
+	myDepth++;
+	myStats.calls++;
+	myStats.maxDepth = std::max(myStats.maxDepth, myDepth);
+	size_t next = argsAt;
+	for (auto formal : decl->getFormals()){
+		SemSymbol * sym = formal->getSymbol();
+		declare(sym);
+		size_t addr = address(sym);
+		size_t size = cells(sym->getDataType());
+		for (size_t i = 0; i < size; i++){ store(addr + i, myArgs[next++]); }
+	}
+	myArgs.resize(argsAt);
+
+	myResult = 0;
+	StmtCode * code = myTiers == nullptr ? nullptr : myTiers->called(decl);
+	if (code != nullptr){
+		code->exec(this);
+	} else {
+		decl->invoke(this);
+	}
+	myDepth--;
+	myTop = myFrame;
+	myFrame = callerFrame;
+	myFrameSize = callerFrameSize;
+	return myResult;
+}
+
+//Records and arrays are only ever copied from variables
+size_t Interpreter::whole(ExpNode * exp){
+	LValNode * lval = exp->asLVal();
+	if (lval == nullptr){
+		fail(exp->pos(), "Only variables can be copied whole");
+	}
+	return lval->locate(this);
+}
+
+Interpreter::Cell Interpreter::intern(const std::string& str){
+	auto found = myStringIDs.find(str);
+	if (found != myStringIDs.end()){ return found->second; }
+	Cell id = static_cast<Cell>(myStrings.size());
+	myStrings.push_back(str);
+	myStringIDs[str] = id;
+	return id;
+}
+
+Interpreter::Cell Interpreter::string(size_t strID){
+	auto found = myLiterals.find(strID);
+	if (found != myLiterals.end()){ return found->second; }
+	Cell id = intern(StringPool::contents(strID));
+	myLiterals[strID] = id;
+	return id;
+}
+
+//Input is read a word at a time. Once it runs out, every
+// read gives 0 (or the empty string)
+Interpreter::Cell Interpreter::read(const DataType * type){
+	if (type->isString()){
+		std::string word;
+		myIn >> word;
+		return intern(word);
+	}
+	long long num = 0;
+	if (!(myIn >> num)){ num = 0; }
+	if (type->isBool()){ return num != 0; }
+	return wrap(type, num);
+}
+
+void Interpreter::write(ExpNode * exp, Cell value){
+	if (myTypes->nodeType(exp)->isString()){
+		myOut << myStrings[static_cast<size_t>(value)];
+	} else {
+		myOut << value;
+	}
+}
+
+Interpreter::Cell Interpreter::wrap(const DataType * type, Cell value){
+	if (type->isShort()){
+		return static_cast<int16_t>(static_cast<uint16_t>(value));
+	}
+	if (type->isBool()){ return value != 0; }
+	return wrapInt(value);
+}
+
+void Interpreter::fail(const Position * pos, const char * msg) const{
+	throw new RunError(pos, msg);
+}
+
+static bool execAll(const std::vector<StmtNode *>& stmts,
+	Interpreter * interp){
+	for (auto stmt : stmts){
+		if (stmt->exec(interp)){ return true; }
+	}
+	return false;
+}
+
+bool StmtNode::exec(Interpreter * interp){
+	throw new InternalError("A statement that cannot be run");
+}
+
+int64_t ExpNode::eval(Interpreter * interp){
+	throw new InternalError("An expression that cannot be run");
+}
+
+void FnDeclNode::invoke(Interpreter * interp){
+	execAll(myBody, interp);
+}
+
+bool VarDeclNode::exec(Interpreter * interp){
+	interp->step();
+	interp->declare(getSymbol());
+	return false;
+}
+
+bool AssignStmtNode::exec(Interpreter * interp){
+	interp->step();
+	myExp->eval(interp);
+	return false;
+}
+
+bool ReadStmtNode::exec(Interpreter * interp){
+	interp->step();
+	size_t addr = myDst->locate(interp);
+	interp->store(addr, interp->read(myDst->resolvedType()));
+	return false;
+}
+
+bool WriteStmtNode::exec(Interpreter * interp){
+	interp->step();
+	interp->write(mySrc, mySrc->eval(interp));
+	return false;
+}
+
+bool PostDecStmtNode::exec(Interpreter * interp){
+	interp->step();
+	size_t addr = myLVal->locate(interp);
+	interp->store(addr,
+	  Interpreter::wrap(myLVal->resolvedType(), interp->load(addr) - 1));
+	return false;
+}
+
+bool PostIncStmtNode::exec(Interpreter * interp){
+	interp->step();
+	size_t addr = myLVal->locate(interp);
+	interp->store(addr,
+	  Interpreter::wrap(myLVal->resolvedType(), interp->load(addr) + 1));
+	return false;
+}
+
+bool IfStmtNode::exec(Interpreter * interp){
+	interp->step();
+	if (myCond->eval(interp)){ return execAll(myBody, interp); }
+	return false;
+}
+
+bool IfElseStmtNode::exec(Interpreter * interp){
+	interp->step();
+	if (myCond->eval(interp)){ return execAll(myBodyTrue, interp); }
+	return execAll(myBodyFalse, interp);
+}
+
+bool WhileStmtNode::exec(Interpreter * interp){
+	LoopTier * tier = interp->loopTier(this);
+	LoopCode * code = tier == nullptr ? nullptr : tier->entered();
+	if (code != nullptr){ return code->exec(interp); }
+	interp->step();
+	if (myRotated){
+		//The guard has already tested the condition
+		do {
+			if (execAll(myBody, interp)){ return true; }
+			code = tier == nullptr ? nullptr : tier->backEdge();
+			if (code != nullptr){ return code->resume(interp); }
+		} while (myCond->eval(interp));
+		return false;
+	}
+	while (myCond->eval(interp)){
+		if (execAll(myBody, interp)){ return true; }
+		code = tier == nullptr ? nullptr : tier->backEdge();
+		if (code != nullptr){ return code->resume(interp); }
+	}
+	return false;
+}
+
+bool ReturnStmtNode::exec(Interpreter * interp){
+	interp->step();
+	if (myExp != nullptr){ interp->returned(myExp->eval(interp)); }
+	return true;
+}
+
+bool CallStmtNode::exec(Interpreter * interp){
+	interp->step();
+	myCallExp->eval(interp);
+	return false;
+}
+
+int64_t LValNode::eval(Interpreter * interp){
+	interp->step();
+	return interp->load(locate(interp));
+}
+
+int64_t IDNode::eval(Interpreter * interp){
+	interp->step();
+	ExpNode * constant = mySymbol->getConstant();
+	if (constant != nullptr){ return constant->eval(interp); }
+	return interp->load(interp->address(mySymbol));
+}
+
+size_t IDNode::locate(Interpreter * interp){
+	return interp->address(mySymbol);
+}
+
+size_t DerefNode::locate(Interpreter * interp){
+	return interp->deref(myID->eval(interp), pos());
+}
+
+size_t FieldAccessNode::locate(Interpreter * interp){
+	size_t base = myBase->locate(interp);
+	const RecordType * record = myBase->resolvedType()->asRecord();
+	return base + interp->fieldOffset(record, myField->getSymbol());
+}
+
+size_t IndexNode::locate(Interpreter * interp){
+	size_t base = myBase->locate(interp);
+	int64_t index = myIndex->eval(interp);
+	const ArrayType * array = myBase->resolvedType()->asArray();
+	if (myChecked && (index < 0
+	    || static_cast<size_t>(index) >= array->getLength())){
+		interp->fail(pos(), "Array index out of bounds");
+	}
+	return base + static_cast<size_t>(index) * interp->cells(array->getElem());
+}
+
+int64_t CallExpNode::eval(Interpreter * interp){
+	interp->step();
+	return interp->call(myID->getSymbol(), myArgs, pos());
+}
+
+int64_t PlusNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return Interpreter::wrapInt(lhs + myExp2->eval(interp));
+}
+
+int64_t MinusNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return Interpreter::wrapInt(lhs - myExp2->eval(interp));
+}
+
+int64_t TimesNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return Interpreter::wrapInt(lhs * myExp2->eval(interp));
+}
+
+int64_t DivideNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	int64_t rhs = myExp2->eval(interp);
+	if (rhs == 0){ interp->fail(pos(), "Division by zero"); }
+	return Interpreter::wrapInt(lhs / rhs);
+}
+
+int64_t AndNode::eval(Interpreter * interp){
+	interp->step();
+	return myExp1->eval(interp) && myExp2->eval(interp);
+}
+
+int64_t OrNode::eval(Interpreter * interp){
+	interp->step();
+	return myExp1->eval(interp) || myExp2->eval(interp);
+}
+
+int64_t EqualsNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return lhs == myExp2->eval(interp);
+}
+
+int64_t NotEqualsNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return lhs != myExp2->eval(interp);
+}
+
+int64_t LessNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return lhs < myExp2->eval(interp);
+}
+
+int64_t LessEqNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return lhs <= myExp2->eval(interp);
+}
+
+int64_t GreaterNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return lhs > myExp2->eval(interp);
+}
+
+int64_t GreaterEqNode::eval(Interpreter * interp){
+	interp->step();
+	int64_t lhs = myExp1->eval(interp);
+	return lhs >= myExp2->eval(interp);
+}
+
+int64_t RefNode::eval(Interpreter * interp){
+	interp->step();
+	return static_cast<int64_t>(myID->locate(interp));
+}
+
+int64_t NegNode::eval(Interpreter * interp){
+	interp->step();
+	return Interpreter::wrapInt(-myExp->eval(interp));
+}
+
+int64_t NotNode::eval(Interpreter * interp){
+	interp->step();
+	return !myExp->eval(interp);
+}
+
+int64_t AssignExpNode::eval(Interpreter * interp){
+	interp->step();
+	size_t size = interp->cells(myDst->resolvedType());
+	if (size == 1){
+		int64_t value = mySrc->eval(interp);
+		interp->store(myDst->locate(interp), value);
+		return value;
+	}
+	size_t src = interp->whole(mySrc);
+	interp->copy(myDst->locate(interp), src, size);
+	return 0;
+}
+
+int64_t ShortLitNode::eval(Interpreter * interp){
+	interp->step();
+	return myNum;
+}
+
+int64_t IntLitNode::eval(Interpreter * interp){
+	interp->step();
+	return myNum;
+}
+
+int64_t StrLitNode::eval(Interpreter * interp){
+	interp->step();
+	return interp->string(myStrID);
+}
+
+int64_t TrueNode::eval(Interpreter * interp){
+	interp->step();
+	return 1;
+}
+
+int64_t FalseNode::eval(Interpreter * interp){
+	interp->step();
+	return 0;
+}
+
+}
@@ -0,0 +1,167 @@
+#ifndef CMINUSMINUS_INTERPRETER
+#define CMINUSMINUS_INTERPRETER
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cminusminus{
+
+class DataType;
+class ExpNode;
+class FnDeclNode;
+class Position;
+class ProgramNode;
+class RecordType;
+class SemSymbol;
+class Tiers;
+class LoopTier;
+class TypeAnalysis;
+class WhileStmtNode;
+
+//What a run of a program did, as output by --stats. A step
+// is one statement or expression evaluated.
+struct RunStats{
+	RunStats() : steps(0), calls(0), maxDepth(0), seconds(0){ }
+	void write(std::ostream& out) const;
+	//Count another run in with this one, other than its time
+	// and tier ups
+	void add(const RunStats& run);
+	uint64_t steps;
+	uint64_t calls;
+	size_t maxDepth;
+	double seconds;
+	//The functions and loops that moved to the compiled
+	// tier, in the order they did
+	std::vector<std::string> tierUps;
+};
+
+//Runs a checked program by walking its AST. Every variable
+// is a run of cells in a single memory: a scalar takes one
+// cell, and a record or array one cell for each scalar in
+// it. The globals come first, followed by the frames of the
+// calls being run. Address 0 is never used, so that it can
+// stand for a null pointer.
+class Interpreter{
+public:
+	typedef int64_t Cell;
+	//Run the main function of the program, reading input
+	// from in and writing output to out. Returns false if
+	// the program made a mistake, which is reported as a
+	// diagnostic on err. A tiered run compiles the functions
+	// and loops that run often
+	static bool run(TypeAnalysis * types, std::istream& in,
+		std::ostream& out, RunStats * stats, bool tiered = false,
+		std::ostream& err = std::cerr);
+
+	//What the nodes use to run themselves
+	void step(){ myStats.steps++; }
+	void steps(uint64_t count){ myStats.steps += count; }
+	Cell load(size_t addr) const { return myMemory[addr]; }
+	void store(size_t addr, Cell value){ myMemory[addr] = value; }
+	void copy(size_t dst, size_t src, size_t cells);
+	//The location of a record or array being copied
+	size_t whole(ExpNode * exp);
+	//The address of a variable in the current frame or
+	// among the globals
+	size_t address(SemSymbol * var) const;
+	//Make room in the current frame for a local whose
+	// declaration has been reached
+	void declare(SemSymbol * var);
+	//The address a pointer points to, which must be in use
+	size_t deref(Cell ptr, const Position * pos) const;
+	size_t cells(const DataType * type);
+	size_t fieldOffset(const RecordType * record, SemSymbol * field);
+	Cell call(SemSymbol * fn, const std::vector<ExpNode *>& args,
+		const Position * pos);
+	//A call in parts: the function being called, which is
+	// checked before the actuals are evaluated, the actuals,
+	// and then the call itself, with the actuals pushed
+	// since argsAt
+	FnDeclNode * callee(SemSymbol * fn, const Position * pos);
+	size_t pendingArgs() const { return myArgs.size(); }
+	void pushArg(Cell value){ myArgs.push_back(value); }
+	Cell enter(FnDeclNode * decl, size_t argsAt);
+	//Where a variable is: at an address among the globals,
+	// or at an offset in the frame of its function
+	struct Slot{
+		bool global;
+		size_t offset;
+	};
+	//Where a variable is, or nullptr if it has no storage
+	// yet. A variable stays where it is once it has some
+	const Slot * slot(SemSymbol * var) const;
+	size_t frame() const { return myFrame; }
+	//The tier of a loop, or nullptr if the run isn't tiered
+	LoopTier * loopTier(WhileStmtNode * loop);
+	void returned(Cell value){ myResult = value; }
+	Cell string(size_t strID);
+	Cell read(const DataType * type);
+	void write(ExpNode * exp, Cell value);
+	//Keep a value within the range of its type, wrapping
+	// around as two's complement does
+	static Cell wrap(const DataType * type, Cell value);
+	static Cell wrapInt(Cell value){
+		return static_cast<int32_t>(static_cast<uint32_t>(value));
+	}
+	[[noreturn]] void fail(const Position * pos, const char * msg) const;
+private:
+	Interpreter(TypeAnalysis * types, std::istream& in, std::ostream& out)
+	: myTypes(types), myIn(in), myOut(out), myFrame(0), myTop(1),
+	  myFrameSize(nullptr), myDepth(0), myResult(0), myTiers(nullptr),
+	  myStackLow(0){ }
+	~Interpreter();
+	//Run the program on a native stack of its own (or, if
+	// there is no memory for one, on this thread's stack)
+	void startOnStack(ProgramNode * ast);
+	static void * runOnStack(void * interp);
+	void start(ProgramNode * ast);
+	//Make sure the memory reaches an address
+	void reach(size_t end);
+	//The one copy of a string's contents
+	Cell intern(const std::string& str);
+	TypeAnalysis * myTypes;
+	std::istream& myIn;
+	std::ostream& myOut;
+	std::vector<Cell> myMemory;
+	size_t myFrame;
+	size_t myTop;
+	//The size of the frame of the running function, which
+	// grows as its declarations are first reached
+	size_t * myFrameSize;
+	size_t myDepth;
+	Cell myResult;
+	//The actuals of calls, between being evaluated and
+	// being copied into the frame of the callee
+	std::vector<Cell> myArgs;
+	std::unordered_map<SemSymbol *, Slot> mySlots;
+	//A function, and the native stack a call of it may take
+	// before it calls another
+	struct Callee{
+		FnDeclNode * decl;
+		size_t stack;
+	};
+	std::unordered_map<SemSymbol *, Callee> myFns;
+	std::unordered_map<FnDeclNode *, size_t> myFrameSizes;
+	std::unordered_map<const DataType *, size_t> myCells;
+	std::unordered_map<SemSymbol *, size_t> myFieldOffsets;
+	std::unordered_map<size_t, Cell> myLiterals;
+	std::unordered_map<std::string, Cell> myStringIDs;
+	std::vector<std::string> myStrings;
+	RunStats myStats;
+	Tiers * myTiers;
+	//The lowest address of the native stack that calls may
+	// use, and what the program running on it threw
+	uintptr_t myStackLow;
+	ProgramNode * myAST;
+	std::exception_ptr myError;
+};
+
+}
+
+#endif
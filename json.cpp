@@ -0,0 +1,253 @@
+#include <cstdlib>
+#include <sstream>
+#include "json.hpp"
+
+namespace cminusminus{
+
+Json::~Json(){
+	for (auto elem : myElems){
+		delete elem;
+	}
+}
+
+static void skipSpace(const std::string& text, size_t& i){
+	while (i < text.length() && (text[i] == ' ' || text[i] == '\t'
+		|| text[i] == '\n' || text[i] == '\r')){
+		i++;
+	}
+}
+
+static bool skipWord(const std::string& text, size_t& i,
+	const char * word){
+	std::string w(word);
+	if (text.compare(i, w.length(), w) != 0){ return false; }
+	i += w.length();
+	return true;
+}
+
+Json * Json::parse(const std::string& text){
+	size_t i = 0;
+	Json * res = parseValue(text, i);
+	if (res == nullptr){ return nullptr; }
+	skipSpace(text, i);
+	if (i != text.length()){
+		delete res;
+		return nullptr;
+	}
+	return res;
+}
+
+//Append a code point to a string as UTF-8
+static void appendUTF8(std::string& out, unsigned long cp){
+	if (cp < 0x80){
+		out += static_cast<char>(cp);
+	} else if (cp < 0x800){
+		out += static_cast<char>(0xC0 | (cp >> 6));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	} else if (cp < 0x10000){
+		out += static_cast<char>(0xE0 | (cp >> 12));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	} else {
+		out += static_cast<char>(0xF0 | (cp >> 18));
+		out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+}
+
+bool Json::parseString(const std::string& text, size_t& i,
+	std::string& out){
+	if (i >= text.length() || text[i] != '"'){ return false; }
+	i++;
+	while (i < text.length()){
+		char c = text[i++];
+		if (c == '"'){ return true; }
+		if (c != '\\'){
+			out += c;
+			continue;
+		}
+		if (i >= text.length()){ return false; }
+		char esc = text[i++];
+		switch (esc){
+			case '"': out += '"'; break;
+			case '\\': out += '\\'; break;
+			case '/': out += '/'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': {
+				if (i + 4 > text.length()){ return false; }
+				std::string hex = text.substr(i, 4);
+				i += 4;
+				unsigned long cp = strtoul(hex.c_str(), nullptr, 16);
+				//A surrogate pair encodes a single code point
+				if (cp >= 0xD800 && cp < 0xDC00
+				  && text.compare(i, 2, "\\u") == 0
+				  && i + 6 <= text.length()){
+					std::string low = text.substr(i + 2, 4);
+					unsigned long lo = strtoul(low.c_str(), nullptr, 16);
+					if (lo >= 0xDC00 && lo < 0xE000){
+						i += 6;
+						cp = 0x10000 + ((cp - 0xD800) << 10)
+							+ (lo - 0xDC00);
+					}
+				}
+				appendUTF8(out, cp);
+				break;
+			}
+			default: return false;
+		}
+	}
+	return false;
+}
+
+Json * Json::parseValue(const std::string& text, size_t& i){
+	skipSpace(text, i);
+	if (i >= text.length()){ return nullptr; }
+	char c = text[i];
+	if (c == '{'){
+		Json * obj = new Json(OBJECT);
+		i++;
+		skipSpace(text, i);
+		if (i < text.length() && text[i] == '}'){
+			i++;
+			return obj;
+		}
+		while (true){
+			skipSpace(text, i);
+			std::string key;
+			if (!parseString(text, i, key)){ break; }
+			skipSpace(text, i);
+			if (i >= text.length() || text[i] != ':'){ break; }
+			i++;
+			Json * val = parseValue(text, i);
+			if (val == nullptr){ break; }
+			obj->myKeys.push_back(key);
+			obj->myElems.push_back(val);
+			skipSpace(text, i);
+			if (i < text.length() && text[i] == ','){
+				i++;
+			} else if (i < text.length() && text[i] == '}'){
+				i++;
+				return obj;
+			} else {
+				break;
+			}
+		}
+		delete obj;
+		return nullptr;
+	}
+	if (c == '['){
+		Json * arr = new Json(ARRAY);
+		i++;
+		skipSpace(text, i);
+		if (i < text.length() && text[i] == ']'){
+			i++;
+			return arr;
+		}
+		while (true){
+			Json * val = parseValue(text, i);
+			if (val == nullptr){ break; }
+			arr->myElems.push_back(val);
+			skipSpace(text, i);
+			if (i < text.length() && text[i] == ','){
+				i++;
+			} else if (i < text.length() && text[i] == ']'){
+				i++;
+				return arr;
+			} else {
+				break;
+			}
+		}
+		delete arr;
+		return nullptr;
+	}
+	if (c == '"'){
+		Json * str = new Json(STRING);
+		if (!parseString(text, i, str->myStr)){
+			delete str;
+			return nullptr;
+		}
+		return str;
+	}
+	if (skipWord(text, i, "true")){
+		Json * b = new Json(BOOLEAN);
+		b->myNum = 1;
+		return b;
+	}
+	if (skipWord(text, i, "false")){ return new Json(BOOLEAN); }
+	if (skipWord(text, i, "null")){ return new Json(NUL); }
+
+	const char * start = text.c_str() + i;
+	char * end = nullptr;
+	double val = strtod(start, &end);
+	if (end == start){ return nullptr; }
+	i += static_cast<size_t>(end - start);
+	Json * num = new Json(NUMBER);
+	num->myNum = val;
+	num->myStr = std::string(start, static_cast<size_t>(end - start));
+	return num;
+}
+
+Json * Json::get(const std::string& key) const{
+	if (myKind != OBJECT){ return nullptr; }
+	for (size_t i = 0; i < myKeys.size(); i++){
+		if (myKeys[i] == key){ return myElems[i]; }
+	}
+	return nullptr;
+}
+
+std::string Json::quote(const std::string& str){
+	std::string out = "\"";
+	for (char c : str){
+		switch (c){
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20){
+					const char * hex = "0123456789abcdef";
+					out += "\\u00";
+					out += hex[(c >> 4) & 0xF];
+					out += hex[c & 0xF];
+				} else {
+					out += c;
+				}
+		}
+	}
+	out += '"';
+	return out;
+}
+
+std::string Json::dump() const{
+	switch (myKind){
+		case NUL: return "null";
+		case BOOLEAN: return truth() ? "true" : "false";
+		case NUMBER: return myStr;
+		case STRING: return quote(myStr);
+		case ARRAY: {
+			std::string out = "[";
+			for (size_t i = 0; i < myElems.size(); i++){
+				if (i > 0){ out += ","; }
+				out += myElems[i]->dump();
+			}
+			return out + "]";
+		}
+		case OBJECT: {
+			std::string out = "{";
+			for (size_t i = 0; i < myElems.size(); i++){
+				if (i > 0){ out += ","; }
+				out += quote(myKeys[i]) + ":" + myElems[i]->dump();
+			}
+			return out + "}";
+		}
+	}
+	return "null";
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef CMINUSMINUS_JSON
+#define CMINUSMINUS_JSON
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cminusminus{
+
+//A parsed JSON value, as exchanged with editors by the
+// language server. Arrays and objects own their elements.
+// Output is written directly as text, with quote() used
+// for strings.
+class Json{
+public:
+	enum Kind{
+		NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT
+	};
+	~Json();
+	//Parse a complete JSON text, or return nullptr if it
+	// is malformed
+	static Json * parse(const std::string& text);
+	//A string as a JSON string literal, quotes included
+	static std::string quote(const std::string& str);
+
+	Kind kind() const { return myKind; }
+	bool truth() const { return myKind == BOOLEAN && myNum != 0; }
+	double num() const { return myNum; }
+	const std::string& str() const { return myStr; }
+	size_t size() const { return myElems.size(); }
+	Json * at(size_t i) const { return myElems[i]; }
+	//The member of an object with the given key, or
+	// nullptr if this is not an object or has no such member
+	Json * get(const std::string& key) const;
+	//The value written back out as JSON text
+	std::string dump() const;
+private:
+	Json(Kind kindIn) : myKind(kindIn), myNum(0){ }
+	static Json * parseValue(const std::string& text, size_t& i);
+	static bool parseString(const std::string& text, size_t& i,
+		std::string& out);
+	Kind myKind;
+	double myNum;
+	std::string myStr;
+	std::vector<Json *> myElems;
+	std::vector<std::string> myKeys;
+};
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+#include <cstdlib>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+#include "lsp.hpp"
+#include "json.hpp"
+
+namespace cminusminus{
+
+static std::string diagnosticsJson(const std::vector<Diagnostic>& diags){
+	std::string out = "[";
+	for (auto& diag : diags){
+		if (out.length() > 1){ out += ","; }
+		//LSP positions count from 0
+		out += "{\"range\":{\"start\":{\"line\":" 
+			+ std::to_string(diag.line - 1)
+			+ ",\"character\":" + std::to_string(diag.col - 1)
+			+ "},\"end\":{\"line\":" + std::to_string(diag.endLine - 1)
+			+ ",\"character\":" + std::to_string(diag.endCol - 1)
+			+ "}},\"severity\":1,\"source\":\"cmmc\",\"message\":"
+			+ Json::quote(diag.msg) + "}";
+	}
+	return out + "]";
+}
+
+int LanguageServer::serve(){
+	//Anything the compiler writes to std::cout would corrupt
+	// the protocol, so it is discarded and messages go
+	// straight to the stream buffer instead
+	std::ostream wire(std::cout.rdbuf());
+	std::cout.rdbuf(nullptr);
+	LanguageServer server(wire);
+	std::string body;
+	while (!server.myExit && server.readMessage(body, true)){
+		//Catch up on every message already sent before
+		// analyzing, so that a burst of edits is analyzed once
+		do {
+			Json * msg = Json::parse(body);
+			if (msg != nullptr){ server.handle(msg); }
+			delete msg;
+		} while (!server.myExit && server.readMessage(body, false));
+		server.flush();
+	}
+	return server.myShutdown ? 0 : 1;
+}
+
+bool LanguageServer::readMessage(std::string& body, bool block){
+	const std::string lengthField = "Content-Length:";
+	while (true){
+		size_t headerEnd = myInput.find("\r\n\r\n");
+		if (headerEnd != std::string::npos){
+			size_t length = 0;
+			size_t field = myInput.find(lengthField);
+			if (field != std::string::npos && field < headerEnd){
+				length = std::strtoul(myInput.c_str() + field
+					+ lengthField.length(), nullptr, 10);
+			}
+			size_t bodyAt = headerEnd + 4;
+			if (myInput.length() >= bodyAt + length){
+				body = myInput.substr(bodyAt, length);
+				myInput.erase(0, bodyAt + length);
+				return true;
+			}
+		}
+		if (!block){
+			struct pollfd in;
+			in.fd = 0;
+			in.events = POLLIN;
+			in.revents = 0;
+			if (poll(&in, 1, 0) <= 0){ return false; }
+		}
+		char buf[65536];
+		ssize_t got = read(0, buf, sizeof(buf));
+		if (got <= 0){ return false; }
+		myInput.append(buf, static_cast<size_t>(got));
+	}
+}
+
+void LanguageServer::send(const std::string& body){
+	myWire << "Content-Length: " << body.length() << "\r\n\r\n" << body;
+	myWire.flush();
+}
+
+//The id of a request as it is sent back, which is null if
+// the request had none
+static std::string idText(Json * id){
+	return id == nullptr ? "null" : id->dump();
+}
+
+void LanguageServer::reply(Json * id, const std::string& result){
+	send("{\"jsonrpc\":\"2.0\",\"id\":" + idText(id)
+		+ ",\"result\":" + result + "}");
+}
+
+void LanguageServer::replyError(Json * id, int code,
+	const std::string& msg){
+	send("{\"jsonrpc\":\"2.0\",\"id\":" + idText(id)
+		+ ",\"error\":{\"code\":" + std::to_string(code)
+		+ ",\"message\":" + Json::quote(msg) + "}}");
+}
+
+static size_t field(Json * obj, const char * key){
+	Json * val = obj == nullptr ? nullptr : obj->get(key);
+	if (val == nullptr || val->kind() != Json::NUMBER){ return 0; }
+	return static_cast<size_t>(val->num());
+}
+
+static std::string text(Json * obj, const char * key){
+	Json * val = obj == nullptr ? nullptr : obj->get(key);
+	if (val == nullptr || val->kind() != Json::STRING){ return ""; }
+	return val->str();
+}
+
+void LanguageServer::handle(Json * msg){
+	std::string method = text(msg, "method");
+	Json * id = msg->get("id");
+	Json * params = msg->get("params");
+	Json * doc = params == nullptr ? nullptr : params->get("textDocument");
+	std::string uri = text(doc, "uri");
+
+	if (method == "initialize"){
+		Json * caps = params == nullptr ? nullptr
+			: params->get("capabilities");
+		Json * docCaps = caps == nullptr ? nullptr
+			: caps->get("textDocument");
+		myPull = docCaps != nullptr
+			&& docCaps->get("diagnostic") != nullptr;
+		reply(id, "{\"capabilities\":{\"textDocumentSync\":"
+			"{\"openClose\":true,\"change\":2,\"save\":true},"
+			"\"diagnosticProvider\":{\"interFileDependencies\":false,"
+			"\"workspaceDiagnostics\":false}},"
+			"\"serverInfo\":{\"name\":\"cmmc\"}}");
+	} else if (method == "shutdown"){
+		//Answer whatever came before
+		flush();
+		myShutdown = true;
+		reply(id, "null");
+	} else if (method == "exit"){
+		myExit = true;
+	} else if (method == "textDocument/didOpen"){
+		myDocs.setSource(uri, text(doc, "text"));
+		myOpen.insert(uri);
+		myEdited.insert(uri);
+	} else if (method == "textDocument/didChange"){
+		Json * changes = params == nullptr ? nullptr
+			: params->get("contentChanges");
+		if (!myDocs.hasSource(uri) || changes == nullptr){ return; }
+		for (size_t i = 0; i < changes->size(); i++){
+			Json * change = changes->at(i);
+			Json * range = change->get("range");
+			if (range == nullptr){
+				myDocs.setSource(uri, text(change, "text"));
+				continue;
+			}
+			Json * start = range->get("start");
+			Json * end = range->get("end");
+			myDocs.editSource(uri,
+				field(start, "line"), field(start, "character"),
+				field(end, "line"), field(end, "character"),
+				text(change, "text"));
+		}
+		myEdited.insert(uri);
+		//Requests about the document before the edit are
+		// stale, so the editor should ask again
+		for (auto it = myPulls.begin(); it != myPulls.end(); ){
+			if (it->second != uri){ ++it; continue; }
+			send("{\"jsonrpc\":\"2.0\",\"id\":" + it->first
+				+ ",\"error\":{\"code\":-32802,\"message\":"
+				"\"Document changed\",\"data\":"
+				"{\"retriggerRequest\":true}}}");
+			it = myPulls.erase(it);
+		}
+	} else if (method == "textDocument/didSave"){
+		//Any document may import the one saved
+		myDocs.saved(uri);
+		myEdited.insert(myOpen.begin(), myOpen.end());
+	} else if (method == "textDocument/didClose"){
+		if (myDocs.hasSource(uri)){ myDocs.removeSource(uri); }
+		myOpen.erase(uri);
+		myEdited.erase(uri);
+		if (!myPull){
+			send("{\"jsonrpc\":\"2.0\",\"method\":"
+				"\"textDocument/publishDiagnostics\",\"params\":"
+				"{\"uri\":" + Json::quote(uri) + ",\"diagnostics\":[]}}");
+		}
+	} else if (method == "textDocument/diagnostic"){
+		//A request without an id can't be answered
+		if (id == nullptr){ return; }
+		myPulls.push_back(std::make_pair(id->dump(), uri));
+	} else if (method == "$/cancelRequest"){
+		Json * cancelled = params == nullptr ? nullptr : params->get("id");
+		if (cancelled == nullptr){ return; }
+		for (auto it = myPulls.begin(); it != myPulls.end(); ++it){
+			if (it->first != cancelled->dump()){ continue; }
+			replyError(cancelled, -32800, "Request cancelled");
+			myPulls.erase(it);
+			break;
+		}
+	} else if (id != nullptr){
+		replyError(id, -32601, "Unhandled method " + method);
+	}
+}
+
+void LanguageServer::flush(){
+	for (auto& uri : myEdited){
+		if (!myPull && myDocs.hasSource(uri)){ publish(uri); }
+	}
+	myEdited.clear();
+	for (auto& pull : myPulls){
+		std::string items = "[]";
+		if (myDocs.hasSource(pull.second)){
+			items = diagnosticsJson(myDocs.diagnostics(pull.second));
+		}
+		send("{\"jsonrpc\":\"2.0\",\"id\":" + pull.first
+			+ ",\"result\":{\"kind\":\"full\",\"items\":" + items + "}}");
+	}
+	myPulls.clear();
+	myDocs.releaseUnused();
+}
+
+void LanguageServer::publish(const std::string& uri){
+	send("{\"jsonrpc\":\"2.0\",\"method\":"
+		"\"textDocument/publishDiagnostics\",\"params\":{\"uri\":"
+		+ Json::quote(uri) + ",\"diagnostics\":"
+		+ diagnosticsJson(myDocs.diagnostics(uri)) + "}}");
+}
+
+}
@@ -0,0 +1,50 @@
+#ifndef CMINUSMINUS_LSP
+#define CMINUSMINUS_LSP
+
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "compilation.hpp"
+
+namespace cminusminus{
+
+class Json;
+
+//A Language Server Protocol server on stdin and stdout,
+// which publishes the diagnostics of each open document as
+// it is edited
+class LanguageServer{
+public:
+	//Serve an editor until it exits. Returns the exit code
+	static int serve();
+private:
+	LanguageServer(std::ostream& wire) : myWire(wire),
+	  myPull(false), myShutdown(false), myExit(false){ }
+	bool readMessage(std::string& body, bool block);
+	void handle(Json * msg);
+	void flush();
+	void send(const std::string& body);
+	void reply(Json * id, const std::string& result);
+	void replyError(Json * id, int code, const std::string& msg);
+	void publish(const std::string& uri);
+	std::ostream& myWire;
+	std::string myInput;
+	//The open documents, by URI
+	Compilation myDocs;
+	std::unordered_set<std::string> myOpen;
+	//Documents edited since diagnostics were last sent
+	std::unordered_set<std::string> myEdited;
+	//Whether the editor asks for diagnostics rather than
+	// having them published
+	bool myPull;
+	//Diagnostic requests held until their document is
+	// analyzed: the id of each, and its document
+	std::vector<std::pair<std::string, std::string>> myPulls;
+	bool myShutdown;
+	bool myExit;
+};
+
+}
+
+#endif
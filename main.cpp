@@ -1,21 +1,67 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <fstream>
+#include <sstream>
 #include "errors.hpp"
 #include "scanner.hpp"
 #include "name_analysis.hpp"
 #include "type_analysis.hpp"
+#include "record_layout.hpp"
+#include "passes.hpp"
+#include "remarks.hpp"
+#include "superopt.hpp"
+#include "interpreter.hpp"
+#include "batch.hpp"
+#include "time_report.hpp"
+#include "compilation.hpp"
+#include "modules.hpp"
+#include "lsp.hpp"
+#include "watch.hpp"
 
 using namespace cminusminus;
 
 static void usageAndDie(){
-	std::cerr << "Usage: cmmc <infile>"
+	std::cerr << "Usage: cmmc --lsp: Serve diagnostics to an editor"
+	<< " over stdin and stdout (Language Server Protocol)\n"
+	<< "       cmmc --watch <dir>: Recheck the .cmm files in <dir>"
+	<< " as they change\n"
+	<< "       cmmc <infile>"
 	<< " [-t <tokensFile>]: Output tokens to <tokensFile>\n"
 	<< " [-p]: Parse the input to check syntax\n"
 	<< " [-u <unparseFile>]: Output canonical program form\n"
 	<< " [-n <nameFile>]: Output program with IDs annotated with symbols\n"
 	<< " [-c]: Perform type analysis / typecheck the program\n"
+	<< " [--fused]: Resolve names and types in a single pass for -c\n"
+	<< " [--time-report=functions[:N]]: Output the N functions that"
+	<< " took -c longest (default 10)\n"
+	<< " [-l <layoutFile>]: Output the memory layout of each record\n"
+	<< " [--split-cold]: Move rarely-accessed record fields to a cold block\n"
+	<< " [-b <boundsFile>]: Output which array bounds checks are eliminated\n"
+	<< " [-o <optFile>]: Output the optimized program, annotated as for -n\n"
+	<< " [--hash-cons]: Share identical pure expressions when optimizing\n"
+	<< " [--passes=<p1,p2,...>]: The passes to optimize with"
+	<< " (default fold,dead-args,copy-prop,cond-elim,scev)\n"
+	<< " [--superopt-rules=<rulesFile>]: Look expressions up in"
+	<< " <rulesFile> for the superopt pass\n"
+	<< " [--superopt-search]: Search for the expressions not in"
+	<< " <rulesFile>, adding what is found to it\n"
+	<< " [--time-passes]: Output the time spent in each pass\n"
+	<< " [--remarks=<remarksFile>]: Output what each pass did and did"
+	<< " not do, and why\n"
+	<< " [--remarks-passes=<p1,...>]: Only output remarks of these"
+	<< " passes\n"
+	<< " [--remarks-fns=<f1,...>]: Only output remarks in these"
+	<< " functions\n"
+	<< " [-s <shareFile>]: Output statistics of shared expressions\n"
+	<< " [--run]: Run the optimized program, with input from stdin\n"
+	<< " [--tiered]: Compile the functions and loops that run often,"
+	<< " switching to them as the run goes on\n"
+	<< " [--run-batch <input> ...]: Run the optimized program once"
+	<< " for each input, in parallel, outputting each run's output"
+	<< " under a header naming its input\n"
+	<< " [--stats]: Output what the run did to stderr\n"
 	;
 	exit(1);
 }
@@ -86,7 +132,7 @@ static cminusminus::NameAnalysis * doNameAnalysis(const char * inputPath){
 	cminusminus::ProgramNode * ast = parse(inputPath);
 	if (ast == nullptr){ return nullptr; }
 	
-	return cminusminus::NameAnalysis::build(ast);
+	return cminusminus::NameAnalysis::build(ast, new Modules(), inputPath);
 }
 
 static bool doUnparsing(const char * inputPath, const char * outPath){
@@ -100,16 +146,183 @@ static bool doUnparsing(const char * inputPath, const char * outPath){
 	return true;
 }
 
-static cminusminus::TypeAnalysis * doTypeAnalysis(const char * inputPath){
+static bool doLayout(const char * inputPath, const char * outPath,
+	bool splitCold){
 	cminusminus::NameAnalysis * nameAnalysis = doNameAnalysis(inputPath);
-	if (nameAnalysis == nullptr){ return nullptr; }
-	return TypeAnalysis::build(nameAnalysis);
+	if (nameAnalysis == nullptr){ return false; }
+	RecordLayout * layout = RecordLayout::build(nameAnalysis, splitCold);
+	if (strcmp(outPath, "--") == 0){
+		layout->report(std::cout);
+	} else {
+		std::ofstream outStream(outPath);
+		if (!outStream.good()){
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new cminusminus::InternalError(msg.c_str());
+		}
+		layout->report(outStream);
+	}
+	return true;
+}
+
+//Check the program through the compiler's queries, which 
+// analyze each global declaration separately, and report
+// where the time went if asked to
+static bool doChecking(const char * inputPath, TimeReport * report){
+	std::ifstream inStream(inputPath);
+	if (!inStream.good()){
+		std::string msg = "Bad input stream ";
+		msg += inputPath;
+		throw new UserError(msg.c_str());
+	}
+	std::stringstream text;
+	text << inStream.rdbuf();
+
+	Compilation compilation;
+	compilation.setSource(inputPath, text.str());
+	if (!compilation.parses(inputPath)){
+		//Parse the whole program again, which reports the
+		// first syntax error just as it always has
+		parse(inputPath);
+		return false;
+	}
+	const auto& diags = compilation.diagnostics(inputPath);
+	size_t failedAt = 0;
+	std::exception_ptr failure = compilation.failure(inputPath, &failedAt);
+	size_t count = failure ? failedAt : diags.size();
+	for (size_t i = 0; i < count; i++){
+		const Diagnostic& diag = diags[i];
+		Position pos(diag.line, diag.col, diag.endLine, diag.endCol);
+		Report::fatal(&pos, diag.msg);
+	}
+	if (report != nullptr){
+		compilation.timeFns(inputPath, report);
+		report->write(std::cerr);
+	}
+	//An error in the compiler itself stops it, as it always has
+	if (failure){ std::rethrow_exception(failure); }
+	return compilation.passes(inputPath);
+}
+
+static cminusminus::TypeAnalysis * doFusedAnalysis(const char * inputPath){
+	cminusminus::ProgramNode * ast = parse(inputPath);
+	if (ast == nullptr){ return nullptr; }
+	return TypeAnalysis::buildFused(ast, new Modules(), inputPath);
+}
+
+//How the optimizer runs, and what it reports
+struct OptOptions{
+	OptOptions() : pipeline("fold,dead-args,copy-prop,cond-elim,scev"), timePasses(false),
+	  remarksFile(nullptr), rulesFile(nullptr), superoptSearch(false){ }
+	std::string pipeline;
+	bool timePasses;
+	const char * remarksFile;
+	const char * rulesFile;
+	bool superoptSearch;
+	std::string remarksPasses;
+	std::string remarksFns;
+};
+
+//Run the passes of a pipeline over the program
+static PassManager * doOptimization(const char * inputPath,
+	const OptOptions& opts){
+	cminusminus::ProgramNode * ast = parse(inputPath);
+	if (ast == nullptr){ return nullptr; }
+	PassManager * pm = new PassManager(ast, new Modules(), inputPath);
+	if (opts.remarksFile != nullptr){
+		Remarks * remarks = new Remarks(ast);
+		remarks->onlyPasses(opts.remarksPasses);
+		remarks->onlyFns(opts.remarksFns);
+		pm->setRemarks(remarks);
+	}
+	if (opts.rulesFile != nullptr){
+		pm->setRules(RuleDatabase::load(opts.rulesFile, opts.superoptSearch));
+	}
+	if (!pm->runAll(opts.pipeline)){ return nullptr; }
+	return pm;
+}
+
+//Output what the passes have to say, once they are done
+static void finishOptimization(PassManager * pm, const OptOptions& opts){
+	if (opts.timePasses){ pm->reportTimes(std::cerr); }
+	if (pm->rules() != nullptr){ pm->rules()->save(); }
+	if (opts.remarksFile == nullptr){ return; }
+	if (strcmp(opts.remarksFile, "--") == 0){
+		pm->remarks()->write(std::cout);
+	} else {
+		std::ofstream outStream(opts.remarksFile);
+		if (!outStream.good()){
+			std::string msg = "Bad output file ";
+			msg += opts.remarksFile;
+			throw new cminusminus::InternalError(msg.c_str());
+		}
+		pm->remarks()->write(outStream);
+	}
+}
+
+static void outputReport(Pass * pass, const char * outPath){
+	if (strcmp(outPath, "--") == 0){
+		pass->report(std::cout);
+	} else {
+		std::ofstream outStream(outPath);
+		if (!outStream.good()){
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new cminusminus::InternalError(msg.c_str());
+		}
+		pass->report(outStream);
+	}
+}
+
+//Run the program once the passes are done with it, which
+// fails if the program makes a mistake as it runs
+static bool doRun(PassManager * pm, bool showStats, bool tiered){
+	RunStats stats;
+	bool ran = Interpreter::run(pm->types(), std::cin, std::cout, &stats,
+		tiered);
+	if (showStats){ stats.write(std::cerr); }
+	return ran;
+}
+
+//Run the program over each input, which fails if any run
+// does
+static bool doRunBatch(PassManager * pm,
+	const std::vector<std::string>& inputs, bool showStats, bool tiered){
+	RunStats stats;
+	bool ran = Batch::run(pm->types(), inputs, std::cout, &stats, tiered);
+	if (showStats){ stats.write(std::cerr); }
+	return ran;
+}
+
+static bool doSharing(const char * inputPath, const char * outPath,
+	const OptOptions& opts){
+	PassManager * pm = doOptimization(inputPath, opts);
+	if (pm == nullptr){ return false; }
+	if (pm->ran("hash-cons") == nullptr){ pm->run("hash-cons"); }
+	outputReport(pm->ran("hash-cons"), outPath);
+	finishOptimization(pm, opts);
+	return true;
+}
+
+static bool doBoundsChecks(const char * inputPath, const char * outPath,
+	const OptOptions& opts){
+	PassManager * pm = doOptimization(inputPath, opts);
+	if (pm == nullptr || !pm->run("bounds")){ return false; }
+	outputReport(pm->analysis("bounds"), outPath);
+	finishOptimization(pm, opts);
+	return true;
 }
 
 int 
 main( const int argc, const char **argv )
 {
 	if (argc <= 1){ usageAndDie(); }
+	if (argc == 2 && strcmp(argv[1], "--lsp") == 0){
+		return LanguageServer::serve();
+	}
+	if (argc == 3 && strcmp(argv[1], "--watch") == 0){
+		return Watcher::watch(argv[2]);
+	}
 	std::ifstream * input = new std::ifstream(argv[1]);
 	if (input == nullptr){ usageAndDie(); }
 	if (!input->good()){
@@ -123,12 +336,67 @@ main( const int argc, const char **argv )
 	const char * unparseFile = NULL;
 	const char * namesFile = NULL;
 	bool checkTypes = false;
+	bool fused = false;
+	const char * layoutFile = NULL;
+	bool splitCold = false;
+	const char * boundsFile = NULL;
+	const char * optFile = NULL;
+	bool hashCons = false;
+	const char * shareFile = NULL;
+	bool run = false;
+	//The inputs given after --run-batch
+	bool runBatch = false;
+	std::vector<std::string> batchInputs;
+	bool showStats = false;
+	bool tiered = false;
+	OptOptions opts;
+	TimeReport * timeReport = nullptr;
 
 	bool useful = false;
 	int i = 1;
 	for (int i = 1 ; i < argc ; i++){
 		if (argv[i][0] == '-'){
-			if (argv[i][1] == 't'){
+			if (strcmp(argv[i], "--split-cold") == 0){
+				splitCold = true;
+			} else if (strcmp(argv[i], "--fused") == 0){
+				fused = true;
+			} else if (strncmp(argv[i], "--time-report=", 14) == 0){
+				timeReport = new TimeReport();
+				if (!timeReport->configure(argv[i] + 14)){ usageAndDie(); }
+			} else if (strcmp(argv[i], "--hash-cons") == 0){
+				hashCons = true;
+			} else if (strncmp(argv[i], "--passes=", 9) == 0){
+				opts.pipeline = argv[i] + 9;
+			} else if (strcmp(argv[i], "--run") == 0){
+				run = true;
+				useful = true;
+			} else if (strcmp(argv[i], "--run-batch") == 0){
+				runBatch = true;
+				useful = true;
+			} else if (strcmp(argv[i], "--stats") == 0){
+				showStats = true;
+			} else if (strcmp(argv[i], "--tiered") == 0){
+				tiered = true;
+			} else if (strcmp(argv[i], "--time-passes") == 0){
+				opts.timePasses = true;
+			} else if (strncmp(argv[i], "--superopt-rules=", 17) == 0){
+				opts.rulesFile = argv[i] + 17;
+			} else if (strcmp(argv[i], "--superopt-search") == 0){
+				opts.superoptSearch = true;
+				useful = true;
+			} else if (strncmp(argv[i], "--remarks=", 10) == 0){
+				opts.remarksFile = argv[i] + 10;
+				useful = true;
+			} else if (strncmp(argv[i], "--remarks-passes=", 17) == 0){
+				opts.remarksPasses = argv[i] + 17;
+			} else if (strncmp(argv[i], "--remarks-fns=", 14) == 0){
+				opts.remarksFns = argv[i] + 14;
+			} else if (argv[i][1] == 's'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				shareFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 't'){
 				i++;
 				tokensFile = argv[i];
 				useful = true;
@@ -148,11 +416,28 @@ main( const int argc, const char **argv )
 			} else if (argv[i][1] == 'c'){
 				checkTypes = true;
 				useful = true;
+			} else if (argv[i][1] == 'l'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				layoutFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'b'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				boundsFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'o'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				optFile = argv[i];
+				useful = true;
 			} else {
 				std::cerr << "Unrecognized argument: ";
 				std::cerr << argv[i] << std::endl;
 				usageAndDie();
 			}
+		} else if (runBatch){
+			batchInputs.push_back(argv[i]);
 		} else {
 			if (inFile == NULL){
 				inFile = argv[i];
@@ -166,10 +451,17 @@ main( const int argc, const char **argv )
 	if (inFile == NULL){
 		usageAndDie();
 	}
+	if (runBatch && batchInputs.empty()){
+		std::cerr << "No inputs given to --run-batch\n";
+		usageAndDie();
+	}
 	if (!useful){
 		std::cerr << "Hey, you didn't tell cmmc to do anything!\n";
 		usageAndDie();
 	}
+	//Sharing must come after every pass that changes
+	// expressions in place
+	if (hashCons){ opts.pipeline += ",hash-cons"; }
 
 	try {
 		if (tokensFile != nullptr){
@@ -193,16 +485,76 @@ main( const int argc, const char **argv )
 			}
 			outputAST(na->ast, namesFile);
 		}
+		if (layoutFile){
+			if (!doLayout(inFile, layoutFile, splitCold)){
+				std::cerr << "Name Analysis Failed\n";
+				return 1;
+			}
+		}
+		if (boundsFile){
+			if (!doBoundsChecks(inFile, boundsFile, opts)){
+				std::cerr << "Type Analysis Failed\n";
+				return 1;
+			}
+		}
+		if (optFile){
+			PassManager * pm = doOptimization(inFile, opts);
+			if (pm == nullptr){
+				std::cerr << "Type Analysis Failed\n";
+				return 1;
+			}
+			outputAST(pm->ast(), optFile);
+			finishOptimization(pm, opts);
+		}
+		if (shareFile){
+			if (!doSharing(inFile, shareFile, opts)){
+				std::cerr << "Type Analysis Failed\n";
+				return 1;
+			}
+		}
+		//Remarks or a search alone just run the passes
+		bool optimized = optFile || boundsFile || shareFile || run || runBatch;
+		bool passesOnly = opts.remarksFile || opts.superoptSearch;
+		if (passesOnly && !optimized){
+			PassManager * pm = doOptimization(inFile, opts);
+			if (pm == nullptr){
+				std::cerr << "Type Analysis Failed\n";
+				return 1;
+			}
+			finishOptimization(pm, opts);
+		}
 		if (checkTypes){
-			cminusminus::TypeAnalysis * ta;
-			ta = doTypeAnalysis(inFile);
-			if (ta == nullptr){
+			bool passed;
+			if (fused){
+				passed = doFusedAnalysis(inFile) != nullptr;
+			} else {
+				passed = doChecking(inFile, timeReport);
+			}
+			if (!passed){
 				std::cerr << "Type Analysis Failed\n";
 				return 1;
 			} else {
 				std::cout << "Great job! Type analysis succeeded\n";
 			}
 		}
+		if (run){
+			PassManager * pm = doOptimization(inFile, opts);
+			if (pm == nullptr){
+				std::cerr << "Type Analysis Failed\n";
+				return 1;
+			}
+			finishOptimization(pm, opts);
+			if (!doRun(pm, showStats, tiered)){ return 1; }
+		}
+		if (runBatch){
+			PassManager * pm = doOptimization(inFile, opts);
+			if (pm == nullptr){
+				std::cerr << "Type Analysis Failed\n";
+				return 1;
+			}
+			finishOptimization(pm, opts);
+			if (!doRunBatch(pm, batchInputs, showStats, tiered)){ return 1; }
+		}
 	} catch (cminusminus::ToDoError * e){
 		std::cerr << "ToDoError: " << e->msg() << "\n";
 		exit(1);
@@ -0,0 +1,513 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+#include "modules.hpp"
+#include "ast.hpp"
+#include "name_analysis.hpp"
+#include "scanner.hpp"
+#include "string_pool.hpp"
+#include "symbol_table.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+//A summary starts with this, followed by a hash of the
+// module's text. The rest of the summary is its interface:
+//  use <hash> <path>: an imported module, with the hash of
+//   its interface when the summary was written
+//  record <name> <count>, then field <type> <name> for each
+//   field
+//  var <type> <name>
+//  const <type> <name> <literal>
+//  fn <name> <count> <return type> <type of each formal>
+// Types are written prefix: int, bool, string, short, void,
+// ptr <type>, array <length> <type>, or record <module>
+// <name>, where module 0 is the module itself and module i
+// is the ith it uses.
+static const char * SUMMARY_HEADER = "cmmi ";
+
+static const Position noPos(0, 0, 0, 0);
+
+//FNV-1a, which is plenty to tell versions of a file apart
+static std::string hashText(const std::string& text){
+	uint64_t hash = 14695981039346656037ULL;
+	for (char c : text){
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	std::stringstream hex;
+	hex << std::hex << hash;
+	return hex.str();
+}
+
+static bool readFile(const std::string& path, std::string& text){
+	std::ifstream in(path);
+	if (!in.good()){ return false; }
+	std::stringstream contents;
+	contents << in.rdbuf();
+	text = contents.str();
+	return true;
+}
+
+static std::string summaryPath(const std::string& path){
+	return path + "i";
+}
+
+//Reads the declarations of a summary
+class Module::Reader{
+public:
+	Reader(Module * module, const std::string& line)
+	: myModule(module), myWords(line){ }
+	std::string word(){
+		std::string word;
+		myWords >> word;
+		return word;
+	}
+	bool number(size_t& num){
+		long long read = -1;
+		myWords >> read;
+		if (myWords.fail() || read < 0){ return false; }
+		num = static_cast<size_t>(read);
+		return true;
+	}
+	//The rest of the line, after the space that follows
+	// the last word read
+	std::string rest(){
+		std::string rest;
+		myWords.get();
+		std::getline(myWords, rest);
+		return rest;
+	}
+	const DataType * type(){
+		std::string kind = word();
+		if (kind == "int"){ return BasicType::INT(); }
+		if (kind == "bool"){ return BasicType::BOOL(); }
+		if (kind == "string"){ return BasicType::STRING(); }
+		if (kind == "short"){ return BasicType::SHORT(); }
+		if (kind == "void"){ return BasicType::VOID(); }
+		if (kind == "ptr"){
+			const DataType * base = type();
+			if (base == nullptr){ return nullptr; }
+			return PtrType::produce(base);
+		}
+		size_t num;
+		if (kind == "array" && number(num)){
+			const DataType * elem = type();
+			if (elem == nullptr){ return nullptr; }
+			return ArrayType::produce(elem, num);
+		}
+		if (kind == "record" && number(num)){
+			std::string name = word();
+			if (num == 0){ return myModule->record(name); }
+			if (num > myModule->myUses.size()){ return nullptr; }
+			return myModule->myUses[num - 1]->record(name);
+		}
+		return nullptr;
+	}
+	ExpNode * literal(){
+		std::string text = rest();
+		if (text == "true"){ return new TrueNode(&noPos); }
+		if (text == "false"){ return new FalseNode(&noPos); }
+		if (text.empty()){ return nullptr; }
+		if (text[0] == '"'){
+			return new StrLitNode(&noPos, StringPool::internLiteral(text));
+		}
+		int num = std::atoi(text.c_str());
+		if (text.back() == 'S'){ return new ShortLitNode(&noPos, num); }
+		return new IntLitNode(&noPos, num);
+	}
+private:
+	Module * myModule;
+	std::istringstream myWords;
+};
+
+Module::~Module(){
+	clear();
+}
+
+void Module::clear(){
+	for (auto sym : myExports){ delete sym; }
+	for (auto sym : myFields){ delete sym; }
+	for (auto type : myFnTypes){ delete type; }
+	for (auto record : myRecords){ delete record.second; }
+	for (auto constant : myConstants){ delete constant; }
+	myExports.clear();
+	myFields.clear();
+	myFnTypes.clear();
+	myRecords.clear();
+	myConstants.clear();
+	myUses.clear();
+}
+
+RecordType * Module::record(const std::string& name) const{
+	auto found = myRecords.find(name);
+	if (found == myRecords.end()){ return nullptr; }
+	return found->second;
+}
+
+bool Module::read(const std::string& summary, size_t from){
+	std::istringstream in(summary.substr(from));
+	std::string line;
+	while (std::getline(in, line)){
+		Reader reader(this, line);
+		std::string kind = reader.word();
+		if (kind == "record"){
+			std::string name = reader.word();
+			size_t count;
+			if (!reader.number(count) || myRecords.count(name) > 0){
+				return false;
+			}
+			//Fields may point to the record, so it is known
+			// before they are read
+			RecordType * record = new RecordType(name);
+			myRecords[name] = record;
+			for (size_t i = 0; i < count; i++){
+				if (!std::getline(in, line)){ return false; }
+				Reader field(this, line);
+				if (field.word() != "field"){ return false; }
+				const DataType * type = field.type();
+				if (type == nullptr){ return false; }
+				SemSymbol * sym = new VarSymbol(field.word(), type);
+				myFields.push_back(sym);
+				record->addField(sym, type);
+			}
+			record->complete();
+			myExports.push_back(new RecordSymbol(name, record));
+		} else if (kind == "var" || kind == "const"){
+			const DataType * type = reader.type();
+			if (type == nullptr){ return false; }
+			VarSymbol * sym = new VarSymbol(reader.word(), type);
+			myExports.push_back(sym);
+			if (kind == "const"){
+				ExpNode * value = reader.literal();
+				if (value == nullptr){ return false; }
+				myConstants.push_back(value);
+				sym->setConstant(value);
+			}
+		} else if (kind == "fn"){
+			std::string name = reader.word();
+			size_t count;
+			if (!reader.number(count)){ return false; }
+			const DataType * ret = reader.type();
+			std::list<const DataType *> * formals =
+				new std::list<const DataType *>();
+			FnType * type = new FnType(formals, ret);
+			myFnTypes.push_back(type);
+			for (size_t i = 0; i < count; i++){
+				formals->push_back(reader.type());
+				if (formals->back() == nullptr){ return false; }
+			}
+			if (ret == nullptr){ return false; }
+			myExports.push_back(new FnSymbol(name, type));
+		} else if (!kind.empty()){
+			return false;
+		}
+	}
+	return true;
+}
+
+//Write a type as a summary does, given how to refer to each
+// record an export may have
+static void writeType(std::ostream& out, const DataType * type,
+	const std::unordered_map<const RecordType *, std::string>& records){
+	if (type->asPtr() != nullptr){
+		out << "ptr ";
+		writeType(out, type->asPtr()->getBase(), records);
+	} else if (type->asArray() != nullptr){
+		out << "array " << type->asArray()->getLength() << " ";
+		writeType(out, type->asArray()->getElem(), records);
+	} else if (type->asRecord() != nullptr){
+		auto found = records.find(type->asRecord());
+		if (found == records.end()){
+			throw new InternalError("Exported record is not"
+				" declared or imported by its module");
+		}
+		out << "record " << found->second;
+	} else if (type->asBasic() != nullptr){
+		out << type->getString();
+	} else {
+		throw new InternalError("Export has no summary type");
+	}
+}
+
+//The interface of a module that passed analysis
+static std::string summarize(ProgramNode * ast,
+	const std::vector<Module *>& uses){
+	std::unordered_map<const RecordType *, std::string> records;
+	std::stringstream out;
+	for (size_t i = 0; i < uses.size(); i++){
+		out << "use " << uses[i]->summaryHash() << " "
+			<< uses[i]->path() << "\n";
+		for (auto sym : uses[i]->exports()){
+			if (sym->getKind() != RECORD){ continue; }
+			records[sym->getDataType()->asRecord()] =
+				std::to_string(i + 1) + " " + sym->getName();
+		}
+	}
+	for (auto decl : ast->getGlobals()){
+		SemSymbol * sym = decl->getSymbol();
+		std::string name = sym->getName();
+		const DataType * type = sym->getDataType();
+		if (sym->getKind() == RECORD){
+			const RecordType * record = type->asRecord();
+			records[record] = "0 " + name;
+			out << "record " << name << " "
+				<< record->getFields()->size() << "\n";
+			for (auto field : *record->getFields()){
+				out << "field ";
+				writeType(out, field->getType(), records);
+				out << " " << field->getSymbol()->getName() << "\n";
+			}
+		} else if (sym->getKind() == FN){
+			const FnType * fnType = type->asFn();
+			out << "fn " << name << " "
+				<< fnType->getFormalTypes()->size() << " ";
+			writeType(out, fnType->getReturnType(), records);
+			for (auto formal : *fnType->getFormalTypes()){
+				out << " ";
+				writeType(out, formal, records);
+			}
+			out << "\n";
+		} else if (sym->getConstant() != nullptr){
+			out << "const ";
+			writeType(out, type, records);
+			out << " " << name << " ";
+			sym->getConstant()->unparse(out, 0);
+			out << "\n";
+		} else {
+			out << "var ";
+			writeType(out, type, records);
+			out << " " << name << "\n";
+		}
+	}
+	return out.str();
+}
+
+Modules::~Modules(){
+	for (auto module : myModules){
+		delete module.second;
+	}
+}
+
+std::string Modules::resolve(const std::string& from,
+	const std::string& path){
+	std::string joined = path;
+	size_t slash = from.rfind('/');
+	if (!path.empty() && path[0] != '/' && slash != std::string::npos){
+		joined = from.substr(0, slash + 1) + path;
+	}
+	//The same module is reached by the same path, however
+	// it is imported. A file that is not there (yet) is
+	// found by its directory
+	std::string name;
+	char * real = realpath(joined.c_str(), nullptr);
+	size_t dirEnd = joined.rfind('/');
+	if (real == nullptr && dirEnd != std::string::npos){
+		name = joined.substr(dirEnd);
+		real = realpath(joined.substr(0, dirEnd + 1).c_str(), nullptr);
+	}
+	if (real == nullptr){ return joined; }
+	std::string resolved = real + name;
+	free(real);
+	return resolved;
+}
+
+Module * Modules::load(const std::string& path){
+	Module *& module = myModules[path];
+	if (module != nullptr){ return module; }
+	module = new Module(path);
+	//The map may grow while the module is loaded
+	Module * loading = module;
+	loading->mySerial = ++myLoads;
+	std::string text;
+	if (!readFile(path, text)){
+		loading->myStatus = Module::MISSING;
+		return loading;
+	}
+	std::string hash = hashText(text);
+	if (!loadSummary(loading, hash)){
+		analyze(loading, text, hash);
+	}
+	return loading;
+}
+
+//Read the interface of a module from its summary. The
+// summary is out of date if the module has changed since,
+// or the interface of anything it imports has
+static bool fromSummary(Modules * modules, Module * module,
+	const std::string& summary, const std::string& hash,
+	std::vector<Module *>& uses, size_t * declsAt){
+	std::istringstream in(summary);
+	std::string line;
+	if (!std::getline(in, line) || line != SUMMARY_HEADER + hash){
+		return false;
+	}
+	size_t at = static_cast<size_t>(in.tellg());
+	while (summary.compare(at, 4, "use ") == 0){
+		std::getline(in, line);
+		size_t hashEnd = line.find(' ', 4);
+		if (hashEnd == std::string::npos){ return false; }
+		Module * used = modules->load(line.substr(hashEnd + 1));
+		if (used->status() != Module::LOADED
+		  || used->summaryHash() != line.substr(4, hashEnd - 4)){
+			return false;
+		}
+		uses.push_back(used);
+		at = static_cast<size_t>(in.tellg());
+	}
+	*declsAt = at;
+	return true;
+}
+
+bool Modules::loadSummary(Module * module, const std::string& hash){
+	std::string summary;
+	if (!readFile(summaryPath(module->path()), summary)){ return false; }
+	size_t declsAt;
+	std::vector<Module *> uses;
+	if (!fromSummary(this, module, summary, hash, uses, &declsAt)){
+		return false;
+	}
+	module->myUses = uses;
+	if (!module->read(summary, declsAt)){
+		//Start over from the module itself
+		module->clear();
+		return false;
+	}
+	module->mySummaryHash = hashText(summary.substr(
+		summary.find('\n') + 1));
+	module->myStatus = Module::LOADED;
+	return true;
+}
+
+void Modules::analyze(Module * module, const std::string& text,
+	const std::string& hash){
+	//What the compiler has to say about the module is not
+	// output. Its importers are told it has errors, and it
+	// can be checked on its own
+	std::stringstream out;
+	std::stringstream errs;
+	std::streambuf * outBuf = std::cout.rdbuf(out.rdbuf());
+	std::streambuf * errBuf = std::cerr.rdbuf(errs.rdbuf());
+	ProgramNode * ast = nullptr;
+	NameAnalysis * names = nullptr;
+	bool passed = false;
+	try {
+		std::istringstream in(text);
+		Scanner scanner(&in);
+		Parser parser(scanner, &ast);
+		if (parser.parse() != 0){ ast = nullptr; }
+		if (ast != nullptr){
+			names = NameAnalysis::build(ast, this, module->path());
+		}
+		passed = names != nullptr;
+		for (size_t i = 0; passed && i < ast->getGlobals().size(); i++){
+			TypeAnalysis * ta = TypeAnalysis::build(ast->getGlobals()[i]);
+			passed = ta->passed();
+			delete ta;
+		}
+	} catch (...) {
+		std::cout.rdbuf(outBuf);
+		std::cerr.rdbuf(errBuf);
+		module->myStatus = Module::BROKEN;
+		throw;
+	}
+	std::cout.rdbuf(outBuf);
+	std::cerr.rdbuf(errBuf);
+	if (!passed){
+		module->myStatus = Module::BROKEN;
+		//Its errors may only be that it imports itself
+		for (size_t i = 0; ast != nullptr && i < ast->getImports().size(); i++){
+			Module * imported = load(resolve(module->path(),
+				ast->getImports()[i]->getPath()));
+			if (imported->status() == Module::LOADING
+			    || imported->status() == Module::CYCLIC){
+				module->myStatus = Module::CYCLIC;
+			}
+		}
+		delete names;
+		delete ast;
+		return;
+	}
+
+	std::vector<Module *> uses;
+	std::unordered_set<Module *> used;
+	for (auto import : ast->getImports()){
+		Module * imported = load(resolve(module->path(), import->getPath()));
+		if (used.insert(imported).second){ uses.push_back(imported); }
+	}
+	std::string summary = SUMMARY_HEADER + hash + "\n"
+		+ summarize(ast, uses);
+	delete names;
+	delete ast;
+
+	//The summary is written whole or not at all, so that
+	// another compiler reading it never sees part of it
+	std::string path = summaryPath(module->path());
+	std::string temp = path + ".tmp";
+	std::ofstream file(temp);
+	file << summary;
+	file.close();
+	if (!file.good() || std::rename(temp.c_str(), path.c_str()) != 0){
+		std::remove(temp.c_str());
+	}
+
+	//The declarations follow the header and the uses
+	size_t declsAt = summary.find('\n') + 1;
+	while (summary.compare(declsAt, 4, "use ") == 0){
+		declsAt = summary.find('\n', declsAt) + 1;
+	}
+	module->myUses = uses;
+	if (!module->read(summary, declsAt)){
+		throw new InternalError("Module summary cannot be read back");
+	}
+	module->mySummaryHash = hashText(summary.substr(
+		summary.find('\n') + 1));
+	module->myStatus = Module::LOADED;
+}
+
+std::vector<std::string> Modules::forget(const std::string& path){
+	std::unordered_set<Module *> gone;
+	auto changed = myModules.find(path);
+	if (changed != myModules.end()){ gone.insert(changed->second); }
+	//Modules that failed to load may have failed because
+	// of the change, and the interface of a module is made
+	// of the interfaces it uses, so those go as well
+	bool grew = true;
+	while (grew){
+		grew = false;
+		for (auto& entry : myModules){
+			Module * module = entry.second;
+			if (gone.count(module) > 0){ continue; }
+			bool stale = module->status() != Module::LOADED;
+			for (auto used : module->uses()){
+				stale = stale || gone.count(used) > 0;
+			}
+			if (stale){
+				gone.insert(module);
+				grew = true;
+			}
+		}
+	}
+	std::vector<std::string> paths;
+	for (auto module : gone){
+		paths.push_back(module->path());
+		myModules.erase(module->path());
+		delete module;
+	}
+	return paths;
+}
+
+void Modules::markLive(LiveInterned * live) const{
+	for (auto& entry : myModules){
+		for (auto constant : entry.second->myConstants){
+			StrLitNode * lit = constant->asStrLit();
+			if (lit != nullptr){ live->markLiteral(lit->getStrID()); }
+		}
+	}
+}
+
+}
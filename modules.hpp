@@ -0,0 +1,105 @@
+#ifndef CMINUSMINUS_MODULES
+#define CMINUSMINUS_MODULES
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cminusminus{
+
+class DataType;
+class ExpNode;
+class FnType;
+struct LiveInterned;
+class Modules;
+class RecordType;
+class SemSymbol;
+
+//A source file whose global declarations are imported by
+// other files. Importers only ever see its interface: a
+// symbol for each global, with the types and constant
+// values other files can use. The interface is always read
+// back from the module's summary (see Modules), whether the
+// summary was just written or was found on disk, so both
+// give the same symbols.
+class Module{
+public:
+	enum Status{
+		//Being loaded, so importing it again is a cycle
+		LOADING,
+		MISSING,
+		BROKEN,
+		//Broken by importing itself, through other modules
+		CYCLIC,
+		LOADED
+	};
+	Module(const std::string& pathIn) : myPath(pathIn),
+	  myStatus(LOADING), mySerial(0){ }
+	~Module();
+	const std::string& path() const { return myPath; }
+	Status status() const { return myStatus; }
+	//Differs between any two loads of modules, so that an
+	// importer can tell a module was loaded again
+	size_t serial() const { return mySerial; }
+	//Identifies the interface, for the summaries of the
+	// modules importing this one
+	const std::string& summaryHash() const { return mySummaryHash; }
+	const std::vector<SemSymbol *>& exports() const { return myExports; }
+	//The modules this one imports
+	const std::vector<Module *>& uses() const { return myUses; }
+	RecordType * record(const std::string& name) const;
+private:
+	friend class Modules;
+	class Reader;
+	//Read the declarations of a summary into symbols
+	bool read(const std::string& summary, size_t from);
+	void clear();
+	std::string myPath;
+	Status myStatus;
+	size_t mySerial;
+	std::string mySummaryHash;
+	std::vector<SemSymbol *> myExports;
+	std::vector<Module *> myUses;
+	std::unordered_map<std::string, RecordType *> myRecords;
+	//What the symbols are made of, which they don't own
+	std::vector<SemSymbol *> myFields;
+	std::vector<FnType *> myFnTypes;
+	std::vector<ExpNode *> myConstants;
+};
+
+//The modules imported by a program. Each module is lexed,
+// parsed and analyzed at most once, the first time it is
+// imported, after which its interface is kept. The
+// interface is also summarized in a file beside the module
+// (lib.cmm has lib.cmmi), which is used in place of the
+// module for as long as the module and the interfaces of
+// what it imports are unchanged.
+class Modules{
+public:
+	Modules() : myLoads(0){ }
+	~Modules();
+	//The path of a module imported by a file. Paths are
+	// relative to the directory of the importing file
+	static std::string resolve(const std::string& from,
+		const std::string& path);
+	//The module at a resolved path
+	Module * load(const std::string& path);
+	//Forget the module at a path, which has changed, and
+	// every module that imports it. Returns the paths of
+	// the modules forgotten
+	std::vector<std::string> forget(const std::string& path);
+	//Mark the literals of the constants of every module as
+	// used
+	void markLive(LiveInterned * live) const;
+private:
+	//Load a module from its summary, if that is up to date
+	bool loadSummary(Module * module, const std::string& hash);
+	void analyze(Module * module, const std::string& text,
+		const std::string& hash);
+	std::unordered_map<std::string, Module *> myModules;
+	size_t myLoads;
+};
+
+}
+
+#endif
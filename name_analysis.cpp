@@ -2,80 +2,134 @@
 #include "symbol_table.hpp"
 #include "errName.hpp"
 #include "types.hpp"
+#include "type_analysis.hpp"
+#include "modules.hpp"
 
 namespace cminusminus{
 
+//How much more an access one loop deeper counts towards
+// the hotness of a record field, and the deepest nesting 
+// that is distinguished
+static const size_t LOOP_WEIGHT = 8;
+static const size_t MAX_WEIGHTED_DEPTH = 6;
+
+//When names and types are resolved in a single traversal,
+// a node is typed as soon as its names are resolved 
+static bool typed(SymbolTable * symTab, ASTNode * node, bool resolved){
+	TypeAnalysis * ta = symTab->getFusedTypes();
+	if (ta != nullptr){ ta->fusedRule(node, resolved); }
+	return resolved;
+}
+
 bool ProgramNode::nameAnalysis(SymbolTable * symTab){
 	//Enter the global scope
 	symTab->enterScope();
 	bool res = true;
-	for (auto decl : *myGlobals){
+	//Imported names are visible throughout the file, so
+	// they go in first
+	for (auto import : myImports){
+		res = import->nameAnalysis(symTab) && res;
+	}
+	for (auto decl : myGlobals){
 		res = decl->nameAnalysis(symTab) && res;
 	}
 	//Leave the global scope
 	symTab->leaveScope();
-	return res;
+	return typed(symTab, this, res);
+}
+
+bool ImportNode::nameAnalysis(SymbolTable * symTab){
+	Modules * modules = symTab->getModules();
+	if (modules == nullptr){
+		throw new InternalError("Import with no modules to import");
+	}
+	Module * module = modules->load(
+		Modules::resolve(symTab->getImporter(), getPath()));
+	switch (module->status()){
+	case Module::MISSING:
+		return typed(symTab, this, NameErr::missingModule(pos()));
+	case Module::BROKEN:
+		return typed(symTab, this, NameErr::brokenModule(pos()));
+	case Module::LOADING:
+	case Module::CYCLIC:
+		return typed(symTab, this, NameErr::circularImport(pos()));
+	case Module::LOADED:
+		break;
+	}
+
+	bool validNames = true;
+	ScopeTable * globals = symTab->getCurrentScope();
+	for (auto sym : module->exports()){
+		//Importing a module twice changes nothing
+		if (globals->lookup(sym->getName()) == sym){ continue; }
+		validNames = globals->insert(sym) && validNames;
+	}
+	if (!validNames){ NameErr::multiDecl(pos()); }
+	return typed(symTab, this, validNames);
 }
 
 bool AssignStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myExp->nameAnalysis(symTab);
+	return typed(symTab, this, myExp->nameAnalysis(symTab));
 }
 
 bool PostIncStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myLVal->nameAnalysis(symTab);
+	return typed(symTab, this, myLVal->nameAnalysis(symTab));
 }
 
 bool PostDecStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myLVal->nameAnalysis(symTab);
+	return typed(symTab, this, myLVal->nameAnalysis(symTab));
 }
 
 bool ReadStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myDst->nameAnalysis(symTab);
+	return typed(symTab, this, myDst->nameAnalysis(symTab));
 }
 
 bool WriteStmtNode::nameAnalysis(SymbolTable * symTab){
-	return mySrc->nameAnalysis(symTab);
+	return typed(symTab, this, mySrc->nameAnalysis(symTab));
 }
 
 bool IfStmtNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
 	result = myCond->nameAnalysis(symTab) && result;
 	symTab->enterScope();
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		result = stmt->nameAnalysis(symTab) && result;
 	}	
 	symTab->leaveScope();
-	return result;
+	return typed(symTab, this, result);
 }
 
 bool IfElseStmtNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
 	result = myCond->nameAnalysis(symTab) && result;
 	symTab->enterScope();
-	for (auto stmt : *myBodyTrue){
+	for (auto stmt : myBodyTrue){
 		result = stmt->nameAnalysis(symTab) && result;
 	}	
 	symTab->leaveScope();
 	symTab->enterScope();
-	for (auto stmt : *myBodyFalse){
+	for (auto stmt : myBodyFalse){
 		result = stmt->nameAnalysis(symTab) && result;
 	}	
 	symTab->leaveScope();
-	return result;
+	return typed(symTab, this, result);
 }
 
 bool WhileStmtNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
+	symTab->enterLoop();
 	result = myCond->nameAnalysis(symTab) && result;
 	symTab->enterScope();
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		result = stmt->nameAnalysis(symTab) && result;
 	}	
 	symTab->leaveScope();
-	return result;
+	symTab->leaveLoop();
+	return typed(symTab, this, result);
 }
 
 bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
+	dropSymbol();
 	bool checkType = myType->nameAnalysis(symTab);
 
 	const DataType * dataType = getTypeNode()->getType();
@@ -96,16 +150,28 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 	if (!validName){ NameErr::multiDecl(ID()->pos()); }
 
 	if (!checkType || !validType || !validName){ 
-		return false; 
+		return typed(symTab, this, false); 
 	} else {
 		symTab->insert(new VarSymbol(varName, dataType));
 		SemSymbol * sym = symTab->find(varName);
 		//this->myID->attachSymbol(sym);
-		return true;
+		mySymbol = sym;
+		return typed(symTab, this, true);
 	}
 }
 
+bool ConstDeclNode::nameAnalysis(SymbolTable * symTab){
+	//The declaration is typed by VarDeclNode::nameAnalysis
+	bool validInit = myInit->nameAnalysis(symTab);
+	bool validDecl = VarDeclNode::nameAnalysis(symTab);
+	if (!validInit || !validDecl){ return false; }
+	//The symbol was just created by the VarDeclNode
+	static_cast<VarSymbol *>(mySymbol)->setConstant(myInit);
+	return true;
+}
+
 bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
+	dropSymbol();
 	std::string fnName = this->ID()->getName();
 
 	bool validRet = myRetType->nameAnalysis(symTab);
@@ -128,7 +194,7 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 	bool validFormals = true;
 	std::list<const DataType *> * formalTypes = 
 		new std::list<const DataType *>();
-	for (auto formal : *(this->myFormals)){
+	for (auto formal : myFormals){
 		validFormals = formal->nameAnalysis(symTab) && validFormals;
 		TypeNode * typeNode = formal->getTypeNode();
 		const DataType * formalType = typeNode->getType();
@@ -138,111 +204,251 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 
 	const DataType * retType = this->getRetTypeNode()->getType();
 	FnType * dataType = new FnType(formalTypes, retType);
+	delete myFnType;
+	myFnType = dataType;
 	//Make sure the fnSymbol is in the symbol table before 
 	// analyzing the body, to allow for recursive calls
 	if (validName){
 		atFnScope->addFn(fnName, dataType);
 		SemSymbol * sym = atFnScope->lookup(fnName);
 		//this->myID->attachSymbol(sym);
+		mySymbol = sym;
 	}
 
+	TypeAnalysis * ta = symTab->getFusedTypes();
+	if (ta != nullptr){ ta->setCurrentFnType(dataType); }
+
 	bool validBody = true;
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		validBody = stmt->nameAnalysis(symTab) && validBody;
 	}
 
 	symTab->leaveScope();
-	return (validRet && validFormals && validName && validBody);
+	bool res = validRet && validFormals && validName && validBody;
+	return typed(symTab, this, res);
+}
+
+bool RecordDeclNode::nameAnalysis(SymbolTable * symTab){
+	dropSymbol();
+	std::string recName = ID()->getName();
+
+	bool validName = !symTab->clash(recName);
+	if (!validName){ NameErr::multiDecl(ID()->pos()); }
+
+	//The record's symbol goes in before its fields are 
+	// analyzed, so that a field may point to its own 
+	// record. The type stays incomplete until the end of
+	// the declaration, so a field may not contain the 
+	// record by value.
+	delete myType;
+	myType = new RecordType(recName);
+	if (validName){
+		mySymbol = new RecordSymbol(recName, myType);
+		symTab->insert(mySymbol);
+	}
+
+	//Fields get a scope of their own, so that they don't
+	// clash with names outside of the record
+	ScopeTable * fieldScope = symTab->enterScope();
+	bool validFields = true;
+	for (auto field : myFields){
+		bool validField = field->nameAnalysis(symTab);
+		validFields = validField && validFields;
+		if (validField){
+			std::string fieldName = field->ID()->getName();
+			SemSymbol * fieldSym = fieldScope->lookup(fieldName);
+			myType->addField(fieldSym, fieldSym->getDataType());
+		}
+	}
+	symTab->leaveScope();
+	myType->complete();
+
+	return typed(symTab, this, validName && validFields);
+}
+
+bool FieldAccessNode::nameAnalysis(SymbolTable * symTab){
+	if (!myBase->nameAnalysis(symTab)){ 
+		return typed(symTab, this, false); 
+	}
+
+	const DataType * baseType = myBase->resolvedType();
+	const RecordType * recType = nullptr;
+	if (baseType != nullptr){ recType = baseType->asRecord(); }
+	if (recType == nullptr){ 
+		NameErr::badFieldBase(myBase->pos()); 
+		return typed(symTab, this, false);
+	}
+
+	RecordField * field = recType->getField(myField->getName());
+	if (field == nullptr){ 
+		NameErr::badField(myField->pos()); 
+		return typed(symTab, this, false);
+	}
+	myField->attachSymbol(field->getSymbol());
+	typed(symTab, myField, true);
+
+	size_t weight = 1;
+	size_t depth = symTab->getLoopDepth();
+	for (size_t i = 0; i < depth && i < MAX_WEIGHTED_DEPTH; i++){
+		weight *= LOOP_WEIGHT;
+	}
+	recType->noteAccess(myField->getName(), weight);
+	return typed(symTab, this, true);
+}
+
+bool IndexNode::nameAnalysis(SymbolTable * symTab){
+	bool result = true;
+	result = myBase->nameAnalysis(symTab) && result;
+	result = myIndex->nameAnalysis(symTab) && result;
+	return typed(symTab, this, result);
 }
 
 bool BinaryExpNode::nameAnalysis(SymbolTable * symTab){
 	bool resultLHS = myExp1->nameAnalysis(symTab);
 	bool resultRHS = myExp2->nameAnalysis(symTab);
-	return resultLHS && resultRHS;
+	return typed(symTab, this, resultLHS && resultRHS);
 }
 
 bool CallExpNode::nameAnalysis(SymbolTable* symTab){
 	bool result = true;
 	result = myID->nameAnalysis(symTab) && result;
-	for (auto arg : *myArgs){
+
+	//As in type analysis, the arguments of a call to a 
+	// non-function are not typed
+	TypeAnalysis * ta = symTab->getFusedTypes();
+	bool untyped = ta != nullptr && ta->rulesActive() 
+		&& ta->nodeType(myID)->asFn() == nullptr;
+	if (untyped){ ta->suspendRules(); }
+	for (auto arg : myArgs){
 		result = arg->nameAnalysis(symTab) && result;
 	}
-	return result;
+	if (untyped){ ta->resumeRules(); }
+	return typed(symTab, this, result);
 }
 
 bool RefNode::nameAnalysis(SymbolTable* symTab){
-	return myExp->nameAnalysis(symTab);
+	return typed(symTab, this, myExp->nameAnalysis(symTab));
 }
 
 bool DerefNode::nameAnalysis(SymbolTable* symTab){
-	return myID->nameAnalysis(symTab);
+	return typed(symTab, this, myID->nameAnalysis(symTab));
 }
 
 bool NegNode::nameAnalysis(SymbolTable* symTab){
-	return myExp->nameAnalysis(symTab);
+	return typed(symTab, this, myExp->nameAnalysis(symTab));
 }
 
 
 bool NotNode::nameAnalysis(SymbolTable* symTab){
-	return myExp->nameAnalysis(symTab);
+	return typed(symTab, this, myExp->nameAnalysis(symTab));
 }
 
 bool AssignExpNode::nameAnalysis(SymbolTable* symTab){
 	bool result = true;
 	result = myDst->nameAnalysis(symTab) && result;
 	result = mySrc->nameAnalysis(symTab) && result;
-	return result;
+	return typed(symTab, this, result);
 }
 
 bool ReturnStmtNode::nameAnalysis(SymbolTable * symTab){
 	if (myExp == nullptr){ // May happen in void functions
-		return true;
+		return typed(symTab, this, true);
 	}
-	return myExp->nameAnalysis(symTab);
+	return typed(symTab, this, myExp->nameAnalysis(symTab));
 }
 
 bool CallStmtNode::nameAnalysis(SymbolTable* symTab){
-	return myCallExp->nameAnalysis(symTab);
+	return typed(symTab, this, myCallExp->nameAnalysis(symTab));
 }
 
 bool TypeNode::nameAnalysis(SymbolTable * symTab){
 	return true;
 }
 
-bool IntLitNode::nameAnalysis(SymbolTable * symTab){
+bool PtrTypeNode::nameAnalysis(SymbolTable * symTab){
+	return myBaseType->nameAnalysis(symTab);
+}
+
+bool ArrayTypeNode::nameAnalysis(SymbolTable * symTab){
+	return myElemType->nameAnalysis(symTab);
+}
+
+bool RecordTypeNode::nameAnalysis(SymbolTable * symTab){
+	myType = nullptr;
+	SemSymbol * sym = symTab->find(myID->getName());
+	if (sym == nullptr){
+		return NameErr::undeclID(myID->pos());
+	}
+	//If the name is not a record, the type is left 
+	// unresolved and the enclosing declaration will
+	// report it as an invalid type
+	if (sym->getKind() == RECORD){
+		myType = sym->getDataType();
+	}
 	return true;
 }
 
+bool IntLitNode::nameAnalysis(SymbolTable * symTab){
+	return typed(symTab, this, true);
+}
+
 bool ShortLitNode::nameAnalysis(SymbolTable * symTab){
-	return true;
+	return typed(symTab, this, true);
 }
 
 bool StrLitNode::nameAnalysis(SymbolTable * symTab){
-	return true;
+	return typed(symTab, this, true);
 }
 
 bool TrueNode::nameAnalysis(SymbolTable * symTab){
-	return true;
+	return typed(symTab, this, true);
 }
 
 bool FalseNode::nameAnalysis(SymbolTable * symTab){
-	return true;
+	return typed(symTab, this, true);
 }
 
 bool IDNode::nameAnalysis(SymbolTable* symTab){
+	//Forget the symbol of any earlier analysis
+	mySymbol = nullptr;
 	std::string myName = this->getName();
 	SemSymbol * sym = symTab->find(myName);
 	if (sym == nullptr){
-		return NameErr::undeclID(pos());
+		return typed(symTab, this, NameErr::undeclID(pos()));
 	}
 	if (sym->getKind() != RECORD){
 		this->attachSymbol(sym);
 	}
-	return true;
+	return typed(symTab, this, true);
 }
 
 void IDNode::attachSymbol(SemSymbol * symbolIn){
 	this->mySymbol = symbolIn;
 }
 
+const DataType * IDNode::resolvedType() const{
+	if (mySymbol == nullptr){ return nullptr; }
+	return mySymbol->getDataType();
+}
+
+const DataType * DerefNode::resolvedType() const{
+	const DataType * idType = myID->resolvedType();
+	if (idType == nullptr || idType->asPtr() == nullptr){ 
+		return nullptr; 
+	}
+	return idType->asPtr()->getBase();
+}
+
+const DataType * FieldAccessNode::resolvedType() const{
+	return myField->resolvedType();
+}
+
+const DataType * IndexNode::resolvedType() const{
+	const DataType * baseType = myBase->resolvedType();
+	if (baseType == nullptr || baseType->asArray() == nullptr){ 
+		return nullptr; 
+	}
+	return baseType->asArray()->getElem();
+}
+
 }
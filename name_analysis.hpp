@@ -7,9 +7,13 @@ namespace cminusminus{
 
 class NameAnalysis{
 public:
-	static NameAnalysis * build(ProgramNode * astIn){
+	//Analyze the program in the file at a path, importing
+	// modules from those given
+	static NameAnalysis * build(ProgramNode * astIn, Modules * modules,
+		const std::string& path){
 		NameAnalysis * nameAnalysis = new NameAnalysis;
 		SymbolTable * symTab = new SymbolTable();
+		symTab->importFrom(modules, path);
 		bool res = astIn->nameAnalysis(symTab);
 		delete symTab;
 		if (!res){ return nullptr; }
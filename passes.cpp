@@ -0,0 +1,426 @@
+#include <chrono>
+#include <iomanip>
+#include "passes.hpp"
+#include "bounds_check.hpp"
+#include "cond_elim.hpp"
+#include "const_fold.hpp"
+#include "copy_prop.hpp"
+#include "dead_args.hpp"
+#include "errors.hpp"
+#include "hash_cons.hpp"
+#include "name_analysis.hpp"
+#include "promote.hpp"
+#include "rotate.hpp"
+#include "scev.hpp"
+#include "superopt.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+//The passes that can be named in a pipeline, in the order
+// they are listed in errors
+static const char * const PASS_NAMES[] = {
+	"names", "types", "effects", "bounds", "fold", "dead-args",
+	"rotate", "copy-prop", "cond-elim", "scev", "promote",
+	"superopt", "hash-cons"
+};
+
+NamesPass::~NamesPass(){
+	delete myNames;
+}
+
+bool NamesPass::compute(PassManager * pm){
+	myNames = NameAnalysis::build(pm->ast(), pm->modules(), pm->path());
+	return myNames != nullptr;
+}
+
+TypesPass::~TypesPass(){
+	delete myTypes;
+}
+
+bool TypesPass::compute(PassManager * pm){
+	NameAnalysis * names = pm->names();
+	if (names == nullptr){ return false; }
+	myTypes = TypeAnalysis::build(names);
+	return myTypes != nullptr;
+}
+
+bool EffectsPass::compute(PassManager * pm){
+	std::set<SemSymbol *> globals;
+	for (auto decl : pm->ast()->getGlobals()){
+		SemSymbol * sym = decl->getSymbol();
+		if (sym->getKind() == VAR){ globals.insert(sym); }
+		if (sym->getKind() != FN){ continue; }
+		myFns.push_back(decl);
+		decl->collectEffects(&myEffects[sym]);
+	}
+
+	//A function is pure until it is found to do something,
+	// or to call a function that does, so that recursive
+	// functions can be pure
+	for (auto decl : myFns){
+		SemSymbol * fn = decl->getSymbol();
+		const Effects& effects = myEffects[fn];
+		if (effects.hasIO()){ 
+			myWhy[fn] = "it reads input or writes output";
+		} else if (effects.hasPtrWrites()){
+			myWhy[fn] = "it writes through a pointer";
+		}
+		for (auto sym : *effects.getModified()){
+			if (globals.count(sym) == 0 || myWhy.count(fn) > 0){ continue; }
+			myWhy[fn] = "it modifies global " + sym->getName();
+		}
+		myPure[fn] = myWhy.count(fn) == 0;
+	}
+	bool changed = true;
+	while (changed){
+		changed = false;
+		for (auto decl : myFns){
+			SemSymbol * fn = decl->getSymbol();
+			if (!myPure[fn]){ continue; }
+			for (auto callee : *myEffects[fn].getCallees()){
+				if (pure(callee)){ continue; }
+				myPure[fn] = false;
+				myWhy[fn] = "it calls " + callee->getName()
+				  + ", which is impure";
+				changed = true;
+				break;
+			}
+		}
+	}
+
+	Remarks * remarks = pm->remarks();
+	for (size_t i = 0; remarks != nullptr && i < myFns.size(); i++){
+		SemSymbol * fn = myFns[i]->getSymbol();
+		remarks->analysis("effects", myFns[i]->pos(), fn->getName() 
+		  + (myPure[fn] ? " is pure" : " is impure, " + myWhy[fn]));
+	}
+	return true;
+}
+
+void EffectsPass::report(std::ostream& out){
+	for (auto decl : myFns){
+		SemSymbol * fn = decl->getSymbol();
+		out << fn->getName() << ": "
+		  << (myPure[fn] ? "pure" : "impure") << "\n";
+	}
+}
+
+const Effects * EffectsPass::of(SemSymbol * fn) const{
+	auto found = myEffects.find(fn);
+	if (found == myEffects.end()){ return nullptr; }
+	return &found->second;
+}
+
+bool EffectsPass::pure(SemSymbol * fn) const{
+	auto found = myPure.find(fn);
+	return found != myPure.end() && found->second;
+}
+
+BoundsPass::~BoundsPass(){
+	delete myBounds;
+}
+
+bool BoundsPass::compute(PassManager * pm){
+	TypeAnalysis * types = pm->types();
+	if (types == nullptr){ return false; }
+	myBounds = BoundsCheckElim::build(types, pm->remarks());
+	return true;
+}
+
+void BoundsPass::report(std::ostream& out){
+	myBounds->report(out);
+}
+
+unsigned FoldPass::run(PassManager * pm){
+	ConstFold * fold = ConstFold::build(pm->types(), pm->remarks());
+	myFolded = fold->folded();
+	myRemoved = fold->removed();
+	delete fold;
+	unsigned changes = CHANGES_NOTHING;
+	if (myFolded > 0){ changes |= CHANGES_EXPS; }
+	if (myRemoved > 0){ changes |= CHANGES_DECLS; }
+	return changes;
+}
+
+void FoldPass::report(std::ostream& out){
+	out << myFolded << " uses of constants folded, "
+	  << myRemoved << " constants removed\n";
+}
+
+unsigned CopyPropPass::run(PassManager * pm){
+	CopyProp * prop = CopyProp::build(pm->types(), pm->remarks());
+	myReplaced = prop->replaced();
+	myEliminated = prop->eliminated();
+	myRemoved = prop->removed();
+	delete prop;
+	unsigned changes = CHANGES_NOTHING;
+	if (myReplaced > 0){ changes |= CHANGES_EXPS; }
+	if (myEliminated > 0){ changes |= CHANGES_STMTS; }
+	if (myRemoved > 0){ changes |= CHANGES_DECLS; }
+	return changes;
+}
+
+void CopyPropPass::report(std::ostream& out){
+	out << myReplaced << " uses of copies replaced, "
+	  << myEliminated << " copies eliminated, "
+	  << myRemoved << " locals removed\n";
+}
+
+unsigned CondElimPass::run(PassManager * pm){
+	CondElim * elim = CondElim::build(pm->ast(), pm->remarks());
+	myRemoved = elim->removed();
+	myThreaded = elim->threaded();
+	delete elim;
+	if (myRemoved + myThreaded == 0){ return CHANGES_NOTHING; }
+	return CHANGES_STMTS;
+}
+
+void CondElimPass::report(std::ostream& out){
+	out << myRemoved << " redundant tests removed, "
+	  << myThreaded << " branches threaded\n";
+}
+
+unsigned RotatePass::run(PassManager * pm){
+	LoopRotation * rot = LoopRotation::build(pm->types(), pm->remarks());
+	myRotated = rot->rotated();
+	delete rot;
+	if (myRotated == 0){ return CHANGES_NOTHING; }
+	return CHANGES_STMTS;
+}
+
+void RotatePass::report(std::ostream& out){
+	out << myRotated << " loops rotated\n";
+}
+
+unsigned ScevPass::run(PassManager * pm){
+	ScalarEvolution * scev = ScalarEvolution::build(pm->types(),
+		pm->remarks());
+	myClosed = scev->closed();
+	delete scev;
+	if (myClosed == 0){ return CHANGES_NOTHING; }
+	return CHANGES_STMTS;
+}
+
+void ScevPass::report(std::ostream& out){
+	out << myClosed << " loops replaced by their closed form\n";
+}
+
+unsigned PromotePass::run(PassManager * pm){
+	TypeAnalysis * types = pm->types();
+	Analysis * effects = pm->analysis("effects");
+	if (types == nullptr || effects == nullptr){ return CHANGES_NOTHING; }
+	ScalarPromotion * sp = ScalarPromotion::build(types,
+		static_cast<EffectsPass *>(effects), pm->remarks());
+	myPromoted = sp->promoted();
+	delete sp;
+	if (myPromoted == 0){ return CHANGES_NOTHING; }
+	return CHANGES_EXPS | CHANGES_STMTS | CHANGES_DECLS;
+}
+
+void PromotePass::report(std::ostream& out){
+	out << myPromoted << " globals promoted in loops\n";
+}
+
+HashConsPass::~HashConsPass(){
+	delete myShared;
+}
+
+unsigned DeadArgsPass::run(PassManager * pm){
+	TypeAnalysis * types = pm->types();
+	if (types == nullptr){ return CHANGES_NOTHING; }
+	DeadArgElim * dae = DeadArgElim::build(types, pm->remarks());
+	myFormals = dae->formals();
+	myActuals = dae->actuals();
+	myResults = dae->results();
+	delete dae;
+	if (myFormals == 0 && myResults == 0){ return CHANGES_NOTHING; }
+	return CHANGES_EXPS | CHANGES_STMTS | CHANGES_DECLS;
+}
+
+void DeadArgsPass::report(std::ostream& out){
+	out << myFormals << " formals removed, " << myActuals
+	  << " arguments removed, " << myResults << " functions made void\n";
+}
+
+unsigned SuperoptPass::run(PassManager * pm){
+	TypeAnalysis * types = pm->types();
+	if (types == nullptr || pm->rules() == nullptr){ return CHANGES_NOTHING; }
+	Superoptimizer * so = Superoptimizer::build(types, pm->rules(),
+		pm->remarks());
+	myReplaced = so->replaced();
+	mySearched = so->searched();
+	delete so;
+	if (myReplaced == 0){ return CHANGES_NOTHING; }
+	return CHANGES_EXPS;
+}
+
+void SuperoptPass::report(std::ostream& out){
+	out << myReplaced << " expressions replaced by a cheaper form, "
+	  << mySearched << " searched for\n";
+}
+
+unsigned HashConsPass::run(PassManager * pm){
+	delete myShared;
+	myShared = HashCons::build(pm->types(), pm->remarks());
+	return CHANGES_EXPS;
+}
+
+void HashConsPass::report(std::ostream& out){
+	myShared->report(out);
+}
+
+PassManager::~PassManager(){
+	for (auto analysis : myAnalyses){ delete analysis.second; }
+	for (auto transform : myTransforms){ delete transform.second; }
+}
+
+Pass * PassManager::create(const std::string& name){
+	if (name == "names"){ return new NamesPass(); }
+	if (name == "types"){ return new TypesPass(); }
+	if (name == "effects"){ return new EffectsPass(); }
+	if (name == "bounds"){ return new BoundsPass(); }
+	if (name == "fold"){ return new FoldPass(); }
+	if (name == "dead-args"){ return new DeadArgsPass(); }
+	if (name == "copy-prop"){ return new CopyPropPass(); }
+	if (name == "cond-elim"){ return new CondElimPass(); }
+	if (name == "rotate"){ return new RotatePass(); }
+	if (name == "scev"){ return new ScevPass(); }
+	if (name == "superopt"){ return new SuperoptPass(); }
+	if (name == "promote"){ return new PromotePass(); }
+	if (name == "hash-cons"){ return new HashConsPass(); }
+	std::string msg = "Unknown pass " + name + ", the passes are";
+	for (auto known : PASS_NAMES){ msg += std::string(" ") + known; }
+	throw new UserError(msg.c_str());
+}
+
+//Time a pass, not counting the passes it runs in turn,
+// which are timed on their own
+template <typename Step>
+static void timed(double& nested, double& self, Step step){
+	auto start = std::chrono::steady_clock::now();
+	double outer = nested;
+	nested = 0;
+	step();
+	std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - start;
+	self += elapsed.count() - nested;
+	nested = outer + elapsed.count();
+}
+
+Analysis * PassManager::analysis(const std::string& name){
+	if (myFailed.count(name) > 0){ return nullptr; }
+	auto found = myAnalyses.find(name);
+	if (found != myAnalyses.end()){ return found->second; }
+
+	Pass * pass = create(name);
+	if (!pass->isAnalysis()){
+		delete pass;
+		std::string msg = name + " is not an analysis";
+		throw new InternalError(msg.c_str());
+	}
+	Analysis * analysis = static_cast<Analysis *>(pass);
+	Timing& timing = myTimes[name];
+	bool passed = false;
+	timed(myNested, timing.seconds, [&](){
+		passed = analysis->compute(this);
+	});
+	if (timing.runs++ == 0){ myOrder.push_back(name); }
+	if (!passed){
+		delete analysis;
+		myFailed.insert(name);
+		return nullptr;
+	}
+	myAnalyses[name] = analysis;
+	return analysis;
+}
+
+NameAnalysis * PassManager::names(){
+	Analysis * names = analysis("names");
+	if (names == nullptr){ return nullptr; }
+	return static_cast<NamesPass *>(names)->names();
+}
+
+TypeAnalysis * PassManager::types(){
+	Analysis * types = analysis("types");
+	if (types == nullptr){ return nullptr; }
+	return static_cast<TypesPass *>(types)->types();
+}
+
+bool PassManager::run(const std::string& name){
+	Pass * pass = create(name);
+	if (pass->isAnalysis()){
+		delete pass;
+		//Every pass needs a well-typed program
+		return types() != nullptr && analysis(name) != nullptr;
+	}
+	Transform * transform = static_cast<Transform *>(pass);
+	if (myShared && transform->changesInPlace()){
+		delete transform;
+		std::string msg = "Pass " + name + " changes expressions"
+			" in place, so it must come before hash-cons";
+		throw new UserError(msg.c_str());
+	}
+	if (types() == nullptr){
+		delete transform;
+		return false;
+	}
+
+	Timing& timing = myTimes[name];
+	unsigned changes = CHANGES_NOTHING;
+	timed(myNested, timing.seconds, [&](){
+		changes = transform->run(this);
+	});
+	if (timing.runs++ == 0){ myOrder.push_back(name); }
+	if (name == "hash-cons"){ myShared = true; }
+
+	for (auto it = myAnalyses.begin(); it != myAnalyses.end(); ){
+		if ((it->second->dependsOn() & changes) != 0){
+			delete it->second;
+			it = myAnalyses.erase(it);
+		} else {
+			++it;
+		}
+	}
+	delete myTransforms[name];
+	myTransforms[name] = transform;
+	return true;
+}
+
+bool PassManager::runAll(const std::string& pipeline){
+	//Even an empty pipeline checks the program
+	if (types() == nullptr){ return false; }
+	size_t start = 0;
+	while (start <= pipeline.size()){
+		size_t end = pipeline.find(',', start);
+		if (end == std::string::npos){ end = pipeline.size(); }
+		std::string name = pipeline.substr(start, end - start);
+		if (!name.empty() && !run(name)){ return false; }
+		start = end + 1;
+	}
+	return true;
+}
+
+Transform * PassManager::ran(const std::string& name) const{
+	auto found = myTransforms.find(name);
+	if (found == myTransforms.end()){ return nullptr; }
+	return found->second;
+}
+
+void PassManager::reportTimes(std::ostream& out) const{
+	double total = 0;
+	out << std::left << std::setw(12) << "pass" << std::right
+	  << std::setw(6) << "runs" << std::setw(12) << "ms" << "\n";
+	for (auto& name : myOrder){
+		const Timing& timing = myTimes.at(name);
+		total += timing.seconds;
+		out << std::left << std::setw(12) << name << std::right
+		  << std::setw(6) << timing.runs
+		  << std::setw(12) << std::fixed << std::setprecision(3)
+		  << timing.seconds * 1000 << "\n";
+	}
+	out << std::left << std::setw(18) << "total" << std::right
+	  << std::setw(12) << total * 1000 << "\n";
+}
+
+}
@@ -0,0 +1,302 @@
+#ifndef CMINUSMINUS_PASSES
+#define CMINUSMINUS_PASSES
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.hpp"
+#include "effects.hpp"
+#include "remarks.hpp"
+
+namespace cminusminus{
+
+class BoundsCheckElim;
+class HashCons;
+class Modules;
+class NameAnalysis;
+class RuleDatabase;
+class PassManager;
+class TypeAnalysis;
+
+//What a transform changed in the program. Each analysis
+// names the changes after which it is out of date
+enum Change : unsigned {
+	CHANGES_NOTHING = 0,
+	//Expressions were replaced or rewritten
+	CHANGES_EXPS = 1,
+	//Statements were added, removed or moved
+	CHANGES_STMTS = 2,
+	//Global or local declarations were added or removed
+	CHANGES_DECLS = 4,
+	CHANGES_ALL = 7
+};
+
+//A named step of the optimizer
+class Pass{
+public:
+	virtual ~Pass(){ }
+	const std::string& name() const { return myName; }
+	virtual bool isAnalysis() const = 0;
+	//Output what the pass found or did
+	virtual void report(std::ostream& out){ }
+protected:
+	Pass(const std::string& name) : myName(name){ }
+private:
+	std::string myName;
+};
+
+//Facts about the program, which the pass manager keeps
+// until a transform changes what they were computed from
+class Analysis : public Pass{
+public:
+	bool isAnalysis() const override { return true; }
+	//The changes after which it must be computed again
+	virtual unsigned dependsOn() const = 0;
+	//Compute the facts, asking the pass manager for any
+	// other analyses needed. Returns whether the program
+	// passed, which only name and type analysis can fail
+	virtual bool compute(PassManager * pm) = 0;
+protected:
+	Analysis(const std::string& name) : Pass(name){ }
+};
+
+//Changes the program. Transforms keep the symbol and type
+// of every node up to date, so that name and type analysis
+// never need to be done again
+class Transform : public Pass{
+public:
+	bool isAnalysis() const override { return false; }
+	//Transform the program, and return what changed
+	virtual unsigned run(PassManager * pm) = 0;
+	//Whether the transform changes expression nodes in
+	// place, which it may only do before they are shared
+	virtual bool changesInPlace() const { return true; }
+protected:
+	Transform(const std::string& name) : Pass(name){ }
+};
+
+//The result of name analysis, which owns the symbols
+class NamesPass : public Analysis{
+public:
+	NamesPass() : Analysis("names"), myNames(nullptr){ }
+	~NamesPass();
+	unsigned dependsOn() const override { return CHANGES_NOTHING; }
+	bool compute(PassManager * pm) override;
+	NameAnalysis * names() const { return myNames; }
+private:
+	NameAnalysis * myNames;
+};
+
+class TypesPass : public Analysis{
+public:
+	TypesPass() : Analysis("types"), myTypes(nullptr){ }
+	~TypesPass();
+	unsigned dependsOn() const override { return CHANGES_NOTHING; }
+	bool compute(PassManager * pm) override;
+	TypeAnalysis * types() const { return myTypes; }
+private:
+	TypeAnalysis * myTypes;
+};
+
+//What the body of each function may do, and which
+// functions are pure: they do no I/O, write nothing through
+// pointers, modify no global and only call pure functions.
+// A call to a pure function can be dropped if its value is
+// unused.
+class EffectsPass : public Analysis{
+public:
+	EffectsPass() : Analysis("effects"){ }
+	unsigned dependsOn() const override { return CHANGES_ALL; }
+	bool compute(PassManager * pm) override;
+	void report(std::ostream& out) override;
+	//What the body of a function does itself, not counting
+	// what the functions it calls do
+	const Effects * of(SemSymbol * fn) const;
+	bool pure(SemSymbol * fn) const;
+private:
+	std::vector<DeclNode *> myFns;
+	std::unordered_map<SemSymbol *, Effects> myEffects;
+	std::unordered_map<SemSymbol *, bool> myPure;
+	//Why each impure function is impure
+	std::unordered_map<SemSymbol *, std::string> myWhy;
+};
+
+//Marks which array bounds checks can be dropped. The marks
+// are on the index nodes, so an unchanged program keeps them
+class BoundsPass : public Analysis{
+public:
+	BoundsPass() : Analysis("bounds"), myBounds(nullptr){ }
+	~BoundsPass();
+	unsigned dependsOn() const override { return CHANGES_ALL; }
+	bool compute(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	BoundsCheckElim * myBounds;
+};
+
+class FoldPass : public Transform{
+public:
+	FoldPass() : Transform("fold"), myFolded(0), myRemoved(0){ }
+	unsigned run(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	size_t myFolded;
+	size_t myRemoved;
+};
+
+class CopyPropPass : public Transform{
+public:
+	CopyPropPass()
+	: Transform("copy-prop"), myReplaced(0), myEliminated(0),
+	  myRemoved(0){ }
+	unsigned run(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	size_t myReplaced;
+	size_t myEliminated;
+	size_t myRemoved;
+};
+
+class CondElimPass : public Transform{
+public:
+	CondElimPass() : Transform("cond-elim"), myRemoved(0), myThreaded(0){ }
+	unsigned run(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	size_t myRemoved;
+	size_t myThreaded;
+};
+
+class RotatePass : public Transform{
+public:
+	RotatePass() : Transform("rotate"), myRotated(0){ }
+	unsigned run(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	size_t myRotated;
+};
+
+class ScevPass : public Transform{
+public:
+	ScevPass() : Transform("scev"), myClosed(0){ }
+	unsigned run(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	size_t myClosed;
+};
+
+class PromotePass : public Transform{
+public:
+	PromotePass() : Transform("promote"), myPromoted(0){ }
+	unsigned run(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	size_t myPromoted;
+};
+
+class DeadArgsPass : public Transform{
+public:
+	DeadArgsPass() : Transform("dead-args"), myFormals(0), myActuals(0),
+	  myResults(0){ }
+	unsigned run(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	size_t myFormals;
+	size_t myActuals;
+	size_t myResults;
+};
+
+class SuperoptPass : public Transform{
+public:
+	SuperoptPass() : Transform("superopt"), myReplaced(0), mySearched(0){ }
+	unsigned run(PassManager * pm) override;
+	void report(std::ostream& out) override;
+private:
+	size_t myReplaced;
+	size_t mySearched;
+};
+
+class HashConsPass : public Transform{
+public:
+	HashConsPass() : Transform("hash-cons"), myShared(nullptr){ }
+	~HashConsPass();
+	unsigned run(PassManager * pm) override;
+	//Sharing is itself done in place, but only once
+	bool changesInPlace() const override { return false; }
+	void report(std::ostream& out) override;
+private:
+	HashCons * myShared;
+};
+
+//Runs the passes of a pipeline over a program, keeping
+// each analysis until a transform changes what it depends
+// on, and timing every pass. Passes are run by name, so
+// that a pipeline can be given on the command line
+// (--passes=fold,hash-cons).
+class PassManager{
+public:
+	PassManager(ProgramNode * ast, Modules * modules,
+		const std::string& path)
+	: myAST(ast), myModules(modules), myPath(path),
+	  myRemarks(nullptr), myRules(nullptr), myShared(false),
+	  myNested(0){ }
+	~PassManager();
+	ProgramNode * ast() const { return myAST; }
+	Modules * modules() const { return myModules; }
+	const std::string& path() const { return myPath; }
+	//Where passes note what they did, if anywhere
+	Remarks * remarks() const { return myRemarks; }
+	void setRemarks(Remarks * remarks){ myRemarks = remarks; }
+	//The rules the superoptimizer looks expressions up in
+	RuleDatabase * rules() const { return myRules; }
+	void setRules(RuleDatabase * rules){ myRules = rules; }
+	//The analysis with a name, which is computed again only
+	// if a transform has changed what it depends on since.
+	// Returns nullptr if the program failed it
+	Analysis * analysis(const std::string& name);
+	//Name and type analysis, or nullptr if they failed
+	NameAnalysis * names();
+	TypeAnalysis * types();
+	//Run a pass (which for an analysis means making sure
+	// it is up to date). Returns false if the program
+	// failed name or type analysis
+	bool run(const std::string& name);
+	//Run a comma-separated list of passes
+	bool runAll(const std::string& pipeline);
+	//The last run of a transform, if it ran
+	Transform * ran(const std::string& name) const;
+	//The time spent in each pass
+	void reportTimes(std::ostream& out) const;
+private:
+	static Pass * create(const std::string& name);
+	struct Timing{
+		Timing() : runs(0), seconds(0){ }
+		size_t runs;
+		double seconds;
+	};
+	ProgramNode * myAST;
+	Modules * myModules;
+	std::string myPath;
+	Remarks * myRemarks;
+	RuleDatabase * myRules;
+	//Whether expressions are shared, after which nothing
+	// may change them in place
+	bool myShared;
+	//The time spent in the passes run by the pass being
+	// timed, which is not counted as its own
+	double myNested;
+	std::unordered_map<std::string, Analysis *> myAnalyses;
+	std::unordered_map<std::string, Transform *> myTransforms;
+	//The analyses the program failed, which are not done
+	// again so that their errors are only reported once
+	std::unordered_set<std::string> myFailed;
+	std::unordered_map<std::string, Timing> myTimes;
+	//The passes in the order they first finished
+	std::vector<std::string> myOrder;
+};
+
+}
+
+#endif
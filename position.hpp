@@ -10,16 +10,31 @@ public:
 	Position(size_t lineI, size_t colI, size_t lineE, size_t colE)
 	: myLineI(lineI), myColI(colI), myLineE(lineE), myColE(colE){
 	}
-	Position(Position * start, Position * end)
+	Position(const Position * start, const Position * end)
 	: myLineI(start->myLineI), myColI(start->myColI),
 	  myLineE(end->myLineE),myColE(end->myColE){
 	}
-	virtual void expand(Position * start, Position * end){
+	virtual void expand(const Position * start, const Position * end){
 	  myLineI = start->myLineI;
 	  myColI = start->myColI;
 	  myLineE = end->myLineE;
 	  myColE = end->myColE;
 	}
+	//The line of a position within a single line (such as
+	// that of a token), and moving it to another line
+	size_t line() const { return myLineI; }
+	void moveToLine(size_t line){ 
+	  myLineI = line;
+	  myLineE = line;
+	}
+	//Whether another position lies within this one
+	bool contains(const Position * other) const{
+		bool startsAfter = other->myLineI > myLineI 
+		  || (other->myLineI == myLineI && other->myColI >= myColI);
+		bool endsBefore = other->myLineE < myLineE
+		  || (other->myLineE == myLineE && other->myColE <= myColE);
+		return startsAfter && endsBefore;
+	}
 	virtual std::string begin() const{
 		std::string result = "[" 
 		+ std::to_string(myLineI)
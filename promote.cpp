@@ -0,0 +1,242 @@
+#include <algorithm>
+#include "promote.hpp"
+#include "passes.hpp"
+
+namespace cminusminus{
+
+ScalarPromotion * ScalarPromotion::build(TypeAnalysis * typeAnalysis,
+	const EffectsPass * effects, Remarks * remarks){
+	ScalarPromotion * sp = new ScalarPromotion(typeAnalysis, effects,
+		remarks);
+	ProgramNode * ast = typeAnalysis->ast;
+	for (auto decl : ast->getGlobals()){
+		SemSymbol * sym = decl->getSymbol();
+		if (sym == nullptr){ continue; }
+		if (sym->getKind() == VAR){ sp->myGlobals.insert(sym); }
+		if (sym->getKind() != FN){ continue; }
+		const Effects * fnEffects = effects->of(sym);
+		if (fnEffects == nullptr){ continue; }
+		sp->myAddrTaken.insert(fnEffects->getAddrTaken()->begin(),
+			fnEffects->getAddrTaken()->end());
+	}
+	ast->promoteGlobals(sp);
+	return sp;
+}
+
+ExpNode * ScalarPromotion::rewrite(ExpNode * exp){
+	IDNode * use = exp->asID();
+	if (use == nullptr){ return exp; }
+	auto found = myLocals.find(use->getSymbol());
+	if (found == myLocals.end()){ return exp; }
+	IDNode * local = new IDNode(use->pos(), found->second->getName());
+	local->attachSymbol(found->second);
+	local->typeAnalysis(myTypes);
+	return local;
+}
+
+void ScalarPromotion::rewriteLoc(IDNode * loc){
+	auto found = myLocals.find(loc->getSymbol());
+	if (found == myLocals.end()){ return; }
+	loc->rename(found->second);
+}
+
+const std::set<SemSymbol *>& ScalarPromotion::touched(SemSymbol * fn){
+	auto found = myTouched.find(fn);
+	if (found != myTouched.end()){ return found->second; }
+
+	//Gather what every function reachable from this one
+	// uses and modifies
+	std::set<SemSymbol *>& globals = myTouched[fn];
+	std::set<SemSymbol *> seen;
+	std::vector<SemSymbol *> work{fn};
+	seen.insert(fn);
+	while (!work.empty()){
+		SemSymbol * callee = work.back();
+		work.pop_back();
+		const Effects * effects = myEffects->of(callee);
+		if (effects == nullptr){ continue; }
+		for (auto sym : *effects->getUsed()){ globals.insert(sym); }
+		for (auto sym : *effects->getModified()){ globals.insert(sym); }
+		for (auto next : *effects->getCallees()){
+			if (seen.insert(next).second){ work.push_back(next); }
+		}
+	}
+	return globals;
+}
+
+bool ScalarPromotion::promotable(SemSymbol * global,
+	const Effects * loopEffects, std::string * why){
+	const DataType * type = global->getDataType();
+	if (global->getConstant() != nullptr){
+		*why = "it is a constant";
+		return false;
+	}
+	if (!type->isInt() && !type->isShort() && !type->isBool()){
+		*why = "it is not an int, short or bool";
+		return false;
+	}
+	if (myAddrTaken.count(global) > 0){
+		*why = "its address is taken";
+		return false;
+	}
+	for (auto callee : *loopEffects->getCallees()){
+		if (touched(callee).count(global) > 0){
+			*why = "the loop calls " + callee->getName() + ", which uses it";
+			return false;
+		}
+	}
+	return true;
+}
+
+StmtNode * ScalarPromotion::store(const Position * pos,
+	SemSymbol * global){
+	IDNode * dst = new IDNode(pos, global->getName());
+	dst->attachSymbol(global);
+	IDNode * src = new IDNode(pos, myLocals[global]->getName());
+	src->attachSymbol(myLocals[global]);
+	StmtNode * stmt = new AssignStmtNode(pos,
+		new AssignExpNode(pos, dst, src));
+	stmt->typeAnalysis(myTypes);
+	return stmt;
+}
+
+void ScalarPromotion::promote(std::vector<StmtNode *>& body){
+	for (size_t i = 0; i < body.size(); i++){
+		std::vector<StmtNode *> before;
+		std::vector<StmtNode *> after;
+		body[i]->promoteGlobals(this, &before, &after);
+		auto at = body.begin() + static_cast<long>(i);
+		body.insert(at + 1, after.begin(), after.end());
+		at = body.begin() + static_cast<long>(i);
+		body.insert(at, before.begin(), before.end());
+		i += before.size() + after.size();
+	}
+}
+
+void ScalarPromotion::promoteLoop(WhileStmtNode * loop,
+	std::vector<StmtNode *> * before, std::vector<StmtNode *> * after){
+	Effects loopEffects;
+	loop->collectEffects(&loopEffects);
+	std::vector<SemSymbol *> candidates;
+	for (auto sym : myGlobals){
+		if (loopEffects.uses(sym) || loopEffects.modifies(sym)){
+			candidates.push_back(sym);
+		}
+	}
+	//In the order of their names, so that the output is
+	// the same from run to run
+	std::sort(candidates.begin(), candidates.end(),
+		[](SemSymbol * a, SemSymbol * b){
+			return a->getName() < b->getName();
+		});
+
+	myLocals.clear();
+	myStored.clear();
+	const Position * pos = loop->pos();
+	for (auto global : candidates){
+		std::string why;
+		if (!promotable(global, &loopEffects, &why)){
+			if (myRemarks != nullptr){
+				myRemarks->missed("promote", pos, "Global "
+					+ global->getName() + " kept in memory in the loop, since "
+					+ why);
+			}
+			continue;
+		}
+		std::string name = global->getName() + ".local"
+		  + std::to_string(myPromoted++);
+		VarDeclNode * decl = VarDeclNode::temp(pos, global->getDataType(),
+			name);
+		decl->typeAnalysis(myTypes);
+		myLocals[global] = decl->getSymbol();
+		before->push_back(decl);
+
+		IDNode * dst = new IDNode(pos, name);
+		dst->attachSymbol(decl->getSymbol());
+		IDNode * src = new IDNode(pos, global->getName());
+		src->attachSymbol(global);
+		StmtNode * load = new AssignStmtNode(pos,
+			new AssignExpNode(pos, dst, src));
+		load->typeAnalysis(myTypes);
+		before->push_back(load);
+
+		bool changed = loopEffects.modifies(global);
+		if (changed){
+			myStored.push_back(global);
+			after->push_back(store(pos, global));
+		}
+		if (myRemarks != nullptr){
+			myRemarks->applied("promote", pos, "Kept global "
+				+ global->getName() + " in local " + name + " for the loop"
+				+ (changed ? ", storing it back after" : ""));
+		}
+	}
+	if (myLocals.empty()){ return; }
+	loop->rewriteExps(this);
+	loop->storeBeforeReturns(this);
+	myLocals.clear();
+	myStored.clear();
+}
+
+void ScalarPromotion::storeBeforeReturns(std::vector<StmtNode *>& body){
+	for (size_t i = 0; i < body.size(); i++){
+		if (!body[i]->isReturn()){
+			body[i]->storeBeforeReturns(this);
+			continue;
+		}
+		std::vector<StmtNode *> stores;
+		for (auto global : myStored){
+			stores.push_back(store(body[i]->pos(), global));
+		}
+		body.insert(body.begin() + static_cast<long>(i), stores.begin(),
+			stores.end());
+		i += stores.size();
+	}
+}
+
+void ProgramNode::promoteGlobals(ScalarPromotion * sp){
+	for (auto decl : myGlobals){
+		std::vector<StmtNode *> before;
+		std::vector<StmtNode *> after;
+		decl->promoteGlobals(sp, &before, &after);
+	}
+}
+
+void FnDeclNode::promoteGlobals(ScalarPromotion * sp,
+	std::vector<StmtNode *> * before, std::vector<StmtNode *> * after){
+	sp->promote(myBody);
+}
+
+void IfStmtNode::promoteGlobals(ScalarPromotion * sp,
+	std::vector<StmtNode *> * before, std::vector<StmtNode *> * after){
+	sp->promote(myBody);
+}
+
+void IfElseStmtNode::promoteGlobals(ScalarPromotion * sp,
+	std::vector<StmtNode *> * before, std::vector<StmtNode *> * after){
+	sp->promote(myBodyTrue);
+	sp->promote(myBodyFalse);
+}
+
+void WhileStmtNode::promoteGlobals(ScalarPromotion * sp,
+	std::vector<StmtNode *> * before, std::vector<StmtNode *> * after){
+	//Globals that can't be promoted for the whole loop may
+	// still be for the loops inside it
+	sp->promoteLoop(this, before, after);
+	sp->promote(myBody);
+}
+
+void IfStmtNode::storeBeforeReturns(ScalarPromotion * sp){
+	sp->storeBeforeReturns(myBody);
+}
+
+void IfElseStmtNode::storeBeforeReturns(ScalarPromotion * sp){
+	sp->storeBeforeReturns(myBodyTrue);
+	sp->storeBeforeReturns(myBodyFalse);
+}
+
+void WhileStmtNode::storeBeforeReturns(ScalarPromotion * sp){
+	sp->storeBeforeReturns(myBody);
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef CMINUSMINUS_PROMOTE
+#define CMINUSMINUS_PROMOTE
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.hpp"
+#include "effects.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+class EffectsPass;
+
+// Keeps globals that a loop reads and writes in locals for
+// the length of the loop. The global is loaded into a new
+// local just before the loop, every use of it in the loop
+// becomes a use of the local, and (if the loop changes it)
+// it is stored back after the loop and before each return
+// from inside it. This is only done for scalar globals whose
+// address is never taken, so that no write through a
+// pointer can reach them, and only in loops where nothing
+// called (directly or not) uses or modifies the global.
+class ScalarPromotion : public ExpRewriter{
+public:
+	static ScalarPromotion * build(TypeAnalysis * typeAnalysis,
+		const EffectsPass * effects, Remarks * remarks = nullptr);
+	//Replace a use of a promoted global by its local
+	ExpNode * rewrite(ExpNode * exp) override;
+	void rewriteLoc(IDNode * loc) override;
+	size_t promoted() const { return myPromoted; }
+
+	//Promote the globals of the loops in a body, adding
+	// the loads and stores around them
+	void promote(std::vector<StmtNode *>& body);
+	//Promote the globals that can be in a loop, adding the
+	// statements that come before and after it
+	void promoteLoop(WhileStmtNode * loop, std::vector<StmtNode *> * before,
+		std::vector<StmtNode *> * after);
+	//Store the globals that the loop being promoted changes
+	// before each return in a body
+	void storeBeforeReturns(std::vector<StmtNode *>& body);
+private:
+	ScalarPromotion(TypeAnalysis * typeAnalysis, const EffectsPass * effects,
+		Remarks * remarks)
+	: myTypes(typeAnalysis), myEffects(effects), myRemarks(remarks),
+	  myPromoted(0){ }
+	//Whether a global can be kept in a local for a loop,
+	// and if not why not
+	bool promotable(SemSymbol * global, const Effects * loopEffects,
+		std::string * why);
+	//The globals a function uses or modifies, including in
+	// the functions it calls
+	const std::set<SemSymbol *>& touched(SemSymbol * fn);
+	StmtNode * store(const Position * pos, SemSymbol * global);
+	TypeAnalysis * myTypes;
+	const EffectsPass * myEffects;
+	Remarks * myRemarks;
+	std::set<SemSymbol *> myGlobals;
+	std::set<SemSymbol *> myAddrTaken;
+	std::unordered_map<SemSymbol *, std::set<SemSymbol *>> myTouched;
+	//The local of each global promoted in the loop being
+	// rewritten, and those of them the loop changes
+	std::unordered_map<SemSymbol *, SemSymbol *> myLocals;
+	std::vector<SemSymbol *> myStored;
+	size_t myPromoted;
+};
+
+}
+
+#endif
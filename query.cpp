@@ -0,0 +1,94 @@
+#include "query.hpp"
+#include "errors.hpp"
+
+namespace cminusminus{
+
+void Database::fetch(Query * query){
+	update(query);
+	if (!myActive.empty()){
+		myActive.back()->myDeps.push_back(query);
+		query->myUsers++;
+	}
+}
+
+void Database::set(Input * input){
+	if (!myActive.empty()){
+		throw new InternalError("Input set while computing a query");
+	}
+	myRevision++;
+	input->myVerifiedAt = myRevision;
+	input->myChangedAt = myRevision;
+}
+
+void Database::retire(Query * query){
+	if (query->myRetired){ return; }
+	query->myRetired = true;
+	//Anything computed from the query has to be computed again
+	myRevision++;
+	query->myChangedAt = myRevision;
+	if (query->myUsers == 0){
+		release(query->myDeps);
+		delete query;
+	}
+}
+
+void Database::update(Query * query){
+	if (query->myRetired || query->myVerifiedAt == myRevision){
+		return;
+	}
+	if (query->myComputing){
+		throw new InternalError("Query depends on itself");
+	}
+	if (query->myVerifiedAt > 0 && depsUnchanged(query)){
+		query->myVerifiedAt = myRevision;
+		return;
+	}
+
+	//Whatever was read last time is released once the new
+	// computation has read what it needs, so that nothing
+	// still wanted is deleted in between
+	std::vector<Query *> oldDeps;
+	oldDeps.swap(query->myDeps);
+	bool first = query->myVerifiedAt == 0;
+	bool changed;
+	query->myComputing = true;
+	myActive.push_back(query);
+	try {
+		changed = query->compute(this);
+	} catch (...) {
+		myActive.pop_back();
+		query->myComputing = false;
+		query->myVerifiedAt = 0;
+		release(oldDeps);
+		throw;
+	}
+	myActive.pop_back();
+	query->myComputing = false;
+	release(oldDeps);
+	query->myVerifiedAt = myRevision;
+	if (changed || first){ query->myChangedAt = myRevision; }
+}
+
+bool Database::depsUnchanged(Query * query){
+	//Stop at the first change, since the rest may no longer
+	// be read at all
+	for (auto dep : query->myDeps){
+		update(dep);
+		if (dep->myChangedAt > query->myVerifiedAt){ return false; }
+	}
+	return true;
+}
+
+void Database::release(const std::vector<Query *>& deps){
+	for (auto dep : deps){
+		dep->myUsers--;
+		if (dep->myRetired && dep->myUsers == 0){
+			std::vector<Query *> next;
+			next.swap(dep->myDeps);
+			delete dep;
+			release(next);
+		}
+	}
+}
+
+}
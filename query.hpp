@@ -0,0 +1,74 @@
+#ifndef CMINUSMINUS_QUERY
+#define CMINUSMINUS_QUERY
+
+#include <cstddef>
+#include <vector>
+
+namespace cminusminus{
+
+class Database;
+
+//A result that is computed when it is asked for, and then
+// kept until something it was computed from changes. While
+// a query is computed, every other query it reads is
+// recorded, so that it is only computed again once one of
+// those has changed. A query whose result comes out the
+// same as before counts as unchanged, and so whatever was
+// computed from it is kept as well.
+class Query{
+public:
+	Query() : myVerifiedAt(0), myChangedAt(0), myUsers(0),
+	  myComputing(false), myRetired(false){ }
+	virtual ~Query(){ }
+protected:
+	//Compute the result again, reading other queries
+	// through Database::fetch. Returns whether the result
+	// differs from the last one
+	virtual bool compute(Database * db) = 0;
+private:
+	friend class Database;
+	//The revision at which the result was last known to be
+	// up to date, and the revision at which it last changed
+	size_t myVerifiedAt;
+	size_t myChangedAt;
+	//The queries read by the last computation
+	std::vector<Query *> myDeps;
+	//How many times other queries read this one
+	size_t myUsers;
+	bool myComputing;
+	bool myRetired;
+};
+
+//A query whose result is set from outside, such as the
+// text of a source file
+class Input : public Query{
+protected:
+	bool compute(Database *) override { return false; }
+};
+
+//Keeps track of which queries are up to date
+class Database{
+public:
+	Database() : myRevision(1){ }
+	//Bring a query up to date, recording that it was read
+	// by the query being computed, if any
+	void fetch(Query * query);
+	//Note that an input was set. This may not be done while
+	// a query is being computed
+	void set(Input * input);
+	//Note that a query is gone along with whatever it was
+	// computed from, so that its users are computed again.
+	// It is deleted once no query reads it
+	void retire(Query * query);
+private:
+	void update(Query * query);
+	bool depsUnchanged(Query * query);
+	void release(const std::vector<Query *>& deps);
+	size_t myRevision;
+	//The queries being computed, innermost last
+	std::vector<Query *> myActive;
+};
+
+}
+
+#endif
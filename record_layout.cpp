@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <vector>
+#include "record_layout.hpp"
+#include "symbol_table.hpp"
+#include "ast.hpp"
+
+namespace cminusminus{
+
+//The size of the pointer from the hot part of a split 
+// record to its cold block
+static const size_t COLD_PTR_SIZE = 8;
+
+//A field is considered cold if its hottest sibling is 
+// accessed at least this many times more often
+static const size_t COLD_RATIO = 8;
+
+static size_t roundUp(size_t val, size_t align){
+	if (align == 0){ return val; }
+	return (val + align - 1) / align * align;
+}
+
+//Assign offsets to the given fields, in order, starting at
+// base. Returns the end offset (before tail padding)
+static size_t place(std::list<RecordField *> * fields, size_t base,
+	size_t * maxAlign){
+	size_t offset = base;
+	for (auto field : *fields){
+		size_t align = field->getType()->getAlignment();
+		offset = roundUp(offset, align);
+		field->offset = offset;
+		offset += field->getType()->getSize();
+		*maxAlign = std::max(*maxAlign, align);
+	}
+	return offset;
+}
+
+static void sortBySize(std::list<RecordField *> * fields){
+	//Stable, so that equally-sized fields keep their
+	// declaration order
+	std::vector<RecordField *> sorted(fields->begin(), fields->end());
+	std::stable_sort(sorted.begin(), sorted.end(),
+		[](RecordField * a, RecordField * b){
+			size_t alignA = a->getType()->getAlignment();
+			size_t alignB = b->getType()->getAlignment();
+			if (alignA != alignB){ return alignA > alignB; }
+			return a->getType()->getSize() > b->getType()->getSize();
+		});
+	fields->assign(sorted.begin(), sorted.end());
+}
+
+void RecordType::addField(SemSymbol * sym, const DataType * type){
+	myFields.push_back(new RecordField(sym, type));
+}
+
+RecordField * RecordType::getField(std::string name) const{
+	for (auto field : myFields){
+		if (field->getSymbol()->getName() == name){ return field; }
+	}
+	return nullptr;
+}
+
+void RecordType::noteAccess(std::string name, size_t weight) const{
+	RecordField * field = getField(name);
+	if (field != nullptr){ field->hits += weight; }
+}
+
+void RecordType::layout(bool splitCold) const{
+	myLaidOut = true;
+	mySplitCold = splitCold;
+	myHotOrder.assign(myFields.begin(), myFields.end());
+	myColdOrder.clear();
+	for (auto field : myFields){ field->cold = false; }
+	arrange();
+
+	if (!splitCold){ return; }
+
+	size_t maxHits = 0;
+	for (auto field : myFields){
+		maxHits = std::max(maxHits, field->hits);
+	}
+	std::list<RecordField *> hot;
+	std::list<RecordField *> cold;
+	for (auto field : myFields){
+		if (field->hits * COLD_RATIO < maxHits){ 
+			cold.push_back(field); 
+		} else {
+			hot.push_back(field);
+		}
+	}
+	if (cold.empty()){ return; }
+
+	//Only keep the split if it actually shrinks the hot 
+	// part of the record, since the cold pointer itself
+	// takes up room
+	size_t unsplitSize = mySize;
+	myHotOrder = hot;
+	myColdOrder = cold;
+	arrange();
+	if (mySize >= unsplitSize){
+		myHotOrder.assign(myFields.begin(), myFields.end());
+		myColdOrder.clear();
+		arrange();
+		return;
+	}
+	for (auto field : myColdOrder){ field->cold = true; }
+}
+
+void RecordType::arrange() const{
+	sortBySize(&myHotOrder);
+	sortBySize(&myColdOrder);
+
+	myAlign = 1;
+	size_t base = 0;
+	if (!myColdOrder.empty()){
+		//The cold pointer goes first since it has the
+		// strictest alignment of anything in the record
+		base = COLD_PTR_SIZE;
+		myAlign = COLD_PTR_SIZE;
+	}
+	size_t end = place(&myHotOrder, base, &myAlign);
+	mySize = roundUp(end, myAlign);
+
+	size_t coldAlign = 1;
+	size_t coldEnd = place(&myColdOrder, 0, &coldAlign);
+	myColdSize = roundUp(coldEnd, coldAlign);
+}
+
+size_t RecordType::getSize() const{
+	if (!myLaidOut){ layout(mySplitCold); }
+	return mySize;
+}
+
+size_t RecordType::getAlignment() const{
+	if (!myLaidOut){ layout(mySplitCold); }
+	return myAlign;
+}
+
+size_t RecordType::getColdSize() const{
+	if (!myLaidOut){ layout(mySplitCold); }
+	return myColdSize;
+}
+
+size_t RecordType::getPadding() const{
+	size_t used = isSplit() ? COLD_PTR_SIZE : 0;
+	for (auto field : myHotOrder){
+		used += field->getType()->getSize();
+	}
+	return getSize() - used;
+}
+
+size_t RecordType::getDeclaredSize() const{
+	//The size the record would have if the fields were 
+	// laid out in the order they were written. Only the 
+	// size is computed, the real offsets are left alone
+	size_t align = 1;
+	size_t offset = 0;
+	for (auto field : myFields){
+		size_t fieldAlign = field->getType()->getAlignment();
+		offset = roundUp(offset, fieldAlign);
+		offset += field->getType()->getSize();
+		align = std::max(align, fieldAlign);
+	}
+	return roundUp(offset, align);
+}
+
+RecordLayout * RecordLayout::build(NameAnalysis * nameAnalysis, 
+	bool splitCold){
+	RecordLayout * result = new RecordLayout();
+	nameAnalysis->ast->collectRecords(&result->myRecords);
+	//Records are laid out in declaration order, so that any
+	// record nested by value has its final size already
+	for (auto record : result->myRecords){
+		record->layout(splitCold);
+	}
+	return result;
+}
+
+static void reportFields(std::ostream& out, 
+	const std::list<RecordField *> * fields){
+	for (auto field : *fields){
+		out << "\t" << field->offset 
+		  << "\t" << field->getType()->getString()
+		  << " " << field->getSymbol()->getName()
+		  << " (" << field->getType()->getSize() << " bytes, "
+		  << field->hits << " weighted accesses)\n";
+	}
+}
+
+void RecordLayout::report(std::ostream& out){
+	for (auto record : myRecords){
+		size_t declared = record->getDeclaredSize();
+		out << "record " << record->getString() 
+		  << ": size " << record->getSize()
+		  << ", alignment " << record->getAlignment()
+		  << ", padding " << record->getPadding()
+		  << " (declaration order: size " << declared << ")\n";
+		if (record->isSplit()){
+			out << "\t0\tcold block pointer (" 
+			  << COLD_PTR_SIZE << " bytes)\n";
+		}
+		reportFields(out, record->getHotOrder());
+		if (record->isSplit()){
+			out << "  cold block: size " << record->getColdSize()
+			  << "\n";
+			reportFields(out, record->getColdOrder());
+		}
+	}
+}
+
+}
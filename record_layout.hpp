@@ -0,0 +1,30 @@
+#ifndef CMINUSMINUS_RECORD_LAYOUT
+#define CMINUSMINUS_RECORD_LAYOUT
+
+#include <ostream>
+#include <list>
+#include "types.hpp"
+#include "name_analysis.hpp"
+
+namespace cminusminus{
+
+// Computes the memory layout of every record in the program.
+// Fields are ordered by decreasing alignment (and then size)
+// so that padding only ever appears at the tail of a record.
+// Optionally, fields that are rarely accessed relative to the
+// hottest field of their record are moved out into a separate
+// cold block reached through a pointer, so that the hot part
+// of the record packs into as few cache lines as possible.
+class RecordLayout{
+public:
+	static RecordLayout * build(NameAnalysis * nameAnalysis, 
+		bool splitCold);
+	void report(std::ostream& out);
+private:
+	RecordLayout(){ }
+	std::list<const RecordType *> myRecords;
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "remarks.hpp"
+#include "ast.hpp"
+
+namespace cminusminus{
+
+const char * Remark::kindName(Kind kind){
+	switch (kind){
+	case APPLIED: return "applied";
+	case MISSED: return "missed";
+	case ANALYSIS: return "analysis";
+	}
+	return "unknown";
+}
+
+static void addNames(const std::string& names,
+	std::unordered_set<std::string>& into){
+	size_t start = 0;
+	while (start <= names.size()){
+		size_t end = names.find(',', start);
+		if (end == std::string::npos){ end = names.size(); }
+		if (end > start){ into.insert(names.substr(start, end - start)); }
+		start = end + 1;
+	}
+}
+
+void Remarks::onlyPasses(const std::string& names){
+	addNames(names, myPasses);
+}
+
+void Remarks::onlyFns(const std::string& names){
+	addNames(names, myFns);
+}
+
+void Remarks::add(Remark::Kind kind, const std::string& pass,
+	const Position * pos, const std::string& msg){
+	if (!myPasses.empty() && myPasses.count(pass) == 0){ return; }
+	std::string fn = fnAt(pos);
+	if (!myFns.empty() && myFns.count(fn) == 0){ return; }
+	myRemarks.push_back(Remark(kind, pass, *pos, fn, msg));
+}
+
+std::string Remarks::fnAt(const Position * pos) const{
+	for (auto decl : myAST->getGlobals()){
+		if (decl->getSymbol() == nullptr
+		    || decl->getSymbol()->getKind() != FN){
+			continue;
+		}
+		if (decl->pos()->contains(pos)){ return decl->ID()->getName(); }
+	}
+	return "";
+}
+
+void Remarks::write(std::ostream& out) const{
+	for (auto& remark : myRemarks){
+		out << Remark::kindName(remark.kind) << " " << remark.pass
+		  << " " << (remark.fn.empty() ? "-" : remark.fn)
+		  << " " << remark.pos.span() << ": " << remark.msg << "\n";
+	}
+}
+
+}
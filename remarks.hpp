@@ -0,0 +1,78 @@
+#ifndef CMINUSMINUS_REMARKS
+#define CMINUSMINUS_REMARKS
+
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "position.hpp"
+
+namespace cminusminus{
+
+class ProgramNode;
+
+//A note from a pass about one place in the program: an
+// optimization it made, one it could not make and why, or
+// something it found out
+class Remark{
+public:
+	enum Kind{
+		APPLIED,
+		MISSED,
+		ANALYSIS
+	};
+	Remark(Kind kindIn, const std::string& passIn, const Position& posIn,
+		const std::string& fnIn, const std::string& msgIn)
+	: kind(kindIn), pass(passIn), pos(posIn), fn(fnIn), msg(msgIn){ }
+	static const char * kindName(Kind kind);
+	Kind kind;
+	std::string pass;
+	Position pos;
+	//The function the remark is in, or empty for one
+	// about a global declaration
+	std::string fn;
+	std::string msg;
+};
+
+//The remarks of every pass run over a program, written as
+// one line each:
+//  <kind> <pass> <function> <span>: <message>
+// where the function is - outside of any function. Only the
+// remarks of the passes and functions asked for are kept,
+// so that a large program can be looked at one function at
+// a time.
+class Remarks{
+public:
+	Remarks(ProgramNode * ast) : myAST(ast){ }
+	//Keep only the remarks of some passes or functions,
+	// each given as a comma-separated list
+	void onlyPasses(const std::string& names);
+	void onlyFns(const std::string& names);
+	void applied(const std::string& pass, const Position * pos,
+		const std::string& msg){
+		add(Remark::APPLIED, pass, pos, msg);
+	}
+	void missed(const std::string& pass, const Position * pos,
+		const std::string& msg){
+		add(Remark::MISSED, pass, pos, msg);
+	}
+	void analysis(const std::string& pass, const Position * pos,
+		const std::string& msg){
+		add(Remark::ANALYSIS, pass, pos, msg);
+	}
+	const std::vector<Remark>& all() const { return myRemarks; }
+	void write(std::ostream& out) const;
+private:
+	void add(Remark::Kind kind, const std::string& pass,
+		const Position * pos, const std::string& msg);
+	//The function a position is in
+	std::string fnAt(const Position * pos) const;
+	ProgramNode * myAST;
+	std::unordered_set<std::string> myPasses;
+	std::unordered_set<std::string> myFns;
+	std::vector<Remark> myRemarks;
+};
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "ast.hpp"
+
+namespace cminusminus{
+
+void ProgramNode::rewriteExps(ExpRewriter * rw){
+	for (auto decl : myGlobals){
+		decl->rewriteExps(rw);
+	}
+}
+
+void FnDeclNode::rewriteExps(ExpRewriter * rw){
+	for (auto stmt : myBody){
+		stmt->rewriteExps(rw);
+	}
+}
+
+void AssignStmtNode::rewriteExps(ExpRewriter * rw){
+	//The assignment is kept as the statement's expression,
+	// since its value is never used
+	myExp->rewriteExps(rw);
+}
+
+void ReadStmtNode::rewriteExps(ExpRewriter * rw){
+	myDst->rewriteLocExps(rw);
+}
+
+void WriteStmtNode::rewriteExps(ExpRewriter * rw){
+	mySrc = mySrc->rewriteExps(rw);
+}
+
+void PostIncStmtNode::rewriteExps(ExpRewriter * rw){
+	myLVal->rewriteLocExps(rw);
+}
+
+void PostDecStmtNode::rewriteExps(ExpRewriter * rw){
+	myLVal->rewriteLocExps(rw);
+}
+
+void IfStmtNode::rewriteExps(ExpRewriter * rw){
+	myCond = myCond->rewriteExps(rw);
+	for (auto stmt : myBody){
+		stmt->rewriteExps(rw);
+	}
+}
+
+void IfElseStmtNode::rewriteExps(ExpRewriter * rw){
+	myCond = myCond->rewriteExps(rw);
+	for (auto stmt : myBodyTrue){
+		stmt->rewriteExps(rw);
+	}
+	for (auto stmt : myBodyFalse){
+		stmt->rewriteExps(rw);
+	}
+}
+
+void WhileStmtNode::rewriteExps(ExpRewriter * rw){
+	myCond = myCond->rewriteExps(rw);
+	for (auto stmt : myBody){
+		stmt->rewriteExps(rw);
+	}
+}
+
+void ReturnStmtNode::rewriteExps(ExpRewriter * rw){
+	if (myExp != nullptr){ myExp = myExp->rewriteExps(rw); }
+}
+
+void CallStmtNode::rewriteExps(ExpRewriter * rw){
+	//As for assignments, the call itself stays in place
+	myCallExp->rewriteExps(rw);
+}
+
+void IDNode::rewriteLocExps(ExpRewriter * rw){
+	rw->rewriteLoc(this);
+}
+
+ExpNode * CallExpNode::rewriteExps(ExpRewriter * rw){
+	for (auto& arg : myArgs){
+		arg = arg->rewriteExps(rw);
+	}
+	return rw->rewrite(this);
+}
+
+ExpNode * BinaryExpNode::rewriteExps(ExpRewriter * rw){
+	myExp1 = myExp1->rewriteExps(rw);
+	myExp2 = myExp2->rewriteExps(rw);
+	return rw->rewrite(this);
+}
+
+ExpNode * UnaryExpNode::rewriteExps(ExpRewriter * rw){
+	myExp = myExp->rewriteExps(rw);
+	return rw->rewrite(this);
+}
+
+ExpNode * RefNode::rewriteExps(ExpRewriter * rw){
+	//The operand is a location, not a value
+	return rw->rewrite(this);
+}
+
+ExpNode * FieldAccessNode::rewriteExps(ExpRewriter * rw){
+	rewriteLocExps(rw);
+	return rw->rewrite(this);
+}
+
+void FieldAccessNode::rewriteLocExps(ExpRewriter * rw){
+	myBase->rewriteLocExps(rw);
+}
+
+ExpNode * IndexNode::rewriteExps(ExpRewriter * rw){
+	rewriteLocExps(rw);
+	return rw->rewrite(this);
+}
+
+void IndexNode::rewriteLocExps(ExpRewriter * rw){
+	myBase->rewriteLocExps(rw);
+	myIndex = myIndex->rewriteExps(rw);
+}
+
+ExpNode * AssignExpNode::rewriteExps(ExpRewriter * rw){
+	myDst->rewriteLocExps(rw);
+	mySrc = mySrc->rewriteExps(rw);
+	return rw->rewrite(this);
+}
+
+}
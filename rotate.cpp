@@ -0,0 +1,128 @@
+#include "rotate.hpp"
+
+namespace cminusminus{
+
+LoopRotation * LoopRotation::build(TypeAnalysis * typeAnalysis,
+	Remarks * remarks){
+	LoopRotation * rot = new LoopRotation(typeAnalysis, remarks);
+	typeAnalysis->ast->rotateLoops(rot);
+	return rot;
+}
+
+void LoopRotation::rotate(std::vector<StmtNode *>& body){
+	for (auto& stmt : body){
+		stmt = stmt->rotateLoops(this);
+	}
+}
+
+StmtNode * LoopRotation::guard(WhileStmtNode * loop, ExpNode * cond){
+	cond->typeAnalysis(myTypes);
+	IfStmtNode * guard = new IfStmtNode(loop->pos(), cond, {loop});
+	guard->typeRule(myTypes);
+	myRotated++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("rotate", loop->pos(), "Rotated the loop,"
+			" testing its condition once before it and then at the"
+			" bottom of each iteration");
+	}
+	return guard;
+}
+
+void LoopRotation::kept(WhileStmtNode * loop){
+	if (myRemarks != nullptr){
+		myRemarks->missed("rotate", loop->pos(), "Loop not rotated,"
+			" since its condition does more than read variables");
+	}
+}
+
+void ProgramNode::rotateLoops(LoopRotation * rot){
+	for (auto decl : myGlobals){
+		decl->rotateLoops(rot);
+	}
+}
+
+StmtNode * FnDeclNode::rotateLoops(LoopRotation * rot){
+	rot->rotate(myBody);
+	return this;
+}
+
+StmtNode * IfStmtNode::rotateLoops(LoopRotation * rot){
+	rot->rotate(myBody);
+	return this;
+}
+
+StmtNode * IfElseStmtNode::rotateLoops(LoopRotation * rot){
+	rot->rotate(myBodyTrue);
+	rot->rotate(myBodyFalse);
+	return this;
+}
+
+StmtNode * WhileStmtNode::rotateLoops(LoopRotation * rot){
+	rot->rotate(myBody);
+	if (myRotated){ return this; }
+	//The guard and the bottom of the loop together test
+	// the condition as often as the top of the loop did,
+	// so any condition that can be copied will do
+	ExpNode * guardCond = myCond->duplicate();
+	if (guardCond == nullptr){
+		rot->kept(this);
+		return this;
+	}
+	myRotated = true;
+	return rot->guard(this, guardCond);
+}
+
+ExpNode * IDNode::duplicate() const{
+	IDNode * copy = new IDNode(&myPos, name);
+	copy->attachSymbol(mySymbol);
+	return copy;
+}
+
+ExpNode * BinaryExpNode::duplicate() const{
+	ExpNode * lhs = myExp1->duplicate();
+	if (lhs == nullptr){ return nullptr; }
+	ExpNode * rhs = myExp2->duplicate();
+	if (rhs == nullptr){
+		delete lhs;
+		return nullptr;
+	}
+	return withOperands(lhs, rhs);
+}
+
+ExpNode * NegNode::duplicate() const{
+	ExpNode * exp = myExp->duplicate();
+	if (exp == nullptr){ return nullptr; }
+	return new NegNode(&myPos, exp);
+}
+
+ExpNode * NotNode::duplicate() const{
+	ExpNode * exp = myExp->duplicate();
+	if (exp == nullptr){ return nullptr; }
+	return new NotNode(&myPos, exp);
+}
+
+ExpNode * DerefNode::duplicate() const{
+	return new DerefNode(&myPos, myID->duplicate()->asID());
+}
+
+ExpNode * FieldAccessNode::duplicate() const{
+	ExpNode * base = myBase->duplicate();
+	if (base == nullptr){ return nullptr; }
+	return new FieldAccessNode(&myPos, base->asLVal(),
+		myField->duplicate()->asID());
+}
+
+ExpNode * IndexNode::duplicate() const{
+	ExpNode * base = myBase->duplicate();
+	if (base == nullptr){ return nullptr; }
+	ExpNode * index = myIndex->duplicate();
+	if (index == nullptr){
+		delete base;
+		return nullptr;
+	}
+	IndexNode * copy = new IndexNode(&myPos, base->asLVal(), index);
+	copy->myChecked = myChecked;
+	return copy;
+}
+
+}
@@ -0,0 +1,43 @@
+#ifndef CMINUSMINUS_ROTATE
+#define CMINUSMINUS_ROTATE
+
+#include <vector>
+#include "ast.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+// Rotates while loops into guarded do-while form. Each loop
+// is placed in an if that tests a copy of its condition, and
+// the loop itself then only tests the condition at the bottom
+// of each iteration, so that the steady state takes a single
+// conditional branch back to the top. This is the form later
+// loop passes expect: whatever they put between the guard and
+// the loop only runs when the loop does, and a guard known to
+// hold can be removed, so the first test is never made.
+class LoopRotation{
+public:
+	static LoopRotation * build(TypeAnalysis * typeAnalysis,
+		Remarks * remarks = nullptr);
+	size_t rotated() const { return myRotated; }
+
+	//Rotate the loops of a body, replacing each by its guard
+	void rotate(std::vector<StmtNode *>& body);
+	//Place a loop in a guard testing a copy of its
+	// condition, returning the guard
+	StmtNode * guard(WhileStmtNode * loop, ExpNode * cond);
+	//Note that a loop's condition can't be copied, so that
+	// it stays as it is
+	void kept(WhileStmtNode * loop);
+private:
+	LoopRotation(TypeAnalysis * typeAnalysis, Remarks * remarks)
+	: myTypes(typeAnalysis), myRemarks(remarks), myRotated(0){ }
+	TypeAnalysis * myTypes;
+	Remarks * myRemarks;
+	size_t myRotated;
+};
+
+}
+
+#endif
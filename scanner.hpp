@@ -31,10 +31,10 @@ public:
 
    int makeBareToken(int tagIn){
 	size_t len = static_cast<size_t>(yyleng);
-	Position * pos = new Position(
+	Position pos(
 	  this->lineNum, this->colNum,
 	  this->lineNum, this->colNum+len);
-        this->yylval->lexeme = new Token(pos, tagIn);
+        this->yylval->emplace<Token>(pos, tagIn);
         colNum += len;
         return tagIn;
    }
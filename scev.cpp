@@ -0,0 +1,390 @@
+#include "scev.hpp"
+#include "hash_cons.hpp"
+
+namespace cminusminus{
+
+ScalarEvolution * ScalarEvolution::build(TypeAnalysis * typeAnalysis,
+	Remarks * remarks){
+	ScalarEvolution * scev = new ScalarEvolution(typeAnalysis, remarks);
+	typeAnalysis->ast->closeLoops(scev);
+	return scev;
+}
+
+bool ScalarEvolution::pure(const ExpNode * exp){
+	ConsKey key;
+	if (!exp->consKey(&key)){ return false; }
+	if (key.lhs != nullptr && !pure(key.lhs)){ return false; }
+	if (key.rhs != nullptr && !pure(key.rhs)){ return false; }
+	return true;
+}
+
+void ScalarEvolution::usesOf(const ExpNode * exp,
+	std::set<const SemSymbol *> * uses){
+	ConsKey key;
+	if (!exp->consKey(&key)){ return; }
+	if (key.sym != nullptr){ uses->insert(key.sym); }
+	if (key.lhs != nullptr){ usesOf(key.lhs, uses); }
+	if (key.rhs != nullptr){ usesOf(key.rhs, uses); }
+}
+
+//Whether an expression is the literal one
+static bool isOne(const ExpNode * exp){
+	if (exp == nullptr){ return true; }
+	ConsKey key;
+	return exp->consKey(&key) && key.op == "int" && key.num == 1;
+}
+
+//The variable an expression reads, if it is a variable
+static const SemSymbol * readOf(const ExpNode * exp){
+	ConsKey key;
+	if (!exp->consKey(&key) || key.op != "id"){ return nullptr; }
+	return key.sym;
+}
+
+void ScalarEvolution::enterFn(const Effects * fnEffects){
+	myAliases.enterFn(fnEffects);
+}
+
+void ScalarEvolution::close(std::vector<StmtNode *>& body){
+	myFrames.push_back(Frame{&body, 0});
+	for (size_t i = 0; i < body.size(); i++){
+		myFrames.back().at = i;
+		body[i] = body[i]->closeLoops(this);
+	}
+	myFrames.pop_back();
+}
+
+void ScalarEvolution::recur(SemSymbol * var, const ExpNode * term,
+	long sign){
+	if (!myWhy.empty()){ return; }
+	if (var == nullptr || var->getKind() != VAR
+	  || !var->getDataType()->isInt()){
+		myWhy = "it changes a variable that is not an int";
+		return;
+	}
+	if (recurrenceOf(var) != nullptr){
+		myWhy = var->getName() + " changes more than once in it";
+		return;
+	}
+	myRecs.push_back(Recurrence{var, term, sign});
+}
+
+bool ScalarEvolution::assigned(IDNode * dst, const ExpNode * src){
+	SemSymbol * var = dst->getSymbol();
+	ConsKey key;
+	if (!src->consKey(&key) || (key.op != "+" && key.op != "-")){
+		return false;
+	}
+	if (readOf(key.lhs) == var){
+		recur(var, key.rhs, key.op == "+" ? 1 : -1);
+		return true;
+	}
+	if (key.op == "+" && readOf(key.rhs) == var){
+		recur(var, key.lhs, 1);
+		return true;
+	}
+	return false;
+}
+
+const ScalarEvolution::Recurrence * ScalarEvolution::recurrenceOf(
+	const SemSymbol * var) const{
+	for (const Recurrence& rec : myRecs){
+		if (rec.var == var){ return &rec; }
+	}
+	return nullptr;
+}
+
+bool ScalarEvolution::induction(const Recurrence& rec) const{
+	if (rec.term == nullptr){ return true; }
+	if (!pure(rec.term)){ return false; }
+	std::set<const SemSymbol *> uses;
+	usesOf(rec.term, &uses);
+	for (auto sym : uses){
+		if (recurrenceOf(sym) != nullptr){ return false; }
+	}
+	return true;
+}
+
+bool ScalarEvolution::changes(StmtNode * stmt, SemSymbol * var){
+	Effects effects;
+	stmt->collectEffects(&effects);
+	return effects.modifies(var)
+	  || (Aliases::hidden(&effects) && myAliases.aliased(var));
+}
+
+bool ScalarEvolution::startValue(WhileStmtNode * loop, SemSymbol * var,
+	long * value){
+	for (size_t f = myFrames.size(); f > 0; f--){
+		const Frame& frame = myFrames[f - 1];
+		for (size_t k = frame.at; k > 0; k--){
+			StmtNode * stmt = (*frame.body)[k - 1];
+			AssignExpNode * assign = stmt->assignment();
+			if (assign != nullptr && assign->getDst()->asID() != nullptr
+			  && assign->getDst()->asID()->getSymbol() == var){
+				ConsKey key;
+				if (!assign->getSrc()->consKey(&key) || key.op != "int"){
+					return false;
+				}
+				*value = key.num;
+				return true;
+			}
+			if (changes(stmt, var)){ return false; }
+		}
+		//A rotated loop alone in its guard starts from what
+		// there is before the guard, unless testing the guard
+		// changes it
+		if (!loop->isRotated() || f != myFrames.size() || f < 2
+		  || frame.body->size() != 1){
+			return false;
+		}
+		const Frame& outer = myFrames[f - 2];
+		StmtNode * guard = (*outer.body)[outer.at];
+		if (guard->arm(true) != frame.body || guard->arm(false) != nullptr){
+			return false;
+		}
+		Effects condEffects;
+		guard->branchCond()->collectEffects(&condEffects);
+		if (condEffects.modifies(var) || (Aliases::hidden(&condEffects)
+		  && myAliases.aliased(var))){
+			return false;
+		}
+	}
+	return false;
+}
+
+void ScalarEvolution::missed(WhileStmtNode * loop, const std::string& why){
+	if (myRemarks != nullptr){
+		myRemarks->missed("scev", loop->pos(), "Loop kept, since " + why);
+	}
+}
+
+IDNode * ScalarEvolution::use(const Position * pos, SemSymbol * var){
+	IDNode * id = new IDNode(pos, var->getName());
+	id->attachSymbol(var);
+	return id;
+}
+
+ExpNode * ScalarEvolution::times(const Position * pos, ExpNode * lhs,
+	const ExpNode * term){
+	if (term == nullptr){ return lhs; }
+	return new TimesNode(pos, lhs, term->duplicate());
+}
+
+StmtNode * ScalarEvolution::assign(const Position * pos, SemSymbol * var,
+	ExpNode * value){
+	return new AssignStmtNode(pos, new AssignExpNode(pos, use(pos, var),
+		value));
+}
+
+StmtNode * ScalarEvolution::evolve(WhileStmtNode * loop,
+	const ExpNode * cond, std::vector<StmtNode *>& body){
+	myRecs.clear();
+	myWhy.clear();
+	for (auto stmt : body){
+		if (!stmt->addRecurrence(this)){
+			missed(loop, "its body does more than add to variables");
+			return loop;
+		}
+	}
+	if (!myWhy.empty()){
+		missed(loop, myWhy);
+		return loop;
+	}
+
+	//The condition compares a variable the loop counts
+	// towards a bound it doesn't change
+	ConsKey key;
+	if (!cond->consKey(&key) || (key.op != "<" && key.op != ">")){
+		missed(loop, "its condition is not a < or > comparison");
+		return loop;
+	}
+	const Recurrence * counter = recurrenceOf(readOf(key.lhs));
+	const ExpNode * bound = key.rhs;
+	bool up = key.op == "<";
+	if (counter == nullptr){
+		counter = recurrenceOf(readOf(key.rhs));
+		bound = key.lhs;
+		up = !up;
+	}
+	if (counter == nullptr){
+		missed(loop, "its condition doesn't test a variable it counts");
+		return loop;
+	}
+	if (!isOne(counter->term) || counter->sign != (up ? 1 : -1)){
+		missed(loop, counter->var->getName()
+		  + " doesn't step by one towards the bound");
+		return loop;
+	}
+	std::set<const SemSymbol *> boundUses;
+	usesOf(bound, &boundUses);
+	bool invariant = pure(bound);
+	for (auto sym : boundUses){
+		if (recurrenceOf(sym) != nullptr){ invariant = false; }
+	}
+	if (!invariant){
+		missed(loop, "its bound may change in it");
+		return loop;
+	}
+
+	bool sums = false;
+	for (const Recurrence& rec : myRecs){
+		if (induction(rec)){ continue; }
+		const Recurrence * summed = recurrenceOf(readOf(rec.term));
+		if (summed == nullptr || summed == &rec || !induction(*summed)){
+			missed(loop, "what it adds to " + rec.var->getName()
+			  + " changes in a way that isn't understood");
+			return loop;
+		}
+		sums = true;
+	}
+	if (sums){
+		long start = -1;
+		ConsKey boundKey;
+		bool fits = up
+		  ? startValue(loop, counter->var, &start) && start >= 0
+		  : bound->consKey(&boundKey) && boundKey.op == "int"
+		    && boundKey.num >= 0;
+		if (!fits){
+			missed(loop, "its trip count may not fit in an int");
+			return loop;
+		}
+	}
+
+	const Position * pos = loop->pos();
+	std::string prefix = counter->var->getName() + ".";
+	std::string suffix = std::to_string(myClosed);
+	std::vector<StmtNode *> stmts;
+	VarDeclNode * tripsDecl = VarDeclNode::temp(pos, BasicType::INT(),
+		prefix + "trips" + suffix);
+	SemSymbol * trips = tripsDecl->getSymbol();
+	stmts.push_back(tripsDecl);
+	stmts.push_back(assign(pos, trips, up
+	  ? new MinusNode(pos, bound->duplicate(), use(pos, counter->var))
+	  : new MinusNode(pos, use(pos, counter->var), bound->duplicate())));
+
+	//trips * (trips - 1) / 2, halving whichever factor is
+	// even so that the product can wrap around
+	SemSymbol * tri = nullptr;
+	if (sums){
+		VarDeclNode * triDecl = VarDeclNode::temp(pos, BasicType::INT(),
+			prefix + "tri" + suffix);
+		tri = triDecl->getSymbol();
+		stmts.push_back(triDecl);
+		ExpNode * half = new DivideNode(pos, use(pos, trips),
+			new IntLitNode(pos, 2));
+		ExpNode * odd = new MinusNode(pos, use(pos, trips),
+			new TimesNode(pos, half->duplicate(), new IntLitNode(pos, 2)));
+		ExpNode * other = new PlusNode(pos, new MinusNode(pos,
+			use(pos, trips), new IntLitNode(pos, 1)), odd);
+		stmts.push_back(assign(pos, tri, new TimesNode(pos, half, other)));
+	}
+
+	//Sums come first, since they read the values the
+	// induction variables start with
+	std::string names;
+	for (size_t i = 0; i < myRecs.size(); i++){
+		const Recurrence& rec = myRecs[i];
+		if (induction(rec)){ continue; }
+		const Recurrence * summed = recurrenceOf(readOf(rec.term));
+		//The value added in the first iteration, which is
+		// past the first step if that comes before the sum
+		ExpNode * first = use(pos, summed->var);
+		if (summed < &rec){
+			ExpNode * step = summed->term == nullptr
+			  ? new IntLitNode(pos, 1) : summed->term->duplicate();
+			first = summed->sign > 0 ? static_cast<ExpNode *>(
+			    new PlusNode(pos, first, step))
+			  : new MinusNode(pos, first, step);
+		}
+		ExpNode * total = new TimesNode(pos, use(pos, trips), first);
+		ExpNode * growth = times(pos, use(pos, tri), summed->term);
+		total = summed->sign > 0 ? static_cast<ExpNode *>(
+		    new PlusNode(pos, total, growth))
+		  : new MinusNode(pos, total, growth);
+		stmts.push_back(assign(pos, rec.var, rec.sign > 0
+		  ? static_cast<ExpNode *>(
+		      new PlusNode(pos, use(pos, rec.var), total))
+		  : new MinusNode(pos, use(pos, rec.var), total)));
+	}
+	for (const Recurrence& rec : myRecs){
+		names += (names.empty() ? "" : ", ") + rec.var->getName();
+		if (&rec == counter || !induction(rec)){ continue; }
+		ExpNode * total = times(pos, use(pos, trips), rec.term);
+		stmts.push_back(assign(pos, rec.var, rec.sign > 0
+		  ? static_cast<ExpNode *>(
+		      new PlusNode(pos, use(pos, rec.var), total))
+		  : new MinusNode(pos, use(pos, rec.var), total)));
+	}
+	//Counting by one, the counter stops exactly at the bound
+	stmts.push_back(assign(pos, counter->var, bound->duplicate()));
+
+	StmtNode * guard = new IfStmtNode(pos, cond->duplicate(), stmts);
+	guard->typeAnalysis(myTypes);
+	myClosed++;
+	if (myRemarks != nullptr){
+		myRemarks->applied("scev", pos, "Replaced the loop by the values"
+			" it leaves in " + names);
+	}
+	return guard;
+}
+
+void ProgramNode::closeLoops(ScalarEvolution * scev){
+	for (auto decl : myGlobals){
+		SemSymbol * sym = decl->getSymbol();
+		if (sym != nullptr && sym->getKind() == VAR){
+			scev->addGlobal(sym);
+		}
+	}
+	for (auto decl : myGlobals){
+		decl->closeLoops(scev);
+	}
+}
+
+StmtNode * FnDeclNode::closeLoops(ScalarEvolution * scev){
+	Effects fnEffects;
+	collectEffects(&fnEffects);
+	scev->enterFn(&fnEffects);
+	scev->close(myBody);
+	return this;
+}
+
+StmtNode * IfStmtNode::closeLoops(ScalarEvolution * scev){
+	scev->close(myBody);
+	return this;
+}
+
+StmtNode * IfElseStmtNode::closeLoops(ScalarEvolution * scev){
+	scev->close(myBodyTrue);
+	scev->close(myBodyFalse);
+	return this;
+}
+
+StmtNode * WhileStmtNode::closeLoops(ScalarEvolution * scev){
+	scev->close(myBody);
+	//A rotated loop is only reached once its condition
+	// holds, so the guard that replaces it tests it again
+	// to no effect
+	return scev->evolve(this, myCond, myBody);
+}
+
+bool PostIncStmtNode::addRecurrence(ScalarEvolution * scev){
+	IDNode * id = myLVal->asID();
+	if (id == nullptr){ return false; }
+	scev->recur(id->getSymbol(), nullptr, 1);
+	return true;
+}
+
+bool PostDecStmtNode::addRecurrence(ScalarEvolution * scev){
+	IDNode * id = myLVal->asID();
+	if (id == nullptr){ return false; }
+	scev->recur(id->getSymbol(), nullptr, -1);
+	return true;
+}
+
+bool AssignStmtNode::addRecurrence(ScalarEvolution * scev){
+	IDNode * dst = myExp->getDst()->asID();
+	if (dst == nullptr){ return false; }
+	return scev->assigned(dst, myExp->getSrc());
+}
+
+}
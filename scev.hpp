@@ -0,0 +1,101 @@
+#ifndef CMINUSMINUS_SCEV
+#define CMINUSMINUS_SCEV
+
+#include <set>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "effects.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+// Replaces loops that only count by the values they leave.
+// A loop qualifies when its condition compares a variable
+// counted up (or down) by one each iteration against a bound
+// the loop doesn't change, and every statement in its body
+// adds to or subtracts from an int variable either an amount
+// the loop doesn't change (an induction variable) or the
+// value of an induction variable (a sum). The number of
+// iterations is the distance from the counter to the bound,
+// and each variable's value on exit follows from it:
+//   x + trips * step     for an induction variable
+//   s + trips * y0 + step * trips * (trips - 1) / 2
+//                        for a sum of an induction variable
+// Ints wrap around, so these are computed modulo 2^32, which
+// is exact for every product. Halving is not, so sums are
+// only replaced where the trip count is known to fit in an
+// int: the counter starts at a known value of at least zero
+// (counting up) or the bound is such a value (counting down).
+class ScalarEvolution{
+public:
+	//How a variable changes on each iteration: by sign *
+	// term, where a term of nullptr stands for one
+	struct Recurrence{
+		SemSymbol * var;
+		const ExpNode * term;
+		long sign;
+	};
+
+	static ScalarEvolution * build(TypeAnalysis * typeAnalysis,
+		Remarks * remarks = nullptr);
+	size_t closed() const { return myClosed; }
+
+	void addGlobal(SemSymbol * sym){ myAliases.addGlobal(sym); }
+	void enterFn(const Effects * fnEffects);
+	//Close the loops of a body, replacing each loop by the
+	// statements that compute what it leaves
+	void close(std::vector<StmtNode *>& body);
+	//The statement that replaces a loop, or the loop itself
+	// if it can't be replaced
+	StmtNode * evolve(WhileStmtNode * loop, const ExpNode * cond,
+		std::vector<StmtNode *>& body);
+	//Note that a variable changes by sign * term on each
+	// iteration (a term of nullptr stands for one)
+	void recur(SemSymbol * var, const ExpNode * term, long sign);
+	//Note an assignment to a variable in a loop body,
+	// returning false if it isn't a recurrence
+	bool assigned(IDNode * dst, const ExpNode * src);
+private:
+	ScalarEvolution(TypeAnalysis * typeAnalysis, Remarks * remarks)
+	: myTypes(typeAnalysis), myRemarks(remarks), myClosed(0){ }
+	static bool pure(const ExpNode * exp);
+	static void usesOf(const ExpNode * exp,
+		std::set<const SemSymbol *> * uses);
+	//The recurrence of a variable in the loop, if it has one
+	const Recurrence * recurrenceOf(const SemSymbol * var) const;
+	//Whether a variable steps by a term that is the same in
+	// every iteration
+	bool induction(const Recurrence& rec) const;
+	//The value a variable is known to hold just before the
+	// loop being closed, from an assignment of a literal
+	bool startValue(WhileStmtNode * loop, SemSymbol * var, long * value);
+	//Whether running a statement may change a variable
+	bool changes(StmtNode * stmt, SemSymbol * var);
+	void missed(WhileStmtNode * loop, const std::string& why);
+	IDNode * use(const Position * pos, SemSymbol * var);
+	ExpNode * times(const Position * pos, ExpNode * lhs,
+		const ExpNode * term);
+	StmtNode * assign(const Position * pos, SemSymbol * var,
+		ExpNode * value);
+	TypeAnalysis * myTypes;
+	Remarks * myRemarks;
+	Aliases myAliases;
+	//The bodies that the loop being closed is in, innermost
+	// last, each with the position of what it is in
+	struct Frame{
+		std::vector<StmtNode *> * body;
+		size_t at;
+	};
+	std::vector<Frame> myFrames;
+	//The recurrences of the loop being closed, in the order
+	// of its statements, and why it can't be closed
+	std::vector<Recurrence> myRecs;
+	std::string myWhy;
+	size_t myClosed;
+};
+
+}
+
+#endif
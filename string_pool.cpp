@@ -0,0 +1,105 @@
+#include "string_pool.hpp"
+
+namespace cminusminus{
+
+std::string& StringPool::blob(){
+	static std::string theBlob;
+	return theBlob;
+}
+
+std::vector<StringPool::Entry>& StringPool::entries(){
+	static std::vector<Entry> theEntries;
+	return theEntries;
+}
+
+std::unordered_map<std::string, size_t>& StringPool::ids(){
+	static std::unordered_map<std::string, size_t> theIDs;
+	return theIDs;
+}
+
+std::vector<size_t>& StringPool::freeIDs(){
+	static std::vector<size_t> theFree;
+	return theFree;
+}
+
+size_t StringPool::internLiteral(const std::string& raw){
+	//The scanner only produces literals whose escapes are
+	// valid, so each backslash is followed by one of n, t, 
+	// " or a backslash
+	std::string contents;
+	contents.reserve(raw.length());
+	for (size_t i = 1; i + 1 < raw.length(); i++){
+		char c = raw[i];
+		if (c == '\\' && i + 2 < raw.length()){
+			i++;
+			switch (raw[i]){
+				case 'n': c = '\n'; break;
+				case 't': c = '\t'; break;
+				default: c = raw[i]; break;
+			}
+		}
+		contents += c;
+	}
+	return intern(contents);
+}
+
+size_t StringPool::intern(const std::string& contents){
+	auto found = ids().find(contents);
+	if (found != ids().end()){ return found->second; }
+
+	Entry entry;
+	entry.offset = blob().length();
+	entry.length = contents.length();
+	entry.released = false;
+	blob() += contents;
+	blob() += '\0';
+
+	size_t id = entries().size();
+	if (freeIDs().empty()){
+		entries().push_back(entry);
+	} else {
+		id = freeIDs().back();
+		freeIDs().pop_back();
+		entries()[id] = entry;
+	}
+	ids()[contents] = id;
+	return id;
+}
+
+void StringPool::release(const std::vector<bool>& live){
+	std::string kept;
+	for (size_t id = 0; id < entries().size(); id++){
+		Entry& entry = entries()[id];
+		if (entry.released){ continue; }
+		if (id < live.size() && !live[id]){
+			ids().erase(contents(id));
+			entry.offset = 0;
+			entry.length = 0;
+			entry.released = true;
+			freeIDs().push_back(id);
+			continue;
+		}
+		size_t offset = kept.length();
+		kept.append(blob(), entry.offset, entry.length + 1);
+		entry.offset = offset;
+	}
+	blob().swap(kept);
+}
+
+void StringPool::unparse(std::ostream& out, size_t id){
+	out << '"';
+	const std::string& chars = blob();
+	size_t end = offset(id) + length(id);
+	for (size_t i = offset(id); i < end; i++){
+		switch (chars[i]){
+			case '\n': out << "\\n"; break;
+			case '\t': out << "\\t"; break;
+			case '"': out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			default: out << chars[i]; break;
+		}
+	}
+	out << '"';
+}
+
+}
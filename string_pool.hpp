@@ -0,0 +1,55 @@
+#ifndef CMINUSMINUS_STRING_POOL
+#define CMINUSMINUS_STRING_POOL
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cminusminus{
+
+// All string literals in the program. The escapes in each
+// literal are decoded once, when it is scanned, and identical
+// contents are stored only once. Every distinct literal gets 
+// a stable id; its characters live in a single read-only data 
+// blob (each followed by a NUL), together with a precomputed 
+// length, so that code generators can emit the whole pool as
+// one data section. A literal nothing uses any longer can be
+// released, which frees its characters and lets its id be
+// given out again.
+class StringPool{
+public:
+	//Decode the escapes in a literal as written in the 
+	// source (quotes included), and add it to the pool
+	static size_t internLiteral(const std::string& raw);
+	//Add already-decoded contents to the pool
+	static size_t intern(const std::string& contents);
+	static size_t length(size_t id){ return entries()[id].length; }
+	static size_t offset(size_t id){ return entries()[id].offset; }
+	static size_t count(){ return entries().size(); }
+	//The decoded contents of a literal
+	static std::string contents(size_t id){
+		return blob().substr(offset(id), length(id));
+	}
+	//Every literal in the pool, each terminated by a NUL
+	static const std::string& data(){ return blob(); }
+	//Output a literal as it would be written in the source
+	static void unparse(std::ostream& out, size_t id);
+	//Release every literal that is not live, moving the
+	// rest together in the blob. Their ids are unchanged
+	static void release(const std::vector<bool>& live);
+private:
+	struct Entry{
+		size_t offset;
+		size_t length;
+		bool released;
+	};
+	static std::string& blob();
+	static std::vector<Entry>& entries();
+	static std::unordered_map<std::string, size_t>& ids();
+	static std::vector<size_t>& freeIDs();
+};
+
+}
+
+#endif
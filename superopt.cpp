@@ -0,0 +1,632 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+#include "superopt.hpp"
+#include "errors.hpp"
+#include "hash_cons.hpp"
+#include "interpreter.hpp"
+
+namespace cminusminus{
+
+//The most binary operators in an expression that is looked up
+static const size_t MAX_OPS = 6;
+//The most nodes in a candidate, and candidates in a search
+static const size_t MAX_CANDIDATE = 7;
+static const size_t MAX_CANDIDATES = 50000;
+//How often a search starts over with a new sample input
+static const size_t MAX_ROUNDS = 16;
+//The most combinations of inputs checked one by one, and
+// the number of random inputs checked after them
+static const size_t EXHAUSTIVE = 1 << 20;
+static const size_t RANDOM = 20000;
+static const size_t SAMPLES = 64;
+
+static const char * const INT_OPS[] = {
+	"+", "-", "*", "==", "!=", "<", "<="
+};
+static const char * const SHORT_OPS[] = {
+	"==", "!=", "<", "<="
+};
+static const char * const BOOL_OPS[] = {
+	"and", "or", "==", "!=", "<", "<="
+};
+
+static char typeCode(const DataType * type){
+	if (type->isInt()){ return 'i'; }
+	if (type->isShort()){ return 's'; }
+	if (type->isBool()){ return 'b'; }
+	return 0;
+}
+
+static bool arithmetic(const std::string& op){
+	return op == "+" || op == "-" || op == "*" || op == "/";
+}
+
+static bool commutes(const std::string& op){
+	return op == "+" || op == "*" || op == "and" || op == "or"
+	  || op == "==" || op == "!=";
+}
+
+static int64_t apply(const std::string& op, int64_t lhs, int64_t rhs){
+	if (op == "+"){ return Interpreter::wrapInt(lhs + rhs); }
+	if (op == "-"){ return Interpreter::wrapInt(lhs - rhs); }
+	if (op == "*"){ return Interpreter::wrapInt(lhs * rhs); }
+	//Only division by a literal other than zero is looked up
+	if (op == "/"){ return rhs == 0 ? 0 : Interpreter::wrapInt(lhs / rhs); }
+	if (op == "and"){ return lhs && rhs; }
+	if (op == "or"){ return lhs || rhs; }
+	if (op == "=="){ return lhs == rhs; }
+	if (op == "!="){ return lhs != rhs; }
+	if (op == "<"){ return lhs < rhs; }
+	if (op == "<="){ return lhs <= rhs; }
+	if (op == ">"){ return lhs > rhs; }
+	if (op == ">="){ return lhs >= rhs; }
+	if (op == "neg"){ return Interpreter::wrapInt(-lhs); }
+	if (op == "!"){ return !lhs; }
+	std::string msg = "Bad superoptimizer operator " + op;
+	throw new InternalError(msg.c_str());
+}
+
+size_t SuperTerm::cost() const{
+	size_t nodes = 1;
+	if (lhs != nullptr){ nodes += lhs->cost(); }
+	if (rhs != nullptr){ nodes += rhs->cost(); }
+	return nodes;
+}
+
+void SuperTerm::write(std::ostream& out) const{
+	if (op == "var"){
+		out << (type == 'i' ? 'x' : type) << num;
+	} else if (op == "int"){
+		out << num;
+	} else if (op == "short"){
+		out << num << "S";
+	} else if (lhs == nullptr){
+		out << op;
+	} else {
+		out << "(" << op << " ";
+		lhs->write(out);
+		if (rhs != nullptr){
+			out << " ";
+			rhs->write(out);
+		}
+		out << ")";
+	}
+}
+
+std::string SuperTerm::text() const{
+	std::stringstream out;
+	write(out);
+	return out.str();
+}
+
+int64_t SuperTerm::eval(const std::vector<int64_t>& vars) const{
+	if (op == "var"){ return vars[static_cast<size_t>(num)]; }
+	if (op == "int" || op == "short"){ return num; }
+	if (op == "true"){ return 1; }
+	if (op == "false"){ return 0; }
+	int64_t left = lhs->eval(vars);
+	return apply(op, left, rhs == nullptr ? 0 : rhs->eval(vars));
+}
+
+RuleDatabase * RuleDatabase::load(const std::string& path, bool search){
+	RuleDatabase * rules = new RuleDatabase(path, search);
+	std::ifstream in(path);
+	std::string line;
+	while (std::getline(in, line)){
+		if (line.empty() || line[0] == '#'){ continue; }
+		size_t arrow = line.find(" => ");
+		if (arrow == std::string::npos){
+			std::string msg = "Bad superoptimizer rule " + line;
+			throw new InternalError(msg.c_str());
+		}
+		rules->myRules[line.substr(0, arrow)] = line.substr(arrow + 4);
+	}
+	return rules;
+}
+
+const std::string * RuleDatabase::lookup(const std::string& pattern) const{
+	auto found = myRules.find(pattern);
+	if (found == myRules.end()){ return nullptr; }
+	return &found->second;
+}
+
+void RuleDatabase::add(const std::string& pattern,
+	const std::string& replacement){
+	myRules[pattern] = replacement;
+	myChanged = true;
+}
+
+void RuleDatabase::save(){
+	if (!myChanged){ return; }
+	std::ofstream out(myPath);
+	if (!out.good()){
+		std::string msg = "Bad output file " + myPath;
+		throw new InternalError(msg.c_str());
+	}
+	out << "# Found by cmmc --superopt-search; a pattern that is its"
+	  << " own replacement has no cheaper form\n";
+	for (auto rule : myRules){
+		out << rule.first << " => " << rule.second << "\n";
+	}
+	myChanged = false;
+}
+
+//A search for the cheapest term equal to a target. Every term
+// enumerated is kept with its values on the sample inputs,
+// and only the first of those with the same values, which
+// is the smallest, is built on.
+class SuperSearch{
+public:
+	SuperSearch(const SuperTerm * target)
+	: myTarget(target), myRandom(1), myFound(nullptr), myRestart(false){
+		gather(target);
+		domains();
+		folds();
+	}
+	std::string run();
+private:
+	struct Candidate{
+		const SuperTerm * term;
+		std::vector<int64_t> values;
+	};
+	void gather(const SuperTerm * term);
+	void domains();
+	//Add what the int literals make together, which folding
+	// would have made of them
+	void folds();
+	std::vector<int64_t> draw(bool uniform);
+	const SuperTerm * make(const std::string& op, char type, long num,
+		const SuperTerm * lhs = nullptr, const SuperTerm * rhs = nullptr);
+	//Enumerate candidates until one is equal to the target,
+	// one that is equal on the samples isn't, or there are
+	// no more
+	bool enumerate();
+	void leaf(const std::string& op, char type, long num);
+	void combine(const std::string& op, size_t size, const Candidate& lhs,
+		const Candidate * rhs);
+	void offer(const SuperTerm * term, size_t size,
+		std::vector<int64_t>& values);
+	//Whether a term is equal to the target on every input
+	// checked, or else the input on which it is not
+	bool verify(const SuperTerm * term, std::vector<int64_t> * wrong);
+	bool differs(const SuperTerm * term, const std::vector<int64_t>& vars){
+		return term->eval(vars) != myTarget->eval(vars);
+	}
+	const SuperTerm * myTarget;
+	std::mt19937 myRandom;
+	std::vector<char> myVarTypes;
+	std::vector<long> myInts;
+	std::vector<long> myShorts;
+	//The values each variable is checked with in combination
+	std::vector<std::vector<int64_t>> myDomains;
+	std::vector<std::vector<int64_t>> mySamples;
+	std::vector<int64_t> myTargetValues;
+	std::deque<SuperTerm> myTerms;
+	std::deque<Candidate> myCandidates;
+	std::vector<std::vector<size_t>> myBySize;
+	std::unordered_set<std::string> mySeen;
+	const SuperTerm * myFound;
+	bool myRestart;
+};
+
+void SuperSearch::gather(const SuperTerm * term){
+	if (term->op == "var"){
+		size_t var = static_cast<size_t>(term->num);
+		if (myVarTypes.size() <= var){ myVarTypes.resize(var + 1, 'i'); }
+		myVarTypes[var] = term->type;
+	} else if (term->op == "int"){
+		myInts.push_back(term->num);
+	} else if (term->op == "short"){
+		myShorts.push_back(term->num);
+	}
+	if (term->lhs != nullptr){ gather(term->lhs); }
+	if (term->rhs != nullptr){ gather(term->rhs); }
+}
+
+void SuperSearch::domains(){
+	size_t shorts = 0;
+	size_t ints = 0;
+	for (auto type : myVarTypes){
+		if (type == 's'){ shorts++; }
+		if (type == 'i'){ ints++; }
+	}
+	std::vector<int64_t> small;
+	for (int64_t value = -8; value <= 8; value++){ small.push_back(value); }
+	for (auto type : myVarTypes){
+		std::vector<int64_t> domain;
+		if (type == 'b'){
+			domain = {0, 1};
+		} else if (type == 's' && shorts == 1 && ints == 0){
+			for (int64_t value = -32768; value <= 32767; value++){
+				domain.push_back(value);
+			}
+		} else if (type == 's'){
+			domain = small;
+			domain.insert(domain.end(), {-32768, -32767, 32766, 32767});
+			for (auto lit : myShorts){
+				domain.insert(domain.end(), {lit - 1, lit, lit + 1});
+			}
+		} else {
+			domain = small;
+			domain.insert(domain.end(), {INT32_MIN, INT32_MIN + 1, -65536,
+				-65535, -32769, -32768, 32767, 32768, 65535, 65536,
+				INT32_MAX - 1, INT32_MAX});
+			for (auto lit : myInts){
+				domain.insert(domain.end(), {Interpreter::wrapInt(lit - 1), lit,
+					Interpreter::wrapInt(lit + 1)});
+			}
+		}
+		myDomains.push_back(domain);
+	}
+}
+
+void SuperSearch::folds(){
+	std::vector<long> lits = myInts;
+	lits.insert(lits.end(), {0, 1});
+	for (auto lhs : myInts){
+		for (auto rhs : myInts){
+			for (auto op : {"+", "-", "*"}){ lits.push_back(apply(op, lhs, rhs)); }
+		}
+	}
+	size_t made = lits.size();
+	for (size_t n = 0; n < made; n++){ lits.push_back(apply("neg", lits[n], 0)); }
+	//Smallest first, and a literal before its negation
+	std::sort(lits.begin(), lits.end(), [](long a, long b){
+		if (std::labs(a) != std::labs(b)){ return std::labs(a) < std::labs(b); }
+		return a > b;
+	});
+	lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+	myInts.swap(lits);
+}
+
+std::vector<int64_t> SuperSearch::draw(bool uniform){
+	std::vector<int64_t> vars;
+	for (size_t var = 0; var < myVarTypes.size(); var++){
+		uint32_t bits = myRandom();
+		if (!uniform){
+			const std::vector<int64_t>& domain = myDomains[var];
+			vars.push_back(domain[bits % domain.size()]);
+		} else if (myVarTypes[var] == 'b'){
+			vars.push_back(bits & 1);
+		} else if (myVarTypes[var] == 's'){
+			vars.push_back(static_cast<int16_t>(bits & 0xffff));
+		} else {
+			vars.push_back(static_cast<int32_t>(bits));
+		}
+	}
+	return vars;
+}
+
+bool SuperSearch::verify(const SuperTerm * term,
+	std::vector<int64_t> * wrong){
+	size_t combinations = 1;
+	for (auto& domain : myDomains){
+		combinations *= domain.size();
+		if (combinations > EXHAUSTIVE){ break; }
+	}
+	if (combinations <= EXHAUSTIVE){
+		//Count through every combination of the domains
+		std::vector<size_t> at(myDomains.size(), 0);
+		std::vector<int64_t> vars(myDomains.size());
+		for (size_t n = 0; n < combinations; n++){
+			for (size_t var = 0; var < vars.size(); var++){
+				vars[var] = myDomains[var][at[var]];
+			}
+			if (differs(term, vars)){
+				*wrong = vars;
+				return false;
+			}
+			for (size_t var = 0; var < at.size(); var++){
+				if (++at[var] < myDomains[var].size()){ break; }
+				at[var] = 0;
+			}
+		}
+	}
+	for (size_t n = 0; n < 2 * RANDOM; n++){
+		std::vector<int64_t> vars = draw(n % 2 == 0);
+		if (differs(term, vars)){
+			*wrong = vars;
+			return false;
+		}
+	}
+	return true;
+}
+
+const SuperTerm * SuperSearch::make(const std::string& op, char type,
+	long num, const SuperTerm * lhs, const SuperTerm * rhs){
+	myTerms.push_back(SuperTerm{op, type, num, lhs, rhs});
+	return &myTerms.back();
+}
+
+void SuperSearch::offer(const SuperTerm * term, size_t size,
+	std::vector<int64_t>& values){
+	std::string key(1, term->type);
+	for (auto value : values){ key += std::to_string(value) + ","; }
+	if (!mySeen.insert(key).second){ return; }
+	if (term->type == myTarget->type && values == myTargetValues){
+		std::vector<int64_t> wrong;
+		if (verify(term, &wrong)){
+			myFound = term;
+		} else {
+			mySamples.push_back(wrong);
+			myRestart = true;
+		}
+		return;
+	}
+	myCandidates.push_back(Candidate{term, std::vector<int64_t>()});
+	myCandidates.back().values.swap(values);
+	myBySize[size].push_back(myCandidates.size() - 1);
+}
+
+void SuperSearch::leaf(const std::string& op, char type, long num){
+	const SuperTerm * term = make(op, type, num);
+	std::vector<int64_t> values;
+	for (auto& vars : mySamples){ values.push_back(term->eval(vars)); }
+	offer(term, 1, values);
+}
+
+void SuperSearch::combine(const std::string& op, size_t size,
+	const Candidate& lhs, const Candidate * rhs){
+	char type = arithmetic(op) || op == "neg" ? 'i' : 'b';
+	const SuperTerm * term = make(op, type, 0, lhs.term,
+		rhs == nullptr ? nullptr : rhs->term);
+	std::vector<int64_t> values;
+	for (size_t n = 0; n < mySamples.size(); n++){
+		values.push_back(apply(op, lhs.values[n],
+			rhs == nullptr ? 0 : rhs->values[n]));
+	}
+	offer(term, size, values);
+}
+
+bool SuperSearch::enumerate(){
+	myTerms.clear();
+	myCandidates.clear();
+	mySeen.clear();
+	myFound = nullptr;
+	myRestart = false;
+	myTargetValues.clear();
+	for (auto& vars : mySamples){
+		myTargetValues.push_back(myTarget->eval(vars));
+	}
+	size_t most = std::min(myTarget->cost() - 1, MAX_CANDIDATE);
+	myBySize.assign(most + 1, std::vector<size_t>());
+	for (size_t size = 1; size <= most; size++){
+		if (size == 1){
+			for (size_t var = 0; var < myVarTypes.size(); var++){
+				leaf("var", myVarTypes[var], static_cast<long>(var));
+			}
+			for (auto lit : myInts){ leaf("int", 'i', lit); }
+			for (auto lit : myShorts){ leaf("short", 's', lit); }
+			leaf("true", 'b', 0);
+			leaf("false", 'b', 0);
+			if (myFound != nullptr || myRestart){ return true; }
+			continue;
+		}
+		for (auto operand : myBySize[size - 1]){
+			const Candidate& exp = myCandidates[operand];
+			combine(exp.term->type == 'i' ? "neg" : "!", size, exp, nullptr);
+			if (myFound != nullptr || myRestart){ return true; }
+		}
+		for (size_t left = 1; left + 1 < size; left++){
+			size_t right = size - 1 - left;
+			for (auto lhsAt : myBySize[left]){
+				for (auto rhsAt : myBySize[right]){
+					const Candidate& lhs = myCandidates[lhsAt];
+					const Candidate& rhs = myCandidates[rhsAt];
+					char type = lhs.term->type;
+					if (type != rhs.term->type){ continue; }
+					std::vector<std::string> ops;
+					if (type == 'i'){
+						ops.assign(std::begin(INT_OPS), std::end(INT_OPS));
+					} else if (type == 's'){
+						ops.assign(std::begin(SHORT_OPS), std::end(SHORT_OPS));
+					} else {
+						ops.assign(std::begin(BOOL_OPS), std::end(BOOL_OPS));
+					}
+					for (auto& op : ops){
+						//One order of the operands of an operator that
+						// commutes is enough
+						if (commutes(op) && (left > right
+						  || (left == right && lhsAt > rhsAt))){
+							continue;
+						}
+						combine(op, size, lhs, &rhs);
+						if (myFound != nullptr || myRestart){ return true; }
+					}
+					if (myCandidates.size() > MAX_CANDIDATES){ return false; }
+				}
+			}
+		}
+	}
+	return false;
+}
+
+std::string SuperSearch::run(){
+	std::vector<int64_t> zeros(myVarTypes.size(), 0);
+	mySamples.push_back(zeros);
+	for (size_t n = 1; n < SAMPLES; n++){ mySamples.push_back(draw(n % 2 == 0)); }
+	for (size_t round = 0; round < MAX_ROUNDS; round++){
+		if (!enumerate()){ break; }
+		if (myFound != nullptr){ return myFound->text(); }
+	}
+	return myTarget->text();
+}
+
+Superoptimizer * Superoptimizer::build(TypeAnalysis * typeAnalysis,
+	RuleDatabase * rules, Remarks * remarks){
+	Superoptimizer * so = new Superoptimizer(typeAnalysis, rules, remarks);
+	typeAnalysis->ast->rewriteExps(so);
+	return so;
+}
+
+const SuperTerm * Superoptimizer::make(const std::string& op, char type,
+	long num, const SuperTerm * lhs, const SuperTerm * rhs){
+	myTerms.push_back(SuperTerm{op, type, num, lhs, rhs});
+	return &myTerms.back();
+}
+
+const SuperTerm * Superoptimizer::abstract(const ExpNode * exp,
+	size_t * ops){
+	ConsKey key;
+	if (!exp->consKey(&key)){ return nullptr; }
+	char type = typeCode(myTypes->nodeType(exp));
+	if (type == 0){ return nullptr; }
+	if (key.op == "id"){
+		size_t var = 0;
+		while (var < myVars.size()){
+			ConsKey seen;
+			myVars[var]->consKey(&seen);
+			if (seen.sym == key.sym){ break; }
+			var++;
+		}
+		if (var == myVars.size()){ myVars.push_back(exp); }
+		return make("var", type, static_cast<long>(var));
+	}
+	if (key.op == "int" || key.op == "short" || key.op == "true"
+	  || key.op == "false"){
+		return make(key.op, type, key.num);
+	}
+	if (key.lhs == nullptr){ return nullptr; }
+	const SuperTerm * lhs = abstract(key.lhs, ops);
+	if (lhs == nullptr){ return nullptr; }
+	if (key.rhs == nullptr){ return make(key.op, type, 0, lhs); }
+
+	//Candidates never divide, so that none can fail where the
+	// expression does not
+	if (key.op == "/"){
+		ConsKey divisor;
+		if (!key.rhs->consKey(&divisor) || divisor.op != "int"
+		  || divisor.num == 0){
+			return nullptr;
+		}
+	}
+	if (++*ops > MAX_OPS){ return nullptr; }
+	const SuperTerm * rhs = abstract(key.rhs, ops);
+	if (rhs == nullptr){ return nullptr; }
+	return make(key.op, type, 0, lhs, rhs);
+}
+
+const SuperTerm * Superoptimizer::parse(const std::string& text,
+	size_t * at){
+	std::string msg = "Bad superoptimizer rule " + text;
+	while (*at < text.size() && text[*at] == ' '){ (*at)++; }
+	if (*at >= text.size()){ throw new InternalError(msg.c_str()); }
+	bool applied = text[*at] == '(';
+	if (applied){ (*at)++; }
+	size_t end = text.find_first_of(" ()", *at);
+	if (end == std::string::npos){ end = text.size(); }
+	std::string word = text.substr(*at, end - *at);
+	*at = end;
+	if (word.empty()){ throw new InternalError(msg.c_str()); }
+
+	if (applied){
+		const SuperTerm * lhs = parse(text, at);
+		const SuperTerm * rhs = nullptr;
+		if (word != "neg" && word != "!"){ rhs = parse(text, at); }
+		if (*at >= text.size() || text[*at] != ')'){
+			throw new InternalError(msg.c_str());
+		}
+		(*at)++;
+		char type = arithmetic(word) || word == "neg" ? 'i' : 'b';
+		return make(word, type, 0, lhs, rhs);
+	}
+	if (word == "true" || word == "false"){ return make(word, 'b', 0); }
+	char first = word[0];
+	if (first == 'x' || first == 's' || first == 'b'){
+		char type = first == 'x' ? 'i' : first;
+		return make("var", type, std::stol(word.substr(1)));
+	}
+	if (word.back() == 'S'){
+		return make("short", 's', std::stol(word));
+	}
+	return make("int", 'i', std::stol(word));
+}
+
+ExpNode * Superoptimizer::instantiate(const SuperTerm * term,
+	const Position * pos){
+	if (term->op == "var"){
+		size_t var = static_cast<size_t>(term->num);
+		if (var >= myVars.size()
+		  || typeCode(myTypes->nodeType(myVars[var])) != term->type){
+			std::string msg = "Bad superoptimizer rule for "
+			  + term->text();
+			throw new InternalError(msg.c_str());
+		}
+		return myVars[var]->duplicate();
+	}
+	const std::string& op = term->op;
+	int num = static_cast<int>(term->num);
+	if (op == "int"){ return new IntLitNode(pos, num); }
+	if (op == "short"){ return new ShortLitNode(pos, num); }
+	if (op == "true"){ return new TrueNode(pos); }
+	if (op == "false"){ return new FalseNode(pos); }
+	ExpNode * lhs = instantiate(term->lhs, pos);
+	if (op == "neg"){ return new NegNode(pos, lhs); }
+	if (op == "!"){ return new NotNode(pos, lhs); }
+	ExpNode * rhs = instantiate(term->rhs, pos);
+	if (op == "+"){ return new PlusNode(pos, lhs, rhs); }
+	if (op == "-"){ return new MinusNode(pos, lhs, rhs); }
+	if (op == "*"){ return new TimesNode(pos, lhs, rhs); }
+	if (op == "/"){ return new DivideNode(pos, lhs, rhs); }
+	if (op == "and"){ return new AndNode(pos, lhs, rhs); }
+	if (op == "or"){ return new OrNode(pos, lhs, rhs); }
+	if (op == "=="){ return new EqualsNode(pos, lhs, rhs); }
+	if (op == "!="){ return new NotEqualsNode(pos, lhs, rhs); }
+	if (op == "<"){ return new LessNode(pos, lhs, rhs); }
+	if (op == "<="){ return new LessEqNode(pos, lhs, rhs); }
+	if (op == ">"){ return new GreaterNode(pos, lhs, rhs); }
+	if (op == ">="){ return new GreaterEqNode(pos, lhs, rhs); }
+	std::string msg = "Bad superoptimizer operator " + op;
+	throw new InternalError(msg.c_str());
+}
+
+ExpNode * Superoptimizer::rewrite(ExpNode * exp){
+	ConsKey key;
+	if (!exp->consKey(&key) || key.lhs == nullptr){ return exp; }
+	myTerms.clear();
+	myVars.clear();
+	size_t ops = 0;
+	const SuperTerm * target = abstract(exp, &ops);
+	if (target == nullptr){ return exp; }
+
+	std::string pattern = target->text();
+	const std::string * found = myRules->lookup(pattern);
+	std::string replacement;
+	if (found != nullptr){
+		replacement = *found;
+	} else if (myRules->searching()){
+		SuperSearch search(target);
+		replacement = search.run();
+		myRules->add(pattern, replacement);
+		mySearched++;
+	}
+	if (replacement.empty() || replacement == pattern){ return exp; }
+
+	size_t at = 0;
+	const SuperTerm * better = parse(replacement, &at);
+	if (better->cost() >= target->cost() || better->type != target->type){
+		std::string msg = "Bad superoptimizer rule " + pattern;
+		throw new InternalError(msg.c_str());
+	}
+	ExpNode * result = instantiate(better, exp->pos());
+	result->typeAnalysis(myTypes);
+	myReplaced++;
+	if (myRemarks != nullptr){
+		std::stringstream before;
+		exp->unparse(before, 0);
+		std::stringstream after;
+		result->unparse(after, 0);
+		size_t saved = target->cost() - better->cost();
+		myRemarks->applied("superopt", exp->pos(), "Replaced "
+			+ before.str() + " by " + after.str() + ", "
+			+ std::to_string(saved) + (saved == 1 ? " node" : " nodes")
+			+ " fewer");
+	}
+	return result;
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef CMINUSMINUS_SUPEROPT
+#define CMINUSMINUS_SUPEROPT
+
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "remarks.hpp"
+#include "type_analysis.hpp"
+
+namespace cminusminus{
+
+//A pure expression as the superoptimizer sees it. Variables
+// are numbered in the order they first appear, so that
+// expressions which differ only in the variables they read
+// are the same pattern. Written out, a term is an operator
+// applied to its operands, (+ x0 (neg x1)), where x, s and b
+// stand for int, short and bool variables
+class SuperTerm{
+public:
+	//"var", "int", "short", "true", "false" or an operator
+	std::string op;
+	//'i', 's' or 'b', for int, short and bool
+	char type;
+	//The number of a variable or the value of a literal
+	long num;
+	const SuperTerm * lhs;
+	const SuperTerm * rhs;
+	//The cost of evaluating the term, one step per node
+	size_t cost() const;
+	void write(std::ostream& out) const;
+	std::string text() const;
+	//The value of the term, given a value for each variable
+	int64_t eval(const std::vector<int64_t>& vars) const;
+};
+
+//The rewrites that searching has found, kept in a file with a
+// line "pattern => replacement" per rule. A pattern with no
+// cheaper form is kept as a rule that replaces it by itself,
+// so that it is not searched for again. Only a database that
+// searches looks for rules it doesn't have, so that other
+// compiles only look rules up.
+class RuleDatabase{
+public:
+	//The rules in a file, which need not exist yet
+	static RuleDatabase * load(const std::string& path, bool search);
+	bool searching() const { return mySearch; }
+	const std::string * lookup(const std::string& pattern) const;
+	void add(const std::string& pattern, const std::string& replacement);
+	size_t size() const { return myRules.size(); }
+	//Write the rules back to the file, if any were added
+	void save();
+private:
+	RuleDatabase(const std::string& path, bool search)
+	: myPath(path), mySearch(search), myChanged(false){ }
+	std::string myPath;
+	bool mySearch;
+	bool myChanged;
+	std::map<std::string, std::string> myRules;
+};
+
+// Replaces pure int and bool expressions of up to six binary
+// operators by the cheapest equivalent expression, where
+// each node costs one step to evaluate. Each expression is
+// looked up in the rule database. One that isn't there is,
+// if the database searches, found by enumerating every
+// expression smaller than it over the same variables, the
+// literals it uses, their sums, differences and products,
+// zero, one and the negations of them all, smallest first.
+// Those that give the same values as it on a set of sample
+// inputs are then checked against it on many more: every
+// combination of bools, every short (for a lone short), and
+// for ints every combination of small and boundary values as
+// well as random ones, all computed wrapping around as the
+// interpreter does. An input on which a candidate differs is
+// added to the samples and the search started over. Ints are
+// too many to try them all, so for them the check is a test,
+// not a proof.
+class Superoptimizer : public ExpRewriter{
+public:
+	static Superoptimizer * build(TypeAnalysis * typeAnalysis,
+		RuleDatabase * rules, Remarks * remarks = nullptr);
+	ExpNode * rewrite(ExpNode * exp) override;
+	size_t replaced() const { return myReplaced; }
+	size_t searched() const { return mySearched; }
+private:
+	Superoptimizer(TypeAnalysis * typeAnalysis, RuleDatabase * rules,
+		Remarks * remarks)
+	: myTypes(typeAnalysis), myRules(rules), myRemarks(remarks),
+	  myReplaced(0), mySearched(0){ }
+	const SuperTerm * make(const std::string& op, char type, long num,
+		const SuperTerm * lhs = nullptr, const SuperTerm * rhs = nullptr);
+	//The term of an expression, or nullptr if it isn't one
+	// the superoptimizer handles
+	const SuperTerm * abstract(const ExpNode * exp, size_t * ops);
+	//The term written out in a rule
+	const SuperTerm * parse(const std::string& text, size_t * at);
+	ExpNode * instantiate(const SuperTerm * term, const Position * pos);
+	TypeAnalysis * myTypes;
+	RuleDatabase * myRules;
+	Remarks * myRemarks;
+	std::deque<SuperTerm> myTerms;
+	//The variables of the expression being rewritten, by number
+	std::vector<const ExpNode *> myVars;
+	size_t myReplaced;
+	size_t mySearched;
+};
+
+}
+
+#endif
@@ -4,6 +4,16 @@ namespace cminusminus{
 
 SymbolTable::SymbolTable(){
 	scopeTableChain = new std::list<ScopeTable *>();
+	loopDepth = 0;
+	fusedTypes = nullptr;
+	importModules = nullptr;
+}
+
+SymbolTable::~SymbolTable(){
+	for (auto scope : *scopeTableChain){
+		delete scope;
+	}
+	delete scopeTableChain;
 }
 
 void SymbolTable::print(){
@@ -24,6 +34,7 @@ void SymbolTable::leaveScope(){
 		throw new InternalError("Attempt to pop"
 			"empty symbol table");
 	}
+	delete scopeTableChain->front();
 	scopeTableChain->pop_front();
 }
 
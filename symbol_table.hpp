@@ -16,6 +16,10 @@ using namespace std;
 
 namespace cminusminus{
 
+class ExpNode;
+class Modules;
+class TypeAnalysis;
+
 enum SymbolKind {
 	VAR, FN, RECORD
 };
@@ -28,6 +32,7 @@ class SemSymbol {
 public:
 	SemSymbol(std::string nameIn, const DataType * typeIn) 
 	: myName(nameIn), myType(typeIn){ }
+	virtual ~SemSymbol(){ }
 	virtual std::string toString();
 	std::string getName() const { return myName; }
 	virtual SymbolKind getKind() const = 0;
@@ -35,6 +40,9 @@ public:
 	virtual const DataType * getDataType() const{
 		return myType;
 	}
+	//The literal value of a constant, or nullptr 
+	// if the symbol may change at runtime
+	virtual ExpNode * getConstant() const { return nullptr; }
 	static std::string kindToString(SymbolKind symKind) { 
 		switch(symKind){
 			case VAR: return "var";
@@ -51,8 +59,12 @@ private:
 class VarSymbol : public SemSymbol {
 public:
 	VarSymbol(std::string name, const DataType * type) 
-	: SemSymbol(name, type) { }
+	: SemSymbol(name, type), myConstant(nullptr) { }
 	virtual SymbolKind getKind() const override { return VAR; } 
+	ExpNode * getConstant() const override { return myConstant; }
+	void setConstant(ExpNode * value){ myConstant = value; }
+private:
+	ExpNode * myConstant;
 };
 
 class FnSymbol : public SemSymbol{
@@ -63,6 +75,19 @@ public:
 	SymbolKind getKind(){ return FN; } 
 };
 
+//The symbol for a record's name (as opposed to a variable
+// of record type, which is a VarSymbol). The fields themselves
+// are VarSymbols held by the RecordType.
+class RecordSymbol : public SemSymbol{
+public:
+	RecordSymbol(std::string name, RecordType * recType)
+	: SemSymbol(name, recType), myRecType(recType){ }
+	virtual SymbolKind getKind() const override { return RECORD; }
+	RecordType * getRecordType() const { return myRecType; }
+private:
+	RecordType * myRecType;
+};
+
 //A single scope. The symbol table is broken down into a 
 // chain of scope tables, and each scope table holds 
 // semantic symbols for a single scope. For example,
@@ -72,6 +97,8 @@ public:
 class ScopeTable {
 	public:
 		ScopeTable();
+		//The symbols themselves are not owned by the scope
+		~ScopeTable(){ delete symbols; }
 		SemSymbol * lookup(std::string name);
 		bool insert(SemSymbol * symbol);
 		bool clash(std::string name);
@@ -89,6 +116,7 @@ class ScopeTable {
 class SymbolTable{
 	public:
 		SymbolTable();
+		~SymbolTable();
 		ScopeTable * enterScope();
 		void leaveScope();
 		ScopeTable * getCurrentScope();
@@ -102,8 +130,30 @@ class SymbolTable{
 			getCurrentScope()->addFn(name, type);
 		}
 		void print();
+		//Track how deeply loops are nested at the current
+		// point of the analysis, which is used to weight 
+		// record field accesses
+		void enterLoop(){ loopDepth++; }
+		void leaveLoop(){ loopDepth--; }
+		size_t getLoopDepth() const { return loopDepth; }
+		//The type analysis to run alongside name analysis, 
+		// if the two are fused (see TypeAnalysis::buildFused)
+		void fuseTypes(TypeAnalysis * ta){ fusedTypes = ta; }
+		TypeAnalysis * getFusedTypes() const { return fusedTypes; }
+		//Where imports are loaded from, and the path of the
+		// file being analyzed, which imports are relative to
+		void importFrom(Modules * modules, const std::string& file){
+			importModules = modules;
+			importer = file;
+		}
+		Modules * getModules() const { return importModules; }
+		const std::string& getImporter() const { return importer; }
 	private:
 		std::list<ScopeTable *> * scopeTableChain;
+		size_t loopDepth;
+		TypeAnalysis * fusedTypes;
+		Modules * importModules;
+		std::string importer;
 };
 
 	
@@ -0,0 +1,907 @@
+#include "tiers.hpp"
+#include "ast.hpp"
+#include "errors.hpp"
+#include "hash_cons.hpp"
+#include "types.hpp"
+
+namespace cminusminus{
+
+typedef Interpreter::Cell Cell;
+
+size_t ExpCode::locate(Interpreter * interp){
+	throw new InternalError("Compiled code for a value has no location");
+}
+
+static bool isScalar(const DataType * type){
+	return type->asArray() == nullptr && type->asRecord() == nullptr;
+}
+
+//How a scalar of a type wraps around: 's' for short, 'b' for
+// bool and 'i' for anything else, as Interpreter::wrap does
+static char wrapKind(const DataType * type){
+	if (type->isShort()){ return 's'; }
+	if (type->isBool()){ return 'b'; }
+	return 'i';
+}
+
+static Cell wrapAs(char kind, Cell value){
+	if (kind == 's'){
+		return static_cast<int16_t>(static_cast<uint16_t>(value));
+	}
+	if (kind == 'b'){ return value != 0; }
+	return Interpreter::wrapInt(value);
+}
+
+//The variable an expression reads, if it only reads one
+static SemSymbol * plainVar(ExpNode * exp){
+	IDNode * id = exp->asID();
+	if (id == nullptr || id->getSymbol() == nullptr){ return nullptr; }
+	SemSymbol * sym = id->getSymbol();
+	if (sym->getKind() != VAR || sym->getConstant() != nullptr){
+		return nullptr;
+	}
+	return sym;
+}
+
+static bool literal(const ExpNode * exp, Cell * value){
+	ConsKey key;
+	if (!exp->consKey(&key)){ return false; }
+	if (key.op == "int" || key.op == "short"){
+		*value = key.num;
+		return true;
+	}
+	if (key.op == "true" || key.op == "false"){
+		*value = key.op == "true";
+		return true;
+	}
+	return false;
+}
+
+//A node run as the AST runs it
+class ExpFallback : public ExpCode{
+public:
+	explicit ExpFallback(ExpNode * exp) : myExp(exp){ }
+	Cell eval(Interpreter * interp) override { return myExp->eval(interp); }
+	size_t locate(Interpreter * interp) override {
+		return interp->whole(myExp);
+	}
+private:
+	ExpNode * myExp;
+};
+
+class StmtFallback : public StmtCode{
+public:
+	explicit StmtFallback(StmtNode * stmt) : myStmt(stmt){ }
+	bool exec(Interpreter * interp) override { return myStmt->exec(interp); }
+private:
+	StmtNode * myStmt;
+};
+
+//A variable, whose place is looked up when it is first used
+// and kept from then on
+class VarCode : public ExpCode{
+public:
+	explicit VarCode(SemSymbol * var) : myVar(var), mySlot(nullptr){ }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		return interp->load(locate(interp));
+	}
+	size_t locate(Interpreter * interp) override {
+		if (mySlot == nullptr){
+			mySlot = interp->slot(myVar);
+			if (mySlot == nullptr){ return interp->address(myVar); }
+		}
+		return mySlot->global ? mySlot->offset : interp->frame() + mySlot->offset;
+	}
+private:
+	SemSymbol * myVar;
+	const Interpreter::Slot * mySlot;
+};
+
+class ConstCode : public ExpCode{
+public:
+	explicit ConstCode(ExpCode * value) : myValue(value){ }
+	~ConstCode(){ delete myValue; }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		return myValue->eval(interp);
+	}
+private:
+	ExpCode * myValue;
+};
+
+class LitCode : public ExpCode{
+public:
+	explicit LitCode(Cell value) : myValue(value){ }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		return myValue;
+	}
+private:
+	Cell myValue;
+};
+
+class StrCode : public ExpCode{
+public:
+	explicit StrCode(size_t strID) : myStrID(strID){ }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		return interp->string(myStrID);
+	}
+private:
+	size_t myStrID;
+};
+
+class DerefCode : public ExpCode{
+public:
+	DerefCode(ExpCode * ptr, const Position * pos) : myPtr(ptr), myPos(pos){ }
+	~DerefCode(){ delete myPtr; }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		return interp->load(locate(interp));
+	}
+	size_t locate(Interpreter * interp) override {
+		return interp->deref(myPtr->eval(interp), myPos);
+	}
+private:
+	ExpCode * myPtr;
+	const Position * myPos;
+};
+
+class FieldCode : public ExpCode{
+public:
+	FieldCode(ExpCode * base, const RecordType * record, SemSymbol * field)
+	: myBase(base), myRecord(record), myField(field), myKnown(false),
+	  myOffset(0){ }
+	~FieldCode(){ delete myBase; }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		return interp->load(locate(interp));
+	}
+	size_t locate(Interpreter * interp) override {
+		size_t base = myBase->locate(interp);
+		if (!myKnown){
+			myOffset = interp->fieldOffset(myRecord, myField);
+			myKnown = true;
+		}
+		return base + myOffset;
+	}
+private:
+	ExpCode * myBase;
+	const RecordType * myRecord;
+	SemSymbol * myField;
+	bool myKnown;
+	size_t myOffset;
+};
+
+class IndexCode : public ExpCode{
+public:
+	IndexCode(ExpCode * base, ExpCode * index, const ArrayType * array,
+		bool checked, const Position * pos)
+	: myBase(base), myIndex(index), myArray(array), myChecked(checked),
+	  myPos(pos), myElemCells(0){ }
+	~IndexCode(){
+		delete myBase;
+		delete myIndex;
+	}
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		return interp->load(locate(interp));
+	}
+	size_t locate(Interpreter * interp) override {
+		size_t base = myBase->locate(interp);
+		Cell index = myIndex->eval(interp);
+		if (myChecked && (index < 0
+		    || static_cast<size_t>(index) >= myArray->getLength())){
+			interp->fail(myPos, "Array index out of bounds");
+		}
+		if (myElemCells == 0){ myElemCells = interp->cells(myArray->getElem()); }
+		return base + static_cast<size_t>(index) * myElemCells;
+	}
+private:
+	ExpCode * myBase;
+	ExpCode * myIndex;
+	const ArrayType * myArray;
+	bool myChecked;
+	const Position * myPos;
+	size_t myElemCells;
+};
+
+class CallCode : public ExpCode{
+public:
+	//Each actual is scalar, with a null type, or copied whole
+	// from a value of the type given
+	CallCode(SemSymbol * fn, std::vector<ExpCode *> args,
+		std::vector<const DataType *> wholes, const Position * pos)
+	: myFn(fn), myArgs(std::move(args)), myWholes(std::move(wholes)),
+	  myPos(pos){ }
+	~CallCode(){
+		for (auto arg : myArgs){ delete arg; }
+	}
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		FnDeclNode * decl = interp->callee(myFn, myPos);
+		size_t argsAt = interp->pendingArgs();
+		for (size_t i = 0; i < myArgs.size(); i++){
+			if (myWholes[i] == nullptr){
+				interp->pushArg(myArgs[i]->eval(interp));
+				continue;
+			}
+			size_t size = interp->cells(myWholes[i]);
+			size_t src = myArgs[i]->locate(interp);
+			for (size_t k = 0; k < size; k++){ interp->pushArg(interp->load(src + k)); }
+		}
+		return interp->enter(decl, argsAt);
+	}
+private:
+	SemSymbol * myFn;
+	std::vector<ExpCode *> myArgs;
+	std::vector<const DataType *> myWholes;
+	const Position * myPos;
+};
+
+struct AddOp{
+	static Cell apply(Cell lhs, Cell rhs){
+		return Interpreter::wrapInt(lhs + rhs);
+	}
+};
+struct SubOp{
+	static Cell apply(Cell lhs, Cell rhs){
+		return Interpreter::wrapInt(lhs - rhs);
+	}
+};
+struct MulOp{
+	static Cell apply(Cell lhs, Cell rhs){
+		return Interpreter::wrapInt(lhs * rhs);
+	}
+};
+struct EqOp{ static Cell apply(Cell lhs, Cell rhs){ return lhs == rhs; } };
+struct NeOp{ static Cell apply(Cell lhs, Cell rhs){ return lhs != rhs; } };
+struct LtOp{ static Cell apply(Cell lhs, Cell rhs){ return lhs < rhs; } };
+struct LeOp{ static Cell apply(Cell lhs, Cell rhs){ return lhs <= rhs; } };
+struct GtOp{ static Cell apply(Cell lhs, Cell rhs){ return lhs > rhs; } };
+struct GeOp{ static Cell apply(Cell lhs, Cell rhs){ return lhs >= rhs; } };
+
+template <typename Op>
+class BinaryCode : public ExpCode{
+public:
+	BinaryCode(ExpCode * lhs, ExpCode * rhs) : myLhs(lhs), myRhs(rhs){ }
+	~BinaryCode(){
+		delete myLhs;
+		delete myRhs;
+	}
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		Cell lhs = myLhs->eval(interp);
+		return Op::apply(lhs, myRhs->eval(interp));
+	}
+private:
+	ExpCode * myLhs;
+	ExpCode * myRhs;
+};
+
+//An operator on a variable and a literal, or on two
+// variables, which is most of what loops test and count
+// with, run as one piece of code
+template <typename Op>
+class VarLitCode : public ExpCode{
+public:
+	VarLitCode(SemSymbol * var, Cell lit) : myVar(var), myLit(lit){ }
+	Cell eval(Interpreter * interp) override {
+		interp->steps(3);
+		return Op::apply(interp->load(myVar.locate(interp)), myLit);
+	}
+private:
+	VarCode myVar;
+	Cell myLit;
+};
+
+template <typename Op>
+class VarVarCode : public ExpCode{
+public:
+	VarVarCode(SemSymbol * lhs, SemSymbol * rhs) : myLhs(lhs), myRhs(rhs){ }
+	Cell eval(Interpreter * interp) override {
+		interp->steps(3);
+		Cell lhs = interp->load(myLhs.locate(interp));
+		return Op::apply(lhs, interp->load(myRhs.locate(interp)));
+	}
+private:
+	VarCode myLhs;
+	VarCode myRhs;
+};
+
+template <typename Op>
+static ExpCode * operands(Compiler * comp, ExpNode * lhs, ExpNode * rhs){
+	SemSymbol * lhsVar = plainVar(lhs);
+	if (lhsVar != nullptr){
+		SemSymbol * rhsVar = plainVar(rhs);
+		if (rhsVar != nullptr){ return new VarVarCode<Op>(lhsVar, rhsVar); }
+		Cell lit;
+		if (literal(rhs, &lit)){ return new VarLitCode<Op>(lhsVar, lit); }
+	}
+	return new BinaryCode<Op>(comp->exp(lhs), comp->exp(rhs));
+}
+
+class DivCode : public ExpCode{
+public:
+	DivCode(ExpCode * lhs, ExpCode * rhs, const Position * pos)
+	: myLhs(lhs), myRhs(rhs), myPos(pos){ }
+	~DivCode(){
+		delete myLhs;
+		delete myRhs;
+	}
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		Cell lhs = myLhs->eval(interp);
+		Cell rhs = myRhs->eval(interp);
+		if (rhs == 0){ interp->fail(myPos, "Division by zero"); }
+		return Interpreter::wrapInt(lhs / rhs);
+	}
+private:
+	ExpCode * myLhs;
+	ExpCode * myRhs;
+	const Position * myPos;
+};
+
+class AndCode : public ExpCode{
+public:
+	AndCode(ExpCode * lhs, ExpCode * rhs, bool isAnd)
+	: myLhs(lhs), myRhs(rhs), myAnd(isAnd){ }
+	~AndCode(){
+		delete myLhs;
+		delete myRhs;
+	}
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		if (myAnd){ return myLhs->eval(interp) && myRhs->eval(interp); }
+		return myLhs->eval(interp) || myRhs->eval(interp);
+	}
+private:
+	ExpCode * myLhs;
+	ExpCode * myRhs;
+	bool myAnd;
+};
+
+class RefCode : public ExpCode{
+public:
+	explicit RefCode(ExpCode * var) : myVar(var){ }
+	~RefCode(){ delete myVar; }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		return static_cast<Cell>(myVar->locate(interp));
+	}
+private:
+	ExpCode * myVar;
+};
+
+class UnaryCode : public ExpCode{
+public:
+	UnaryCode(ExpCode * exp, bool isNeg) : myExp(exp), myNeg(isNeg){ }
+	~UnaryCode(){ delete myExp; }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		if (myNeg){ return Interpreter::wrapInt(-myExp->eval(interp)); }
+		return !myExp->eval(interp);
+	}
+private:
+	ExpCode * myExp;
+	bool myNeg;
+};
+
+class AssignCode : public ExpCode{
+public:
+	AssignCode(ExpCode * dst, ExpCode * src) : myDst(dst), mySrc(src){ }
+	~AssignCode(){
+		delete myDst;
+		delete mySrc;
+	}
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		Cell value = mySrc->eval(interp);
+		interp->store(myDst->locate(interp), value);
+		return value;
+	}
+private:
+	ExpCode * myDst;
+	ExpCode * mySrc;
+};
+
+class AssignVarCode : public ExpCode{
+public:
+	AssignVarCode(SemSymbol * dst, ExpCode * src) : myDst(dst), mySrc(src){ }
+	~AssignVarCode(){ delete mySrc; }
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		Cell value = mySrc->eval(interp);
+		interp->store(myDst.locate(interp), value);
+		return value;
+	}
+private:
+	VarCode myDst;
+	ExpCode * mySrc;
+};
+
+//An assignment of a whole record or array
+class CopyCode : public ExpCode{
+public:
+	CopyCode(ExpCode * dst, ExpCode * src, const DataType * type)
+	: myDst(dst), mySrc(src), myType(type){ }
+	~CopyCode(){
+		delete myDst;
+		delete mySrc;
+	}
+	Cell eval(Interpreter * interp) override {
+		interp->step();
+		size_t size = interp->cells(myType);
+		size_t src = mySrc->locate(interp);
+		interp->copy(myDst->locate(interp), src, size);
+		return 0;
+	}
+private:
+	ExpCode * myDst;
+	ExpCode * mySrc;
+	const DataType * myType;
+};
+
+class BodyCode : public StmtCode{
+public:
+	explicit BodyCode(std::vector<StmtCode *> stmts)
+	: myStmts(std::move(stmts)){ }
+	~BodyCode(){
+		for (auto stmt : myStmts){ delete stmt; }
+	}
+	bool exec(Interpreter * interp) override {
+		for (auto stmt : myStmts){
+			if (stmt->exec(interp)){ return true; }
+		}
+		return false;
+	}
+private:
+	std::vector<StmtCode *> myStmts;
+};
+
+class DeclareCode : public StmtCode{
+public:
+	explicit DeclareCode(SemSymbol * var) : myVar(var){ }
+	bool exec(Interpreter * interp) override {
+		interp->step();
+		interp->declare(myVar);
+		return false;
+	}
+private:
+	SemSymbol * myVar;
+};
+
+//A statement that evaluates an expression for what it does
+class ExpStmtCode : public StmtCode{
+public:
+	explicit ExpStmtCode(ExpCode * exp) : myExp(exp){ }
+	~ExpStmtCode(){ delete myExp; }
+	bool exec(Interpreter * interp) override {
+		interp->step();
+		myExp->eval(interp);
+		return false;
+	}
+private:
+	ExpCode * myExp;
+};
+
+class ReadCode : public StmtCode{
+public:
+	ReadCode(ExpCode * dst, const DataType * type) : myDst(dst), myType(type){ }
+	~ReadCode(){ delete myDst; }
+	bool exec(Interpreter * interp) override {
+		interp->step();
+		size_t addr = myDst->locate(interp);
+		interp->store(addr, interp->read(myType));
+		return false;
+	}
+private:
+	ExpCode * myDst;
+	const DataType * myType;
+};
+
+class WriteCode : public StmtCode{
+public:
+	WriteCode(ExpCode * src, ExpNode * node) : mySrc(src), myNode(node){ }
+	~WriteCode(){ delete mySrc; }
+	bool exec(Interpreter * interp) override {
+		interp->step();
+		interp->write(myNode, mySrc->eval(interp));
+		return false;
+	}
+private:
+	ExpCode * mySrc;
+	ExpNode * myNode;
+};
+
+//An increment or decrement
+class StepCode : public StmtCode{
+public:
+	StepCode(ExpCode * loc, char kind, Cell delta)
+	: myLoc(loc), myKind(kind), myDelta(delta){ }
+	~StepCode(){ delete myLoc; }
+	bool exec(Interpreter * interp) override {
+		interp->step();
+		size_t addr = myLoc->locate(interp);
+		interp->store(addr, wrapAs(myKind, interp->load(addr) + myDelta));
+		return false;
+	}
+private:
+	ExpCode * myLoc;
+	char myKind;
+	Cell myDelta;
+};
+
+class IfCode : public StmtCode{
+public:
+	IfCode(ExpCode * cond, StmtCode * bodyTrue, StmtCode * bodyFalse)
+	: myCond(cond), myTrue(bodyTrue), myFalse(bodyFalse){ }
+	~IfCode(){
+		delete myCond;
+		delete myTrue;
+		delete myFalse;
+	}
+	bool exec(Interpreter * interp) override {
+		interp->step();
+		if (myCond->eval(interp)){ return myTrue->exec(interp); }
+		return myFalse != nullptr && myFalse->exec(interp);
+	}
+private:
+	ExpCode * myCond;
+	StmtCode * myTrue;
+	StmtCode * myFalse;
+};
+
+class ReturnCode : public StmtCode{
+public:
+	explicit ReturnCode(ExpCode * exp) : myExp(exp){ }
+	~ReturnCode(){ delete myExp; }
+	bool exec(Interpreter * interp) override {
+		interp->step();
+		if (myExp != nullptr){ interp->returned(myExp->eval(interp)); }
+		return true;
+	}
+private:
+	ExpCode * myExp;
+};
+
+LoopCode::~LoopCode(){
+	delete myCond;
+	delete myBody;
+}
+
+bool LoopCode::exec(Interpreter * interp){
+	interp->step();
+	if (myRotated){
+		//The guard has already tested the condition
+		do {
+			if (myBody->exec(interp)){ return true; }
+		} while (myCond->eval(interp));
+		return false;
+	}
+	return resume(interp);
+}
+
+bool LoopCode::resume(Interpreter * interp){
+	while (myCond->eval(interp)){
+		if (myBody->exec(interp)){ return true; }
+	}
+	return false;
+}
+
+ExpCode * Compiler::exp(ExpNode * exp){
+	return exp->compile(this);
+}
+
+ExpCode * Compiler::whole(ExpNode * exp){
+	//Copying from anything else fails as the AST does
+	if (exp->asLVal() == nullptr){ return fallback(exp); }
+	return exp->compile(this);
+}
+
+StmtCode * Compiler::body(const std::vector<StmtNode *>& stmts){
+	std::vector<StmtCode *> code;
+	for (auto stmt : stmts){ code.push_back(stmt->compile(this)); }
+	return new BodyCode(std::move(code));
+}
+
+ExpCode * Compiler::binary(const std::string& op, ExpNode * lhs,
+	ExpNode * rhs, const Position * pos){
+	if (op == "+"){ return operands<AddOp>(this, lhs, rhs); }
+	if (op == "-"){ return operands<SubOp>(this, lhs, rhs); }
+	if (op == "*"){ return operands<MulOp>(this, lhs, rhs); }
+	if (op == "=="){ return operands<EqOp>(this, lhs, rhs); }
+	if (op == "!="){ return operands<NeOp>(this, lhs, rhs); }
+	if (op == "<"){ return operands<LtOp>(this, lhs, rhs); }
+	if (op == "<="){ return operands<LeOp>(this, lhs, rhs); }
+	if (op == ">"){ return operands<GtOp>(this, lhs, rhs); }
+	if (op == ">="){ return operands<GeOp>(this, lhs, rhs); }
+	if (op == "/"){ return new DivCode(exp(lhs), exp(rhs), pos); }
+	if (op == "and" || op == "or"){
+		return new AndCode(exp(lhs), exp(rhs), op == "and");
+	}
+	return nullptr;
+}
+
+ExpCode * Compiler::fallback(ExpNode * exp){
+	return new ExpFallback(exp);
+}
+
+StmtCode * Compiler::fallback(StmtNode * stmt){
+	return new StmtFallback(stmt);
+}
+
+ExpCode * ExpNode::compile(Compiler * comp){
+	return comp->fallback(this);
+}
+
+StmtCode * StmtNode::compile(Compiler * comp){
+	return comp->fallback(this);
+}
+
+ExpCode * IDNode::compile(Compiler * comp){
+	ExpNode * constant = mySymbol->getConstant();
+	if (constant != nullptr){ return new ConstCode(comp->exp(constant)); }
+	return new VarCode(mySymbol);
+}
+
+ExpCode * DerefNode::compile(Compiler * comp){
+	return new DerefCode(comp->exp(myID), pos());
+}
+
+ExpCode * FieldAccessNode::compile(Compiler * comp){
+	const DataType * base = myBase->resolvedType();
+	if (base == nullptr || base->asRecord() == nullptr){
+		return comp->fallback(this);
+	}
+	return new FieldCode(comp->exp(myBase), base->asRecord(),
+		myField->getSymbol());
+}
+
+ExpCode * IndexNode::compile(Compiler * comp){
+	const DataType * base = myBase->resolvedType();
+	if (base == nullptr || base->asArray() == nullptr){
+		return comp->fallback(this);
+	}
+	return new IndexCode(comp->exp(myBase), comp->exp(myIndex),
+		base->asArray(), myChecked, pos());
+}
+
+ExpCode * CallExpNode::compile(Compiler * comp){
+	const FnType * type = myID->getSymbol()->getDataType()->asFn();
+	if (type == nullptr || type->getFormalTypes()->size() != myArgs.size()){
+		return comp->fallback(this);
+	}
+	std::vector<ExpCode *> args;
+	std::vector<const DataType *> wholes;
+	auto formal = type->getFormalTypes()->begin();
+	for (auto arg : myArgs){
+		if (isScalar(*formal)){
+			args.push_back(comp->exp(arg));
+			wholes.push_back(nullptr);
+		} else {
+			args.push_back(comp->whole(arg));
+			wholes.push_back(*formal);
+		}
+		++formal;
+	}
+	return new CallCode(myID->getSymbol(), std::move(args), std::move(wholes),
+		pos());
+}
+
+ExpCode * BinaryExpNode::compile(Compiler * comp){
+	ExpCode * code = comp->binary(opString(), myExp1, myExp2, pos());
+	if (code == nullptr){ return comp->fallback(this); }
+	return code;
+}
+
+ExpCode * RefNode::compile(Compiler * comp){
+	return new RefCode(comp->exp(myID));
+}
+
+ExpCode * NegNode::compile(Compiler * comp){
+	return new UnaryCode(comp->exp(myExp), true);
+}
+
+ExpCode * NotNode::compile(Compiler * comp){
+	return new UnaryCode(comp->exp(myExp), false);
+}
+
+ExpCode * AssignExpNode::compile(Compiler * comp){
+	const DataType * type = myDst->resolvedType();
+	if (type == nullptr){ return comp->fallback(this); }
+	if (!isScalar(type)){
+		return new CopyCode(comp->exp(myDst), comp->whole(mySrc), type);
+	}
+	SemSymbol * var = plainVar(myDst);
+	if (var != nullptr){ return new AssignVarCode(var, comp->exp(mySrc)); }
+	return new AssignCode(comp->exp(myDst), comp->exp(mySrc));
+}
+
+ExpCode * ShortLitNode::compile(Compiler * comp){
+	return new LitCode(myNum);
+}
+
+ExpCode * IntLitNode::compile(Compiler * comp){
+	return new LitCode(myNum);
+}
+
+ExpCode * StrLitNode::compile(Compiler * comp){
+	return new StrCode(myStrID);
+}
+
+ExpCode * TrueNode::compile(Compiler * comp){
+	return new LitCode(1);
+}
+
+ExpCode * FalseNode::compile(Compiler * comp){
+	return new LitCode(0);
+}
+
+StmtCode * FnDeclNode::compileBody(Compiler * comp){
+	return comp->body(myBody);
+}
+
+StmtCode * VarDeclNode::compile(Compiler * comp){
+	return new DeclareCode(getSymbol());
+}
+
+StmtCode * AssignStmtNode::compile(Compiler * comp){
+	return new ExpStmtCode(comp->exp(myExp));
+}
+
+StmtCode * CallStmtNode::compile(Compiler * comp){
+	return new ExpStmtCode(comp->exp(myCallExp));
+}
+
+StmtCode * ReadStmtNode::compile(Compiler * comp){
+	const DataType * type = myDst->resolvedType();
+	if (type == nullptr){ return comp->fallback(this); }
+	return new ReadCode(comp->exp(myDst), type);
+}
+
+StmtCode * WriteStmtNode::compile(Compiler * comp){
+	return new WriteCode(comp->exp(mySrc), mySrc);
+}
+
+StmtCode * PostDecStmtNode::compile(Compiler * comp){
+	const DataType * type = myLVal->resolvedType();
+	if (type == nullptr){ return comp->fallback(this); }
+	return new StepCode(comp->exp(myLVal), wrapKind(type), -1);
+}
+
+StmtCode * PostIncStmtNode::compile(Compiler * comp){
+	const DataType * type = myLVal->resolvedType();
+	if (type == nullptr){ return comp->fallback(this); }
+	return new StepCode(comp->exp(myLVal), wrapKind(type), 1);
+}
+
+StmtCode * IfStmtNode::compile(Compiler * comp){
+	return new IfCode(comp->exp(myCond), comp->body(myBody), nullptr);
+}
+
+StmtCode * IfElseStmtNode::compile(Compiler * comp){
+	return new IfCode(comp->exp(myCond), comp->body(myBodyTrue),
+		comp->body(myBodyFalse));
+}
+
+StmtCode * WhileStmtNode::compile(Compiler * comp){
+	return compileLoop(comp);
+}
+
+LoopCode * WhileStmtNode::compileLoop(Compiler * comp){
+	return new LoopCode(comp->exp(myCond), comp->body(myBody), myRotated);
+}
+
+StmtCode * ReturnStmtNode::compile(Compiler * comp){
+	if (myExp == nullptr){ return new ReturnCode(nullptr); }
+	return new ReturnCode(comp->exp(myExp));
+}
+
+LoopCode * LoopTier::entered(){
+	LoopCode * code = myCode.load(std::memory_order_acquire);
+	if (code != nullptr && !myEntered){
+		myEntered = true;
+		myTiers->myStats->tierUps.push_back("loop " + myLoop->pos()->span()
+			+ " after " + std::to_string(myCount) + " back-edges");
+	}
+	return code;
+}
+
+LoopCode * LoopTier::hot(){
+	if (myCount == LOOP_THRESHOLD){ myTiers->request(myLoop, this); }
+	LoopCode * code = myCode.load(std::memory_order_acquire);
+	if (code != nullptr && !myEntered){
+		myEntered = true;
+		myTiers->myStats->tierUps.push_back("loop " + myLoop->pos()->span()
+			+ " after " + std::to_string(myCount)
+			+ " back-edges, in the middle of running");
+	}
+	return code;
+}
+
+Tiers::~Tiers(){
+	{
+		std::lock_guard<std::mutex> lock(myLock);
+		myStop = true;
+	}
+	myWake.notify_all();
+	if (myWorker.joinable()){ myWorker.join(); }
+	for (auto code : myCode){ delete code; }
+}
+
+StmtCode * Tiers::called(FnDeclNode * fn){
+	FnTier& tier = myFns[fn];
+	StmtCode * code = tier.code.load(std::memory_order_acquire);
+	if (code == nullptr){
+		if (++tier.count == CALL_THRESHOLD){ request(fn, &tier); }
+		return nullptr;
+	}
+	if (!tier.entered){
+		tier.entered = true;
+		myStats->tierUps.push_back(fn->getSymbol()->getName() + " after "
+			+ std::to_string(tier.count) + " calls");
+	}
+	return code;
+}
+
+LoopTier * Tiers::loop(WhileStmtNode * loop){
+	LoopTier& tier = myLoops[loop];
+	if (tier.myTiers == nullptr){
+		tier.myTiers = this;
+		tier.myLoop = loop;
+	}
+	return &tier;
+}
+
+void Tiers::request(FnDeclNode * fn, FnTier * tier){
+	std::lock_guard<std::mutex> lock(myLock);
+	myJobs.push_back(Job{fn, tier, nullptr, nullptr});
+	if (!myWorker.joinable()){ myWorker = std::thread(&Tiers::work, this); }
+	myWake.notify_one();
+}
+
+void Tiers::request(WhileStmtNode * loop, LoopTier * tier){
+	std::lock_guard<std::mutex> lock(myLock);
+	myJobs.push_back(Job{nullptr, nullptr, loop, tier});
+	if (!myWorker.joinable()){ myWorker = std::thread(&Tiers::work, this); }
+	myWake.notify_one();
+}
+
+//Compiling only reads the AST, which the run never changes
+void Tiers::work(){
+	std::unique_lock<std::mutex> lock(myLock);
+	while (true){
+		myWake.wait(lock, [this]{ return myStop || !myJobs.empty(); });
+		if (myStop){ return; }
+		Job job = myJobs.front();
+		myJobs.pop_front();
+		lock.unlock();
+		Compiler comp;
+		StmtCode * code = nullptr;
+		LoopCode * loop = nullptr;
+		try {
+			if (job.fn != nullptr){
+				code = job.fn->compileBody(&comp);
+			} else {
+				loop = job.loop->compileLoop(&comp);
+				code = loop;
+			}
+		} catch (...){
+			//What can't be compiled goes on running in the AST
+			code = nullptr;
+			loop = nullptr;
+		}
+		lock.lock();
+		if (code == nullptr){ continue; }
+		myCode.push_back(code);
+		if (job.fn != nullptr){
+			job.fnTier->code.store(code, std::memory_order_release);
+		} else {
+			job.loopTier->myCode.store(loop, std::memory_order_release);
+		}
+	}
+}
+
+}
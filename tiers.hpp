@@ -0,0 +1,156 @@
+#ifndef CMINUSMINUS_TIERS
+#define CMINUSMINUS_TIERS
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "interpreter.hpp"
+
+namespace cminusminus{
+
+class ExpNode;
+class FnDeclNode;
+class StmtNode;
+class WhileStmtNode;
+
+//How many calls a function, and how many back-edges a loop,
+// takes before it is compiled
+static const uint64_t CALL_THRESHOLD = 100;
+static const uint64_t LOOP_THRESHOLD = 1000;
+
+//An expression compiled for the second tier. Compiled code
+// works on the same memory and frames as the AST does, and
+// counts the same steps, so that a run can move between the
+// tiers at any call or back-edge.
+class ExpCode{
+public:
+	virtual ~ExpCode(){ }
+	virtual Interpreter::Cell eval(Interpreter * interp) = 0;
+	//The address of a location (or of a record or array
+	// being copied whole)
+	virtual size_t locate(Interpreter * interp);
+};
+
+class StmtCode{
+public:
+	virtual ~StmtCode(){ }
+	//Returns true if the statement returned from the function
+	virtual bool exec(Interpreter * interp) = 0;
+};
+
+class LoopCode : public StmtCode{
+public:
+	LoopCode(ExpCode * cond, StmtCode * body, bool rotated)
+	: myCond(cond), myBody(body), myRotated(rotated){ }
+	~LoopCode();
+	bool exec(Interpreter * interp) override;
+	//Go on with a loop that the AST has been running, from
+	// the end of an iteration
+	bool resume(Interpreter * interp);
+private:
+	ExpCode * myCond;
+	StmtCode * myBody;
+	bool myRotated;
+};
+
+//What compiling looks up as it goes, which is only ever the
+// AST and its symbols, never the state of the run, so that
+// it can compile while the program runs
+class Compiler{
+public:
+	ExpCode * exp(ExpNode * exp);
+	//An expression whose value is a record or array, which
+	// is copied from its location
+	ExpCode * whole(ExpNode * exp);
+	StmtCode * body(const std::vector<StmtNode *>& stmts);
+	ExpCode * binary(const std::string& op, ExpNode * lhs, ExpNode * rhs,
+		const Position * pos);
+	//Code that runs a node in the AST, for what is not
+	// worth compiling
+	ExpCode * fallback(ExpNode * exp);
+	StmtCode * fallback(StmtNode * stmt);
+};
+
+class Tiers;
+
+//The back-edges a loop has taken, and its code once it has
+// been compiled
+class LoopTier{
+public:
+	LoopTier()
+	: myTiers(nullptr), myLoop(nullptr), myCount(0), myCode(nullptr),
+	  myEntered(false){ }
+	//The compiled loop, once the loop is entered again
+	LoopCode * entered();
+	//Count a back-edge, returning the compiled loop if the
+	// rest of it is to run in the compiled tier
+	LoopCode * backEdge(){
+		if (++myCount < LOOP_THRESHOLD){ return nullptr; }
+		return hot();
+	}
+private:
+	LoopCode * hot();
+	friend class Tiers;
+	Tiers * myTiers;
+	WhileStmtNode * myLoop;
+	uint64_t myCount;
+	std::atomic<LoopCode *> myCode;
+	bool myEntered;
+};
+
+// Runs a program in two tiers. The first is the AST, which
+// starts at once; the second is code compiled from the AST,
+// in which each variable's place in the frame, each field's
+// offset and each type's size is found once rather than on
+// every use. A function that has been called CALL_THRESHOLD
+// times, or a loop that has taken LOOP_THRESHOLD back-edges,
+// is compiled by a thread of its own while the AST goes on
+// running it. The next call of the function runs its code;
+// a loop switches to its code at its next back-edge, in the
+// middle of running, since both tiers keep the locals in
+// the same frame.
+class Tiers{
+public:
+	explicit Tiers(RunStats * stats) : myStats(stats), myStop(false){ }
+	~Tiers();
+	//Count a call, giving the compiled body of the function
+	// if it has one
+	StmtCode * called(FnDeclNode * fn);
+	LoopTier * loop(WhileStmtNode * loop);
+private:
+	friend class LoopTier;
+	struct FnTier{
+		FnTier() : count(0), code(nullptr), entered(false){ }
+		uint64_t count;
+		std::atomic<StmtCode *> code;
+		bool entered;
+	};
+	//Compile a function or loop in the background
+	void request(FnDeclNode * fn, FnTier * tier);
+	void request(WhileStmtNode * loop, LoopTier * tier);
+	void work();
+	RunStats * myStats;
+	std::unordered_map<FnDeclNode *, FnTier> myFns;
+	std::unordered_map<WhileStmtNode *, LoopTier> myLoops;
+	//What is waiting to be compiled, and what has been
+	struct Job{
+		FnDeclNode * fn;
+		FnTier * fnTier;
+		WhileStmtNode * loop;
+		LoopTier * loopTier;
+	};
+	std::deque<Job> myJobs;
+	std::vector<StmtCode *> myCode;
+	std::mutex myLock;
+	std::condition_variable myWake;
+	bool myStop;
+	std::thread myWorker;
+};
+
+}
+
+#endif
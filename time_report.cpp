@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include "time_report.hpp"
+#include "ast.hpp"
+
+namespace cminusminus{
+
+static const char * const PHASE_NAMES[] = {
+	"lex", "parse", "names", "types"
+};
+
+double TimeReport::Fn::total() const{
+	double sum = 0;
+	for (auto s : seconds){ sum += s; }
+	return sum;
+}
+
+bool TimeReport::configure(const std::string& what){
+	std::string kind = what.substr(0, what.find(':'));
+	if (kind != "functions"){ return false; }
+	if (kind.size() == what.size()){ return true; }
+	std::string count = what.substr(kind.size() + 1);
+	char * end = nullptr;
+	long num = std::strtol(count.c_str(), &end, 10);
+	if (count.empty() || *end != '\0' || num <= 0){ return false; }
+	myCount = static_cast<size_t>(num);
+	return true;
+}
+
+void TimeReport::write(std::ostream& out){
+	std::sort(myFns.begin(), myFns.end(), [](const Fn& a, const Fn& b){
+		return a.total() > b.total();
+	});
+	size_t shown = std::min(myCount, myFns.size());
+	out << "The " << shown << " most expensive of " << myFns.size()
+	  << " functions (ms)\n";
+	out << std::left << std::setw(20) << "function" << std::right
+	  << std::setw(7) << "line";
+	for (auto phase : PHASE_NAMES){ out << std::setw(9) << phase; }
+	out << std::setw(9) << "total" << std::setw(8) << "nodes"
+	  << std::setw(7) << "depth" << "\n";
+	out << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < shown; i++){
+		const Fn& fn = myFns[i];
+		out << std::left << std::setw(20) << fn.name << std::right
+		  << std::setw(7) << fn.line;
+		for (auto s : fn.seconds){ out << std::setw(9) << s * 1000; }
+		out << std::setw(9) << fn.total() * 1000
+		  << std::setw(8) << fn.nodes << std::setw(7) << fn.depth << "\n";
+	}
+}
+
+void ASTNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+}
+
+void VarDeclNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myType->measure(stats, depth + 1);
+	myID->measure(stats, depth + 1);
+}
+
+void ConstDeclNode::measure(NodeStats * stats, size_t depth){
+	VarDeclNode::measure(stats, depth);
+	myInit->measure(stats, depth + 1);
+}
+
+void FnDeclNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myRetType->measure(stats, depth + 1);
+	myID->measure(stats, depth + 1);
+	for (auto formal : myFormals){ formal->measure(stats, depth + 1); }
+	for (auto stmt : myBody){ stmt->measure(stats, depth + 1); }
+}
+
+void RecordDeclNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myID->measure(stats, depth + 1);
+	for (auto field : myFields){ field->measure(stats, depth + 1); }
+}
+
+void AssignStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myExp->measure(stats, depth + 1);
+}
+
+void ReadStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myDst->measure(stats, depth + 1);
+}
+
+void WriteStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	mySrc->measure(stats, depth + 1);
+}
+
+void PostDecStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myLVal->measure(stats, depth + 1);
+}
+
+void PostIncStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myLVal->measure(stats, depth + 1);
+}
+
+void IfStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myCond->measure(stats, depth + 1);
+	for (auto stmt : myBody){ stmt->measure(stats, depth + 1); }
+}
+
+void IfElseStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myCond->measure(stats, depth + 1);
+	for (auto stmt : myBodyTrue){ stmt->measure(stats, depth + 1); }
+	for (auto stmt : myBodyFalse){ stmt->measure(stats, depth + 1); }
+}
+
+void WhileStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myCond->measure(stats, depth + 1);
+	for (auto stmt : myBody){ stmt->measure(stats, depth + 1); }
+}
+
+void ReturnStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	if (myExp != nullptr){ myExp->measure(stats, depth + 1); }
+}
+
+void CallStmtNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myCallExp->measure(stats, depth + 1);
+}
+
+void CallExpNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myID->measure(stats, depth + 1);
+	for (auto arg : myArgs){ arg->measure(stats, depth + 1); }
+}
+
+void BinaryExpNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myExp1->measure(stats, depth + 1);
+	myExp2->measure(stats, depth + 1);
+}
+
+void UnaryExpNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myExp->measure(stats, depth + 1);
+}
+
+void DerefNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myID->measure(stats, depth + 1);
+}
+
+void FieldAccessNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myBase->measure(stats, depth + 1);
+	myField->measure(stats, depth + 1);
+}
+
+void IndexNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myBase->measure(stats, depth + 1);
+	myIndex->measure(stats, depth + 1);
+}
+
+void AssignExpNode::measure(NodeStats * stats, size_t depth){
+	stats->add(depth);
+	myDst->measure(stats, depth + 1);
+	mySrc->measure(stats, depth + 1);
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef CMINUSMINUS_TIME_REPORT
+#define CMINUSMINUS_TIME_REPORT
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cminusminus{
+
+//The size of a piece of the AST: how many nodes it has,
+// and how deep they go below its root
+class NodeStats{
+public:
+	NodeStats() : nodes(0), maxDepth(0){ }
+	void add(size_t depth){
+		nodes++;
+		if (depth > maxDepth){ maxDepth = depth; }
+	}
+	size_t nodes;
+	size_t maxDepth;
+};
+
+//Measures the time since it was made, or since it was last
+// read
+class Stopwatch{
+public:
+	Stopwatch() : myStart(std::chrono::steady_clock::now()){ }
+	double lap(){
+		auto now = std::chrono::steady_clock::now();
+		std::chrono::duration<double> elapsed = now - myStart;
+		myStart = now;
+		return elapsed.count();
+	}
+private:
+	std::chrono::steady_clock::time_point myStart;
+};
+
+//Where the time of checking a file went, function by
+// function, so that the few functions that make a large
+// generated file slow to check stand out
+class TimeReport{
+public:
+	enum Phase{
+		LEX,
+		PARSE,
+		NAMES,
+		TYPES,
+		PHASES
+	};
+	struct Fn{
+		Fn() : line(0), nodes(0), depth(0){
+			for (auto& s : seconds){ s = 0; }
+		}
+		double total() const;
+		std::string name;
+		size_t line;
+		double seconds[PHASES];
+		size_t nodes;
+		size_t depth;
+	};
+	//Parse what follows --time-report=, which is functions
+	// and optionally how many of them (functions:20).
+	// Returns false if that makes no sense
+	bool configure(const std::string& what);
+	void add(const Fn& fn){ myFns.push_back(fn); }
+	//Output the most expensive functions, most expensive
+	// first
+	void write(std::ostream& out);
+private:
+	size_t myCount = 10;
+	std::vector<Fn> myFns;
+};
+
+}
+
+#endif
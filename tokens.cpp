@@ -1,5 +1,9 @@
 #include "tokens.hpp" // Get the class declarations
 #include "grammar.hh" // Get the TokenKind definitions
+#include <unordered_map>
+#include <vector>
+#include <sstream>
+#include "string_pool.hpp"
 
 namespace cminusminus{
 
@@ -14,8 +18,10 @@ static std::string tokenKindString(int tokKind){
 		case TokenKind::AT: return "AT";
 		case TokenKind::BOOL: return "BOOL";
 		case TokenKind::COMMA: return "COMMA";
+		case TokenKind::CONST: return "CONST";
 		case TokenKind::DEC: return "DEC";
 		case TokenKind::DIVIDE: return "DIVIDE";
+		case TokenKind::DOT: return "DOT";
 		case TokenKind::ELSE: return "ELSE";
 		case TokenKind::END: return "EOF";
 		case TokenKind::EQUALS: return "EQUALS";
@@ -24,9 +30,11 @@ static std::string tokenKindString(int tokKind){
 		case TokenKind::GREATEREQ: return "GREATEREQ";
 		case TokenKind::ID: return "ID";
 		case TokenKind::IF: return "IF";
+		case TokenKind::IMPORT: return "IMPORT";
 		case TokenKind::INC: return "INC";
 		case TokenKind::INT: return "INT";
 		case TokenKind::INTLITERAL: return "INTLITERAL";
+		case TokenKind::LBRACKET: return "LBRACKET";
 		case TokenKind::LCURLY: return "LCURLY";
 		case TokenKind::LESS: return "LESS";
 		case TokenKind::LESSEQ: return "LESSEQ";
@@ -38,7 +46,9 @@ static std::string tokenKindString(int tokKind){
 		case TokenKind::PLUS: return "PLUS";
 		case TokenKind::PTR: return "PTR";
 		case TokenKind::READ: return "READ";
+		case TokenKind::RECORD: return "RECORD";
 		case TokenKind::RETURN: return "RETURN";
+		case TokenKind::RBRACKET: return "RBRACKET";
 		case TokenKind::RCURLY: return "RCURLY";
 		case TokenKind::RPAREN: return "RPAREN";
 		case TokenKind::SEMICOL: return "SEMICOL";
@@ -57,74 +67,106 @@ static std::string tokenKindString(int tokKind){
 	
 }
 
-Token::Token(Position * posIn, int kindIn)
-  : myPos(posIn), myKind(kindIn){
+//Interned text of ID tokens. Each
+// distinct string is stored only once, no matter how many 
+// tokens refer to it. Released texts are left empty (no ID
+// is), and their ids are reused.
+static std::vector<std::string> texts;
+static std::unordered_map<std::string, size_t> textIDs;
+static std::vector<size_t> freeTexts;
+static size_t textBytes = 0;
+
+size_t Token::intern(const std::string& text){
+	auto found = textIDs.find(text);
+	if (found != textIDs.end()){ return found->second; }
+	size_t id = texts.size();
+	if (freeTexts.empty()){
+		texts.push_back(text);
+	} else {
+		id = freeTexts.back();
+		freeTexts.pop_back();
+		texts[id] = text;
+	}
+	textIDs[text] = id;
+	textBytes += text.length();
+	return id;
 }
 
-std::string Token::toString(){
-	return tokenKindString(kind())
-	+ " " + myPos->begin();
-}
+LiveInterned::LiveInterned()
+: texts(cminusminus::texts.size(), false),
+  literals(StringPool::count(), false){ }
 
-int Token::kind() const { 
-	return this->myKind; 
+void Token::markLive(LiveInterned * live) const {
+	if (myKind == TokenKind::ID){ live->markText(myPayload); }
+	if (myKind == TokenKind::STRLITERAL){ live->markLiteral(myPayload); }
 }
 
-Position * Token::pos() const {
-	return myPos;
-}
-
-IDToken::IDToken(Position * posIn, std::string vIn)
-  : Token(posIn, TokenKind::ID), myValue(vIn){ 
+void Token::release(const LiveInterned& live){
+	for (size_t id = 0; id < live.texts.size(); id++){
+		if (live.texts[id] || texts[id].empty()){ continue; }
+		textIDs.erase(texts[id]);
+		textBytes -= texts[id].length();
+		std::string().swap(texts[id]);
+		freeTexts.push_back(id);
+	}
+	StringPool::release(live.literals);
 }
 
-std::string IDToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ myValue + " " + myPos->begin();
+size_t Token::internedBytes(){
+	return textBytes + StringPool::data().length();
 }
 
-const std::string IDToken::value() const { 
-	return this->myValue; 
+Token Token::id(const Position& pos, const std::string& name){
+	return Token(pos, TokenKind::ID, intern(name));
 }
 
-StrToken::StrToken(Position * posIn, std::string sIn)
-  : Token(posIn, TokenKind::STRLITERAL), myStr(sIn){
+Token Token::strLit(const Position& pos, const std::string& raw){
+	return Token(pos, TokenKind::STRLITERAL, 
+		StringPool::internLiteral(raw));
 }
 
-std::string StrToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ this->myStr + " " + myPos->begin();
+Token Token::intLit(const Position& pos, int num){
+	return Token(pos, TokenKind::INTLITERAL, 
+		static_cast<size_t>(num));
 }
 
-const std::string StrToken::str() const {
-	return this->myStr;
+Token Token::shortLit(const Position& pos, int num){
+	return Token(pos, TokenKind::SHORTLITERAL, 
+		static_cast<size_t>(num));
 }
 
-IntLitToken::IntLitToken(Position * pos, int numIn)
-  : Token(pos, TokenKind::INTLITERAL), myNum(numIn){}
-
-
-std::string IntLitToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ std::to_string(this->myNum) + " "
-	+ myPos->begin();
+std::string Token::toString() const{
+	std::string result = tokenKindString(kind());
+	switch(kind()){
+		case TokenKind::ID:
+			result += ":" + value();
+			break;
+		case TokenKind::STRLITERAL: {
+			std::stringstream lit;
+			StringPool::unparse(lit, strID());
+			result += ":" + lit.str();
+			break;
+		}
+		case TokenKind::INTLITERAL:
+		case TokenKind::SHORTLITERAL:
+			result += ":" + std::to_string(num());
+			break;
+		default:
+			break;
+	}
+	return result + " " + myPos.begin();
 }
 
-int IntLitToken::num() const {
-	return this->myNum;
+const std::string& Token::value() const { 
+	return texts[myPayload];
 }
 
-ShortLitToken::ShortLitToken(Position * pos, int numIn)
-  : Token(pos, TokenKind::SHORTLITERAL), myNum(numIn){}
-
-std::string ShortLitToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ std::to_string(this->myNum) + " "
-	+ myPos->begin();
+size_t Token::strID() const {
+	return myPayload;
 }
 
-int ShortLitToken::num() const {
-	return this->myNum;
+int Token::num() const {
+	return static_cast<int>(myPayload);
 }
 
 } //End namespace cminusminus
@@ -2,59 +2,65 @@
 #define CSHANTY_TOKEN_H
 
 #include <string>
+#include <vector>
 #include "position.hpp"
 
 namespace cminusminus{
 
-class Token{
-public:
-	Token(Position * pos, int kindIn);
-	virtual std::string toString();
-	size_t line() const;
-	size_t col() const;
-	int kind() const;
-	Position * pos() const;
-protected:
-	Position * myPos;
-private:
-	const int myKind;
+//The interned ID texts and string literals still in use.
+// Whatever holds their ids marks them, and Token::release
+// then frees the rest, so that a long session only keeps
+// the text of what its documents still contain
+struct LiveInterned{
+	LiveInterned();
+	void markText(size_t id){ texts[id] = true; }
+	void markLiteral(size_t id){ literals[id] = true; }
+	std::vector<bool> texts;
+	std::vector<bool> literals;
 };
 
-class IDToken : public Token{
-public:
-	IDToken(Position * posIn, std::string valIn);
-	const std::string value() const;
-	virtual std::string toString() override;
-private:
-	const std::string myValue;
-	
-};
-
-class StrToken : public Token{
-public:
-	StrToken(Position * posIn, std::string valIn);
-	virtual std::string toString() override;
-	const std::string str() const;
-private:
-	const std::string myStr;
-};
-
-class IntLitToken : public Token{
-public:
-	IntLitToken(Position * posIn, int numIn);
-	virtual std::string toString() override;
-	int num() const;
-private:
-	const int myNum;
-};
-
-class ShortLitToken : public Token{
+//Tokens are small values that are copied (or moved) 
+// between the scanner and the parser: the kind of token,
+// where it appears, and a payload id. The payload of an 
+// integer or short literal is its value. The text of IDs 
+// and string literals is interned, so that their payload 
+// is an index into the table of interned text (or, for
+// string literals, the id of the literal in the StringPool)
+// and a token never owns any memory.
+class Token{
 public:
-	ShortLitToken(Position * posIn, int numIn);
-	virtual std::string toString() override;
+	Token() : myPos(0,0,0,0), myKind(0), myPayload(0){ }
+	Token(const Position& pos, int kindIn, size_t payloadIn = 0)
+	: myPos(pos), myKind(kindIn), myPayload(payloadIn){ }
+	static Token id(const Position& pos, const std::string& name);
+	static Token strLit(const Position& pos, const std::string& raw);
+	static Token intLit(const Position& pos, int num);
+	static Token shortLit(const Position& pos, int num);
+	std::string toString() const;
+	int kind() const { return myKind; }
+	const Position * pos() const { return &myPos; }
+	//Tokens never span lines, so they can be moved between
+	// lines as the text around them is edited
+	void moveToLine(size_t line){ myPos.moveToLine(line); }
+	//The name of an ID token
+	const std::string& value() const;
+	//The StringPool id of a string literal token
+	size_t strID() const;
+	//The value of an integer or short literal token
 	int num() const;
+	//Mark the text or literal the token refers to as used
+	void markLive(LiveInterned * live) const;
+	//Free the ID texts and string literals that were not
+	// marked, so that their ids can be given out again.
+	// Anything interned since the marks were made is kept
+	static void release(const LiveInterned& live);
+	//The size of the ID texts and string literals interned
+	static size_t internedBytes();
 private:
-	const int myNum;
+	static size_t intern(const std::string& text);
+	Position myPos;
+	int myKind;
+	size_t myPayload;
 };
 
 }
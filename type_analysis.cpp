@@ -7,6 +7,14 @@
 
 namespace cminusminus{
 
+//Constants are replaced by their values, so they have no 
+// location that could be written (or pointed to)
+static bool isConst(LValNode * lval){
+	IDNode * id = lval->asID();
+	if (id == nullptr || id->getSymbol() == nullptr){ return false; }
+	return id->getSymbol()->getConstant() != nullptr;
+}
+
 TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
 	//To emphasize that type analysis depends on name analysis
 	// being complete, a name analysis must be supplied for 
@@ -24,16 +32,84 @@ TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
 
 }
 
+TypeAnalysis * TypeAnalysis::buildFused(ProgramNode * ast,
+	Modules * modules, const std::string& path){
+	TypeAnalysis * typeAnalysis = new TypeAnalysis();
+	typeAnalysis->ast = ast;
+
+	SymbolTable * symTab = new SymbolTable();
+	symTab->importFrom(modules, path);
+	bool res = typeAnalysis->fuse(ast, symTab);
+	delete symTab;
+	if (!res){ return nullptr; }
+
+	typeAnalysis->release();
+	if (typeAnalysis->hasError){
+		return nullptr;
+	}
+	return typeAnalysis;
+}
+
+TypeAnalysis * TypeAnalysis::build(DeclNode * decl){
+	TypeAnalysis * typeAnalysis = new TypeAnalysis();
+	typeAnalysis->ast = nullptr;
+	decl->typeAnalysis(typeAnalysis);
+	return typeAnalysis;
+}
+
+bool TypeAnalysis::fuse(ASTNode * root, SymbolTable * symTab){
+	//Name analysis never writes to std::cout, so all of 
+	// it is output of the type rules
+	errOut = &fusedErr;
+	std::streambuf * out = std::cout.rdbuf(fusedOut.rdbuf());
+	symTab->fuseTypes(this);
+	bool res;
+	try {
+		res = root->nameAnalysis(symTab);
+	} catch (...) {
+		std::cout.rdbuf(out);
+		symTab->fuseTypes(nullptr);
+		throw;
+	}
+	std::cout.rdbuf(out);
+	symTab->fuseTypes(nullptr);
+	errOut = &std::cerr;
+	return res;
+}
+
+void TypeAnalysis::release(){
+	//Name analysis passed, so type analysis would have run
+	std::cout << fusedOut.str();
+	std::cerr << fusedErr.str();
+	if (pending != nullptr){
+		std::rethrow_exception(pending);
+	}
+}
+
+void TypeAnalysis::fusedRule(ASTNode * node, bool resolved){
+	if (!resolved){ namesFailed = true; }
+	if (!rulesActive()){ return; }
+
+	try {
+		node->typeRule(this);
+	} catch (...) {
+		pending = std::current_exception();
+	}
+}
+
 void ProgramNode::typeAnalysis(TypeAnalysis * ta){
 
 	//pass the TypeAnalysis down throughout
 	// the entire tree, getting the types for
 	// each element in turn and adding them
 	// to the ta object's hashMap
-	for (auto global : *myGlobals){
+	for (auto global : myGlobals){
 		global->typeAnalysis(ta);
 	}
+	typeRule(ta);
+}
 
+void ProgramNode::typeRule(TypeAnalysis * ta){
 	//The type of the program node will never
 	// be needed. We can just set it to VOID
 	//(Alternatively, we could make our type 
@@ -43,7 +119,10 @@ void ProgramNode::typeAnalysis(TypeAnalysis * ta){
 
 void AssignStmtNode::typeAnalysis(TypeAnalysis * ta){
 	myExp->typeAnalysis(ta);
+	typeRule(ta);
+}
 
+void AssignStmtNode::typeRule(TypeAnalysis * ta){
 	//It can be a bit of a pain to write 
 	// "const DataType *" everywhere, so here
 	// the use of auto is used instead to tell the
@@ -61,50 +140,69 @@ void AssignStmtNode::typeAnalysis(TypeAnalysis * ta){
 }
 
 void PostDecStmtNode::typeAnalysis(TypeAnalysis * ta){
-
 	myLVal->typeAnalysis(ta);
+	typeRule(ta);
 }
 
-void PostIncStmtNode::typeAnalysis(TypeAnalysis * ta){
+void PostDecStmtNode::typeRule(TypeAnalysis * ta){
+	if (isConst(myLVal)){ ta->errConstWrite(myLVal->pos()); }
+}
 
+void PostIncStmtNode::typeAnalysis(TypeAnalysis * ta){
 	myLVal->typeAnalysis(ta);
+	typeRule(ta);
+}
+
+void PostIncStmtNode::typeRule(TypeAnalysis * ta){
+	if (isConst(myLVal)){ ta->errConstWrite(myLVal->pos()); }
 }
 
 void ReadStmtNode::typeAnalysis(TypeAnalysis * ta){
+	myDst->typeAnalysis(ta);
+	typeRule(ta);
+}
 
-    myDst->typeAnalysis(ta);
+void ReadStmtNode::typeRule(TypeAnalysis * ta){
     auto subType = ta->nodeType(myDst);
     if (subType->asFn()){
         ta->errReadFn(myDst->pos());
+    } else if (subType->isRecord()){
+        ta->errReadRecord(myDst->pos());
+    } else if (subType->isArray()){
+        ta->errReadArray(myDst->pos());
+    } else if (isConst(myDst)){
+        ta->errConstWrite(myDst->pos());
     }
 }
 
 void WriteStmtNode::typeAnalysis(TypeAnalysis * ta){
+	mySrc->typeAnalysis(ta);
+	typeRule(ta);
+}
 
-    mySrc->typeAnalysis(ta);
-
+void WriteStmtNode::typeRule(TypeAnalysis * ta){
     auto subType = ta->nodeType(mySrc);
     if(subType->asFn()){
-        if(subType->isVoid()){
-
-            ta->errWriteVoid(mySrc->pos());
-            auto fn = subType->asFn();
-        }
-        else{
-
-            ta->errWriteFn(mySrc->pos());
-               auto fn = subType->asFn();
-        }
+        ta->errWriteFn(mySrc->pos());
+    } else if (subType->isVoid()){
+        ta->errWriteVoid(mySrc->pos());
+    } else if (subType->isRecord()){
+        ta->errWriteRecord(mySrc->pos());
+    } else if (subType->isArray()){
+        ta->errWriteArray(mySrc->pos());
     }
 }
 
 void IfStmtNode::typeAnalysis(TypeAnalysis * ta){
 
 	myCond->typeAnalysis(ta);
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->typeAnalysis(ta);
 	}
+	typeRule(ta);
+}
 
+void IfStmtNode::typeRule(TypeAnalysis * ta){
 	auto condition = ta->nodeType(myCond);
 	if(!condition->isBool()){
 		ta->errIfCond(myCond->pos());
@@ -118,13 +216,16 @@ void IfStmtNode::typeAnalysis(TypeAnalysis * ta){
 void IfElseStmtNode::typeAnalysis(TypeAnalysis * ta){
 
 	myCond->typeAnalysis(ta);
-	for (auto stmt : *myBodyTrue){
+	for (auto stmt : myBodyTrue){
 		stmt->typeAnalysis(ta);
 	}
-	for (auto stmt : *myBodyFalse){
+	for (auto stmt : myBodyFalse){
 		stmt->typeAnalysis(ta);
 	}
+	typeRule(ta);
+}
 
+void IfElseStmtNode::typeRule(TypeAnalysis * ta){
 	auto condition = ta->nodeType(myCond);
 	if(!condition->isBool()){
 		ta->errIfCond(myCond->pos());
@@ -138,10 +239,13 @@ void IfElseStmtNode::typeAnalysis(TypeAnalysis * ta){
 void WhileStmtNode::typeAnalysis(TypeAnalysis * ta){
 
 	myCond->typeAnalysis(ta);
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->typeAnalysis(ta);
 	}
+	typeRule(ta);
+}
 
+void WhileStmtNode::typeRule(TypeAnalysis * ta){
 	auto condition = ta->nodeType(myCond);
 	if(!condition->isBool()){
 		ta->errIfCond(myCond->pos());
@@ -152,13 +256,39 @@ void WhileStmtNode::typeAnalysis(TypeAnalysis * ta){
 	ta->nodeType(this, ErrorType::produce());
 }
 
+void RecordDeclNode::typeAnalysis(TypeAnalysis * ta){
+	typeRule(ta);
+}
+
+void RecordDeclNode::typeRule(TypeAnalysis * ta){
+	// Like VarDecls, record declarations are never
+	// used in an expression, so they are typed void
+	ta->nodeType(this, BasicType::produce(VOID));
+}
+
 void VarDeclNode::typeAnalysis(TypeAnalysis * ta){
+	typeRule(ta);
+}
+
+void VarDeclNode::typeRule(TypeAnalysis * ta){
 	// VarDecls always pass type analysis, since they 
 	// are never used in an expression. You may choose
 	// to type them void (like this), as discussed in class
 	ta->nodeType(this, BasicType::produce(VOID));
 }
 
+void ConstDeclNode::typeAnalysis(TypeAnalysis * ta){
+	myInit->typeAnalysis(ta);
+	typeRule(ta);
+}
+
+void ConstDeclNode::typeRule(TypeAnalysis * ta){
+	if (ta->nodeType(myInit) != getTypeNode()->getType()){
+		ta->errConstInit(myInit->pos());
+	}
+	ta->nodeType(this, BasicType::produce(VOID));
+}
+
 void FnDeclNode::typeAnalysis(TypeAnalysis * ta){
 	//std::cout<<"funciton declaration\n";
 	//HINT: you might want to change the signature for
@@ -176,31 +306,30 @@ void FnDeclNode::typeAnalysis(TypeAnalysis * ta){
 	//BasicType::produce(VOID)
 
 
-	//i "borrowed" ur code, sorry. I tried to reinvent it but this was just too good.
-	std::list<const DataType *> * formalTypes = 
-		new std::list<const DataType *>();
-	for (auto formal : *(this->myFormals)){
+	for (auto formal : myFormals){
 		formal->typeAnalysis(ta);
-		TypeNode * typeNode = formal->getTypeNode();
-		const DataType * formalType = typeNode->getType();
-		formalTypes->push_back(formalType);
 	}
-	const DataType * retType = this->getRetTypeNode()->getType();
-	FnType * functionType = new FnType(formalTypes, retType);
-	ta->setCurrentFnType(functionType);
+	//The type was built by name analysis
+	ta->setCurrentFnType(myFnType);
 	
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->typeAnalysis(ta);
 	}
-	ta->nodeType(myID, functionType);
-	
+	typeRule(ta);
+}
+
+void FnDeclNode::typeRule(TypeAnalysis * ta){
+	ta->nodeType(myID, ta->getCurrentFnType());
 }
 
 void BinaryExpNode::typeAnalysis(TypeAnalysis * ta){
-	//should be overriden by subclass
 	myExp1->typeAnalysis(ta);
 	myExp2->typeAnalysis(ta);
+	typeRule(ta);
+}
 
+void BinaryExpNode::typeRule(TypeAnalysis * ta){
+	//should be overriden by subclass
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -213,11 +342,7 @@ void BinaryExpNode::typeAnalysis(TypeAnalysis * ta){
 	ta->nodeType(this, ErrorType::produce());
 }
 
-void PlusNode::typeAnalysis(TypeAnalysis * ta){
-
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void PlusNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -230,11 +355,7 @@ void PlusNode::typeAnalysis(TypeAnalysis * ta){
 	ta->nodeType(this, ErrorType::produce());
 }
 
-void MinusNode::typeAnalysis(TypeAnalysis * ta){
-
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void MinusNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -247,11 +368,7 @@ void MinusNode::typeAnalysis(TypeAnalysis * ta){
 	ta->nodeType(this, ErrorType::produce());
 }
 
-void DivideNode::typeAnalysis(TypeAnalysis * ta){
-
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void DivideNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -264,11 +381,7 @@ void DivideNode::typeAnalysis(TypeAnalysis * ta){
 	ta->nodeType(this, ErrorType::produce());
 }
 
-void TimesNode::typeAnalysis(TypeAnalysis * ta){
-
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void TimesNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -281,11 +394,7 @@ void TimesNode::typeAnalysis(TypeAnalysis * ta){
 	ta->nodeType(this, ErrorType::produce());
 }
 
-void AndNode::typeAnalysis(TypeAnalysis * ta){
-
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void AndNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -299,11 +408,7 @@ void AndNode::typeAnalysis(TypeAnalysis * ta){
 
 }
 
-void OrNode::typeAnalysis(TypeAnalysis * ta){
-
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void OrNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -317,11 +422,7 @@ void OrNode::typeAnalysis(TypeAnalysis * ta){
 	
 }
 
-void EqualsNode::typeAnalysis(TypeAnalysis * ta){
-
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void EqualsNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -336,11 +437,7 @@ void EqualsNode::typeAnalysis(TypeAnalysis * ta){
 	
 }
 
-void NotEqualsNode::typeAnalysis(TypeAnalysis * ta){
-
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void NotEqualsNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -355,12 +452,7 @@ void NotEqualsNode::typeAnalysis(TypeAnalysis * ta){
 
 }
 
-void LessEqNode::typeAnalysis(TypeAnalysis * ta){
-
-	
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void LessEqNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -375,12 +467,7 @@ void LessEqNode::typeAnalysis(TypeAnalysis * ta){
 
 }
 
-void LessNode::typeAnalysis(TypeAnalysis * ta){
-
-	
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void LessNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -395,12 +482,7 @@ void LessNode::typeAnalysis(TypeAnalysis * ta){
 	
 }
 
-void GreaterEqNode::typeAnalysis(TypeAnalysis * ta){
-
-	
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void GreaterEqNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -415,12 +497,7 @@ void GreaterEqNode::typeAnalysis(TypeAnalysis * ta){
 	
 }
 
-void GreaterNode::typeAnalysis(TypeAnalysis * ta){
-
-	
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-
+void GreaterNode::typeRule(TypeAnalysis * ta){
 	auto exp1 = ta->nodeType(myExp1);
 	auto exp2 = ta->nodeType(myExp2);
 
@@ -437,87 +514,170 @@ void GreaterNode::typeAnalysis(TypeAnalysis * ta){
 
 void CallExpNode::typeAnalysis(TypeAnalysis * ta){
 	myID->typeAnalysis(ta);
-    auto subType = ta->nodeType(myID)->asFn();
-	if(subType == nullptr){
-		std::cout<<"you did not call a function\n";
-	}else{
-		int funcArgSize = 0;
-		int callArgSize = 0;
-		auto funcTypes = subType->getFormalTypes();
-		std::list<const DataType *> * callTypes = 
-			new std::list<const DataType *>();
-		for (auto formal : *(this->myArgs)){
-			callArgSize++;
-			formal->typeAnalysis(ta);
-			auto exp = ta->nodeType(formal);
-			callTypes->push_back(exp);
-		}
-		for(auto funcArg: * funcTypes){
-			funcArgSize++;
+	//The arguments of a call to a non-function are never typed
+	if (ta->nodeType(myID)->asFn() != nullptr){
+		for (auto arg : myArgs){
+			arg->typeAnalysis(ta);
 		}
-		//std::cout<<"Call Arg Size: "<<callArgSize<<"  | Func Arg Size: "<<funcArgSize<<std::endl;
-		if(funcArgSize == callArgSize){
-			//need to step through list, it doesnt have random access iterator
-			auto funcFront = funcTypes->begin();
-			auto callFront = callTypes->begin();
-			bool correctArgs = true;
-			for(int size = 0; size<funcArgSize; size++){
-				cout<<size<<". ";
-				if(* funcFront != * callFront){
-					std::cout<<"mismatched call argument types";
-					correctArgs = false;
-				}
-				advance(funcFront, 1);
-				advance(callFront, 1);
-				std::cout<<"\n";
-				
-			}
-			if(correctArgs == true){
-				// need to set this node to the same type as the return type
-				// tempted to just biff it and use a if-elif-else
-				// ta->nodeType(this, BasicType::produce(subType->getReturnType()))
-			}
-		}
-		else{
-			std::cout<<"call does not have correct number of arguments\n";
-		}
-		
 	}
-	ta->nodeType(this, ErrorType::produce());
+	typeRule(ta);
+}
 
+void CallExpNode::typeRule(TypeAnalysis * ta){
+	auto calleeType = ta->nodeType(myID);
+	const FnType * fnType = calleeType->asFn();
+	if (fnType == nullptr){
+		if (!calleeType->asError()){ ta->errCallee(myID->pos()); }
+		ta->nodeType(this, ErrorType::produce());
+		return;
+	}
+	const std::list<const DataType *> * formals = fnType->getFormalTypes();
+	if (formals->size() != myArgs.size()){
+		ta->errArgCount(pos());
+		ta->nodeType(this, ErrorType::produce());
+		return;
+	}
+	bool correctArgs = true;
+	auto formal = formals->begin();
+	for (auto arg : myArgs){
+		const DataType * argType = ta->nodeType(arg);
+		if (argType->asError()){
+			correctArgs = false;
+		} else if (argType != *formal){
+			ta->errArgMatch(arg->pos());
+			correctArgs = false;
+		}
+		++formal;
+	}
+	if (correctArgs){
+		ta->nodeType(this, fnType->getReturnType());
+	} else {
+		ta->nodeType(this, ErrorType::produce());
+	}
 }
 
 void RefNode::typeAnalysis(TypeAnalysis * ta){
-
 	myExp->typeAnalysis(ta);
+	typeRule(ta);
 }
 
-void DerefNode::typeAnalysis(TypeAnalysis * ta){
+void RefNode::typeRule(TypeAnalysis * ta){
+	auto subType = ta->nodeType(myExp);
+	if (isConst(myID)){
+		ta->errConstRef(myID->pos());
+		ta->nodeType(this, ErrorType::produce());
+	} else if (subType->asError()){
+		ta->nodeType(this, subType);
+	} else {
+		ta->nodeType(this, PtrType::produce(subType));
+	}
+}
 
+void DerefNode::typeAnalysis(TypeAnalysis * ta){
 	myID->typeAnalysis(ta);
+	typeRule(ta);
 }
 
-void NegNode::typeAnalysis(TypeAnalysis * ta){
+void DerefNode::typeRule(TypeAnalysis * ta){
+	auto subType = ta->nodeType(myID);
+	if (subType->asPtr()){
+		ta->nodeType(this, subType->asPtr()->getBase());
+		return;
+	}
+	if (!subType->asError()){
+		ta->errDerefOpd(myID->pos());
+	}
+	ta->nodeType(this, ErrorType::produce());
+}
+
+void FieldAccessNode::typeAnalysis(TypeAnalysis * ta){
+	myBase->typeAnalysis(ta);
+	myField->typeAnalysis(ta);
+	typeRule(ta);
+}
+
+void FieldAccessNode::typeRule(TypeAnalysis * ta){
+	// The field was resolved during name analysis, so
+	// its type is just the type of the field's symbol
+	ta->nodeType(this, ta->nodeType(myField));
+}
+
+void IndexNode::typeAnalysis(TypeAnalysis * ta){
+	myBase->typeAnalysis(ta);
+	myIndex->typeAnalysis(ta);
+	typeRule(ta);
+}
+
+void IndexNode::typeRule(TypeAnalysis * ta){
+	auto baseType = ta->nodeType(myBase);
+	auto indexType = ta->nodeType(myIndex);
+
+	bool valid = true;
+	if (!baseType->isArray()){
+		if (!baseType->asError()){ ta->errIndexBase(myBase->pos()); }
+		valid = false;
+	}
+	if (!indexType->isInt() && !indexType->isShort()){
+		if (!indexType->asError()){ ta->errIndexType(myIndex->pos()); }
+		valid = false;
+	}
+	if (valid){
+		ta->nodeType(this, baseType->asArray()->getElem());
+	} else {
+		ta->nodeType(this, ErrorType::produce());
+	}
+}
 
+void NegNode::typeAnalysis(TypeAnalysis * ta){
 	myExp->typeAnalysis(ta);
+	typeRule(ta);
 }
 
-void NotNode::typeAnalysis(TypeAnalysis * ta){
+void NegNode::typeRule(TypeAnalysis * ta){
+	auto subType = ta->nodeType(myExp);
+	if (subType->isInt()){
+		ta->nodeType(this, subType);
+		return;
+	}
+	if (!subType->asError()){ ta->errMathOpd(myExp->pos()); }
+	ta->nodeType(this, ErrorType::produce());
+}
 
+void NotNode::typeAnalysis(TypeAnalysis * ta){
 	myExp->typeAnalysis(ta);
+	typeRule(ta);
 }
 
-void AssignExpNode::typeAnalysis(TypeAnalysis * ta){
-	//TODO: Note that this function is incomplete. 
-	// and needs additional code
+void NotNode::typeRule(TypeAnalysis * ta){
+	auto subType = ta->nodeType(myExp);
+	if (subType->isBool()){
+		ta->nodeType(this, subType);
+		return;
+	}
+	if (!subType->asError()){ ta->errLogicOpd(myExp->pos()); }
+	ta->nodeType(this, ErrorType::produce());
+}
 
+void AssignExpNode::typeAnalysis(TypeAnalysis * ta){
 	//Do typeAnalysis on the subexpressions
 	myDst->typeAnalysis(ta);
 	mySrc->typeAnalysis(ta);
+	typeRule(ta);
+}
+
+void AssignExpNode::typeRule(TypeAnalysis * ta){
+	//TODO: Note that this function is incomplete. 
+	// and needs additional code
 
 	const DataType * tgtType = ta->nodeType(myDst);
 	const DataType * srcType = ta->nodeType(mySrc);
 
+	if (isConst(myDst)){
+		ta->errConstWrite(myDst->pos());
+		ta->nodeType(this, ErrorType::produce());
+		return;
+	}
+
 	//While incomplete, this gives you one case for 
 	// assignment: if the types are exactly the same
 	// it is usually ok to do the assignment. One
@@ -543,10 +703,16 @@ void AssignExpNode::typeAnalysis(TypeAnalysis * ta){
 }
 
 void ReturnStmtNode::typeAnalysis(TypeAnalysis * ta){
+	if (myExp != nullptr){
+		myExp->typeAnalysis(ta);
+	}
+	typeRule(ta);
+}
+
+void ReturnStmtNode::typeRule(TypeAnalysis * ta){
 	//check type of current  function\check if expression is that type
 	//std::cout<<"return\n";
 	if(myExp != nullptr){
-		myExp->typeAnalysis(ta);
 		auto subType = ta->nodeType(myExp);
 		if(ta->getCurrentFnType()->getReturnType()->validVarType()){
 			ta->nodeType(this, subType);
@@ -570,6 +736,10 @@ void ReturnStmtNode::typeAnalysis(TypeAnalysis * ta){
 
 void CallStmtNode::typeAnalysis(TypeAnalysis * ta){
 	myCallExp->typeAnalysis(ta);
+	typeRule(ta);
+}
+
+void CallStmtNode::typeRule(TypeAnalysis * ta){
 	ta->nodeType(this, ErrorType::produce());
 }
 
@@ -579,39 +749,69 @@ void TypeNode::typeAnalysis(TypeAnalysis * ta){
 }
 
 void IntLitNode::typeAnalysis(TypeAnalysis * ta){
+	typeRule(ta);
+}
+
+void IntLitNode::typeRule(TypeAnalysis * ta){
 	// IntLits never fail their type analysis and always
 	// yield the type INT
 	ta->nodeType(this, BasicType::produce(INT));
 }
 
 void ShortLitNode::typeAnalysis(TypeAnalysis * ta){
+	typeRule(ta);
+}
+
+void ShortLitNode::typeRule(TypeAnalysis * ta){
 	// IntLits never fail their type analysis and always
 	// yield the type INT
 	ta->nodeType(this, BasicType::produce(SHORT));
 }
 
 void StrLitNode::typeAnalysis(TypeAnalysis * ta){
+	typeRule(ta);
+}
+
+void StrLitNode::typeRule(TypeAnalysis * ta){
 	// IntLits never fail their type analysis and always
 	// yield the type INT
 	ta->nodeType(this, BasicType::produce(STRING));
 }
 
 void TrueNode::typeAnalysis(TypeAnalysis * ta){
+	typeRule(ta);
+}
+
+void TrueNode::typeRule(TypeAnalysis * ta){
 	// IntLits never fail their type analysis and always
 	// yield the type INT
 	ta->nodeType(this, BasicType::produce(BOOL));
 }
 
 void FalseNode::typeAnalysis(TypeAnalysis * ta){
+	typeRule(ta);
+}
+
+void FalseNode::typeRule(TypeAnalysis * ta){
 	// IntLits never fail their type analysis and always
 	// yield the type INT
 	ta->nodeType(this, BasicType::produce(BOOL));
 }
 
 void IDNode::typeAnalysis(TypeAnalysis * ta){
+	typeRule(ta);
+}
+
+void IDNode::typeRule(TypeAnalysis * ta){
 	// IDs never fail type analysis and always
 	// yield the type of their symbol (which
-	// depends on their definition)
+	// depends on their definition). The exception
+	// is a record's name, which has no symbol attached
+	if (this->getSymbol() == nullptr){
+		ta->errRecordName(pos());
+		ta->nodeType(this, ErrorType::produce());
+		return;
+	}
 	ta->nodeType(this, this->getSymbol()->getDataType());
 }
 
@@ -1,6 +1,8 @@
 #ifndef CMINUSMINUS_TYPE_ANALYSIS
 #define CMINUSMINUS_TYPE_ANALYSIS
 
+#include <exception>
+#include <sstream>
 #include "ast.hpp"
 #include "symbol_table.hpp"
 #include "types.hpp"
@@ -23,12 +25,41 @@ private:
 	// can only be created via the static build function
 	TypeAnalysis(){
 		hasError = false;
+		namesFailed = false;
+		suspended = 0;
+		errOut = &std::cerr;
 	}
 
 public:
 	static TypeAnalysis * build(NameAnalysis * astRoot);
 	//static TypeAnalysis * build();
 
+	//Resolve names and types in a single traversal of the
+	// AST, with the same diagnostics as name analysis
+	// followed by type analysis. Each node is typed by its
+	// typeRule as soon as its names are resolved
+	static TypeAnalysis * buildFused(ProgramNode * astRoot,
+		Modules * modules, const std::string& path);
+
+	//Type analysis of a single global declaration whose
+	// names have been resolved. The analysis is always
+	// returned, and tells whether it passed
+	static TypeAnalysis * build(DeclNode * decl);
+	bool namesResolved() const { return !namesFailed; }
+
+	//Called by name analysis once the names of a node have
+	// (or have not) been resolved during buildFused
+	void fusedRule(ASTNode * node, bool resolved);
+
+	//Whether fused type rules still run. After a name error
+	// nothing of type analysis would be output, and inside 
+	// a call to a non-function the arguments are not typed
+	bool rulesActive() const {
+		return !namesFailed && suspended == 0 && pending == nullptr;
+	}
+	void suspendRules(){ suspended++; }
+	void resumeRules(){ suspended--; }
+
 	//The type analysis has an instance variable to say whether
 	// the analysis failed or not. Setting this variable is much
 	// less of a pain than passing a boolean all the way up to the
@@ -55,151 +86,225 @@ public:
 
 	//Gets the type of a node already placed in the map. Note
 	// that this function name is overloaded: the 1-argument nodeType
-	// gets the type of the given node out of the map.
-	const DataType * nodeType(const ASTNode * node){
-		const DataType * res = nodeToType[node];
-		if (res == nullptr){
+	// gets the type of the given node out of the map, without
+	// adding to it, so that runs on several threads can share it.
+	const DataType * nodeType(const ASTNode * node) const{
+		auto found = nodeToType.find(node);
+		if (found == nodeToType.end() || found->second == nullptr){
 			const char * msg = "No type for node ";
 			throw new InternalError(msg);
 		}
-		return nodeToType[node];
+		return found->second;
+	}
+
+	//Forget the type of a node that is being deleted
+	void dropNode(const ASTNode * node){
+		nodeToType.erase(node);
 	}
 
 	//The following functions all report and error and 
 	// tell the object that the analysis has failed. 
 	void errWriteFn(Position * pos){
 		hasError = true;
-		Report::fatal(pos,
+		Report::fatal(*errOut, pos,
 			"Attempt to output a function");
 	}
 	void errWriteVoid(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Attempt to write void");
 	}
 	void errAssignFn(Position * pos){
 		hasError = true;
-		Report::fatal(pos,
+		Report::fatal(*errOut, pos,
 			"Attempt to assign user input to function");
 	}
 	void errReadFn(Position * pos){
 		hasError = true;
-		Report::fatal(pos,
+		Report::fatal(*errOut, pos,
 			"Attempt to read a function");
 	}
 	void errCallee(Position * pos){
 		hasError = true;
-		Report::fatal(pos,
+		Report::fatal(*errOut, pos,
 			"Attempt to call a "
 			"non-function");
 	}
 	void errArgCount(Position * pos){
 		hasError = true;
-		Report::fatal(pos,
+		Report::fatal(*errOut, pos,
 			"Function call with wrong"
 			" number of args");
 	}
 	void errArgMatch(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Type of actual does not match"
 			" type of formal");
 	}
 	void errRetEmpty(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Missing return value");
 	}
 	void extraRetValue(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Return with a value in void"
 			" function");
 	}
 	void errRetWrong(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Bad return value");
 	}
 	void errMathOpd(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Arithmetic operator applied"
 			" to invalid operand");
 	}
 	void errRelOpd(Position * pos){
 		hasError = true;
-		Report::fatal(pos,
+		Report::fatal(*errOut, pos,
 			"Relational operator applied to"
 			" non-numeric operand");
 	}
 	void errLogicOpd(Position * pos){
 		hasError = true;
-		Report::fatal(pos,
+		Report::fatal(*errOut, pos,
 			"Logical operator applied to"
 			" non-bool operand");
 	}
 	void errIfCond(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Non-bool expression used as"
 			" an if condition");
 	}
 	void errWhileCond(Position * pos){
 		hasError = true;
-		Report::fatal(pos,
+		Report::fatal(*errOut, pos,
 			"Non-bool expression used as"
 			" a while condition");
 	}
 	void errEqOpd(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Invalid equality operand");
 	}
 	void errEqOpr(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Invalid equality operation");
 	}
 	void errNotLVal(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Non-Lval assignment");
 	}
 	void errAssignOpd(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Invalid assignment operand");
 	}
 	void errAssignOpr(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Invalid assignment operation");
 	}
 	void errWritePtr(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Attempt to write a raw pointer");
 	}
 	void errReadPtr(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Attempt to read a raw pointer");
 	}
 	void errDerefOpd(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Invalid operand for dereference");
 	}
 	void errRefOpd(Position * pos){
 		hasError = true;
-		Report::fatal(pos, 
+		Report::fatal(*errOut, pos, 
 			"Attempt to read a raw pointer");
 	}
+	void errWriteRecord(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Attempt to write a record");
+	}
+	void errReadRecord(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Attempt to read a record");
+	}
+	void errWriteArray(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Attempt to write an array");
+	}
+	void errReadArray(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Attempt to read an array");
+	}
+	void errIndexBase(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Index applied to non-array operand");
+	}
+	void errIndexType(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Non-integer array index");
+	}
+	void errRecordName(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Attempt to use a record name as a value");
+	}
+	void errConstWrite(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Attempt to modify a constant");
+	}
+	void errConstRef(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Attempt to take the address of a constant");
+	}
+	void errConstInit(Position * pos){
+		hasError = true;
+		Report::fatal(*errOut, pos, 
+			"Invalid constant initializer");
+	}
 private:
 	HashMap<const ASTNode *, const DataType *> nodeToType;
 	const FnType * currentFnType;
 	bool hasError;
+
+	//Run name analysis from root, typing each node as its
+	// names are resolved, and return whether they all were
+	bool fuse(ASTNode * root, SymbolTable * symTab);
+	//Output what the type rules held back
+	void release();
+
+	//Where type errors are reported
+	std::ostream * errOut;
+
+	//State of a fused analysis. Output of the type rules is
+	// held back until name analysis is known to succeed, as 
+	// is the first exception thrown by a rule
+	bool namesFailed;
+	size_t suspended;
+	std::exception_ptr pending;
+	std::stringstream fusedOut;
+	std::stringstream fusedErr;
 public:
 	ProgramNode * ast;
 };
@@ -49,7 +49,22 @@ const DataType * VoidTypeNode::getType() {
 }
 
 const DataType * PtrTypeNode::getType() { 
-	return PtrType::produce(myBaseType->getType());
+	const DataType * base = myBaseType->getType();
+	if (base == nullptr){ return nullptr; }
+	return PtrType::produce(base);
+}
+
+const DataType * RecordTypeNode::getType() { 
+	return myType;
+}
+
+const DataType * ArrayTypeNode::getType() { 
+	const DataType * elem = myElemType->getType();
+	if (elem == nullptr){ return nullptr; }
+	//Negative lengths can't be represented, so they
+	// become an (invalid) zero-length array
+	size_t len = myLength > 0 ? static_cast<size_t>(myLength) : 0;
+	return ArrayType::produce(elem, len);
 }
 
 
@@ -2,6 +2,7 @@
 #define CMINUSMINUS_DATA_TYPES
 
 #include <list>
+#include <map>
 #include <sstream>
 #include "errors.hpp"
 
@@ -22,7 +23,10 @@ class ASTNode;
 class BasicType;
 class FnType;
 class PtrType;
+class RecordType;
+class ArrayType;
 class ErrorType;
+class SemSymbol;
 
 enum BaseType{
 	INT, VOID, STRING, BOOL, SHORT
@@ -34,10 +38,13 @@ enum BaseType{
 // using the is<X> functions.
 class DataType{
 public:
+	virtual ~DataType(){ }
 	virtual std::string getString() const = 0;
 	virtual const BasicType * asBasic() const { return nullptr; }
 	virtual const PtrType * asPtr() const { return nullptr; }
 	virtual const FnType * asFn() const { return nullptr; }
+	virtual const RecordType * asRecord() const { return nullptr; }
+	virtual const ArrayType * asArray() const { return nullptr; }
 	virtual const ErrorType * asError() const { return nullptr; }
 	virtual bool isVoid() const { return false; }
 	virtual bool isInt() const { return false; }
@@ -45,8 +52,13 @@ public:
 	virtual bool isString() const { return false; }
 	virtual bool isShort() const { return false; }
 	virtual bool isPtr() const { return false; }
+	virtual bool isRecord() const { return false; }
+	virtual bool isArray() const { return false; }
 	virtual bool validVarType() const = 0 ;
 	virtual size_t getSize() const = 0;
+	//Scalars are naturally aligned, so by default the
+	// alignment of a type is just its size
+	virtual size_t getAlignment() const { return getSize(); }
 protected:
 };
 
@@ -141,6 +153,9 @@ public:
 	bool isBool() const override {
 		return myBaseType == BaseType::BOOL;
 	}
+	bool isShort() const override {
+		return myBaseType == BaseType::SHORT;
+	}
 	virtual bool isVoid() const override { 
 		return myBaseType == BaseType::VOID; 
 	}
@@ -149,11 +164,14 @@ public:
 	}
 	virtual BaseType getBaseType() const { return myBaseType; }
 	virtual std::string getString() const override;
+	//Sizes are the natural (packed) sizes of each type, 
+	// which is what record layout works in terms of.
+	// Strings are represented by a pointer to their data
 	virtual size_t getSize() const override { 
-		if (isBool()){ return 8; }
+		if (isBool()){ return 1; }
+		else if (isShort()){ return 2; }
+		else if (isInt()){ return 4; }
 		else if (isString()){ return 8; }
-		else if (isVoid()){ return 8; }
-		else if (isInt()){ return 8; }
 		else { return 0; }
 	}
 private:
@@ -183,11 +201,55 @@ public:
 	}
 	const PtrType * asPtr() const override { return this; }
 	bool isPtr() const override { return true; }
+	const DataType * getBase() const { return myBase; }
 private:
 	PtrType(const DataType * baseIn) : DataType(), myBase(baseIn){ }
 	const DataType * myBase;
 };
 
+//DataType subclass for fixed-size arrays. Like pointers, 
+// arrays are flyweights: there is one instance for each
+// combination of element type and length
+class ArrayType : public DataType{
+public:
+	static ArrayType * produce(const DataType * elemType, size_t len){
+		static std::map<std::pair<const DataType *, size_t>, 
+			ArrayType *> map;
+
+		auto key = std::make_pair(elemType, len);
+		auto res = map.find(key);
+		if (res == map.end()){
+			ArrayType * a = new ArrayType(elemType, len);
+			map[key] = a;
+			return a;
+		} else {
+			return res->second;
+		}
+	}
+	bool validVarType() const override { 
+		return myLength > 0 && myElem->validVarType(); 
+	}
+	std::string getString() const override { 
+		return myElem->getString() 
+		  + "[" + std::to_string(myLength) + "]"; 
+	}
+	size_t getSize() const override { 
+		return myElem->getSize() * myLength;
+	}
+	size_t getAlignment() const override { 
+		return myElem->getAlignment();
+	}
+	const ArrayType * asArray() const override { return this; }
+	bool isArray() const override { return true; }
+	const DataType * getElem() const { return myElem; }
+	size_t getLength() const { return myLength; }
+private:
+	ArrayType(const DataType * elemIn, size_t lenIn) 
+	: DataType(), myElem(elemIn), myLength(lenIn){ }
+	const DataType * myElem;
+	size_t myLength;
+};
+
 //DataType subclass to represent the type of a function. It will
 // have a list of argument types and a return type. 
 class FnType : public DataType{
@@ -198,6 +260,7 @@ public:
 	  myRetType(retTypeIn)
 	{
 	}
+	~FnType(){ delete myFormalTypes; }
 	std::string getString() const override{
 		std::string result = "";
 		bool first = true;
@@ -218,6 +281,15 @@ public:
 	const std::list<const DataType *> * getFormalTypes() const {
 		return myFormalTypes;
 	}
+	//Change the type in place once a pass has changed the
+	// formals or return type of the function, so that every
+	// node typed with it has the new type
+	void setSignature(const std::list<const DataType *> * formalsIn,
+		const DataType * retTypeIn){
+		delete myFormalTypes;
+		myFormalTypes = formalsIn;
+		myRetType = retTypeIn;
+	}
 	virtual bool validVarType() const override { return false; }
 	virtual size_t getSize() const override { return 0; }
 private:
@@ -225,6 +297,93 @@ private:
 	const DataType * myRetType;
 };
 
+//A single field of a record. The offset is only meaningful
+// once the record has been laid out (see record_layout.cpp)
+class RecordField{
+public:
+	RecordField(SemSymbol * symIn, const DataType * typeIn)
+	: offset(0), hits(0), cold(false), mySym(symIn), myType(typeIn){ }
+	SemSymbol * getSymbol() const { return mySym; }
+	const DataType * getType() const { return myType; }
+	size_t offset;
+	//Static access count, weighted by loop nesting
+	size_t hits;
+	bool cold;
+private:
+	SemSymbol * mySym;
+	const DataType * myType;
+};
+
+//DataType subclass to represent a record. Unlike the other
+// types, records are nominal: there is one RecordType per
+// record declaration, and two records are the same type
+// only if they are the same instance.
+class RecordType : public DataType{
+public:
+	RecordType(std::string nameIn)
+	: DataType(), myName(nameIn), mySerial(nextSerial()),
+	  myComplete(false), myLaidOut(false), mySplitCold(false){ }
+	//The fields' symbols belong to their declarations
+	~RecordType(){
+		for (auto field : myFields){ delete field; }
+	}
+	std::string getString() const override { return myName; }
+	//Differs between any two records, even if one is in
+	// memory where the other was
+	size_t serial() const { return mySerial; }
+	const RecordType * asRecord() const override { return this; }
+	bool isRecord() const override { return true; }
+	//A record cannot contain itself by value, so it is 
+	// not a valid variable type until its closing brace
+	bool validVarType() const override { return myComplete; }
+	size_t getSize() const override;
+	size_t getAlignment() const override;
+
+	void addField(SemSymbol * sym, const DataType * type);
+	void complete(){ myComplete = true; }
+	RecordField * getField(std::string name) const;
+	const std::list<RecordField *> * getFields() const {
+		return &myFields;
+	}
+	//Record an access to the field. The weight lets accesses
+	// inside loops count for more than straight-line ones
+	void noteAccess(std::string name, size_t weight) const;
+
+	//Order the fields to minimize padding, optionally moving
+	// rarely-accessed fields out into a separate cold block.
+	void layout(bool splitCold) const;
+	size_t getPadding() const;
+	size_t getDeclaredSize() const;
+	size_t getColdSize() const;
+	bool isSplit() const { return !myColdOrder.empty(); }
+	const std::list<RecordField *> * getHotOrder() const {
+		return &myHotOrder;
+	}
+	const std::list<RecordField *> * getColdOrder() const {
+		return &myColdOrder;
+	}
+private:
+	static size_t nextSerial(){
+		static size_t serial = 0;
+		return ++serial;
+	}
+	void arrange() const;
+	std::string myName;
+	size_t mySerial;
+	bool myComplete;
+	std::list<RecordField *> myFields;
+	//The layout is computed lazily (field sizes are not
+	// known until nested records are complete, and the
+	// access counts not until name analysis is done)
+	mutable bool myLaidOut;
+	mutable bool mySplitCold;
+	mutable std::list<RecordField *> myHotOrder;
+	mutable std::list<RecordField *> myColdOrder;
+	mutable size_t mySize;
+	mutable size_t myAlign;
+	mutable size_t myColdSize;
+};
+
 }
 
 #endif
@@ -1,5 +1,6 @@
 #include "ast.hpp"
 #include "errors.hpp"
+#include "string_pool.hpp"
 
 namespace cminusminus{
 
@@ -8,16 +9,38 @@ static void doIndent(std::ostream& out, int indent){
 }
 
 void ProgramNode::unparse(std::ostream& out, int indent){
-	for (DeclNode * decl : *myGlobals){
+	for (ImportNode * import : myImports){
+		import->unparse(out, indent);
+	}
+	for (DeclNode * decl : myGlobals){
 		decl->unparse(out, indent);
 	}
 }
 
+void ImportNode::unparse(std::ostream& out, int indent){
+	doIndent(out, indent);
+	out << "import ";
+	StringPool::unparse(out, myPathID);
+	out << ";\n";
+}
+
 void VarDeclNode::unparse(std::ostream& out, int indent){
 	doIndent(out, indent); 
 	myType->unparse(out, 0);
 	out << " ";
 	myID->unparse(out, 0);
+	myType->unparseSuffix(out);
+	out << ";\n";
+}
+
+void ConstDeclNode::unparse(std::ostream& out, int indent){
+	doIndent(out, indent); 
+	out << "const ";
+	getTypeNode()->unparse(out, 0);
+	out << " ";
+	ID()->unparse(out, 0);
+	out << " = ";
+	myInit->unparse(out, 0);
 	out << ";\n";
 }
 
@@ -35,19 +58,31 @@ void FnDeclNode::unparse(std::ostream& out, int indent){
 	myID->unparse(out, 0);
 	out << "(";
 	bool firstFormal = true;
-	for(auto formal : *myFormals){
+	for(auto formal : myFormals){
 		if (firstFormal) { firstFormal = false; }
 		else { out << ", "; }
 		formal->unparse(out, 0);
 	}
 	out << "){\n";
-	for(auto stmt : *myBody){
+	for(auto stmt : myBody){
 		stmt->unparse(out, indent+1);
 	}
 	doIndent(out, indent);
 	out << "}\n";
 }
 
+void RecordDeclNode::unparse(std::ostream& out, int indent){
+	doIndent(out, indent); 
+	out << "record ";
+	myID->unparse(out, 0);
+	out << "{\n";
+	for(auto field : myFields){
+		field->unparse(out, indent+1);
+	}
+	doIndent(out, indent);
+	out << "}\n";
+}
+
 void AssignStmtNode::unparse(std::ostream& out, int indent){
 	doIndent(out, indent);
 	myExp->unparse(out,0);
@@ -85,7 +120,7 @@ void IfStmtNode::unparse(std::ostream& out, int indent){
 	out << "if (";
 	myCond->unparse(out, 0);
 	out << "){\n";
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->unparse(out, indent + 1);
 	}
 	doIndent(out, indent);
@@ -97,12 +132,12 @@ void IfElseStmtNode::unparse(std::ostream& out, int indent){
 	out << "if (";
 	myCond->unparse(out, 0);
 	out << "){\n";
-	for (auto stmt : *myBodyTrue){
+	for (auto stmt : myBodyTrue){
 		stmt->unparse(out, indent + 1);
 	}
 	doIndent(out, indent);
 	out << "} else {\n";
-	for (auto stmt : *myBodyFalse){
+	for (auto stmt : myBodyFalse){
 		stmt->unparse(out, indent + 1);
 	}
 	doIndent(out, indent);
@@ -111,10 +146,21 @@ void IfElseStmtNode::unparse(std::ostream& out, int indent){
 
 void WhileStmtNode::unparse(std::ostream& out, int indent){
 	doIndent(out, indent);
+	if (myRotated){
+		out << "do {\n";
+		for (auto stmt : myBody){
+			stmt->unparse(out, indent + 1);
+		}
+		doIndent(out, indent);
+		out << "} while (";
+		myCond->unparse(out, 0);
+		out << ");\n";
+		return;
+	}
 	out << "while (";
 	myCond->unparse(out, 0);
 	out << "){\n";
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->unparse(out, indent + 1);
 	}
 	doIndent(out, indent);
@@ -149,7 +195,7 @@ void CallExpNode::unparse(std::ostream& out, int indent){
 	out << "(";
 	
 	bool firstArg = true;
-	for(auto arg : *myArgs){
+	for(auto arg : myArgs){
 		if (firstArg) { firstArg = false; }
 		else { out << ", "; }
 		arg->unparse(out, 0);
@@ -250,6 +296,21 @@ void DerefNode::unparse(std::ostream& out, int indent){
 	myID->unparseNested(out);
 }
 
+void FieldAccessNode::unparse(std::ostream& out, int indent){
+	doIndent(out, indent);
+	myBase->unparseNested(out);
+	out << ".";
+	myField->unparse(out, 0);
+}
+
+void IndexNode::unparse(std::ostream& out, int indent){
+	doIndent(out, indent);
+	myBase->unparseNested(out);
+	out << "[";
+	myIndex->unparse(out, 0);
+	out << "]";
+}
+
 void RefNode::unparse(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "& ";
@@ -274,6 +335,20 @@ void PtrTypeNode::unparse(std::ostream& out, int indent){
 	myBaseType->unparse(out, 0);
 }
 
+void RecordTypeNode::unparse(std::ostream& out, int indent){
+	doIndent(out, indent);
+	myID->unparse(out, 0);
+}
+
+void ArrayTypeNode::unparse(std::ostream& out, int indent){
+	doIndent(out, indent);
+	myElemType->unparse(out, 0);
+}
+
+void ArrayTypeNode::unparseSuffix(std::ostream& out){
+	out << "[" << myLength << "]";
+}
+
 void VoidTypeNode::unparse(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "void";
@@ -333,7 +408,7 @@ void ShortLitNode::unparse(std::ostream& out, int indent){
 
 void StrLitNode::unparse(std::ostream& out, int indent){
 	doIndent(out, indent);
-	out << myStr;
+	StringPool::unparse(out, myStrID);
 }
 
 void FalseNode::unparse(std::ostream& out, int indent){
@@ -0,0 +1,145 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include "watch.hpp"
+
+namespace cminusminus{
+
+//How long the directory must be quiet before changed files
+// are checked, in milliseconds
+static const int DEBOUNCE = 50;
+
+static bool isSource(const std::string& name){
+	const std::string ext = ".cmm";
+	return name.length() > ext.length()
+		&& name.compare(name.length() - ext.length(), ext.length(), ext) == 0;
+}
+
+int Watcher::watch(const char * dir){
+	int fd = inotify_init1(IN_CLOEXEC);
+	uint32_t events = IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO
+		| IN_MOVED_FROM | IN_DELETE;
+	if (fd < 0 || inotify_add_watch(fd, dir, events) < 0){
+		std::cerr << "Cannot watch " << dir << ": "
+			<< strerror(errno) << std::endl;
+		return 1;
+	}
+
+	std::set<std::string> names;
+	DIR * listing = opendir(dir);
+	if (listing == nullptr){
+		std::cerr << "Cannot read " << dir << ": "
+			<< strerror(errno) << std::endl;
+		return 1;
+	}
+	while (struct dirent * entry = readdir(listing)){
+		if (isSource(entry->d_name)){ names.insert(entry->d_name); }
+	}
+	closedir(listing);
+
+	//Anything else the compiler writes to std::cout is
+	// discarded, so that only diagnostics are output
+	std::ostream out(std::cout.rdbuf());
+	std::cout.rdbuf(nullptr);
+	Watcher watcher(dir, out);
+	while (!names.empty()){
+		watcher.check(names);
+		names = watcher.waitForChanges(fd);
+	}
+	close(fd);
+	return 1;
+}
+
+std::set<std::string> Watcher::waitForChanges(int fd){
+	std::set<std::string> changed;
+	int timeout = -1;
+	while (true){
+		struct pollfd in;
+		in.fd = fd;
+		in.events = POLLIN;
+		in.revents = 0;
+		int ready = poll(&in, 1, timeout);
+		if (ready < 0 && errno == EINTR){ continue; }
+		if (ready < 0){ return changed; }
+		if (ready == 0){
+			if (!changed.empty()){ return changed; }
+			continue;
+		}
+		alignas(struct inotify_event) char buf[4096];
+		ssize_t got = read(fd, buf, sizeof(buf));
+		if (got <= 0){ return changed; }
+		for (char * at = buf; at < buf + got; ){
+			struct inotify_event * event =
+				reinterpret_cast<struct inotify_event *>(at);
+			if (event->len > 0 && isSource(event->name)){
+				changed.insert(event->name);
+			}
+			at += sizeof(struct inotify_event) + event->len;
+		}
+		//Saving a file can take several events, so wait
+		// for them to stop
+		timeout = DEBOUNCE;
+	}
+}
+
+void Watcher::check(const std::set<std::string>& changed){
+	for (auto& name : changed){
+		load(name);
+	}
+	//A file imported by others changes what is reported for
+	// them too
+	for (auto& name : myNames){
+		report(name);
+	}
+	//Edits would otherwise leave the text of every name
+	// ever typed interned
+	myFiles.releaseUnused();
+}
+
+void Watcher::load(const std::string& name){
+	std::string path = myDir + "/" + name;
+	std::ifstream in(path);
+	if (!in.good()){
+		//The file is gone, and its AST with it
+		if (myFiles.hasSource(path)){ myFiles.removeSource(path); }
+		myFiles.saved(path);
+		myNames.erase(name);
+		if (myReports.erase(name) > 0){
+			myOut << path << ": removed" << std::endl;
+		}
+		return;
+	}
+	std::stringstream text;
+	text << in.rdbuf();
+
+	myFiles.setSource(path, text.str());
+	myFiles.saved(path);
+	myNames.insert(name);
+}
+
+void Watcher::report(const std::string& name){
+	std::string path = myDir + "/" + name;
+	std::vector<std::string> report;
+	for (auto& diag : myFiles.diagnostics(path)){
+		Position pos(diag.line, diag.col, diag.endLine, diag.endCol);
+		report.push_back("FATAL " + pos.span() + ": " + diag.msg);
+	}
+	auto last = myReports.find(name);
+	if (last != myReports.end() && last->second == report){ return; }
+	if (report.empty()){
+		myOut << path << ": no errors\n";
+	}
+	for (auto& line : report){
+		myOut << path << ": " << line << "\n";
+	}
+	myOut.flush();
+	myReports[name] = std::move(report);
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef CMINUSMINUS_WATCH
+#define CMINUSMINUS_WATCH
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "compilation.hpp"
+
+namespace cminusminus{
+
+//Keeps the .cmm files of a directory checked as they are
+// saved. A changed file is only lexed, parsed and analyzed
+// again where it changed, and the results for every other
+// file are kept as they are.
+class Watcher{
+public:
+	//Check every file, then recheck files as they change,
+	// until interrupted. Returns nonzero if the directory
+	// cannot be watched
+	static int watch(const char * dir);
+private:
+	Watcher(const std::string& dir, std::ostream& out)
+	: myDir(dir), myOut(out){ }
+	//Wait for the next burst of changes, and return the
+	// names of the files changed by it
+	std::set<std::string> waitForChanges(int fd);
+	//Read the changed files again, and report on every file
+	// whose diagnostics changed
+	void check(const std::set<std::string>& changed);
+	void load(const std::string& name);
+	void report(const std::string& name);
+	std::string myDir;
+	std::ostream& myOut;
+	//The files, by path
+	Compilation myFiles;
+	//The names of the files there are
+	std::set<std::string> myNames;
+	//What was last output for each file
+	std::map<std::string, std::vector<std::string>> myReports;
+};
+
+}
+
+#endif